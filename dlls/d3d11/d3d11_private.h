@@ -505,6 +505,80 @@ struct d3d11_immediate_context
     struct wined3d_private_store private_store;
 };
 
+/* State set on a deferred context, returned by its Get*() methods. The
+ * objects are kept alive by the context's object array, so these pointers
+ * don't hold references of their own. */
+struct d3d11_deferred_state
+{
+    ID3D11DeviceChild *shaders[WINED3D_SHADER_TYPE_COUNT];
+    ID3D11Buffer *constant_buffers[WINED3D_SHADER_TYPE_COUNT][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    ID3D11ShaderResourceView *shader_resource_views[WINED3D_SHADER_TYPE_COUNT]
+            [D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    ID3D11SamplerState *samplers[WINED3D_SHADER_TYPE_COUNT][D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+
+    ID3D11InputLayout *input_layout;
+    ID3D11Buffer *vertex_buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT vertex_strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT vertex_offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    ID3D11Buffer *index_buffer;
+    DXGI_FORMAT index_format;
+    UINT index_offset;
+    D3D11_PRIMITIVE_TOPOLOGY topology;
+
+    ID3D11Buffer *so_buffers[D3D11_SO_BUFFER_SLOT_COUNT];
+
+    ID3D11RasterizerState *rasterizer_state;
+    D3D11_VIEWPORT viewports[WINED3D_MAX_VIEWPORTS];
+    unsigned int viewport_count;
+    D3D11_RECT scissor_rects[WINED3D_MAX_VIEWPORTS];
+    unsigned int scissor_rect_count;
+
+    ID3D11RenderTargetView *render_target_views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    ID3D11DepthStencilView *depth_stencil_view;
+    ID3D11UnorderedAccessView *unordered_access_views[D3D11_PS_CS_UAV_REGISTER_COUNT];
+    ID3D11UnorderedAccessView *cs_unordered_access_views[D3D11_PS_CS_UAV_REGISTER_COUNT];
+    ID3D11BlendState *blend_state;
+    float blend_factor[4];
+    UINT sample_mask;
+    ID3D11DepthStencilState *depth_stencil_state;
+    UINT stencil_ref;
+
+    ID3D11Predicate *predicate;
+    BOOL predicate_value;
+};
+
+/* ID3D11DeviceContext - deferred context */
+struct d3d11_deferred_context
+{
+    ID3D11DeviceContext1 ID3D11DeviceContext1_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    struct d3d_device *device;
+    struct wined3d_deferred_context *wined3d_context;
+    struct d3d11_deferred_state state;
+
+    IUnknown **objects;
+    SIZE_T objects_size;
+    SIZE_T object_count;
+};
+
+/* ID3D11CommandList */
+struct d3d11_command_list
+{
+    ID3D11CommandList ID3D11CommandList_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    ID3D11Device2 *device;
+    struct wined3d_command_list *wined3d_list;
+
+    IUnknown **objects;
+    SIZE_T object_count;
+};
+
+struct d3d11_command_list *unsafe_impl_from_ID3D11CommandList(ID3D11CommandList *iface) DECLSPEC_HIDDEN;
+
 /* ID3D11Device, ID3D10Device1 */
 struct d3d_device
 {
@@ -2243,9 +2243,7 @@ static void test_create_deferred_context(void)
 
     expected_refcount = get_refcount(device) + 1;
     hr = ID3D11Device_CreateDeferredContext(device, 0, &context);
-    todo_wine ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
-    if (FAILED(hr))
-        goto done;
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
     refcount = get_refcount(device);
     ok(refcount == expected_refcount, "Got refcount %u, expected %u.\n", refcount, expected_refcount);
     refcount = get_refcount(context);
@@ -2259,11 +2257,235 @@ static void test_create_deferred_context(void)
     refcount = ID3D11DeviceContext_Release(context);
     ok(!refcount, "Got unexpected refcount %u.\n", refcount);
 
-done:
     refcount = ID3D11Device_Release(device);
     ok(!refcount, "Device has %u references left.\n", refcount);
 }
 
+static void test_deferred_context_state(void)
+{
+    ID3D11DeviceContext *immediate, *deferred;
+    ID3D11Buffer *green_buffer, *blue_buffer;
+    ID3D11CommandList *list;
+    ID3D11Buffer *ret_buffer;
+    ID3D11Device *device;
+    ULONG refcount;
+    HRESULT hr;
+
+    if (!(device = create_device(NULL)))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    ID3D11Device_GetImmediateContext(device, &immediate);
+
+    green_buffer = create_buffer(device, D3D11_BIND_CONSTANT_BUFFER, 16, NULL);
+    blue_buffer = create_buffer(device, D3D11_BIND_CONSTANT_BUFFER, 16, NULL);
+    ID3D11DeviceContext_PSSetConstantBuffers(immediate, 0, 1, &green_buffer);
+
+    hr = ID3D11Device_CreateDeferredContext(device, 0, &deferred);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+    ok(ID3D11DeviceContext_GetType(deferred) == D3D11_DEVICE_CONTEXT_DEFERRED, "Got unexpected context type.\n");
+
+    ID3D11DeviceContext_PSSetConstantBuffers(deferred, 0, 1, &blue_buffer);
+
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, TRUE, &list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+    ok(!ID3D11CommandList_GetContextFlags(list), "Got unexpected context flags.\n");
+
+    ID3D11DeviceContext_ExecuteCommandList(immediate, list, TRUE);
+    ID3D11DeviceContext_PSGetConstantBuffers(immediate, 0, 1, &ret_buffer);
+    ok(ret_buffer == green_buffer, "Got unexpected buffer %p.\n", ret_buffer);
+    ID3D11Buffer_Release(ret_buffer);
+
+    ID3D11DeviceContext_ExecuteCommandList(immediate, list, FALSE);
+    ID3D11DeviceContext_PSGetConstantBuffers(immediate, 0, 1, &ret_buffer);
+    ok(!ret_buffer, "Got unexpected buffer %p.\n", ret_buffer);
+
+    ID3D11CommandList_Release(list);
+    ID3D11DeviceContext_Release(deferred);
+
+    ID3D11Buffer_Release(blue_buffer);
+    ID3D11Buffer_Release(green_buffer);
+    ID3D11DeviceContext_Release(immediate);
+    refcount = ID3D11Device_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+}
+
+static void test_deferred_context_rendering(void)
+{
+    ID3D11Texture2D *texture, *copy_texture, *wide_texture;
+    struct d3d11_test_context test_context;
+    ID3D11DeviceContext *immediate, *deferred;
+    ID3D11RenderTargetView *rtvs[2];
+    ID3D11DepthStencilView *dsv;
+    D3D11_TEXTURE2D_DESC texture_desc;
+    D3D11_VIEWPORT vp, ret_vp;
+    struct resource_readback rb;
+    const struct uvec4 *value = NULL;
+    ID3D11CommandList *list;
+    struct uvec4 *wide_data;
+    unsigned int x, y, count;
+    ID3D11Device *device;
+    DWORD *data, color;
+    D3D11_BOX box;
+    HRESULT hr;
+
+    static const float green[] = {0.0f, 1.0f, 0.0f, 1.0f};
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    device = test_context.device;
+    immediate = test_context.immediate_context;
+
+    hr = ID3D11Device_CreateDeferredContext(device, 0, &deferred);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+
+    /* State set on a deferred context is returned by its Get*() methods, and
+     * reset by FinishCommandList() unless it's restored. */
+    set_viewport(deferred, 0.0f, 0.0f, 320.0f, 240.0f, 0.0f, 1.0f);
+    ID3D11DeviceContext_OMSetRenderTargets(deferred, 1, &test_context.backbuffer_rtv, NULL);
+    count = 0;
+    ID3D11DeviceContext_RSGetViewports(deferred, &count, NULL);
+    ok(count == 1, "Got unexpected viewport count %u.\n", count);
+    ID3D11DeviceContext_RSGetViewports(deferred, &count, &ret_vp);
+    ok(ret_vp.Width == 320.0f && ret_vp.Height == 240.0f, "Got unexpected viewport %.8e x %.8e.\n",
+            ret_vp.Width, ret_vp.Height);
+    ID3D11DeviceContext_OMGetRenderTargets(deferred, 2, rtvs, &dsv);
+    ok(rtvs[0] == test_context.backbuffer_rtv, "Got unexpected render target view %p.\n", rtvs[0]);
+    ok(!rtvs[1], "Got unexpected render target view %p.\n", rtvs[1]);
+    ok(!dsv, "Got unexpected depth stencil view %p.\n", dsv);
+    ID3D11RenderTargetView_Release(rtvs[0]);
+
+    ID3D11DeviceContext_ClearRenderTargetView(immediate, test_context.backbuffer_rtv, red);
+    ID3D11DeviceContext_ClearRenderTargetView(deferred, test_context.backbuffer_rtv, green);
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+
+    count = 1;
+    ID3D11DeviceContext_RSGetViewports(deferred, &count, &vp);
+    ok(!count, "Got unexpected viewport count %u.\n", count);
+    ID3D11DeviceContext_OMGetRenderTargets(deferred, 1, rtvs, NULL);
+    ok(!rtvs[0], "Got unexpected render target view %p.\n", rtvs[0]);
+
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 1);
+    ID3D11DeviceContext_ExecuteCommandList(immediate, list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+    ID3D11CommandList_Release(list);
+
+    /* Updates larger than the command list packets are split, and the data
+     * is copied when the update is recorded. */
+    texture_desc.Width = 256;
+    texture_desc.Height = 256;
+    texture_desc.MipLevels = 1;
+    texture_desc.ArraySize = 1;
+    texture_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texture_desc.SampleDesc.Count = 1;
+    texture_desc.SampleDesc.Quality = 0;
+    texture_desc.Usage = D3D11_USAGE_DEFAULT;
+    texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    texture_desc.CPUAccessFlags = 0;
+    texture_desc.MiscFlags = 0;
+    hr = ID3D11Device_CreateTexture2D(device, &texture_desc, NULL, &texture);
+    ok(hr == S_OK, "Failed to create texture, hr %#x.\n", hr);
+    hr = ID3D11Device_CreateTexture2D(device, &texture_desc, NULL, &copy_texture);
+    ok(hr == S_OK, "Failed to create texture, hr %#x.\n", hr);
+
+    texture_desc.Width = 8192;
+    texture_desc.Height = 2;
+    texture_desc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
+    hr = ID3D11Device_CreateTexture2D(device, &texture_desc, NULL, &wide_texture);
+    ok(hr == S_OK, "Failed to create texture, hr %#x.\n", hr);
+
+    data = heap_alloc(256 * 256 * sizeof(*data));
+    for (y = 0; y < 256; ++y)
+    {
+        for (x = 0; x < 256; ++x)
+            data[y * 256 + x] = 0xff000000 | (y << 8) | x;
+    }
+    wide_data = heap_alloc(8192 * 2 * sizeof(*wide_data));
+    for (y = 0; y < 2; ++y)
+    {
+        for (x = 0; x < 8192; ++x)
+        {
+            wide_data[y * 8192 + x].x = x;
+            wide_data[y * 8192 + x].y = y;
+            wide_data[y * 8192 + x].z = x ^ 0x5a5a;
+            wide_data[y * 8192 + x].w = 0xdeadbeef;
+        }
+    }
+
+    ID3D11DeviceContext_UpdateSubresource(deferred, (ID3D11Resource *)texture, 0, NULL,
+            data, 256 * sizeof(*data), 0);
+    ID3D11DeviceContext_CopyResource(deferred, (ID3D11Resource *)copy_texture, (ID3D11Resource *)texture);
+    set_box(&box, 3, 0, 0, 8190, 2, 1);
+    ID3D11DeviceContext_UpdateSubresource(deferred, (ID3D11Resource *)wide_texture, 0, &box,
+            &wide_data[box.left], 8192 * sizeof(*wide_data), 0);
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+
+    memset(data, 0, 256 * 256 * sizeof(*data));
+    memset(wide_data, 0, 8192 * 2 * sizeof(*wide_data));
+    ID3D11DeviceContext_ExecuteCommandList(immediate, list, FALSE);
+    ID3D11CommandList_Release(list);
+
+    get_texture_readback(texture, 0, &rb);
+    for (y = 0; y < 256; ++y)
+    {
+        for (x = 0; x < 256; ++x)
+        {
+            color = get_readback_color(&rb, x, y, 0);
+            if (color != (0xff000000 | (y << 8) | x))
+                break;
+        }
+        if (x < 256)
+            break;
+    }
+    ok(y == 256, "Got unexpected color 0x%08x at (%u, %u).\n", color, x, y);
+    release_resource_readback(&rb);
+
+    get_texture_readback(copy_texture, 0, &rb);
+    for (y = 0; y < 256; ++y)
+    {
+        for (x = 0; x < 256; ++x)
+        {
+            color = get_readback_color(&rb, x, y, 0);
+            if (color != (0xff000000 | (y << 8) | x))
+                break;
+        }
+        if (x < 256)
+            break;
+    }
+    ok(y == 256, "Got unexpected color 0x%08x at (%u, %u).\n", color, x, y);
+    release_resource_readback(&rb);
+
+    get_texture_readback(wide_texture, 0, &rb);
+    for (y = box.top; y < box.bottom; ++y)
+    {
+        for (x = box.left; x < box.right; ++x)
+        {
+            value = get_readback_uvec4(&rb, x, y);
+            if (value->x != x || value->y != y || value->z != (x ^ 0x5a5a) || value->w != 0xdeadbeef)
+                break;
+        }
+        if (x < box.right)
+            break;
+    }
+    ok(y == box.bottom, "Got unexpected value {0x%08x, 0x%08x, 0x%08x, 0x%08x} at (%u, %u).\n",
+            value->x, value->y, value->z, value->w, x, y);
+    release_resource_readback(&rb);
+
+    heap_free(wide_data);
+    heap_free(data);
+    ID3D11Texture2D_Release(wide_texture);
+    ID3D11Texture2D_Release(copy_texture);
+    ID3D11Texture2D_Release(texture);
+    ID3D11DeviceContext_Release(deferred);
+    release_test_context(&test_context);
+}
+
 static void test_create_texture1d(void)
 {
     ULONG refcount, expected_refcount;
@@ -29316,6 +29538,8 @@ START_TEST(d3d11)
     queue_for_each_feature_level(test_device_interfaces);
     queue_test(test_get_immediate_context);
     queue_test(test_create_deferred_context);
+    queue_test(test_deferred_context_state);
+    queue_test(test_deferred_context_rendering);
     queue_test(test_create_texture1d);
     queue_test(test_texture1d_interfaces);
     queue_test(test_create_texture2d);
@@ -127,7 +127,8 @@ struct d3d8_device
     DWORD sysmem_ib : 1;
     DWORD in_destruction : 1;
     DWORD recording : 1;
-    DWORD padding : 13;
+    DWORD up_stream_bound : 1;
+    DWORD padding : 12;
 
     /* The d3d8 API supports only one implicit swapchain (no D3DCREATE_ADAPTERGROUP_DEVICE,
      * no GetSwapchain, GetBackBuffer doesn't accept a swapchain number). */
@@ -872,6 +872,20 @@ static HRESULT CDECL reset_enum_callback(struct wined3d_resource *resource)
     return D3DERR_DEVICELOST;
 }
 
+/* DrawPrimitiveUP() and DrawIndexedPrimitiveUP() leave the internal vertex
+ * buffer bound to stream 0, so that consecutive immediate-mode draws don't
+ * have to rebind it and can be merged by wined3d. The NULL stream source the
+ * application expects is set before anything can observe the binding. The
+ * caller is responsible for wined3d locking. */
+static void d3d8_device_unbind_up_stream(struct d3d8_device *device)
+{
+    if (!device->up_stream_bound)
+        return;
+
+    wined3d_device_set_stream_source(device->wined3d_device, 0, NULL, 0, 0);
+    device->up_stream_bound = FALSE;
+}
+
 static HRESULT WINAPI d3d8_device_Reset(IDirect3DDevice8 *iface,
         D3DPRESENT_PARAMETERS *present_parameters)
 {
@@ -893,6 +907,7 @@ static HRESULT WINAPI d3d8_device_Reset(IDirect3DDevice8 *iface,
 
     wined3d_mutex_lock();
 
+    d3d8_device_unbind_up_stream(device);
     if (device->vertex_buffer)
     {
         wined3d_buffer_decref(device->vertex_buffer);
@@ -1865,6 +1880,7 @@ static HRESULT WINAPI d3d8_device_BeginStateBlock(IDirect3DDevice8 *iface)
     TRACE("iface %p.\n", iface);
 
     wined3d_mutex_lock();
+    d3d8_device_unbind_up_stream(device);
     if (SUCCEEDED(hr = wined3d_device_begin_stateblock(device->wined3d_device)))
         device->recording = TRUE;
     wined3d_mutex_unlock();
@@ -1940,6 +1956,7 @@ static HRESULT WINAPI d3d8_device_ApplyStateBlock(IDirect3DDevice8 *iface, DWORD
         wined3d_mutex_unlock();
         return D3DERR_INVALIDCALL;
     }
+    d3d8_device_unbind_up_stream(device);
     wined3d_stateblock_apply(stateblock);
     device->sysmem_vb = 0;
     for (i = 0; i < D3D8_MAX_STREAMS; ++i)
@@ -1980,6 +1997,7 @@ static HRESULT WINAPI d3d8_device_CaptureStateBlock(IDirect3DDevice8 *iface, DWO
         wined3d_mutex_unlock();
         return D3DERR_INVALIDCALL;
     }
+    d3d8_device_unbind_up_stream(device);
     wined3d_stateblock_capture(stateblock);
     wined3d_mutex_unlock();
 
@@ -2036,6 +2054,7 @@ static HRESULT WINAPI d3d8_device_CreateStateBlock(IDirect3DDevice8 *iface,
         WARN("Trying to create a stateblock while recording, returning D3DERR_INVALIDCALL.\n");
         return D3DERR_INVALIDCALL;
     }
+    d3d8_device_unbind_up_stream(device);
     hr = wined3d_stateblock_create(device->wined3d_device, (enum wined3d_stateblock_type)type, &stateblock);
     if (FAILED(hr))
     {
@@ -2367,6 +2386,7 @@ static HRESULT WINAPI d3d8_device_DrawPrimitive(IDirect3DDevice8 *iface,
 
     vertex_count = vertex_count_from_primitive_count(primitive_type, primitive_count);
     wined3d_mutex_lock();
+    d3d8_device_unbind_up_stream(device);
     d3d8_device_upload_sysmem_vertex_buffers(device, start_vertex, vertex_count);
     wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, 0);
     hr = wined3d_device_draw_primitive(device->wined3d_device, start_vertex, vertex_count);
@@ -2389,6 +2409,7 @@ static HRESULT WINAPI d3d8_device_DrawIndexedPrimitive(IDirect3DDevice8 *iface,
 
     index_count = vertex_count_from_primitive_count(primitive_type, primitive_count);
     wined3d_mutex_lock();
+    d3d8_device_unbind_up_stream(device);
     base_vertex_index = wined3d_device_get_base_vertex_index(device->wined3d_device);
     d3d8_device_upload_sysmem_vertex_buffers(device, base_vertex_index + min_vertex_idx, vertex_count);
     d3d8_device_upload_sysmem_index_buffer(device, start_idx, index_count);
@@ -2487,7 +2508,9 @@ static HRESULT WINAPI d3d8_device_DrawPrimitiveUP(IDirect3DDevice8 *iface,
 
     wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, 0);
     hr = wined3d_device_draw_primitive(device->wined3d_device, vb_pos / stride, vtx_count);
-    wined3d_device_set_stream_source(device->wined3d_device, 0, NULL, 0, 0);
+    device->up_stream_bound = TRUE;
+    if (device->recording)
+        d3d8_device_unbind_up_stream(device);
 
 done:
     wined3d_mutex_unlock();
@@ -2615,7 +2638,9 @@ static HRESULT WINAPI d3d8_device_DrawIndexedPrimitiveUP(IDirect3DDevice8 *iface
     wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, 0);
     hr = wined3d_device_draw_indexed_primitive(device->wined3d_device, ib_pos / idx_fmt_size, idx_count);
 
-    wined3d_device_set_stream_source(device->wined3d_device, 0, NULL, 0, 0);
+    device->up_stream_bound = TRUE;
+    if (device->recording)
+        d3d8_device_unbind_up_stream(device);
     wined3d_device_set_index_buffer(device->wined3d_device, NULL, WINED3DFMT_UNKNOWN, 0);
     wined3d_device_set_base_vertex_index(device->wined3d_device, 0);
 
@@ -2644,6 +2669,7 @@ static HRESULT WINAPI d3d8_device_ProcessVertices(IDirect3DDevice8 *iface, UINT
      * do for draws. In some regards that would be easier, but it seems less
      * than optimal to upload data to the GPU only to subsequently download it
      * again. */
+    d3d8_device_unbind_up_stream(device);
     map = device->sysmem_vb;
     while (map)
     {
@@ -3286,6 +3312,7 @@ static HRESULT WINAPI d3d8_device_SetStreamSource(IDirect3DDevice8 *iface,
 
     wined3d_mutex_lock();
 
+    d3d8_device_unbind_up_stream(device);
     if (!buffer_impl)
     {
         wined3d_device_get_stream_source(device->wined3d_device, stream_idx, &wined3d_buffer,
@@ -3326,6 +3353,7 @@ static HRESULT WINAPI d3d8_device_GetStreamSource(IDirect3DDevice8 *iface,
         return D3DERR_INVALIDCALL;
 
     wined3d_mutex_lock();
+    d3d8_device_unbind_up_stream(device);
     hr = wined3d_device_get_stream_source(device->wined3d_device, stream_idx, &wined3d_buffer, 0, stride);
     if (SUCCEEDED(hr) && wined3d_buffer)
     {
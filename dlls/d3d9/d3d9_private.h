@@ -109,7 +109,8 @@ struct d3d9_device
     DWORD in_scene : 1;
     DWORD has_vertex_declaration : 1;
     DWORD recording : 1;
-    DWORD padding : 11;
+    DWORD up_stream_bound : 1;
+    DWORD padding : 10;
 
     DWORD auto_mipmaps; /* D3D9_MAX_TEXTURE_UNITS */
 
@@ -122,6 +123,7 @@ struct d3d9_device
 HRESULT device_init(struct d3d9_device *device, struct d3d9 *parent, struct wined3d *wined3d,
         UINT adapter, D3DDEVTYPE device_type, HWND focus_window, DWORD flags,
         D3DPRESENT_PARAMETERS *parameters, D3DDISPLAYMODEEX *mode) DECLSPEC_HIDDEN;
+void d3d9_device_unbind_up_stream(struct d3d9_device *device) DECLSPEC_HIDDEN;
 
 struct d3d9_resource
 {
@@ -942,6 +942,20 @@ static HRESULT d3d9_device_get_swapchains(struct d3d9_device *device)
     return D3D_OK;
 }
 
+/* DrawPrimitiveUP() and DrawIndexedPrimitiveUP() leave the internal vertex
+ * buffer bound to stream 0, so that consecutive immediate-mode draws don't
+ * have to rebind it and can be merged by wined3d. The NULL stream source the
+ * application expects is set before anything can observe the binding. The
+ * caller is responsible for wined3d locking. */
+void d3d9_device_unbind_up_stream(struct d3d9_device *device)
+{
+    if (!device->up_stream_bound)
+        return;
+
+    wined3d_device_set_stream_source(device->wined3d_device, 0, NULL, 0, 0);
+    device->up_stream_bound = FALSE;
+}
+
 static HRESULT d3d9_device_reset(struct d3d9_device *device,
         D3DPRESENT_PARAMETERS *present_parameters, D3DDISPLAYMODEEX *mode)
 {
@@ -974,6 +988,7 @@ static HRESULT d3d9_device_reset(struct d3d9_device *device,
 
     wined3d_mutex_lock();
 
+    d3d9_device_unbind_up_stream(device);
     if (device->vertex_buffer)
     {
         wined3d_buffer_decref(device->vertex_buffer);
@@ -2355,6 +2370,7 @@ static HRESULT WINAPI d3d9_device_BeginStateBlock(IDirect3DDevice9Ex *iface)
     TRACE("iface %p.\n", iface);
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_stream(device);
     if (SUCCEEDED(hr = wined3d_device_begin_stateblock(device->wined3d_device)))
         device->recording = TRUE;
     wined3d_mutex_unlock();
@@ -2833,6 +2849,7 @@ static HRESULT WINAPI d3d9_device_DrawPrimitive(IDirect3DDevice9Ex *iface,
         WARN("Called without a valid vertex declaration set.\n");
         return D3DERR_INVALIDCALL;
     }
+    d3d9_device_unbind_up_stream(device);
     vertex_count = vertex_count_from_primitive_count(primitive_type, primitive_count);
     d3d9_device_upload_sysmem_vertex_buffers(device, 0, start_vertex, vertex_count);
     d3d9_generate_auto_mipmaps(device);
@@ -2865,6 +2882,7 @@ static HRESULT WINAPI d3d9_device_DrawIndexedPrimitive(IDirect3DDevice9Ex *iface
         WARN("Called without a valid vertex declaration set.\n");
         return D3DERR_INVALIDCALL;
     }
+    d3d9_device_unbind_up_stream(device);
     index_count = vertex_count_from_primitive_count(primitive_type, primitive_count);
     d3d9_device_upload_sysmem_vertex_buffers(device, base_vertex_idx, min_vertex_idx, vertex_count);
     d3d9_device_upload_sysmem_index_buffer(device, start_idx, index_count);
@@ -2980,7 +2998,9 @@ static HRESULT WINAPI d3d9_device_DrawPrimitiveUP(IDirect3DDevice9Ex *iface,
     d3d9_generate_auto_mipmaps(device);
     wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, 0);
     hr = wined3d_device_draw_primitive(device->wined3d_device, vb_pos / stride, vtx_count);
-    wined3d_device_set_stream_source(device->wined3d_device, 0, NULL, 0, 0);
+    device->up_stream_bound = TRUE;
+    if (device->recording)
+        d3d9_device_unbind_up_stream(device);
     if (SUCCEEDED(hr))
         d3d9_rts_flag_auto_gen_mipmap(device);
 
@@ -3123,7 +3143,9 @@ static HRESULT WINAPI d3d9_device_DrawIndexedPrimitiveUP(IDirect3DDevice9Ex *ifa
     wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, 0);
     hr = wined3d_device_draw_indexed_primitive(device->wined3d_device, ib_pos / idx_fmt_size, idx_count);
 
-    wined3d_device_set_stream_source(device->wined3d_device, 0, NULL, 0, 0);
+    device->up_stream_bound = TRUE;
+    if (device->recording)
+        d3d9_device_unbind_up_stream(device);
     wined3d_device_set_index_buffer(device->wined3d_device, NULL, WINED3DFMT_UNKNOWN, 0);
 
     if (SUCCEEDED(hr))
@@ -3156,6 +3178,7 @@ static HRESULT WINAPI d3d9_device_ProcessVertices(IDirect3DDevice9Ex *iface,
      * do for draws. In some regards that would be easier, but it seems less
      * than optimal to upload data to the GPU only to subsequently download it
      * again. */
+    d3d9_device_unbind_up_stream(device);
     map = device->sysmem_vb;
     while (map)
     {
@@ -3566,6 +3589,7 @@ static HRESULT WINAPI d3d9_device_SetStreamSource(IDirect3DDevice9Ex *iface,
             iface, stream_idx, buffer, offset, stride);
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_stream(device);
     if (!buffer_impl)
         wined3d_device_get_stream_source(device->wined3d_device, stream_idx, &wined3d_buffer,
                 &offset, &stride);
@@ -3606,6 +3630,7 @@ static HRESULT WINAPI d3d9_device_GetStreamSource(IDirect3DDevice9Ex *iface,
         return D3DERR_INVALIDCALL;
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_stream(device);
     hr = wined3d_device_get_stream_source(device->wined3d_device, stream_idx, &wined3d_buffer, offset, stride);
     if (SUCCEEDED(hr) && wined3d_buffer)
     {
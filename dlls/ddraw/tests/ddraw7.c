@@ -15893,6 +15893,280 @@ static void test_begin_end_state_block(void)
     DestroyWindow(window);
 }
 
+static BYTE clamp_byte(int x)
+{
+    return x < 0 ? 0 : x > 255 ? 255 : x;
+}
+
+static D3DCOLOR expected_yuy2_color(const BYTE *pair, unsigned int x)
+{
+    int c = 298 * (pair[x & 1 ? 2 : 0] - 16), d = pair[1] - 128, e = pair[3] - 128;
+
+    return clamp_byte((c + 409 * e + 128) >> 8) << 16
+            | clamp_byte((c - 100 * d - 208 * e + 128) >> 8) << 8
+            | clamp_byte((c + 516 * d + 128) >> 8);
+}
+
+static D3DCOLOR expected_r5g6b5_color(WORD pixel)
+{
+    unsigned int r = (pixel >> 11) & 0x1f, g = (pixel >> 5) & 0x3f, b = pixel & 0x1f;
+
+    return ((r * 255 + 15) / 31) << 16 | ((g * 255 + 31) / 63) << 8 | ((b * 255 + 15) / 31);
+}
+
+static void test_blt_format_conversion(void)
+{
+    IDirectDrawSurface7 *src, *dst;
+    DDSURFACEDESC2 surface_desc;
+    unsigned int i, x, y, seed;
+    LONG src_pitch;
+    IDirectDraw7 *ddraw;
+    D3DCOLOR expected;
+    const BYTE *row;
+    ULONG refcount;
+    DWORD *colour;
+    HWND window;
+    HRESULT hr;
+    BYTE *data;
+
+    /* The widths are deliberately not multiples of 4 or 8, so that both the
+     * vectorised part of a row and the remaining pixels are converted. */
+    static const struct
+    {
+        DDPIXELFORMAT format;
+        DWORD caps;
+        unsigned int width;
+        const char *name;
+    }
+    tests[] =
+    {
+        {
+            {
+                sizeof(DDPIXELFORMAT), DDPF_FOURCC, MAKEFOURCC('Y', 'U', 'Y', '2'),
+                {0}, {0}, {0}, {0}, {0}
+            },
+            DDSCAPS_OFFSCREENPLAIN, 14, "YUY2",
+        },
+        {
+            {
+                sizeof(DDPIXELFORMAT), DDPF_RGB, 0,
+                {16}, {0xf800}, {0x07e0}, {0x001f}, {0x0000}
+            },
+            DDSCAPS_OFFSCREENPLAIN | DDSCAPS_SYSTEMMEMORY, 13, "R5G6B5",
+        },
+    };
+
+    window = create_window();
+    ddraw = create_ddraw();
+    ok(!!ddraw, "Failed to create a ddraw object.\n");
+    hr = IDirectDraw7_SetCooperativeLevel(ddraw, window, DDSCL_NORMAL);
+    ok(SUCCEEDED(hr), "Failed to set cooperative level, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(tests); ++i)
+    {
+        memset(&surface_desc, 0, sizeof(surface_desc));
+        surface_desc.dwSize = sizeof(surface_desc);
+        surface_desc.dwFlags = DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT | DDSD_PIXELFORMAT;
+        surface_desc.dwWidth = tests[i].width;
+        surface_desc.dwHeight = 3;
+        surface_desc.ddsCaps.dwCaps = tests[i].caps;
+        U4(surface_desc).ddpfPixelFormat = tests[i].format;
+        if (FAILED(hr = IDirectDraw7_CreateSurface(ddraw, &surface_desc, &src, NULL)))
+        {
+            skip("Failed to create %s surface, hr %#x.\n", tests[i].name, hr);
+            continue;
+        }
+
+        surface_desc.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN | DDSCAPS_SYSTEMMEMORY;
+        U4(surface_desc).ddpfPixelFormat.dwSize = sizeof(U4(surface_desc).ddpfPixelFormat);
+        U4(surface_desc).ddpfPixelFormat.dwFlags = DDPF_RGB;
+        U4(surface_desc).ddpfPixelFormat.dwFourCC = 0;
+        U1(U4(surface_desc).ddpfPixelFormat).dwRGBBitCount = 32;
+        U2(U4(surface_desc).ddpfPixelFormat).dwRBitMask = 0x00ff0000;
+        U3(U4(surface_desc).ddpfPixelFormat).dwGBitMask = 0x0000ff00;
+        U4(U4(surface_desc).ddpfPixelFormat).dwBBitMask = 0x000000ff;
+        U5(U4(surface_desc).ddpfPixelFormat).dwRGBAlphaBitMask = 0x00000000;
+        hr = IDirectDraw7_CreateSurface(ddraw, &surface_desc, &dst, NULL);
+        ok(SUCCEEDED(hr), "Failed to create surface, hr %#x.\n", hr);
+
+        hr = IDirectDrawSurface7_Lock(src, NULL, &surface_desc, DDLOCK_WAIT, NULL);
+        ok(SUCCEEDED(hr), "Failed to lock surface, hr %#x.\n", hr);
+        data = surface_desc.lpSurface;
+        for (y = 0, seed = 0x12345678; y < surface_desc.dwHeight; ++y)
+        {
+            for (x = 0; x < surface_desc.dwWidth * 2; ++x)
+            {
+                seed = seed * 1103515245 + 12345;
+                data[y * U1(surface_desc).lPitch + x] = seed >> 16;
+            }
+        }
+        hr = IDirectDrawSurface7_Unlock(src, NULL);
+        ok(SUCCEEDED(hr), "Failed to unlock surface, hr %#x.\n", hr);
+
+        hr = IDirectDrawSurface7_Blt(dst, NULL, src, NULL, DDBLT_WAIT, NULL);
+        if (FAILED(hr))
+        {
+            skip("Failed to blit from %s, hr %#x.\n", tests[i].name, hr);
+            IDirectDrawSurface7_Release(dst);
+            IDirectDrawSurface7_Release(src);
+            continue;
+        }
+
+        hr = IDirectDrawSurface7_Lock(src, NULL, &surface_desc, DDLOCK_READONLY | DDLOCK_WAIT, NULL);
+        ok(SUCCEEDED(hr), "Failed to lock surface, hr %#x.\n", hr);
+        data = surface_desc.lpSurface;
+        src_pitch = U1(surface_desc).lPitch;
+        hr = IDirectDrawSurface7_Lock(dst, NULL, &surface_desc, DDLOCK_READONLY | DDLOCK_WAIT, NULL);
+        ok(SUCCEEDED(hr), "Failed to lock surface, hr %#x.\n", hr);
+        for (y = 0; y < surface_desc.dwHeight; ++y)
+        {
+            colour = (DWORD *)((BYTE *)surface_desc.lpSurface + y * U1(surface_desc).lPitch);
+            row = data + y * src_pitch;
+            for (x = 0; x < surface_desc.dwWidth; ++x)
+            {
+                if (!i)
+                    expected = expected_yuy2_color(&row[(x & ~1u) * 2], x);
+                else
+                    expected = expected_r5g6b5_color(((const WORD *)row)[x]);
+                ok(compare_color(colour[x] & 0x00ffffff, expected, 2),
+                        "Test %s: Got unexpected colour 0x%08x at (%u, %u), expected 0x%08x.\n",
+                        tests[i].name, colour[x], x, y, expected);
+            }
+        }
+        hr = IDirectDrawSurface7_Unlock(dst, NULL);
+        ok(SUCCEEDED(hr), "Failed to unlock surface, hr %#x.\n", hr);
+        hr = IDirectDrawSurface7_Unlock(src, NULL);
+        ok(SUCCEEDED(hr), "Failed to unlock surface, hr %#x.\n", hr);
+
+        IDirectDrawSurface7_Release(dst);
+        IDirectDrawSurface7_Release(src);
+    }
+
+    refcount = IDirectDraw7_Release(ddraw);
+    ok(!refcount, "DirectDraw has %u references left.\n", refcount);
+    DestroyWindow(window);
+}
+
+static void test_ck_odd_width(void)
+{
+    static struct
+    {
+        struct vec4 position;
+        struct vec2 texcoord;
+    }
+    tquad[] =
+    {
+        {{  0.0f, 480.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+        {{  0.0f,   0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
+        {{640.0f, 480.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+        {{640.0f,   0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},
+    };
+    IDirectDrawSurface7 *texture, *rt;
+    D3DDEVICEDESC7 device_desc;
+    DDSURFACEDESC2 surface_desc;
+    IDirect3DDevice7 *device;
+    D3DCOLOR color, expected;
+    IDirectDraw7 *ddraw;
+    IDirect3D7 *d3d;
+    unsigned int i;
+    ULONG refcount;
+    DWORD *texel;
+    HWND window;
+    HRESULT hr;
+
+    /* 13 texels, so that the color key conversion handles both full vectors
+     * and a remainder. Every third texel matches the key; the others are just
+     * below or above it, or differ from it in a single channel. */
+    static const D3DCOLOR colors[] =
+    {
+        0x00ff00ff, 0x00ff00fe, 0x00ff0100, 0x00ff00ff, 0x00fe00ff, 0x000000ff, 0x00ff00ff,
+        0x00ff01ff, 0x00123456, 0x00ff00ff, 0x00ffffff, 0x00000000, 0x00ff00ff,
+    };
+
+    window = create_window();
+    if (!(device = create_device(window, DDSCL_NORMAL)))
+    {
+        skip("Failed to create a 3D device, skipping test.\n");
+        DestroyWindow(window);
+        return;
+    }
+
+    hr = IDirect3DDevice7_GetCaps(device, &device_desc);
+    ok(SUCCEEDED(hr), "Failed to get device caps, hr %#x.\n", hr);
+    if ((device_desc.dpcTriCaps.dwTextureCaps & D3DPTEXTURECAPS_POW2)
+            && !(device_desc.dpcTriCaps.dwTextureCaps & D3DPTEXTURECAPS_NONPOW2CONDITIONAL))
+    {
+        skip("Non power of two textures not supported, skipping test.\n");
+        IDirect3DDevice7_Release(device);
+        DestroyWindow(window);
+        return;
+    }
+
+    hr = IDirect3DDevice7_GetDirect3D(device, &d3d);
+    ok(SUCCEEDED(hr), "Failed to get d3d interface, hr %#x.\n", hr);
+    hr = IDirect3D7_QueryInterface(d3d, &IID_IDirectDraw7, (void **)&ddraw);
+    ok(SUCCEEDED(hr), "Failed to get ddraw interface, hr %#x.\n", hr);
+    IDirect3D7_Release(d3d);
+
+    hr = IDirect3DDevice7_GetRenderTarget(device, &rt);
+    ok(SUCCEEDED(hr), "Failed to get render target, hr %#x.\n", hr);
+
+    memset(&surface_desc, 0, sizeof(surface_desc));
+    surface_desc.dwSize = sizeof(surface_desc);
+    surface_desc.dwFlags = DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT | DDSD_PIXELFORMAT | DDSD_CKSRCBLT;
+    surface_desc.ddsCaps.dwCaps = DDSCAPS_TEXTURE;
+    surface_desc.dwWidth = ARRAY_SIZE(colors);
+    surface_desc.dwHeight = 1;
+    U4(surface_desc).ddpfPixelFormat.dwSize = sizeof(U4(surface_desc).ddpfPixelFormat);
+    U4(surface_desc).ddpfPixelFormat.dwFlags = DDPF_RGB;
+    U1(U4(surface_desc).ddpfPixelFormat).dwRGBBitCount = 32;
+    U2(U4(surface_desc).ddpfPixelFormat).dwRBitMask = 0x00ff0000;
+    U3(U4(surface_desc).ddpfPixelFormat).dwGBitMask = 0x0000ff00;
+    U4(U4(surface_desc).ddpfPixelFormat).dwBBitMask = 0x000000ff;
+    surface_desc.ddckCKSrcBlt.dwColorSpaceLowValue = 0x00ff00ff;
+    surface_desc.ddckCKSrcBlt.dwColorSpaceHighValue = 0x00ff00ff;
+    hr = IDirectDraw7_CreateSurface(ddraw, &surface_desc, &texture, NULL);
+    ok(SUCCEEDED(hr), "Failed to create surface, hr %#x.\n", hr);
+
+    hr = IDirectDrawSurface7_Lock(texture, NULL, &surface_desc, DDLOCK_WAIT, NULL);
+    ok(SUCCEEDED(hr), "Failed to lock surface, hr %#x.\n", hr);
+    texel = surface_desc.lpSurface;
+    memcpy(texel, colors, sizeof(colors));
+    hr = IDirectDrawSurface7_Unlock(texture, NULL);
+    ok(SUCCEEDED(hr), "Failed to unlock surface, hr %#x.\n", hr);
+
+    hr = IDirect3DDevice7_SetTexture(device, 0, texture);
+    ok(SUCCEEDED(hr), "Failed to set texture, hr %#x.\n", hr);
+    hr = IDirect3DDevice7_SetRenderState(device, D3DRENDERSTATE_COLORKEYENABLE, TRUE);
+    ok(SUCCEEDED(hr), "Failed to enable color keying, hr %#x.\n", hr);
+    hr = IDirect3DDevice7_SetRenderState(device, D3DRENDERSTATE_LIGHTING, FALSE);
+    ok(SUCCEEDED(hr), "Failed to disable lighting, hr %#x.\n", hr);
+
+    hr = IDirect3DDevice7_Clear(device, 0, NULL, D3DCLEAR_TARGET, 0xff808080, 1.0f, 0);
+    ok(SUCCEEDED(hr), "Failed to clear render target, hr %#x.\n", hr);
+    hr = IDirect3DDevice7_BeginScene(device);
+    ok(SUCCEEDED(hr), "Failed to begin scene, hr %#x.\n", hr);
+    hr = IDirect3DDevice7_DrawPrimitive(device, D3DPT_TRIANGLESTRIP, D3DFVF_XYZRHW | D3DFVF_TEX1, &tquad[0], 4, 0);
+    ok(SUCCEEDED(hr), "Failed to draw, hr %#x.\n", hr);
+    hr = IDirect3DDevice7_EndScene(device);
+    ok(SUCCEEDED(hr), "Failed to end scene, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(colors); ++i)
+    {
+        expected = colors[i] == 0x00ff00ff ? 0x00808080 : colors[i];
+        color = get_surface_color(rt, (2 * i + 1) * 640 / (2 * ARRAY_SIZE(colors)), 240);
+        ok(compare_color(color, expected, 1), "Got unexpected color 0x%08x for texel %u, expected 0x%08x.\n",
+                color, i, expected);
+    }
+
+    IDirectDrawSurface7_Release(texture);
+    IDirectDrawSurface7_Release(rt);
+    IDirectDraw7_Release(ddraw);
+    refcount = IDirect3DDevice7_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+    DestroyWindow(window);
+}
+
 START_TEST(ddraw7)
 {
     DDDEVICEIDENTIFIER2 identifier;
@@ -16038,4 +16312,6 @@ START_TEST(ddraw7)
     test_alphatest();
     test_clipper_refcount();
     test_begin_end_state_block();
+    test_blt_format_conversion();
+    test_ck_odd_width();
 }
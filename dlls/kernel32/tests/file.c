@@ -5183,6 +5183,56 @@ static void test_post_completion(void)
     CloseHandle( port );
 }
 
+static void test_post_completion_batch(void)
+{
+    OVERLAPPED_ENTRY entries[64];
+    OVERLAPPED ovl[300];
+    ULONG count, expect, total = 0, i;
+    HANDLE port;
+    BOOL ret;
+
+    if (!pGetQueuedCompletionStatusEx)
+    {
+        win_skip("GetQueuedCompletionStatusEx not available\n");
+        return;
+    }
+
+    port = CreateIoCompletionPort( INVALID_HANDLE_VALUE, NULL, 0, 1 );
+    ok(port != NULL, "CreateIoCompletionPort failed: %u\n", GetLastError());
+
+    for (i = 0; i < ARRAY_SIZE(ovl); i++)
+    {
+        ret = PostQueuedCompletionStatus( port, i, i + 1, &ovl[i] );
+        ok(ret, "PostQueuedCompletionStatus failed: %u\n", GetLastError());
+    }
+
+    while (total < ARRAY_SIZE(ovl))
+    {
+        expect = min( ARRAY_SIZE(entries), ARRAY_SIZE(ovl) - total );
+        count = 0xdeadbeef;
+        memset( entries, 0xcc, sizeof(entries) );
+        ret = pGetQueuedCompletionStatusEx( port, entries, ARRAY_SIZE(entries), &count, 0, FALSE );
+        ok(ret, "GetQueuedCompletionStatusEx failed: %u\n", GetLastError());
+        if (!ret) break;
+        ok(count == expect, "expected count %u, got %u\n", expect, count);
+        for (i = 0; i < count; i++, total++)
+        {
+            ok(entries[i].lpCompletionKey == total + 1, "%u: wrong key %lu\n", total, entries[i].lpCompletionKey);
+            ok(entries[i].lpOverlapped == &ovl[total], "%u: wrong ovl %p\n", total, entries[i].lpOverlapped);
+            ok(!(ULONG)entries[i].Internal, "%u: wrong internal %#x\n", total, (ULONG)entries[i].Internal);
+            ok(entries[i].dwNumberOfBytesTransferred == total,
+               "%u: wrong size %u\n", total, entries[i].dwNumberOfBytesTransferred);
+        }
+    }
+    ok(total == ARRAY_SIZE(ovl), "got %u packets\n", total);
+
+    ret = pGetQueuedCompletionStatusEx( port, entries, ARRAY_SIZE(entries), &count, 0, FALSE );
+    ok(!ret, "GetQueuedCompletionStatusEx succeeded\n");
+    ok(GetLastError() == WAIT_TIMEOUT, "wrong error %u\n", GetLastError());
+
+    CloseHandle( port );
+}
+
 #define TEST_OVERLAPPED_READ_SIZE 4096
 
 static void test_overlapped_read(void)
@@ -5405,6 +5455,7 @@ START_TEST(file)
     test_SetFileInformationByHandle();
     test_GetFileAttributesExW();
     test_post_completion();
+    test_post_completion_batch();
     test_overlapped_read();
     test_file_readonly_access();
     test_find_file_stream();
@@ -30,6 +30,7 @@
 #include "winbase.h"
 #include "winternl.h"
 #include "winnls.h"
+#include "winreg.h"
 #include "wine/test.h"
 #include "delayloadhandler.h"
 
@@ -2170,6 +2171,360 @@ static void test_import_resolution(void)
     }
 }
 
+static void init_bound_test_headers( IMAGE_NT_HEADERS *nt, IMAGE_SECTION_HEADER *section,
+                                     ULONG_PTR base, DWORD data_size )
+{
+    *nt = nt_header_template;
+    nt->FileHeader.NumberOfSections = 1;
+    nt->FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt->FileHeader.Characteristics = IMAGE_FILE_EXECUTABLE_IMAGE | IMAGE_FILE_32BIT_MACHINE |
+                                     IMAGE_FILE_RELOCS_STRIPPED | IMAGE_FILE_DLL;
+    nt->OptionalHeader.SectionAlignment = page_size;
+    nt->OptionalHeader.FileAlignment = 0x200;
+    nt->OptionalHeader.ImageBase = base;
+    nt->OptionalHeader.SizeOfImage = 2 * page_size;
+    nt->OptionalHeader.SizeOfHeaders = nt->OptionalHeader.FileAlignment;
+    nt->OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    nt->OptionalHeader.DllCharacteristics = 0;
+    memset( nt->OptionalHeader.DataDirectory, 0, sizeof(nt->OptionalHeader.DataDirectory) );
+
+    memset( section, 0, sizeof(*section) );
+    memcpy( section->Name, ".text", sizeof(".text") );
+    section->PointerToRawData = nt->OptionalHeader.FileAlignment;
+    section->VirtualAddress = nt->OptionalHeader.SectionAlignment;
+    section->Misc.VirtualSize = data_size;
+    section->SizeOfRawData = data_size;
+    section->Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_CNT_CODE |
+                               IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE | IMAGE_SCN_MEM_EXECUTE;
+}
+
+/* create a dll exporting func1 and func2 at a fixed address */
+static BOOL create_export_dll( ULONG_PTR base, DWORD timestamp, char dll_name[MAX_PATH] )
+{
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+    struct
+    {
+        IMAGE_EXPORT_DIRECTORY dir;
+        DWORD functions[2];
+        DWORD names[2];
+        WORD ordinals[2];
+        char name[16];
+        char func_names[2][8];
+        BYTE code[2][4];
+    } data;
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&data))
+    memset( &data, 0, sizeof(data) );
+    init_bound_test_headers( &nt, &section, base, sizeof(data) );
+    nt.FileHeader.TimeDateStamp = timestamp;
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress = DATA_RVA( &data.dir );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].Size = (char *)data.code - (char *)&data.dir;
+    strcpy( data.name, "export.dll" );
+    data.dir.Name = DATA_RVA( data.name );
+    data.dir.Base = 1;
+    data.dir.NumberOfFunctions = 2;
+    data.dir.NumberOfNames = 2;
+    data.dir.AddressOfFunctions = DATA_RVA( data.functions );
+    data.dir.AddressOfNames = DATA_RVA( data.names );
+    data.dir.AddressOfNameOrdinals = DATA_RVA( data.ordinals );
+    strcpy( data.func_names[0], "func1" );
+    strcpy( data.func_names[1], "func2" );
+    data.names[0] = DATA_RVA( data.func_names[0] );
+    data.names[1] = DATA_RVA( data.func_names[1] );
+    data.ordinals[0] = 0;
+    data.ordinals[1] = 1;
+    data.functions[0] = DATA_RVA( data.code[0] );
+    data.functions[1] = DATA_RVA( data.code[1] );
+    data.code[0][0] = data.code[1][0] = 0xc3;  /* ret */
+#undef DATA_RVA
+
+    return create_test_dll_sections( &dos_header, &nt, &section, &data, dll_name ) != 0;
+}
+
+static void test_bound_imports(void)
+{
+    static const DWORD export_timestamp = 0x5a5a1234;
+    char export_name[MAX_PATH], import_name[MAX_PATH];
+    const char *export_basename;
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+    HMODULE export_mod, mod;
+    void *func1, *func2;
+    struct imports
+    {
+        IMAGE_IMPORT_DESCRIPTOR descr[2];
+        IMAGE_THUNK_DATA original_thunks[2];
+        IMAGE_THUNK_DATA thunks[2];
+        char module[MAX_PATH];
+        struct { WORD hint; char name[8]; } function;
+        struct
+        {
+            IMAGE_BOUND_IMPORT_DESCRIPTOR descr[2];
+            char name[MAX_PATH];
+        } bound;
+    } data, *ptr;
+    int test;
+
+    if (!create_export_dll( 0x13570000, export_timestamp, export_name )) return;
+    export_basename = strrchr( export_name, '\\' ) + 1;
+
+    export_mod = LoadLibraryA( export_name );
+    if (export_mod != (HMODULE)0x13570000)
+    {
+        skip( "export dll not loaded at its preferred base (%p, err %u)\n", export_mod, GetLastError() );
+        if (export_mod) FreeLibrary( export_mod );
+        DeleteFileA( export_name );
+        return;
+    }
+    func1 = GetProcAddress( export_mod, "func1" );
+    func2 = GetProcAddress( export_mod, "func2" );
+    ok( func1 != NULL && func2 != NULL && func1 != func2, "wrong exports %p / %p\n", func1, func2 );
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&data))
+    for (test = 0; test < 3; test++)
+    {
+        /* import func1, with the address table bound to func2 so that we can tell whether it's resolved again */
+        memset( &data, 0, sizeof(data) );
+        init_bound_test_headers( &nt, &section, 0x12340000, sizeof(data) );
+        nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress = DATA_RVA( data.descr );
+        nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].Size = sizeof(data.descr);
+        nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT].VirtualAddress = DATA_RVA( &data.bound );
+        nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT].Size = sizeof(data.bound);
+        U(data.descr[0]).OriginalFirstThunk = DATA_RVA( data.original_thunks );
+        data.descr[0].FirstThunk = DATA_RVA( data.thunks );
+        data.descr[0].Name = DATA_RVA( data.module );
+        data.descr[0].TimeDateStamp = ~0u;
+        strcpy( data.module, export_basename );
+        strcpy( data.function.name, "func1" );
+        data.original_thunks[0].u1.AddressOfData = DATA_RVA( &data.function );
+        data.thunks[0].u1.Function = (ULONG_PTR)func2;
+        data.bound.descr[0].TimeDateStamp = export_timestamp;
+        data.bound.descr[0].OffsetModuleName = offsetof( struct imports, bound.name ) - offsetof( struct imports, bound );
+        strcpy( data.bound.name, export_basename );
+
+        switch (test)
+        {
+        case 0:  /* valid binding, the address table is used as is */
+            break;
+        case 1:  /* stale binding, the dll has been rebuilt since */
+            data.bound.descr[0].TimeDateStamp = export_timestamp - 1;
+            break;
+        case 2:  /* import table not bound */
+            data.descr[0].TimeDateStamp = 0;
+            break;
+        }
+
+        if (!create_test_dll_sections( &dos_header, &nt, &section, &data, import_name )) break;
+        mod = LoadLibraryA( import_name );
+        ok( mod != NULL, "%u: failed to load err %u\n", test, GetLastError() );
+        if (mod)
+        {
+            ptr = (struct imports *)((char *)mod + page_size);
+            ok( (void *)ptr->thunks[0].u1.Function == (test ? func1 : func2),
+                "%u: thunk %p, func1 %p, func2 %p\n", test, (void *)ptr->thunks[0].u1.Function, func1, func2 );
+            FreeLibrary( mod );
+        }
+        DeleteFileA( import_name );
+    }
+#undef DATA_RVA
+
+    FreeLibrary( export_mod );
+    DeleteFileA( export_name );
+}
+
+#define PREFETCH_DLLS 3
+
+struct prefetch_imports
+{
+    IMAGE_IMPORT_DESCRIPTOR descr[PREFETCH_DLLS + 2];
+    IMAGE_THUNK_DATA original_thunks[PREFETCH_DLLS + 1][2];
+    IMAGE_THUNK_DATA thunks[PREFETCH_DLLS + 1][2];
+    char module[PREFETCH_DLLS + 1][MAX_PATH];
+    struct { WORD hint; char name[32]; } function[2];
+};
+
+/* runs in a child process started with the MaxLoaderThreads option */
+static void child_prefetch_imports( const char *import_name )
+{
+    struct prefetch_imports *ptr;
+    HMODULE mod, dep;
+    char path[MAX_PATH];
+    void *expect;
+    int i;
+
+    mod = LoadLibraryExA( import_name, 0, LOAD_WITH_ALTERED_SEARCH_PATH );
+    ok( mod != NULL, "failed to load err %u\n", GetLastError() );
+    if (!mod) return;
+    ptr = (struct prefetch_imports *)((char *)mod + page_size);
+
+    for (i = 0; i <= PREFETCH_DLLS; i++)
+    {
+        dep = GetModuleHandleA( ptr->module[i] );
+        ok( dep != NULL, "%s not loaded\n", ptr->module[i] );
+        if (!dep) continue;
+        expect = GetProcAddress( dep, i ? "func1" : "GetCurrentProcessId" );
+        ok( (void *)ptr->thunks[i][0].u1.Function == expect, "%s: thunk %p instead of %p\n",
+            ptr->module[i], (void *)ptr->thunks[i][0].u1.Function, expect );
+        if (!i) continue;
+
+        /* the dlls are found through the search path, and only loaded once */
+        GetModuleFileNameA( dep, path, MAX_PATH );
+        ok( !strncmp( path, import_name, strrchr( import_name, '\\' ) - import_name ),
+            "%s loaded from %s\n", ptr->module[i], path );
+        ok( GetModuleHandleA( path ) == dep, "%s loaded twice\n", path );
+        ok( dep == (HMODULE)(ULONG_PTR)(0x13570000 + i * 0x20000), "%s loaded at %p\n", ptr->module[i], dep );
+    }
+    FreeLibrary( mod );
+}
+
+static void test_prefetch_imports(void)
+{
+    static const char keyA[] = "Software\\Microsoft\\Windows NT\\CurrentVersion\\Image File Execution Options\\";
+    char export_names[PREFETCH_DLLS][MAX_PATH], import_name[MAX_PATH], key_name[MAX_PATH + 128];
+    char cmdline[3 * MAX_PATH], exe_name[MAX_PATH], **argv;
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    struct prefetch_imports data;
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+    DWORD disposition, threads = 4;
+    HKEY key;
+    LONG res;
+    int i;
+
+    winetest_get_mainargs( &argv );
+    GetModuleFileNameA( NULL, exe_name, MAX_PATH );
+    strcpy( key_name, keyA );
+    strcat( key_name, strrchr( exe_name, '\\' ) + 1 );
+    res = RegCreateKeyExA( HKEY_LOCAL_MACHINE, key_name, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, &disposition );
+    if (res == ERROR_ACCESS_DENIED)
+    {
+        skip( "not enough privileges to set image file execution options\n" );
+        return;
+    }
+    ok( !res, "RegCreateKeyEx failed err %u\n", res );
+    if (res) return;
+    res = RegSetValueExA( key, "MaxLoaderThreads", 0, REG_DWORD, (BYTE *)&threads, sizeof(threads) );
+    ok( !res, "RegSetValueEx failed err %u\n", res );
+
+    /* a dll importing from kernel32 and from several dlls that aren't loaded yet */
+    for (i = 0; i < PREFETCH_DLLS; i++)
+        if (!create_export_dll( 0x13570000 + (i + 1) * 0x20000, 0, export_names[i] )) goto done;
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&data))
+    memset( &data, 0, sizeof(data) );
+    init_bound_test_headers( &nt, &section, 0x12340000, sizeof(data) );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress = DATA_RVA( data.descr );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].Size = sizeof(data.descr);
+    strcpy( data.function[0].name, "GetCurrentProcessId" );
+    strcpy( data.function[1].name, "func1" );
+    for (i = 0; i <= PREFETCH_DLLS; i++)
+    {
+        U(data.descr[i]).OriginalFirstThunk = DATA_RVA( data.original_thunks[i] );
+        data.descr[i].FirstThunk = DATA_RVA( data.thunks[i] );
+        data.descr[i].Name = DATA_RVA( data.module[i] );
+        data.original_thunks[i][0].u1.AddressOfData = DATA_RVA( &data.function[i ? 1 : 0] );
+        data.thunks[i][0].u1.AddressOfData = DATA_RVA( &data.function[i ? 1 : 0] );
+        strcpy( data.module[i], i ? strrchr( export_names[i - 1], '\\' ) + 1 : "kernel32.dll" );
+    }
+#undef DATA_RVA
+    if (!create_test_dll_sections( &dos_header, &nt, &section, &data, import_name )) goto done;
+
+    sprintf( cmdline, "\"%s\" loader prefetch \"%s\"", argv[0], import_name );
+    if (CreateProcessA( argv[0], cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ))
+    {
+        winetest_wait_child_process( pi.hProcess );
+        CloseHandle( pi.hThread );
+        CloseHandle( pi.hProcess );
+    }
+    else ok( 0, "CreateProcess(%s) failed err %u\n", cmdline, GetLastError() );
+    DeleteFileA( import_name );
+
+done:
+    for (i = 0; i < PREFETCH_DLLS; i++) DeleteFileA( export_names[i] );
+    RegDeleteValueA( key, "MaxLoaderThreads" );
+    RegCloseKey( key );
+    if (disposition == REG_CREATED_NEW_KEY) RegDeleteKeyA( HKEY_LOCAL_MACHINE, key_name );
+}
+
+struct relocated_data
+{
+    ULONG_PTR ptr;
+    char str[8];
+    IMAGE_BASE_RELOCATION rel;
+    WORD fixups[2];
+};
+
+/* load the relocated dll with its preferred address taken, and check its relocated pointer */
+static HMODULE load_relocated_dll( const char *dll_name, ULONG_PTR base, BOOL modify )
+{
+    struct relocated_data *ptr;
+    HMODULE mod;
+
+    VirtualAlloc( (void *)base, 2 * page_size, MEM_RESERVE, PAGE_NOACCESS );
+    mod = LoadLibraryA( dll_name );
+    ok( mod != NULL, "failed to load err %u\n", GetLastError() );
+    if (!mod) return NULL;
+    ok( mod != (HMODULE)base, "dll loaded at its preferred address %p\n", mod );
+
+    ptr = (struct relocated_data *)((char *)mod + page_size);
+    ok( ptr->ptr == (ULONG_PTR)ptr->str, "pointer %p, expected %p\n", (void *)ptr->ptr, ptr->str );
+    ok( !strcmp( ptr->str, "reloc" ), "wrong string %s\n", ptr->str );
+    /* the relocated pages are private copies, other processes must not see this */
+    if (modify) ptr->ptr = 0xdeadbeef;
+    return mod;
+}
+
+static void test_relocated_image(void)
+{
+    static const ULONG_PTR base = 0x12340000;
+    char dll_name[MAX_PATH], cmdline[2 * MAX_PATH], **argv;
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    struct relocated_data data;
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+    HMODULE mod;
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&data))
+    memset( &data, 0, sizeof(data) );
+    init_bound_test_headers( &nt, &section, base, sizeof(data) );
+    nt.FileHeader.Characteristics &= ~IMAGE_FILE_RELOCS_STRIPPED;
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].VirtualAddress = DATA_RVA( &data.rel );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].Size = sizeof(data.rel) + sizeof(data.fixups);
+    data.ptr = base + DATA_RVA( data.str );
+    strcpy( data.str, "reloc" );
+    data.rel.VirtualAddress = page_size;
+    data.rel.SizeOfBlock = sizeof(data.rel) + sizeof(data.fixups);
+#ifdef _WIN64
+    data.fixups[0] = (IMAGE_REL_BASED_DIR64 << 12) | (DATA_RVA( &data.ptr ) & 0xfff);
+#else
+    data.fixups[0] = (IMAGE_REL_BASED_HIGHLOW << 12) | (DATA_RVA( &data.ptr ) & 0xfff);
+#endif
+    data.fixups[1] = IMAGE_REL_BASED_ABSOLUTE << 12;
+#undef DATA_RVA
+    if (!create_test_dll_sections( &dos_header, &nt, &section, &data, dll_name )) return;
+
+    mod = load_relocated_dll( dll_name, base, TRUE );
+    if (mod)
+    {
+        /* load it again in another process while it is still loaded here */
+        winetest_get_mainargs( &argv );
+        sprintf( cmdline, "\"%s\" loader relocated \"%s\"", argv[0], dll_name );
+        if (CreateProcessA( argv[0], cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ))
+        {
+            winetest_wait_child_process( pi.hProcess );
+            CloseHandle( pi.hThread );
+            CloseHandle( pi.hProcess );
+        }
+        else ok( 0, "CreateProcess(%s) failed err %u\n", cmdline, GetLastError() );
+        FreeLibrary( mod );
+    }
+    VirtualFree( (void *)base, 0, MEM_RELEASE );
+    DeleteFileA( dll_name );
+}
+
 #define MAX_COUNT 10
 static HANDLE attached_thread[MAX_COUNT];
 static DWORD attached_thread_count;
@@ -3858,6 +4213,36 @@ static void test_dll_file( const char *name )
 #undef OK_FIELD
 }
 
+static void test_builtin_fileid(void)
+{
+    static const char * const names[] = { "ntdll.dll", "kernel32.dll", "advapi32.dll", "user32.dll", "gdi32.dll" };
+    HMODULE modules[ARRAY_SIZE(names)], mod;
+    char path[MAX_PATH];
+    unsigned int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(names); i++)
+    {
+        modules[i] = LoadLibraryA( names[i] );
+        ok( modules[i] != NULL, "failed to load %s err %u\n", names[i], GetLastError() );
+        for (j = 0; j < i; j++)
+            ok( modules[i] != modules[j], "%s and %s are the same module %p\n", names[i], names[j], modules[i] );
+    }
+
+    /* loading a dll through its full path must find the module itself, not another one */
+    for (i = 0; i < ARRAY_SIZE(names); i++)
+    {
+        if (!modules[i]) continue;
+        GetModuleFileNameA( modules[i], path, MAX_PATH );
+        mod = LoadLibraryA( path );
+        ok( mod == modules[i], "%s: got %p instead of %p\n", path, mod, modules[i] );
+        if (mod) FreeLibrary( mod );
+        mod = GetModuleHandleA( path );
+        ok( mod == modules[i], "%s: got handle %p instead of %p\n", path, mod, modules[i] );
+    }
+
+    for (i = 0; i < ARRAY_SIZE(names); i++) if (modules[i]) FreeLibrary( modules[i] );
+}
+
 START_TEST(loader)
 {
     int argc;
@@ -3911,6 +4296,17 @@ START_TEST(loader)
         *child_failures = -1;
 
     argc = winetest_get_mainargs(&argv);
+    if (argc == 4 && !strcmp( argv[2], "prefetch" ))
+    {
+        child_prefetch_imports( argv[3] );
+        return;
+    }
+    if (argc == 4 && !strcmp( argv[2], "relocated" ))
+    {
+        HMODULE mod = load_relocated_dll( argv[3], 0x12340000, FALSE );
+        if (mod) FreeLibrary( mod );
+        return;
+    }
     if (argc > 4)
     {
         test_dll_phase = atoi(argv[4]);
@@ -3923,8 +4319,12 @@ START_TEST(loader)
     test_ImportDescriptors();
     test_section_access();
     test_import_resolution();
+    test_bound_imports();
+    test_prefetch_imports();
+    test_relocated_image();
     test_ExitProcess();
     test_InMemoryOrderModuleList();
+    test_builtin_fileid();
     test_dll_file( "ntdll.dll" );
     test_dll_file( "kernel32.dll" );
     test_dll_file( "advapi32.dll" );
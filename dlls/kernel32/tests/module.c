@@ -275,6 +275,44 @@ static void testNestedLoadLibraryA(void)
         ok(FreeLibrary(hModule1), "FreeLibrary() failed\n");
 }
 
+static void testGetModuleHandle_names(void)
+{
+    char path[MAX_PATH], upper[MAX_PATH];
+    HMODULE kernel32, hmod;
+    DWORD len;
+
+    kernel32 = GetModuleHandleA("kernel32.dll");
+    ok(kernel32 != NULL, "kernel32.dll should be loaded\n");
+
+    hmod = GetModuleHandleA("KERNEL32.DLL");
+    ok(hmod == kernel32, "got %p, expected %p\n", hmod, kernel32);
+    hmod = GetModuleHandleA("KeRnEl32");
+    ok(hmod == kernel32, "got %p, expected %p\n", hmod, kernel32);
+
+    len = GetModuleFileNameA(kernel32, path, sizeof(path));
+    ok(len && len < sizeof(path), "GetModuleFileNameA failed\n");
+    hmod = GetModuleHandleA(path);
+    ok(hmod == kernel32, "got %p, expected %p for %s\n", hmod, kernel32, path);
+    strcpy(upper, path);
+    CharUpperA(upper);
+    hmod = GetModuleHandleA(upper);
+    ok(hmod == kernel32, "got %p, expected %p for %s\n", hmod, kernel32, upper);
+
+    hmod = GetModuleHandleA("kernel33.dll");
+    ok(hmod == NULL, "got %p for a module that is not loaded\n", hmod);
+
+    /* the module must not be found anymore once unloaded */
+    hmod = LoadLibraryA("shell32.dll");
+    if (!hmod)
+    {
+        skip("shell32.dll not available\n");
+        return;
+    }
+    ok(GetModuleHandleA("SHELL32.DLL") == hmod, "shell32.dll not found after load\n");
+    ok(FreeLibrary(hmod), "FreeLibrary failed\n");
+    ok(GetModuleHandleA("SHELL32.DLL") == NULL, "shell32.dll still found after unload\n");
+}
+
 static void testLoadLibraryA_Wrong(void)
 {
     HMODULE hModule;
@@ -304,6 +342,45 @@ static void testGetProcAddress_Wrong(void)
     ok( GetLastError() == ERROR_MOD_NOT_FOUND, "Expected ERROR_MOD_NOT_FOUND, got %d\n", GetLastError() );
 }
 
+static void testGetProcAddress_exports(const char *dllname)
+{
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    const IMAGE_NT_HEADERS *nt;
+    const DWORD *names, *functions;
+    const WORD *ordinals;
+    DWORD i, rva, exp_rva, exp_size;
+    HMODULE hmod;
+    BYTE *base;
+    FARPROC fp;
+
+    hmod = GetModuleHandleA(dllname);
+    ok(hmod != NULL, "%s should be loaded\n", dllname);
+    base = (BYTE *)hmod;
+    nt = (const IMAGE_NT_HEADERS *)(base + ((const IMAGE_DOS_HEADER *)base)->e_lfanew);
+    exp_rva = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress;
+    exp_size = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].Size;
+    exports = (const IMAGE_EXPORT_DIRECTORY *)(base + exp_rva);
+    names = (const DWORD *)(base + exports->AddressOfNames);
+    ordinals = (const WORD *)(base + exports->AddressOfNameOrdinals);
+    functions = (const DWORD *)(base + exports->AddressOfFunctions);
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        const char *name = (const char *)(base + names[i]);
+
+        rva = functions[ordinals[i]];
+        fp = GetProcAddress(hmod, name);
+        if (rva >= exp_rva && rva < exp_rva + exp_size)  /* forwarded export */
+            continue;
+        ok(fp == (FARPROC)(base + rva), "%s.%s: got %p, expected %p\n", dllname, name, fp, base + rva);
+    }
+
+    SetLastError(0xdeadbeef);
+    fp = GetProcAddress(hmod, "non_ex_call");
+    ok(!fp, "non_ex_call should not be found\n");
+    ok(GetLastError() == ERROR_PROC_NOT_FOUND, "Expected ERROR_PROC_NOT_FOUND, got %d\n", GetLastError());
+}
+
 static void testLoadLibraryEx(void)
 {
     CHAR path[MAX_PATH];
@@ -1113,8 +1190,11 @@ START_TEST(module)
 
     testLoadLibraryA();
     testNestedLoadLibraryA();
+    testGetModuleHandle_names();
     testLoadLibraryA_Wrong();
     testGetProcAddress_Wrong();
+    testGetProcAddress_exports("kernel32.dll");
+    testGetProcAddress_exports("ntdll.dll");
     testLoadLibraryEx();
     test_LoadLibraryEx_search_flags();
     testGetModuleHandleEx();
@@ -1056,14 +1056,34 @@ PTP_CLEANUP_GROUP WINAPI CreateThreadpoolCleanupGroup( void )
     return group;
 }
 
+static void CALLBACK tp_io_callback( TP_CALLBACK_INSTANCE *instance, void *userdata, void *cvalue,
+                                     IO_STATUS_BLOCK *iosb, TP_IO *io )
+{
+    PTP_WIN32_IO_CALLBACK callback = *(void **)io;
+    callback( instance, userdata, cvalue, RtlNtStatusToDosError( iosb->Status ), iosb->Information, io );
+}
+
 /***********************************************************************
  *              CreateThreadpoolIo (KERNEL32.@)
  */
 PTP_IO WINAPI CreateThreadpoolIo( HANDLE handle, PTP_WIN32_IO_CALLBACK callback,
                                   PVOID userdata, TP_CALLBACK_ENVIRON *environment )
 {
-    FIXME("(%p, %p, %p, %p): stub\n", handle, callback, userdata, environment);
-    return FALSE;
+    TP_IO *io;
+    NTSTATUS status;
+
+    TRACE( "%p, %p, %p, %p\n", handle, callback, userdata, environment );
+
+    status = TpAllocIoCompletion( &io, handle, tp_io_callback, userdata, environment );
+    if (status)
+    {
+        SetLastError( RtlNtStatusToDosError(status) );
+        return NULL;
+    }
+
+    /* ntdll leaves space for the win32 callback at the start of the object */
+    *(void **)io = callback;
+    return io;
 }
 
 /***********************************************************************
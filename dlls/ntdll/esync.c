@@ -398,6 +398,22 @@ static NTSTATUS get_object( HANDLE handle, struct esync **obj )
     return ret;
 }
 
+/* Threads hold this lock shared while they use the queue of a completion
+ * port, so that closing the port doesn't unmap the queue under them. */
+static RTL_SRWLOCK completion_lock = RTL_SRWLOCK_INIT;
+
+static void close_completion_queue( struct esync *obj )
+{
+    void *queue;
+
+    RtlAcquireSRWLockExclusive( &completion_lock );
+    queue = obj->shm;
+    obj->shm = NULL;
+    RtlReleaseSRWLockExclusive( &completion_lock );
+
+    if (queue) munmap( queue, sizeof(struct completion_queue) );
+}
+
 NTSTATUS esync_close( HANDLE handle )
 {
     UINT_PTR entry, idx = handle_to_index( handle, &entry );
@@ -406,8 +422,11 @@ NTSTATUS esync_close( HANDLE handle )
 
     if (entry < ESYNC_LIST_ENTRIES && esync_list[entry])
     {
-        if (interlocked_xchg((int *)&esync_list[entry][idx].type, 0))
+        enum esync_type type = interlocked_xchg((int *)&esync_list[entry][idx].type, 0);
+
+        if (type)
         {
+            if (type == ESYNC_COMPLETION) close_completion_queue( &esync_list[entry][idx] );
             efd_close( &esync_list[entry][idx] );
             return STATUS_SUCCESS;
         }
@@ -927,6 +946,31 @@ static void update_grabbed_object( struct esync *obj )
     }
 }
 
+/* Grab the APC fd if we don't already have it. */
+static void get_apc_fd(void)
+{
+    obj_handle_t fd_handle;
+    sigset_t sigset;
+    NTSTATUS ret;
+    int fd = -1;
+
+    if (ntdll_get_thread_data()->esync_apc_fd != -1) return;
+
+    server_enter_uninterrupted_section( &fd_cache_section, &sigset );
+    SERVER_START_REQ( get_esync_apc_fd )
+    {
+        if (!(ret = wine_server_call( req )))
+        {
+            fd = receive_fd( &fd_handle );
+            assert( fd_handle == GetCurrentThreadId() );
+        }
+    }
+    SERVER_END_REQ;
+    server_leave_uninterrupted_section( &fd_cache_section, &sigset );
+
+    ntdll_get_thread_data()->esync_apc_fd = fd;
+}
+
 /* A value of STATUS_NOT_IMPLEMENTED returned from this function means that we
  * need to delegate to server_select(). */
 static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles,
@@ -945,27 +989,7 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles,
     int i, j;
     int ret;
 
-    /* Grab the APC fd if we don't already have it. */
-    if (alertable && ntdll_get_thread_data()->esync_apc_fd == -1)
-    {
-        obj_handle_t fd_handle;
-        sigset_t sigset;
-        int fd = -1;
-
-        server_enter_uninterrupted_section( &fd_cache_section, &sigset );
-        SERVER_START_REQ( get_esync_apc_fd )
-        {
-            if (!(ret = wine_server_call( req )))
-            {
-                fd = receive_fd( &fd_handle );
-                assert( fd_handle == GetCurrentThreadId() );
-            }
-        }
-        SERVER_END_REQ;
-        server_leave_uninterrupted_section( &fd_cache_section, &sigset );
-
-        ntdll_get_thread_data()->esync_apc_fd = fd;
-    }
+    if (alertable) get_apc_fd();
 
     NtQuerySystemTime( &now );
     if (timeout)
@@ -1108,6 +1132,7 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles,
                 case ESYNC_AUTO_SERVER:
                 case ESYNC_MANUAL_SERVER:
                 case ESYNC_QUEUE:
+                case ESYNC_COMPLETION:
                     /* We can't wait on any of these. Fortunately I don't think
                      * they'll ever be uncontended anyway (at least, they won't be
                      * performance-critical). */
@@ -1150,7 +1175,8 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles,
 
                     if (obj)
                     {
-                        if (obj->type == ESYNC_MANUAL_EVENT || obj->type == ESYNC_MANUAL_SERVER)
+                        if (obj->type == ESYNC_MANUAL_EVENT || obj->type == ESYNC_MANUAL_SERVER ||
+                            obj->type == ESYNC_COMPLETION)
                         {
                             /* Don't grab the object, just check if it's signaled. */
                             if (fds[i].revents & POLLIN)
@@ -1432,3 +1458,300 @@ NTSTATUS esync_signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable,
 
     return esync_wait_objects( 1, &wait, TRUE, alertable, timeout );
 }
+
+
+/* Completion ports.
+ *
+ * Packets posted with NtSetIoCompletion() go to a queue shared between all
+ * processes that have a handle to the port, and packets generated by the server
+ * (i.e. from asynchronous I/O) go to the server's own list. Either way the
+ * poster adds one to the port's semaphore eventfd after queuing the packet, so
+ * a thread that reads one from the eventfd is guaranteed to find a packet in
+ * one of the two places. Only the latter needs a server call. Waits on the
+ * port handle itself poll the eventfd without reading it. */
+
+static NTSTATUS get_completion( HANDLE handle, struct esync **obj )
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    NTSTATUS ret = STATUS_SUCCESS;
+    obj_handle_t fd_handle;
+    sigset_t sigset;
+    void *queue;
+    int fd = -1, shared_fd = -1;
+
+    if ((*obj = get_cached_object( handle )))
+        return (*obj)->type == ESYNC_COMPLETION ? STATUS_SUCCESS : STATUS_OBJECT_TYPE_MISMATCH;
+
+    if ((INT_PTR)handle < 0) return STATUS_NOT_IMPLEMENTED;
+
+    server_enter_uninterrupted_section( &fd_cache_section, &sigset );
+    if (!(*obj = get_cached_object( handle )))
+    {
+        SERVER_START_REQ( get_esync_completion_fds )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            if (!(ret = wine_server_call( req )))
+            {
+                shared_fd = receive_fd( &fd_handle );
+                assert( wine_server_ptr_handle(fd_handle) == handle );
+                fd = receive_fd( &fd_handle );
+                assert( wine_server_ptr_handle(fd_handle) == handle );
+            }
+        }
+        SERVER_END_REQ;
+
+        if (!ret)
+        {
+            queue = mmap( NULL, sizeof(struct completion_queue), PROT_READ | PROT_WRITE,
+                          MAP_SHARED, shared_fd, 0 );
+            close( shared_fd );
+            if (queue == MAP_FAILED)
+            {
+                ERR("Failed to map completion queue: %s\n", strerror( errno ));
+                close( fd );
+                ret = STATUS_NOT_IMPLEMENTED;
+            }
+            else if (!(*obj = add_to_list( handle, ESYNC_COMPLETION, fd, queue )))
+            {
+                munmap( queue, sizeof(struct completion_queue) );
+                close( fd );
+                ret = STATUS_NOT_IMPLEMENTED;
+            }
+            else if ((*obj)->shm != queue)  /* the handle was cached in the meantime */
+            {
+                munmap( queue, sizeof(struct completion_queue) );
+                close( fd );
+            }
+        }
+    }
+    server_leave_uninterrupted_section( &fd_cache_section, &sigset );
+
+    if (!ret && (*obj)->type != ESYNC_COMPLETION) ret = STATUS_OBJECT_TYPE_MISMATCH;
+    if (ret) *obj = NULL;
+    return ret;
+#else
+    return STATUS_NOT_IMPLEMENTED;
+#endif
+}
+
+/* Get the queue of a port, holding the completion lock until
+ * unlock_completion_queue(); fails if the port has been closed. */
+static struct completion_queue *lock_completion_queue( struct esync *obj )
+{
+    RtlAcquireSRWLockShared( &completion_lock );
+    if (obj->type == ESYNC_COMPLETION && obj->shm) return obj->shm;
+    RtlReleaseSRWLockShared( &completion_lock );
+    return NULL;
+}
+
+static void unlock_completion_queue(void)
+{
+    RtlReleaseSRWLockShared( &completion_lock );
+}
+
+/* Add a packet to the shared queue; fails if the queue is full. */
+static BOOL completion_queue_push( struct completion_queue *queue, ULONG_PTR key, ULONG_PTR value,
+                                   NTSTATUS status, SIZE_T information )
+{
+    struct completion_queue_entry *entry;
+    unsigned int pos = queue->head, idx;
+    int diff, prev;
+
+    for (;;)
+    {
+        idx = pos & (COMPLETION_QUEUE_ENTRIES - 1);
+        entry = &queue->entries[idx];
+        diff = (int)(entry->seq + idx - pos);
+        if (!diff)
+        {
+            if ((prev = interlocked_cmpxchg( &queue->head, pos + 1, pos )) == (int)pos) break;
+            pos = prev;
+        }
+        else if (diff < 0)
+            return FALSE;
+        else
+            pos = queue->head;
+    }
+
+    entry->ckey        = key;
+    entry->cvalue      = value;
+    entry->status      = status;
+    entry->information = information;
+    interlocked_xchg( &entry->seq, pos + 1 - idx );
+    return TRUE;
+}
+
+/* Remove a packet from the shared queue; fails if the queue is empty. Any
+ * process holding the port can write to the queue, so don't wait forever for
+ * an entry which a dead or misbehaving process claimed but never filled. */
+static BOOL completion_queue_pop( struct completion_queue *queue, FILE_IO_COMPLETION_INFORMATION *info )
+{
+    struct completion_queue_entry *entry;
+    unsigned int pos = queue->tail, idx, tries = 0;
+    int diff, prev;
+
+    for (;;)
+    {
+        idx = pos & (COMPLETION_QUEUE_ENTRIES - 1);
+        entry = &queue->entries[idx];
+        diff = (int)(entry->seq + idx - (pos + 1));
+        if (!diff)
+        {
+            if ((prev = interlocked_cmpxchg( &queue->tail, pos + 1, pos )) == (int)pos) break;
+            pos = prev;
+        }
+        else if (diff < 0)
+        {
+            if (queue->head == (int)pos) return FALSE;
+            /* Someone claimed the entry but hasn't filled it yet. */
+            if (++tries > 1024) return FALSE;
+            NtYieldExecution();
+            pos = queue->tail;
+        }
+        else
+            pos = queue->tail;
+    }
+
+    info->CompletionKey             = entry->ckey;
+    info->CompletionValue           = entry->cvalue;
+    info->IoStatusBlock.u.Status    = entry->status;
+    info->IoStatusBlock.Information = entry->information;
+    interlocked_xchg( &entry->seq, pos + COMPLETION_QUEUE_ENTRIES - idx );
+    return TRUE;
+}
+
+/* We own count counts of the eventfd, so there are as many packets for us
+ * somewhere, but other threads may take the ones we see first. If we still
+ * can't find them after a while, give the remaining counts back, so that the
+ * eventfd keeps matching the number of queued packets and the packets are
+ * still picked up when they show up. */
+static ULONG get_completion_packets( HANDLE port, struct esync *obj, struct completion_queue *queue,
+                                     FILE_IO_COMPLETION_INFORMATION *info, ULONG count )
+{
+    unsigned int tries = 0;
+    ULONG i = 0, n;
+
+    while (i < count)
+    {
+        if (completion_queue_pop( queue, &info[i] ))
+            i++;
+        else if (!server_remove_completions( port, info + i, count - i, &n ))
+            i += n;
+        else if (++tries < 64)
+            NtYieldExecution();
+        else
+        {
+            WARN("Only found %u of %u packets for port %p, giving back the rest.\n", i, count, port);
+            if (efd_write( obj, count - i ) == -1)
+                ERR("write: %s\n", strerror(errno));
+            break;
+        }
+    }
+    return i;
+}
+
+NTSTATUS esync_set_io_completion( HANDLE port, ULONG_PTR key, ULONG_PTR value,
+                                  NTSTATUS status, SIZE_T information )
+{
+    struct completion_queue *queue;
+    struct esync *obj;
+    NTSTATUS ret;
+
+    TRACE("%p, %lx, %lx, %#x, %lu.\n", port, key, value, status, information);
+
+    if ((ret = get_completion( port, &obj ))) return ret;
+    if (!(queue = lock_completion_queue( obj ))) return STATUS_INVALID_HANDLE;
+
+    /* If the shared queue is full, let the server queue it. The eventfd also
+     * makes the port signaled for waits on the port handle itself. */
+    if (!completion_queue_push( queue, key, value, status, information ))
+        ret = STATUS_NOT_IMPLEMENTED;
+    else if (efd_write( obj, 1 ) == -1)
+        ERR("write: %s\n", strerror(errno));
+
+    unlock_completion_queue();
+    return ret;
+}
+
+NTSTATUS esync_remove_io_completion( HANDLE port, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
+                                     ULONG *written, const LARGE_INTEGER *timeout, BOOLEAN alertable )
+{
+    static const LARGE_INTEGER zero = {0};
+    struct completion_queue *queue;
+    struct pollfd fds[2];
+    struct esync *obj;
+    LARGE_INTEGER now;
+    ULONGLONG end = 0;
+    ULONG i = 0, owned;
+    NTSTATUS ret;
+    int pollret;
+
+    TRACE("%p, %p, %u, %p, %p, %u.\n", port, info, count, written, timeout, alertable);
+
+    if ((ret = get_completion( port, &obj ))) return ret;
+
+    if (alertable) get_apc_fd();
+
+    NtQuerySystemTime( &now );
+    if (timeout)
+    {
+        if (timeout->QuadPart == TIMEOUT_INFINITE)
+            timeout = NULL;
+        else if (timeout->QuadPart >= 0)
+            end = timeout->QuadPart;
+        else
+            end = now.QuadPart - timeout->QuadPart;
+    }
+
+    fds[0].fd = get_read_fd( obj );
+    fds[0].events = POLLIN;
+    fds[1].fd = ntdll_get_thread_data()->esync_apc_fd;
+    fds[1].events = POLLIN;
+
+    for (;;)
+    {
+        owned = 0;
+        while (i + owned < count && efd_read( obj ) > 0) owned++;
+        if (owned)
+        {
+            if (!(queue = lock_completion_queue( obj )))
+            {
+                TRACE("Port %p was closed.\n", port);
+                ret = STATUS_ABANDONED_WAIT_0;
+                break;
+            }
+            i += get_completion_packets( port, obj, queue, info + i, owned );
+            unlock_completion_queue();
+        }
+        if (i)
+        {
+            TRACE("Removed %u packets.\n", i);
+            break;
+        }
+
+        pollret = do_poll( fds, alertable ? 2 : 1, timeout ? &end : NULL );
+        if (!pollret)
+        {
+            TRACE("Wait timed out.\n");
+            ret = STATUS_TIMEOUT;
+            break;
+        }
+        if (pollret < 0)
+        {
+            ERR("ppoll failed: %s\n", strerror(errno));
+            ret = FILE_GetNtStatus();
+            break;
+        }
+        if (alertable && (fds[1].revents & POLLIN))
+        {
+            TRACE("Woken up by user APC.\n");
+            ret = server_select( NULL, 0, SELECT_INTERRUPTIBLE | SELECT_ALERTABLE, &zero );
+            if (ret == STATUS_TIMEOUT) ret = STATUS_USER_APC;
+            break;
+        }
+    }
+
+    /* same as the server path */
+    *written = i ? i : 1;
+    return ret;
+}
@@ -51,6 +51,11 @@ extern NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN
 extern NTSTATUS esync_signal_and_wait( HANDLE signal, HANDLE wait,
     BOOLEAN alertable, const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
 
+extern NTSTATUS esync_set_io_completion( HANDLE port, ULONG_PTR key, ULONG_PTR value,
+    NTSTATUS status, SIZE_T information ) DECLSPEC_HIDDEN;
+extern NTSTATUS esync_remove_io_completion( HANDLE port, FILE_IO_COMPLETION_INFORMATION *info,
+    ULONG count, ULONG *written, const LARGE_INTEGER *timeout, BOOLEAN alertable ) DECLSPEC_HIDDEN;
+
 
 /* We have to synchronize on the fd cache CS so that our calls to receive_fd
  * don't race with theirs. It looks weird, I know.
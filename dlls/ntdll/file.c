@@ -103,6 +103,7 @@
 #include "wine/debug.h"
 #include "wine/server.h"
 #include "ntdll_misc.h"
+#include "uring.h"
 
 #include "winternl.h"
 #include "winioctl.h"
@@ -863,6 +864,11 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
 
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
+            if (async_read && do_uring() &&
+                (status = uring_queue_io( hFile, unix_handle, type, TRUE, hEvent, apc, apc_user, io_status,
+                                          buffer, 0, length, offset->QuadPart, FALSE )) != STATUS_NOT_IMPLEMENTED)
+                goto err;
+
             /* async I/O doesn't make sense on regular files */
             while ((result = virtual_locked_pread( unix_handle, buffer, length, offset->QuadPart )) == -1)
             {
@@ -955,6 +961,10 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
                 status = STATUS_SUCCESS;
                 goto done;
             }
+            if (do_uring() &&
+                (status = uring_queue_io( hFile, unix_handle, type, TRUE, hEvent, apc, apc_user,
+                                          io_status, buffer, total, length, 0, avail_mode )) != STATUS_NOT_IMPLEMENTED)
+                goto err;
             status = register_async_file_read( hFile, hEvent, apc, apc_user, io_status,
                                                buffer, total, length, avail_mode );
             goto err;
@@ -1268,6 +1278,11 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
                 goto done;
             }
 
+            if (async_write && do_uring() &&
+                (status = uring_queue_io( hFile, unix_handle, type, FALSE, hEvent, apc, apc_user, io_status,
+                                          (void *)buffer, 0, length, off, FALSE )) != STATUS_NOT_IMPLEMENTED)
+                goto err;
+
             /* async I/O doesn't make sense on regular files */
             while ((result = pwrite( unix_handle, buffer, length, off )) == -1)
             {
@@ -1331,6 +1346,11 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
         {
             struct async_fileio_write *fileio;
 
+            if (do_uring() &&
+                (status = uring_queue_io( hFile, unix_handle, type, FALSE, hEvent, apc, apc_user,
+                                          io_status, (void *)buffer, total, length, 0, FALSE )) != STATUS_NOT_IMPLEMENTED)
+                goto err;
+
             fileio = (struct async_fileio_write *)alloc_fileio( sizeof(*fileio), FILE_AsyncWriteService, hFile );
             if (!fileio)
             {
@@ -3544,8 +3564,12 @@ NTSTATUS WINAPI NtDeleteFile( POBJECT_ATTRIBUTES ObjectAttributes )
  */
 NTSTATUS WINAPI NtCancelIoFileEx( HANDLE hFile, PIO_STATUS_BLOCK iosb, PIO_STATUS_BLOCK io_status )
 {
+    BOOL found = FALSE;
+
     TRACE("%p %p %p\n", hFile, iosb, io_status );
 
+    if (do_uring()) found = uring_cancel_io( hFile, iosb, FALSE );
+
     SERVER_START_REQ( cancel_async )
     {
         req->handle      = wine_server_obj_handle( hFile );
@@ -3554,6 +3578,7 @@ NTSTATUS WINAPI NtCancelIoFileEx( HANDLE hFile, PIO_STATUS_BLOCK iosb, PIO_STATU
         io_status->u.Status = wine_server_call( req );
     }
     SERVER_END_REQ;
+    if (found && io_status->u.Status == STATUS_NOT_FOUND) io_status->u.Status = STATUS_SUCCESS;
 
     return io_status->u.Status;
 }
@@ -3565,8 +3590,12 @@ NTSTATUS WINAPI NtCancelIoFileEx( HANDLE hFile, PIO_STATUS_BLOCK iosb, PIO_STATU
  */
 NTSTATUS WINAPI NtCancelIoFile( HANDLE hFile, PIO_STATUS_BLOCK io_status )
 {
+    BOOL found = FALSE;
+
     TRACE("%p %p\n", hFile, io_status );
 
+    if (do_uring()) found = uring_cancel_io( hFile, NULL, TRUE );
+
     SERVER_START_REQ( cancel_async )
     {
         req->handle      = wine_server_obj_handle( hFile );
@@ -3575,6 +3604,7 @@ NTSTATUS WINAPI NtCancelIoFile( HANDLE hFile, PIO_STATUS_BLOCK io_status )
         io_status->u.Status = wine_server_call( req );
     }
     SERVER_END_REQ;
+    if (found && io_status->u.Status == STATUS_NOT_FOUND) io_status->u.Status = STATUS_SUCCESS;
 
     return io_status->u.Status;
 }
@@ -24,9 +24,15 @@
 
 #include <assert.h>
 #include <stdarg.h>
+#ifdef HAVE_DLFCN_H
+# include <dlfcn.h>
+#endif
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -99,11 +105,29 @@ typedef struct _wine_modref
     LDR_MODULE            ldr;
     dev_t                 dev;
     ino_t                 ino;
+    ULONGLONG             ctime;           /* file change time, in 100ns units */
     int                   alloc_deps;
     int                   nDeps;
     struct _wine_modref **deps;
+    struct list           basename_entry;  /* entry in basename_hash */
+    struct list           fullname_entry;  /* entry in fullname_hash */
+    struct list           fileid_entry;    /* entry in fileid_hash */
+    struct list           base_entry;      /* entry in base_hash */
+    DWORD                *export_hash;     /* hash table of export name indices, built on demand */
+    DWORD                 export_hash_mask;
 } WINE_MODREF;
 
+/* hash tables of loaded modules, keyed on case-folded names and file id */
+#define MODULE_HASH_SIZE 128
+
+static struct list basename_hash[MODULE_HASH_SIZE];
+static struct list fullname_hash[MODULE_HASH_SIZE];
+static struct list fileid_hash[MODULE_HASH_SIZE];
+static struct list base_hash[MODULE_HASH_SIZE];
+
+/* minimum number of exported names for building an export hash table */
+#define MIN_EXPORT_HASH_NAMES 16
+
 /* info about the current builtin dll load */
 /* used to keep track of things across the register_dll constructor call */
 struct builtin_load_info
@@ -134,12 +158,82 @@ static WINE_MODREF *cached_modref;
 static WINE_MODREF *current_modref;
 static WINE_MODREF *last_failed_modref;
 
+/* loader phases for the +loaddll startup timing report */
+enum load_phase
+{
+    LOAD_PHASE_OTHER,
+    LOAD_PHASE_MAP,
+    LOAD_PHASE_RELOCATE,
+    LOAD_PHASE_IMPORTS,
+    LOAD_PHASE_INIT,
+    NB_LOAD_PHASES
+};
+
+static const char * const load_phase_names[NB_LOAD_PHASES] =
+{
+    "other", "map", "relocate", "imports", "init"
+};
+
+static ULONGLONG load_phase_time[NB_LOAD_PHASES];
+static ULONGLONG load_phase_start;
+static enum load_phase current_load_phase;
+static unsigned int bound_import_count;
+static unsigned int cached_import_count;
+
+/* dll images mapped and relocated ahead of time on the thread pool */
+enum prefetch_state
+{
+    PREFETCH_QUEUED,                 /* in the work queue */
+    PREFETCH_RUNNING,                /* being processed by a worker */
+    PREFETCH_CANCELLED,              /* no longer needed, freed by the worker when done */
+    PREFETCH_DONE                    /* results are available */
+};
+
+struct prefetch_dll
+{
+    struct list         entry;       /* entry in the work queue */
+    struct list         batch_entry; /* entry in prefetched_dlls */
+    const void         *batch;       /* fixup_imports batch that requested it */
+    LPCWSTR             load_path;
+    WCHAR              *name;        /* dll name to search for, as returned by get_dll_search_name */
+    enum prefetch_state state;       /* protected by loader_work_section */
+    UNICODE_STRING      nt_name;     /* file that was found */
+    void               *module;      /* image mapping, or NULL if nothing was found */
+    pe_image_info_t     image_info;
+    struct stat         st;
+    BOOL                relocated;   /* relocations have been applied already */
+};
+
+static struct list prefetched_dlls = LIST_INIT( prefetched_dlls );
+static struct list loader_work_queue = LIST_INIT( loader_work_queue );
+static unsigned int loader_worker_count;   /* max number of pool callbacks, 0 to load sequentially */
+static void *prefetched_module;           /* image that was just taken from prefetched_dlls */
+
+static RTL_CRITICAL_SECTION loader_work_section;
+static RTL_CRITICAL_SECTION_DEBUG loader_work_critsect_debug =
+{
+    0, 0, &loader_work_section,
+    { &loader_work_critsect_debug.ProcessLocksList, &loader_work_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": loader_work_section") }
+};
+static RTL_CRITICAL_SECTION loader_work_section = { &loader_work_critsect_debug, -1, 0, 0, 0, 0 };
+
 static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_MODREF** pwm );
+static void prefetch_imports( const void *batch, HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *imports,
+                              int nb_imports, LPCWSTR load_path );
+static void discard_prefetched_dlls( const void *batch );
+static NTSTATUS get_dll_search_name( const WCHAR *libname, const WCHAR **search, WCHAR **buffer,
+                                     WINE_MODREF **pwm );
+static NTSTATUS search_dll_file( LPCWSTR paths, LPCWSTR search, UNICODE_STRING *nt_name,
+                                 WINE_MODREF **pwm, void **module, pe_image_info_t *image_info,
+                                 struct stat *st, BOOL prefetch );
 static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved );
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
-                                    DWORD exp_size, DWORD ordinal, LPCWSTR load_path );
+                                    DWORD exp_size, DWORD ordinal, LPCWSTR load_path,
+                                    HMODULE *export_module );
 static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
-                                  DWORD exp_size, const char *name, int hint, LPCWSTR load_path );
+                                  DWORD exp_size, const char *name, int hint, LPCWSTR load_path,
+                                  HMODULE *export_module );
 
 /* convert PE image VirtualAddress to Real Address */
 static inline void *get_rva( HMODULE module, DWORD va )
@@ -159,6 +253,21 @@ static inline void ascii_to_unicode( WCHAR *dst, const char *src, size_t len )
     while (len--) *dst++ = (unsigned char)*src++;
 }
 
+/* switch to a new loader phase, accounting the elapsed time to the previous one */
+static enum load_phase set_load_phase( enum load_phase phase )
+{
+    enum load_phase prev = current_load_phase;
+    LARGE_INTEGER now;
+
+    if (!TRACE_ON(loaddll)) return prev;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    if (load_phase_start) load_phase_time[prev] += now.QuadPart - load_phase_start;
+    load_phase_start = now.QuadPart;
+    current_load_phase = phase;
+    return prev;
+}
+
 #define RTL_UNLOAD_EVENT_TRACE_NUMBER 64
 
 typedef struct _RTL_UNLOAD_EVENT_TRACE
@@ -426,6 +535,99 @@ static void call_ldr_notifications( ULONG reason, LDR_MODULE *module )
     }
 }
 
+/* get a module hash bucket, initializing it on first use */
+static inline struct list *get_module_hash_bucket( struct list *table, unsigned int hash )
+{
+    struct list *bucket = &table[hash % MODULE_HASH_SIZE];
+    if (!bucket->next) list_init( bucket );
+    return bucket;
+}
+
+/* hash a base name the same way strcmpiW compares it */
+static unsigned int hash_basename( const WCHAR *name )
+{
+    unsigned int hash = 0;
+    while (*name) hash = hash * 65599 + tolowerW( *name++ );
+    return hash;
+}
+
+/* hash a full name the same way RtlEqualUnicodeString compares it */
+static unsigned int hash_fullname( const UNICODE_STRING *name )
+{
+    unsigned int i, hash = 0;
+    for (i = 0; i < name->Length / sizeof(WCHAR); i++) hash = hash * 65599 + toupperW( name->Buffer[i] );
+    return hash;
+}
+
+static inline unsigned int hash_fileid( dev_t dev, ino_t ino )
+{
+    return (unsigned int)ino ^ ((unsigned int)dev * 2654435761u);
+}
+
+/* modules are always 64k-aligned */
+static inline unsigned int hash_base( HMODULE module )
+{
+    return (ULONG_PTR)module >> 16;
+}
+
+
+/**********************************************************************
+ *	    add_module_hash
+ *
+ * Add a module to the name and base address hash tables.
+ * The loader_section must be locked while calling this function
+ */
+static void add_module_hash( WINE_MODREF *wm )
+{
+    list_add_tail( get_module_hash_bucket( base_hash, hash_base( wm->ldr.BaseAddress )), &wm->base_entry );
+    list_add_tail( get_module_hash_bucket( basename_hash, hash_basename( wm->ldr.BaseDllName.Buffer )),
+                   &wm->basename_entry );
+    list_add_tail( get_module_hash_bucket( fullname_hash, hash_fullname( &wm->ldr.FullDllName )),
+                   &wm->fullname_entry );
+}
+
+
+/**********************************************************************
+ *	    set_module_fileid
+ *
+ * Set the file id of a module and add it to the file id hash table.
+ * The loader_section must be locked while calling this function
+ */
+static void set_module_fileid( WINE_MODREF *wm, const struct stat *st )
+{
+    wm->dev = st->st_dev;
+    wm->ino = st->st_ino;
+    wm->ctime = (ULONGLONG)st->st_ctime * 10000000;
+#ifdef HAVE_STRUCT_STAT_ST_CTIM
+    wm->ctime += st->st_ctim.tv_nsec / 100;
+#elif defined(HAVE_STRUCT_STAT_ST_CTIMESPEC)
+    wm->ctime += st->st_ctimespec.tv_nsec / 100;
+#endif
+    list_remove( &wm->fileid_entry );
+    list_add_tail( get_module_hash_bucket( fileid_hash, hash_fileid( wm->dev, wm->ino )),
+                   &wm->fileid_entry );
+}
+
+
+/**********************************************************************
+ *	    remove_module_hash
+ *
+ * Remove a module from all the hash tables.
+ * The loader_section must be locked while calling this function
+ */
+static void remove_module_hash( WINE_MODREF *wm )
+{
+    list_remove( &wm->basename_entry );
+    list_remove( &wm->fullname_entry );
+    list_remove( &wm->fileid_entry );
+    list_remove( &wm->base_entry );
+    list_init( &wm->basename_entry );
+    list_init( &wm->fullname_entry );
+    list_init( &wm->fileid_entry );
+    list_init( &wm->base_entry );
+}
+
+
 /*************************************************************************
  *		get_modref
  *
@@ -434,17 +636,15 @@ static void call_ldr_notifications( ULONG reason, LDR_MODULE *module )
  */
 static WINE_MODREF *get_modref( HMODULE hmod )
 {
-    PLIST_ENTRY mark, entry;
-    PLDR_MODULE mod;
+    struct list *bucket;
+    WINE_MODREF *wm;
 
     if (cached_modref && cached_modref->ldr.BaseAddress == hmod) return cached_modref;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    bucket = get_module_hash_bucket( base_hash, hash_base( hmod ));
+    LIST_FOR_EACH_ENTRY( wm, bucket, WINE_MODREF, base_entry )
     {
-        mod = CONTAINING_RECORD(entry, LDR_MODULE, InMemoryOrderModuleList);
-        if (mod->BaseAddress == hmod)
-            return cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
+        if (wm->ldr.BaseAddress == hmod) return cached_modref = wm;
     }
     return NULL;
 }
@@ -458,19 +658,15 @@ static WINE_MODREF *get_modref( HMODULE hmod )
  */
 static WINE_MODREF *find_basename_module( LPCWSTR name )
 {
-    PLIST_ENTRY mark, entry;
-
-    if (cached_modref && !strcmpiW( name, cached_modref->ldr.BaseDllName.Buffer ))
-        return cached_modref;
+    struct list *bucket = get_module_hash_bucket( basename_hash, hash_basename( name ));
+    WINE_MODREF *wm;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    LIST_FOR_EACH_ENTRY( wm, bucket, WINE_MODREF, basename_entry )
     {
-        LDR_MODULE *mod = CONTAINING_RECORD(entry, LDR_MODULE, InLoadOrderModuleList);
-        if (!strcmpiW( name, mod->BaseDllName.Buffer ))
+        if (!strcmpiW( name, wm->ldr.BaseDllName.Buffer ))
         {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
-            return cached_modref;
+            cached_modref = wm;
+            return wm;
         }
     }
     return NULL;
@@ -485,24 +681,21 @@ static WINE_MODREF *find_basename_module( LPCWSTR name )
  */
 static WINE_MODREF *find_fullname_module( const UNICODE_STRING *nt_name )
 {
-    PLIST_ENTRY mark, entry;
+    struct list *bucket;
     UNICODE_STRING name = *nt_name;
+    WINE_MODREF *wm;
 
     if (name.Length <= 4 * sizeof(WCHAR)) return NULL;
     name.Length -= 4 * sizeof(WCHAR);  /* for \??\ prefix */
     name.Buffer += 4;
 
-    if (cached_modref && RtlEqualUnicodeString( &name, &cached_modref->ldr.FullDllName, TRUE ))
-        return cached_modref;
-
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    bucket = get_module_hash_bucket( fullname_hash, hash_fullname( &name ));
+    LIST_FOR_EACH_ENTRY( wm, bucket, WINE_MODREF, fullname_entry )
     {
-        LDR_MODULE *mod = CONTAINING_RECORD(entry, LDR_MODULE, InLoadOrderModuleList);
-        if (RtlEqualUnicodeString( &name, &mod->FullDllName, TRUE ))
+        if (RtlEqualUnicodeString( &name, &wm->ldr.FullDllName, TRUE ))
         {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
-            return cached_modref;
+            cached_modref = wm;
+            return wm;
         }
     }
     return NULL;
@@ -517,17 +710,11 @@ static WINE_MODREF *find_fullname_module( const UNICODE_STRING *nt_name )
  */
 static WINE_MODREF *find_fileid_module( struct stat *st )
 {
-    LIST_ENTRY *mark, *entry;
-
-    if (cached_modref && cached_modref->dev == st->st_dev && cached_modref->ino == st->st_ino)
-        return cached_modref;
+    struct list *bucket = get_module_hash_bucket( fileid_hash, hash_fileid( st->st_dev, st->st_ino ));
+    WINE_MODREF *wm;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    LIST_FOR_EACH_ENTRY( wm, bucket, WINE_MODREF, fileid_entry )
     {
-        LDR_MODULE *mod = CONTAINING_RECORD( entry, LDR_MODULE, InLoadOrderModuleList );
-        WINE_MODREF *wm = CONTAINING_RECORD( mod, WINE_MODREF, ldr );
-
         if (wm->dev == st->st_dev && wm->ino == st->st_ino)
         {
             cached_modref = wm;
@@ -542,9 +729,11 @@ static WINE_MODREF *find_fileid_module( struct stat *st )
  *		find_forwarded_export
  *
  * Find the final function pointer for a forwarded function.
+ * If export_module is not NULL, it receives the module that contains the final function.
  * The loader_section must be locked while calling this function.
  */
-static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWSTR load_path )
+static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWSTR load_path,
+                                      HMODULE *export_module )
 {
     const IMAGE_EXPORT_DIRECTORY *exports;
     DWORD exp_size;
@@ -603,9 +792,11 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
     {
         const char *name = end + 1;
         if (*name == '#')  /* ordinal */
-            proc = find_ordinal_export( wm->ldr.BaseAddress, exports, exp_size, atoi(name+1), load_path );
+            proc = find_ordinal_export( wm->ldr.BaseAddress, exports, exp_size, atoi(name+1),
+                                        load_path, export_module );
         else
-            proc = find_named_export( wm->ldr.BaseAddress, exports, exp_size, name, -1, load_path );
+            proc = find_named_export( wm->ldr.BaseAddress, exports, exp_size, name, -1,
+                                      load_path, export_module );
     }
 
     if (!proc)
@@ -624,10 +815,12 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
  *
  * Find an exported function by ordinal.
  * The exports base must have been subtracted from the ordinal already.
+ * If export_module is not NULL, it receives the module that contains the function.
  * The loader_section must be locked while calling this function.
  */
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
-                                    DWORD exp_size, DWORD ordinal, LPCWSTR load_path )
+                                    DWORD exp_size, DWORD ordinal, LPCWSTR load_path,
+                                    HMODULE *export_module )
 {
     FARPROC proc;
     const DWORD *functions = get_rva( module, exports->AddressOfFunctions );
@@ -644,7 +837,9 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
     /* if the address falls into the export dir, it's a forward */
     if (((const char *)proc >= (const char *)exports) && 
         ((const char *)proc < (const char *)exports + exp_size))
-        return find_forwarded_export( module, (const char *)proc, load_path );
+        return find_forwarded_export( module, (const char *)proc, load_path, export_module );
+
+    if (export_module) *export_module = module;
 
     if (TRACE_ON(snoop))
     {
@@ -660,6 +855,50 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+/*************************************************************************
+ *		hash_export_name
+ */
+static inline unsigned int hash_export_name( const char *name )
+{
+    unsigned int hash = 2166136261u;
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		build_export_hash
+ *
+ * Build the hash table of exported names for a module, if not done already.
+ * The table uses open addressing and stores name indices plus one.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL build_export_hash( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    const DWORD *names = get_rva( wm->ldr.BaseAddress, exports->AddressOfNames );
+    unsigned int i, pos, size = 16;
+
+    if (wm->export_hash) return TRUE;
+    if (exports->NumberOfNames < MIN_EXPORT_HASH_NAMES) return FALSE;
+
+    while (size < 2 * exports->NumberOfNames) size *= 2;
+    if (!(wm->export_hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                             size * sizeof(*wm->export_hash) )))
+        return FALSE;
+    wm->export_hash_mask = size - 1;
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        pos = hash_export_name( get_rva( wm->ldr.BaseAddress, names[i] )) & wm->export_hash_mask;
+        while (wm->export_hash[pos]) pos = (pos + 1) & wm->export_hash_mask;
+        wm->export_hash[pos] = i + 1;
+    }
+    TRACE( "built export hash for %s, %u names\n", debugstr_w(wm->ldr.BaseDllName.Buffer),
+           exports->NumberOfNames );
+    return TRUE;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
@@ -667,18 +906,38 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
  * The loader_section must be locked while calling this function.
  */
 static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
-                                  DWORD exp_size, const char *name, int hint, LPCWSTR load_path )
+                                  DWORD exp_size, const char *name, int hint, LPCWSTR load_path,
+                                  HMODULE *export_module )
 {
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
     int min = 0, max = exports->NumberOfNames - 1;
+    WINE_MODREF *wm;
 
     /* first check the hint */
     if (hint >= 0 && hint <= max)
     {
         char *ename = get_rva( module, names[hint] );
         if (!strcmp( ename, name ))
-            return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
+            return find_ordinal_export( module, exports, exp_size, ordinals[hint],
+                                        load_path, export_module );
+    }
+
+    /* then look it up in the export hash table */
+    if ((wm = get_modref( module )) && build_export_hash( wm, exports ))
+    {
+        unsigned int pos;
+
+        for (pos = hash_export_name( name ) & wm->export_hash_mask; wm->export_hash[pos];
+             pos = (pos + 1) & wm->export_hash_mask)
+        {
+            DWORD index = wm->export_hash[pos] - 1;
+            char *ename = get_rva( module, names[index] );
+            if (!strcmp( ename, name ))
+                return find_ordinal_export( module, exports, exp_size, ordinals[index],
+                                            load_path, export_module );
+        }
+        return NULL;
     }
 
     /* then do a binary search */
@@ -687,7 +946,8 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
         int res, pos = (min + max) / 2;
         char *ename = get_rva( module, names[pos] );
         if (!(res = strcmp( ename, name )))
-            return find_ordinal_export( module, exports, exp_size, ordinals[pos], load_path );
+            return find_ordinal_export( module, exports, exp_size, ordinals[pos],
+                                        load_path, export_module );
         if (res > 0) max = pos - 1;
         else min = pos + 1;
     }
@@ -696,13 +956,482 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
 }
 
 
+/*************************************************************************
+ *		is_bound_module
+ *
+ * Check that a module is the one an import was bound to, and is loaded at its preferred base.
+ */
+static BOOL is_bound_module( const WINE_MODREF *wm, DWORD timestamp )
+{
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( wm->ldr.BaseAddress );
+
+    if (wm->ldr.Flags & LDR_WINE_INTERNAL) return FALSE;
+    return nt->FileHeader.TimeDateStamp == timestamp &&
+           (ULONG_PTR)wm->ldr.BaseAddress == nt->OptionalHeader.ImageBase;
+}
+
+
+/*************************************************************************
+ *		check_bound_import
+ *
+ * Check whether the bound import address table of a module for a given dll is still valid,
+ * in which case it doesn't need to be resolved again.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL check_bound_import( HMODULE module, const char *name, DWORD len, const WINE_MODREF *imp )
+{
+    const IMAGE_BOUND_IMPORT_DESCRIPTOR *bound, *descr;
+    const IMAGE_BOUND_FORWARDER_REF *ref;
+    WCHAR buffer[32];
+    WINE_MODREF *wm;
+    const char *ref_name;
+    DWORD i, size;
+
+    if (TRACE_ON(snoop)) return FALSE;
+    if (!(bound = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT, &size )))
+        return FALSE;
+
+    descr = bound;
+    while (descr->OffsetModuleName)
+    {
+        ref = (const IMAGE_BOUND_FORWARDER_REF *)(descr + 1);
+        if (!_strnicmp( (const char *)bound + descr->OffsetModuleName, name, len ) &&
+            !((const char *)bound)[descr->OffsetModuleName + len])
+        {
+            if (!is_bound_module( imp, descr->TimeDateStamp )) return FALSE;
+
+            /* the modules targeted by forwarded exports must match too */
+            for (i = 0; i < descr->NumberOfModuleForwarderRefs; i++)
+            {
+                ref_name = (const char *)bound + ref[i].OffsetModuleName;
+                if (strlen( ref_name ) >= ARRAY_SIZE(buffer)) return FALSE;
+                ascii_to_unicode( buffer, ref_name, strlen( ref_name ) + 1 );
+                if (!(wm = find_basename_module( buffer ))) return FALSE;
+                if (!is_bound_module( wm, ref[i].TimeDateStamp )) return FALSE;
+            }
+            return TRUE;
+        }
+        descr = (const IMAGE_BOUND_IMPORT_DESCRIPTOR *)(ref + descr->NumberOfModuleForwarderRefs);
+    }
+    return FALSE;
+}
+
+
+/* persistent cache of resolved imports, stored in the prefix */
+
+#define IMPORT_CACHE_MAGIC   0x43504d49  /* "IMPC" */
+#define IMPORT_CACHE_VERSION 1
+#define IMPORT_CACHE_NONE    ~0u
+
+/* identity of a module file; the cache is only used if all the modules still match it */
+struct import_cache_module
+{
+    ULONGLONG dev;
+    ULONGLONG ino;
+    ULONGLONG ctime;
+    DWORD     timestamp;       /* TimeDateStamp of the PE header */
+    DWORD     size;            /* SizeOfImage of the PE header */
+};
+
+struct import_cache_header
+{
+    DWORD                      magic;
+    DWORD                      version;
+    DWORD                      nb_modules;
+    DWORD                      nb_descr;
+    DWORD                      nb_entries;
+    DWORD                      pad;
+    struct import_cache_module self;  /* the importing module */
+};
+
+struct import_cache_descr
+{
+    DWORD module;              /* module table index of the imported dll */
+    DWORD first;               /* index of the first entry */
+    DWORD count;               /* number of entries, IMPORT_CACHE_NONE if not cached */
+};
+
+struct import_cache_entry
+{
+    DWORD    module;           /* module table index of the module containing the function */
+    DWORD    pad;
+    LONGLONG offset;           /* address of the function relative to the module base */
+};
+
+struct import_cache
+{
+    void                             *data;         /* contents of the cache file */
+    SIZE_T                            size;         /* size of the cache file */
+    const struct import_cache_header *header;       /* NULL if there is no valid cache file */
+    const struct import_cache_module *modules;
+    const struct import_cache_descr  *descr;
+    const struct import_cache_entry  *entries;
+    WINE_MODREF                     **loaded;       /* loaded modules matching the module table */
+    BOOL                              dirty;        /* new results need to be saved */
+    /* imports resolved during this load */
+    WINE_MODREF                     **rec_modules;
+    unsigned int                      nb_rec_modules;
+    unsigned int                      alloc_rec_modules;
+    struct import_cache_descr        *rec_descr;
+    unsigned int                      nb_rec_descr;
+    struct import_cache_entry        *rec_entries;
+    unsigned int                      nb_rec_entries;
+    unsigned int                      alloc_rec_entries;
+};
+
+
+/*************************************************************************
+ *		get_import_cache_id
+ *
+ * Get the identity of a module file as stored in the import cache.
+ */
+static BOOL get_import_cache_id( const WINE_MODREF *wm, struct import_cache_module *id )
+{
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( wm->ldr.BaseAddress );
+
+    if (!wm->ino) return FALSE;  /* no file id */
+    id->dev       = wm->dev;
+    id->ino       = wm->ino;
+    id->ctime     = wm->ctime;
+    id->timestamp = nt->FileHeader.TimeDateStamp;
+    id->size      = nt->OptionalHeader.SizeOfImage;
+    return TRUE;
+}
+
+
+/*************************************************************************
+ *		get_import_cache_path
+ *
+ * Build the unix name of the import cache file of a module.
+ * The returned buffer must be freed by the caller.
+ */
+static char *get_import_cache_path( const WINE_MODREF *wm, BOOL create_dir )
+{
+    static const char dirA[] = "/importcache";
+    const char *config_dir = wine_get_config_dir();
+    ULONGLONG dev = wm->dev, ino = wm->ino;
+    char *path;
+
+    if (!(path = RtlAllocateHeap( GetProcessHeap(), 0, strlen(config_dir) + sizeof(dirA) + 40 )))
+        return NULL;
+    strcpy( path, config_dir );
+    strcat( path, dirA );
+    if (create_dir) mkdir( path, 0777 );
+    sprintf( path + strlen(path), "/%x%08x-%x%08x", (DWORD)(dev >> 32), (DWORD)dev,
+             (DWORD)(ino >> 32), (DWORD)ino );
+    return path;
+}
+
+
+/*************************************************************************
+ *		load_import_cache
+ *
+ * Load the import cache of a module, if it is still valid for it.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL load_import_cache( const WINE_MODREF *wm, struct import_cache *cache, int nb_imports )
+{
+    const struct import_cache_header *header;
+    struct import_cache_module id;
+    struct stat st;
+    char *path;
+    int i, fd;
+    ULONGLONG size;
+
+    memset( cache, 0, sizeof(*cache) );
+    if (TRACE_ON(relay) || TRACE_ON(snoop)) return FALSE;  /* thunks depend on the debug channels */
+    if (!get_import_cache_id( wm, &id )) return FALSE;
+
+    if (!(cache->rec_descr = RtlAllocateHeap( GetProcessHeap(), 0, nb_imports * sizeof(*cache->rec_descr) )))
+        return FALSE;
+    for (i = 0; i < nb_imports; i++) cache->rec_descr[i].count = IMPORT_CACHE_NONE;
+    cache->nb_rec_descr = nb_imports;
+
+    if (!(path = get_import_cache_path( wm, FALSE ))) return TRUE;
+    fd = open( path, O_RDONLY );
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+    if (fd == -1) return TRUE;
+
+    if (fstat( fd, &st ) == -1 || st.st_size < sizeof(*header) || st.st_size > 0x1000000) goto done;
+    if (!(cache->data = RtlAllocateHeap( GetProcessHeap(), 0, st.st_size ))) goto done;
+    if (read( fd, cache->data, st.st_size ) != st.st_size) goto done;
+
+    header = cache->data;
+    if (header->magic != IMPORT_CACHE_MAGIC || header->version != IMPORT_CACHE_VERSION) goto done;
+    if (memcmp( &header->self, &id, sizeof(id) ) || header->nb_descr != nb_imports) goto done;
+    size = sizeof(*header) + (ULONGLONG)header->nb_modules * sizeof(*cache->modules) +
+           (ULONGLONG)header->nb_descr * sizeof(*cache->descr) +
+           (ULONGLONG)header->nb_entries * sizeof(*cache->entries);
+    if (size != st.st_size) goto done;
+    if (!(cache->loaded = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                           header->nb_modules * sizeof(*cache->loaded) )))
+        goto done;
+
+    cache->modules = (const struct import_cache_module *)(header + 1);
+    cache->descr   = (const struct import_cache_descr *)(cache->modules + header->nb_modules);
+    cache->entries = (const struct import_cache_entry *)(cache->descr + header->nb_descr);
+    cache->header  = header;
+    cache->size    = st.st_size;
+
+done:
+    close( fd );
+    return TRUE;
+}
+
+
+/*************************************************************************
+ *		get_import_cache_module
+ *
+ * Find the loaded module matching an entry of the import cache module table.
+ * The loader_section must be locked while calling this function.
+ */
+static WINE_MODREF *get_import_cache_module( struct import_cache *cache, DWORD index )
+{
+    const struct import_cache_module *id;
+    struct import_cache_module cur;
+    struct list *bucket;
+    WINE_MODREF *wm;
+
+    if (index >= cache->header->nb_modules) return NULL;
+    if (cache->loaded[index]) return cache->loaded[index];
+
+    id = &cache->modules[index];
+
+    bucket = get_module_hash_bucket( fileid_hash, hash_fileid( id->dev, id->ino ));
+    LIST_FOR_EACH_ENTRY( wm, bucket, WINE_MODREF, fileid_entry )
+    {
+        if (wm->dev != id->dev || wm->ino != id->ino) continue;
+        if (!get_import_cache_id( wm, &cur ) || memcmp( &cur, id, sizeof(cur) )) return NULL;
+        return cache->loaded[index] = wm;
+    }
+    return NULL;
+}
+
+
+/*************************************************************************
+ *		add_import_cache_module
+ *
+ * Add a module to the module table of the recorded imports, and return its index.
+ */
+static DWORD add_import_cache_module( struct import_cache *cache, WINE_MODREF *wm )
+{
+    unsigned int i;
+
+    for (i = 0; i < cache->nb_rec_modules; i++) if (cache->rec_modules[i] == wm) return i;
+
+    if (!wm->ino) return IMPORT_CACHE_NONE;
+    if (cache->nb_rec_modules == cache->alloc_rec_modules)
+    {
+        unsigned int new_count = max( 16, cache->alloc_rec_modules * 2 );
+        WINE_MODREF **new_modules;
+
+        if (cache->rec_modules)
+            new_modules = RtlReAllocateHeap( GetProcessHeap(), 0, cache->rec_modules,
+                                             new_count * sizeof(*new_modules) );
+        else
+            new_modules = RtlAllocateHeap( GetProcessHeap(), 0, new_count * sizeof(*new_modules) );
+        if (!new_modules) return IMPORT_CACHE_NONE;
+        cache->rec_modules = new_modules;
+        cache->alloc_rec_modules = new_count;
+    }
+    cache->rec_modules[cache->nb_rec_modules] = wm;
+    return cache->nb_rec_modules++;
+}
+
+
+/*************************************************************************
+ *		begin_import_record
+ *
+ * Start recording the resolved imports of an import descriptor.
+ */
+static void begin_import_record( struct import_cache *cache, int index, WINE_MODREF *wmImp )
+{
+    struct import_cache_descr *descr = &cache->rec_descr[index];
+
+    descr->module = add_import_cache_module( cache, wmImp );
+    descr->first  = cache->nb_rec_entries;
+    descr->count  = descr->module == IMPORT_CACHE_NONE ? IMPORT_CACHE_NONE : 0;
+}
+
+
+/*************************************************************************
+ *		record_import
+ *
+ * Record a resolved import. A NULL module marks the descriptor as not cacheable.
+ */
+static void record_import( struct import_cache *cache, int index, HMODULE module, ULONG_PTR proc )
+{
+    struct import_cache_descr *descr = &cache->rec_descr[index];
+    struct import_cache_entry *entry;
+    WINE_MODREF *wm;
+    DWORD mod_index;
+
+    if (descr->count == IMPORT_CACHE_NONE) return;
+
+    if (!module || !(wm = get_modref( module )) ||
+        (mod_index = add_import_cache_module( cache, wm )) == IMPORT_CACHE_NONE)
+    {
+        descr->count = IMPORT_CACHE_NONE;
+        return;
+    }
+
+    if (cache->nb_rec_entries == cache->alloc_rec_entries)
+    {
+        unsigned int new_count = max( 64, cache->alloc_rec_entries * 2 );
+        struct import_cache_entry *new_entries;
+
+        if (cache->rec_entries)
+            new_entries = RtlReAllocateHeap( GetProcessHeap(), 0, cache->rec_entries,
+                                             new_count * sizeof(*new_entries) );
+        else
+            new_entries = RtlAllocateHeap( GetProcessHeap(), 0, new_count * sizeof(*new_entries) );
+        if (!new_entries)
+        {
+            descr->count = IMPORT_CACHE_NONE;
+            return;
+        }
+        cache->rec_entries = new_entries;
+        cache->alloc_rec_entries = new_count;
+    }
+    entry = &cache->rec_entries[cache->nb_rec_entries++];
+    entry->module = mod_index;
+    entry->pad    = 0;
+    entry->offset = (LONGLONG)proc - (LONGLONG)(ULONG_PTR)module;
+    descr->count++;
+}
+
+
+/*************************************************************************
+ *		end_import_record
+ *
+ * Finish recording the resolved imports of an import descriptor.
+ */
+static void end_import_record( struct import_cache *cache, int index )
+{
+    if (cache->rec_descr[index].count != IMPORT_CACHE_NONE) cache->dirty = TRUE;
+}
+
+
+/*************************************************************************
+ *		apply_import_cache
+ *
+ * Fill the import address table of a descriptor from the import cache, if all
+ * the modules it refers to are loaded and still match the cache.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL apply_import_cache( struct import_cache *cache, int index, WINE_MODREF *wmImp,
+                                IMAGE_THUNK_DATA *thunk_list, DWORD count )
+{
+    const struct import_cache_descr *descr;
+    const struct import_cache_entry *entry;
+    WINE_MODREF *wm;
+    DWORD i;
+
+    if (!cache->header) return FALSE;
+    descr = &cache->descr[index];
+    if (descr->count != count) return FALSE;
+    if (descr->first > cache->header->nb_entries || count > cache->header->nb_entries - descr->first)
+        return FALSE;
+    if (get_import_cache_module( cache, descr->module ) != wmImp) return FALSE;
+
+    entry = cache->entries + descr->first;
+    for (i = 0; i < count; i++)
+        if (!get_import_cache_module( cache, entry[i].module )) return FALSE;
+
+    begin_import_record( cache, index, wmImp );
+    for (i = 0; i < count; i++)
+    {
+        wm = cache->loaded[entry[i].module];
+        thunk_list[i].u1.Function = (ULONG_PTR)wm->ldr.BaseAddress + (ULONG_PTR)entry[i].offset;
+        record_import( cache, index, wm->ldr.BaseAddress, thunk_list[i].u1.Function );
+    }
+    cached_import_count++;
+    return TRUE;
+}
+
+
+/*************************************************************************
+ *		save_import_cache
+ *
+ * Save the resolved imports of a module, if some of them weren't in the cache yet
+ * and the results differ from the existing cache file.
+ * The loader_section must be locked while calling this function.
+ */
+static void save_import_cache( const WINE_MODREF *wm, struct import_cache *cache )
+{
+    struct import_cache_header *header;
+    struct import_cache_module *modules;
+    char *path, *tmp, *data;
+    unsigned int i;
+    SIZE_T size;
+    int fd;
+
+    if (!cache->dirty) return;
+
+    size = sizeof(*header) + cache->nb_rec_modules * sizeof(*modules) +
+           cache->nb_rec_descr * sizeof(*cache->rec_descr) +
+           cache->nb_rec_entries * sizeof(*cache->rec_entries);
+    if (!(data = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size ))) return;
+
+    header = (struct import_cache_header *)data;
+    header->magic      = IMPORT_CACHE_MAGIC;
+    header->version    = IMPORT_CACHE_VERSION;
+    header->nb_modules = cache->nb_rec_modules;
+    header->nb_descr   = cache->nb_rec_descr;
+    header->nb_entries = cache->nb_rec_entries;
+    get_import_cache_id( wm, &header->self );
+    modules = (struct import_cache_module *)(header + 1);
+    for (i = 0; i < cache->nb_rec_modules; i++) get_import_cache_id( cache->rec_modules[i], &modules[i] );
+    memcpy( modules + cache->nb_rec_modules, cache->rec_descr, cache->nb_rec_descr * sizeof(*cache->rec_descr) );
+    memcpy( (struct import_cache_descr *)(modules + cache->nb_rec_modules) + cache->nb_rec_descr,
+            cache->rec_entries, cache->nb_rec_entries * sizeof(*cache->rec_entries) );
+
+    /* imports that can't be served from the cache resolve to the same results every time */
+    if (cache->header && cache->size == size && !memcmp( cache->data, data, size )) goto done;
+
+    if (!(path = get_import_cache_path( wm, TRUE ))) goto done;
+    if ((tmp = RtlAllocateHeap( GetProcessHeap(), 0, strlen(path) + 16 )))
+    {
+        /* write to a temporary file first, so that other processes never see a partial cache */
+        sprintf( tmp, "%s.%x", path, GetCurrentProcessId() );
+        if ((fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) != -1)
+        {
+            BOOL ok = (write( fd, data, size ) == size);
+            close( fd );
+            if (!ok || rename( tmp, path ) == -1) unlink( tmp );
+            else TRACE_(imports)( "saved import cache %s for %s\n",
+                                  debugstr_a(path), debugstr_w(wm->ldr.FullDllName.Buffer) );
+        }
+        RtlFreeHeap( GetProcessHeap(), 0, tmp );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+done:
+    RtlFreeHeap( GetProcessHeap(), 0, data );
+}
+
+
+/*************************************************************************
+ *		free_import_cache
+ */
+static void free_import_cache( struct import_cache *cache )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, cache->data );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->loaded );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->rec_modules );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->rec_descr );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->rec_entries );
+}
+
+
 /*************************************************************************
  *		import_dll
  *
  * Import the dll specified by the given import descriptor.
+ * If cache is not NULL, it is used to resolve the imports and updated with the results.
  * The loader_section must be locked while calling this function.
  */
-static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LPCWSTR load_path, WINE_MODREF **pwm )
+static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LPCWSTR load_path,
+                        struct import_cache *cache, int index, WINE_MODREF **pwm )
 {
     NTSTATUS status;
     WINE_MODREF *wmImp;
@@ -760,6 +1489,16 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         return FALSE;
     }
 
+    /* nothing to do if the import table was bound to the dll we just got */
+    if (descr->TimeDateStamp == ~0u && descr->u.OriginalFirstThunk &&
+        check_bound_import( module, name, len, wmImp ))
+    {
+        TRACE_(imports)( "using bound imports for %s\n", name );
+        bound_import_count++;
+        *pwm = wmImp;
+        return TRUE;
+    }
+
     /* unprotect the import address table since it can be located in
      * readonly section */
     while (import_list[protect_size].u1.Ordinal) protect_size++;
@@ -768,6 +1507,12 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
     NtProtectVirtualMemory( NtCurrentProcess(), &protect_base,
                             &protect_size, PAGE_READWRITE, &protect_old );
 
+    if (cache && apply_import_cache( cache, index, wmImp, thunk_list, protect_size / sizeof(*thunk_list) ))
+    {
+        TRACE_(imports)( "using cached imports for %s\n", name );
+        goto done;
+    }
+
     imp_mod = wmImp->ldr.BaseAddress;
     exports = RtlImageDirectoryEntryToData( imp_mod, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size );
 
@@ -797,16 +1542,22 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         goto done;
     }
 
+    if (cache) begin_import_record( cache, index, wmImp );
+
     while (import_list->u1.Ordinal)
     {
+        HMODULE export_module = NULL;
+
         if (IMAGE_SNAP_BY_ORDINAL(import_list->u1.Ordinal))
         {
             int ordinal = IMAGE_ORDINAL(import_list->u1.Ordinal);
 
             thunk_list->u1.Function = (ULONG_PTR)find_ordinal_export( imp_mod, exports, exp_size,
-                                                                      ordinal - exports->Base, load_path );
+                                                                      ordinal - exports->Base, load_path,
+                                                                      &export_module );
             if (!thunk_list->u1.Function)
             {
+                export_module = NULL;
                 thunk_list->u1.Function = allocate_stub( name, IntToPtr(ordinal) );
                 WARN("No implementation for %s.%d imported from %s, setting to %p\n",
                      name, ordinal, debugstr_w(current_modref->ldr.FullDllName.Buffer),
@@ -820,9 +1571,11 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
             pe_name = get_rva( module, (DWORD)import_list->u1.AddressOfData );
             thunk_list->u1.Function = (ULONG_PTR)find_named_export( imp_mod, exports, exp_size,
                                                                     (const char*)pe_name->Name,
-                                                                    pe_name->Hint, load_path );
+                                                                    pe_name->Hint, load_path,
+                                                                    &export_module );
             if (!thunk_list->u1.Function)
             {
+                export_module = NULL;
                 thunk_list->u1.Function = allocate_stub( name, (const char*)pe_name->Name );
                 WARN("No implementation for %s.%s imported from %s, setting to %p\n",
                      name, pe_name->Name, debugstr_w(current_modref->ldr.FullDllName.Buffer),
@@ -831,9 +1584,11 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
             TRACE_(imports)("--- %s %s.%d = %p\n",
                             pe_name->Name, name, pe_name->Hint, (void *)thunk_list->u1.Function);
         }
+        if (cache) record_import( cache, index, export_module, thunk_list->u1.Function );
         import_list++;
         thunk_list++;
     }
+    if (cache) end_import_record( cache, index );
 
 done:
     /* restore old protection of the import address table */
@@ -1046,7 +1801,7 @@ static NTSTATUS fixup_imports_ilonly( WINE_MODREF *wm, LPCWSTR load_path, void *
                                                  IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
     {
         const char *name = (wm->ldr.Flags & LDR_IMAGE_IS_DLL) ? "_CorDllMain" : "_CorExeMain";
-        proc = find_named_export( imp->ldr.BaseAddress, exports, exp_size, name, -1, load_path );
+        proc = find_named_export( imp->ldr.BaseAddress, exports, exp_size, name, -1, load_path, NULL );
     }
     if (!proc) return STATUS_PROCEDURE_NOT_FOUND;
     *entry = proc;
@@ -1068,6 +1823,9 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     DWORD size;
     NTSTATUS status;
     ULONG_PTR cookie;
+    enum load_phase phase;
+    struct import_cache cache;
+    BOOL use_cache;
 
     if (!(wm->ldr.Flags & LDR_DONT_RESOLVE_REFS)) return STATUS_SUCCESS;  /* already done */
     wm->ldr.Flags &= ~LDR_DONT_RESOLVE_REFS;
@@ -1095,18 +1853,28 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
      */
     prev = current_modref;
     current_modref = wm;
+    phase = set_load_phase( LOAD_PHASE_IMPORTS );
+    prefetch_imports( wm, wm->ldr.BaseAddress, imports, nb_imports, load_path );
+    use_cache = load_import_cache( wm, &cache, nb_imports );
     status = STATUS_SUCCESS;
     for (i = 0; i < nb_imports; i++)
     {
         dep = wm->nDeps++;
 
-        if (!import_dll( wm->ldr.BaseAddress, &imports[i], load_path, &imp ))
+        if (!import_dll( wm->ldr.BaseAddress, &imports[i], load_path, use_cache ? &cache : NULL, i, &imp ))
         {
             imp = NULL;
             status = STATUS_DLL_NOT_FOUND;
         }
         wm->deps[dep] = imp;
     }
+    if (use_cache)
+    {
+        if (!status) save_import_cache( wm, &cache );
+        free_import_cache( &cache );
+    }
+    discard_prefetched_dlls( wm );
+    set_load_phase( phase );
     current_modref = prev;
     if (wm->ldr.ActivationContext) RtlDeactivateActivationContext( 0, cookie );
     return status;
@@ -1137,6 +1905,7 @@ static WINE_MODREF *alloc_module( HMODULE hModule, const UNICODE_STRING *nt_name
     if ((p = strrchrW( wm->ldr.FullDllName.Buffer, '\\' ))) p++;
     else p = wm->ldr.FullDllName.Buffer;
     RtlInitUnicodeString( &wm->ldr.BaseDllName, p );
+    list_init( &wm->fileid_entry );
 
     if (!(nt->FileHeader.Characteristics & IMAGE_FILE_DLL) || !is_dll_native_subsystem( hModule, nt, p ))
     {
@@ -1150,6 +1919,7 @@ static WINE_MODREF *alloc_module( HMODULE hModule, const UNICODE_STRING *nt_name
                    &wm->ldr.InLoadOrderModuleList);
     InsertTailList(&NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList,
                    &wm->ldr.InMemoryOrderModuleList);
+    add_module_hash( wm );
     /* wait until init is called for inserting into InInitializationOrderModuleList */
 
     if (!(nt->OptionalHeader.DllCharacteristics & IMAGE_DLLCHARACTERISTICS_NX_COMPAT))
@@ -1362,10 +2132,13 @@ static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved )
     if (status == STATUS_SUCCESS)
     {
         WINE_MODREF *prev = current_modref;
+        enum load_phase phase;
         current_modref = wm;
 
         call_ldr_notifications( LDR_DLL_NOTIFICATION_REASON_LOADED, &wm->ldr );
+        phase = set_load_phase( LOAD_PHASE_INIT );
         status = MODULE_InitDLL( wm, DLL_PROCESS_ATTACH, lpReserved );
+        set_load_phase( phase );
         if (status == STATUS_SUCCESS)
         {
             wm->ldr.Flags |= LDR_PROCESS_ATTACHED;
@@ -1671,8 +2444,8 @@ NTSTATUS WINAPI LdrGetProcedureAddress(HMODULE module, const ANSI_STRING *name,
                                                       IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
     {
         LPCWSTR load_path = NtCurrentTeb()->Peb->ProcessParameters->DllPath.Buffer;
-        void *proc = name ? find_named_export( module, exports, exp_size, name->Buffer, -1, load_path )
-                          : find_ordinal_export( module, exports, exp_size, ord - exports->Base, load_path );
+        void *proc = name ? find_named_export( module, exports, exp_size, name->Buffer, -1, load_path, NULL )
+                          : find_ordinal_export( module, exports, exp_size, ord - exports->Base, load_path, NULL );
         if (proc)
         {
             *address = proc;
@@ -1740,7 +2513,7 @@ static BOOL is_16bit_builtin( HMODULE module )
                                                   IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
         return FALSE;
 
-    return find_named_export( module, exports, exp_size, "__wine_spec_dos_header", -1, NULL ) != NULL;
+    return find_named_export( module, exports, exp_size, "__wine_spec_dos_header", -1, NULL, NULL ) != NULL;
 }
 
 
@@ -1790,6 +2563,18 @@ static void load_builtin_callback( void *module, const char *filename )
     }
     wm->ldr.Flags |= LDR_WINE_INTERNAL;
 
+#ifdef HAVE_DLADDR
+    {
+        /* use the .so file as file id, so that imports of builtins can be cached */
+        Dl_info info;
+        struct stat st;
+
+        if (dladdr( module, &info ) && info.dli_fname && !stat( info.dli_fname, &st ) &&
+            !find_fileid_module( &st ))
+            set_module_fileid( wm, &st );
+    }
+#endif
+
     if ((nt->FileHeader.Characteristics & IMAGE_FILE_DLL) ||
         nt->OptionalHeader.Subsystem == IMAGE_SUBSYSTEM_NATIVE ||
         is_16bit_builtin( module ))
@@ -1804,6 +2589,7 @@ static void load_builtin_callback( void *module, const char *filename )
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderModuleList);
             RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
+            remove_module_hash( wm );
             /* FIXME: free the modref */
             builtin_load_info->status = STATUS_DLL_NOT_FOUND;
             return;
@@ -1930,28 +2716,185 @@ static NTSTATUS perform_relocations( void *module, IMAGE_NT_HEADERS *nt, SIZE_T
     end = get_rva( module, relocs->VirtualAddress + relocs->Size );
     delta = (char *)module - base;
 
-    while (rel < end - 1 && rel->SizeOfBlock)
+    while (rel < end - 1 && rel->SizeOfBlock)
+    {
+        if (rel->VirtualAddress >= len)
+        {
+            WARN( "invalid address %p in relocation %p\n", get_rva( module, rel->VirtualAddress ), rel );
+            return STATUS_ACCESS_VIOLATION;
+        }
+        rel = LdrProcessRelocationBlock( get_rva( module, rel->VirtualAddress ),
+                                         (rel->SizeOfBlock - sizeof(*rel)) / sizeof(USHORT),
+                                         (USHORT *)(rel + 1), delta );
+        if (!rel) return STATUS_INVALID_IMAGE_FORMAT;
+    }
+
+    for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
+    {
+        void *addr = get_rva( module, sec[i].VirtualAddress );
+        SIZE_T size = sec[i].SizeOfRawData;
+        NtProtectVirtualMemory( NtCurrentProcess(), &addr,
+                                &size, protect_old[i], &protect_old[i] );
+    }
+
+    return STATUS_SUCCESS;
+}
+
+
+/*************************************************************************
+ *		can_share_relocations
+ *
+ * Check whether the relocated pages of a module can be shared with other
+ * processes loading the same file at the same address.
+ */
+static BOOL can_share_relocations( void *module, IMAGE_NT_HEADERS *nt, SIZE_T len )
+{
+    const IMAGE_DATA_DIRECTORY *relocs = &nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+    const IMAGE_SECTION_HEADER *sec;
+    ULONG i;
+
+    if (module == (void *)nt->OptionalHeader.ImageBase) return FALSE;
+    if (nt->OptionalHeader.SectionAlignment < page_size) return FALSE;
+    if (!(nt->FileHeader.Characteristics & IMAGE_FILE_DLL)) return FALSE;
+    if (nt->FileHeader.Characteristics & IMAGE_FILE_RELOCS_STRIPPED) return FALSE;
+    if (!relocs->Size || !relocs->VirtualAddress) return FALSE;
+    if (relocs->VirtualAddress >= len || relocs->Size > len - relocs->VirtualAddress) return FALSE;
+
+    /* writable shared sections are mapped from a common file already */
+    sec = (const IMAGE_SECTION_HEADER *)((const char *)&nt->OptionalHeader +
+                                         nt->FileHeader.SizeOfOptionalHeader);
+    for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
+        if ((sec[i].Characteristics & IMAGE_SCN_MEM_SHARED) && (sec[i].Characteristics & IMAGE_SCN_MEM_WRITE))
+            return FALSE;
+    return TRUE;
+}
+
+
+/*************************************************************************
+ *		get_relocated_range
+ *
+ * Get the range of pages of a module that its base relocations modify.
+ */
+static BOOL get_relocated_range( void *module, IMAGE_NT_HEADERS *nt, SIZE_T len, SIZE_T *start, SIZE_T *end )
+{
+    const IMAGE_DATA_DIRECTORY *relocs = &nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+    const IMAGE_BASE_RELOCATION *rel = get_rva( module, relocs->VirtualAddress );
+    const IMAGE_BASE_RELOCATION *rel_end = get_rva( module, relocs->VirtualAddress + relocs->Size );
+
+    *start = len;
+    *end = 0;
+    while (rel < rel_end - 1 && rel->SizeOfBlock)
+    {
+        if (rel->VirtualAddress >= len) return FALSE;
+        /* fixups are at most 0xfff bytes into the block, and at most 8 bytes long */
+        *start = min( *start, rel->VirtualAddress );
+        *end = max( *end, rel->VirtualAddress + 0x1000 + sizeof(ULONGLONG) );
+        rel = (const IMAGE_BASE_RELOCATION *)((const char *)rel + rel->SizeOfBlock);
+    }
+    *start &= ~(SIZE_T)(page_size - 1);
+    *end = min( (*end + page_size - 1) & ~(SIZE_T)(page_size - 1), len );
+    return *start < *end;
+}
+
+
+/*************************************************************************
+ *		map_relocated_pages
+ *
+ * Map the pages that another process relocated for this file and address.
+ */
+static BOOL map_relocated_pages( void *module, SIZE_T len )
+{
+    HANDLE file = 0;
+    SIZE_T start = 0, end = 0;
+    NTSTATUS status;
+    int fd, needs_close;
+
+    SERVER_START_REQ( get_relocated_image )
+    {
+        req->base = wine_server_client_ptr( module );
+        if (!(status = wine_server_call( req )))
+        {
+            start = reply->start;
+            end   = reply->end;
+            file  = wine_server_ptr_handle( reply->file );
+        }
+    }
+    SERVER_END_REQ;
+    if (status)
+    {
+        TRACE( "no relocated pages for %p, status %x\n", module, status );
+        return FALSE;
+    }
+
+    if (start >= end || end > len) status = STATUS_INVALID_PARAMETER;
+    else if (!(status = server_get_unix_fd( file, 0, &fd, &needs_close, NULL, NULL )))
+    {
+        status = virtual_map_relocated_pages( module, start, end - start, fd );
+        if (needs_close) close( fd );
+    }
+    NtClose( file );
+    if (status) WARN( "failed to map relocated pages for %p, status %x\n", module, status );
+    else TRACE( "mapped relocated pages %p-%p\n", (char *)module + start, (char *)module + end );
+    return !status;
+}
+
+
+/*************************************************************************
+ *		store_relocated_pages
+ *
+ * Store the relocated pages of a module in a sealed file, so that other
+ * processes loading the same file at the same address can map them.
+ */
+static void store_relocated_pages( void *module, SIZE_T start, SIZE_T end )
+{
+#if defined(MFD_ALLOW_SEALING) && defined(F_ADD_SEALS)
+    NTSTATUS status;
+    int fd;
+
+    if ((fd = memfd_create( "wine-relocated", MFD_CLOEXEC | MFD_ALLOW_SEALING )) == -1) return;
+    if (ftruncate( fd, end ) == -1 ||
+        pwrite( fd, (char *)module + start, end - start, start ) != end - start ||
+        fcntl( fd, F_ADD_SEALS, F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE ) == -1)
     {
-        if (rel->VirtualAddress >= len)
-        {
-            WARN( "invalid address %p in relocation %p\n", get_rva( module, rel->VirtualAddress ), rel );
-            return STATUS_ACCESS_VIOLATION;
-        }
-        rel = LdrProcessRelocationBlock( get_rva( module, rel->VirtualAddress ),
-                                         (rel->SizeOfBlock - sizeof(*rel)) / sizeof(USHORT),
-                                         (USHORT *)(rel + 1), delta );
-        if (!rel) return STATUS_INVALID_IMAGE_FORMAT;
+        WARN( "failed to store relocated pages for %p\n", module );
+        close( fd );
+        return;
     }
 
-    for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
+    wine_server_send_fd( fd );
+    SERVER_START_REQ( set_relocated_image )
     {
-        void *addr = get_rva( module, sec[i].VirtualAddress );
-        SIZE_T size = sec[i].SizeOfRawData;
-        NtProtectVirtualMemory( NtCurrentProcess(), &addr,
-                                &size, protect_old[i], &protect_old[i] );
+        req->base  = wine_server_client_ptr( module );
+        req->start = start;
+        req->end   = end;
+        req->fd    = fd;
+        status = wine_server_call( req );
     }
+    SERVER_END_REQ;
+    close( fd );
+    if (status) TRACE( "relocated pages for %p not stored, status %x\n", module, status );
+    else TRACE( "stored relocated pages %p-%p\n", (char *)module + start, (char *)module + end );
+#endif
+}
 
-    return STATUS_SUCCESS;
+
+/*************************************************************************
+ *		relocate_image
+ *
+ * Perform the base relocations of a module, sharing the relocated pages with
+ * other processes that load the same file at the same address.
+ */
+static NTSTATUS relocate_image( void *module, IMAGE_NT_HEADERS *nt, SIZE_T len )
+{
+    SIZE_T start, end;
+    NTSTATUS status;
+    BOOL share;
+
+    share = can_share_relocations( module, nt, len ) && get_relocated_range( module, nt, len, &start, &end );
+    if (share && map_relocated_pages( module, len )) return STATUS_SUCCESS;
+    if (!(status = perform_relocations( module, nt, len )) && share)
+        store_relocated_pages( module, start, end );
+    return status;
 }
 
 #ifdef _WIN64
@@ -2038,23 +2981,16 @@ static BOOL is_valid_binary( HMODULE module, const pe_image_info_t *info )
 
 
 /***********************************************************************
- *	open_dll_file
+ *	open_dll_handle
  *
- * Open a file for a new dll. Helper for find_dll_file.
+ * Open the file of a dll, reporting missing files as STATUS_DLL_NOT_FOUND.
  */
-static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm,
-                               void **module, pe_image_info_t *image_info, struct stat *st )
+static NTSTATUS open_dll_handle( UNICODE_STRING *nt_name, HANDLE *handle )
 {
     FILE_BASIC_INFORMATION info;
     OBJECT_ATTRIBUTES attr;
     IO_STATUS_BLOCK io;
-    LARGE_INTEGER size;
-    SIZE_T len = 0;
     NTSTATUS status;
-    HANDLE handle, mapping;
-    int fd, needs_close;
-
-    if ((*pwm = find_fullname_module( nt_name ))) return STATUS_SUCCESS;
 
     attr.Length = sizeof(attr);
     attr.RootDirectory = 0;
@@ -2062,7 +2998,7 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm,
     attr.ObjectName = nt_name;
     attr.SecurityDescriptor = NULL;
     attr.SecurityQualityOfService = NULL;
-    if ((status = NtOpenFile( &handle, GENERIC_READ | SYNCHRONIZE, &attr, &io,
+    if ((status = NtOpenFile( handle, GENERIC_READ | SYNCHRONIZE, &attr, &io,
                               FILE_SHARE_READ | FILE_SHARE_DELETE,
                               FILE_SYNCHRONOUS_IO_NONALERT | FILE_NON_DIRECTORY_FILE )))
     {
@@ -2076,19 +3012,22 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm,
         /* otherwise continue searching */
         return STATUS_DLL_NOT_FOUND;
     }
+    return STATUS_SUCCESS;
+}
 
-    if (!server_get_unix_fd( handle, 0, &fd, &needs_close, NULL, NULL ))
-    {
-        fstat( fd, st );
-        if (needs_close) close( fd );
-        if ((*pwm = find_fileid_module( st )))
-        {
-            TRACE( "%s is the same file as existing module %p %s\n", debugstr_w( nt_name->Buffer ),
-                   (*pwm)->ldr.BaseAddress, debugstr_w( (*pwm)->ldr.FullDllName.Buffer ));
-            NtClose( handle );
-            return STATUS_SUCCESS;
-        }
-    }
+
+/***********************************************************************
+ *	map_dll_file
+ *
+ * Map an opened dll file as an image. The file handle is closed.
+ */
+static NTSTATUS map_dll_file( const UNICODE_STRING *nt_name, HANDLE handle,
+                              void **module, pe_image_info_t *image_info )
+{
+    LARGE_INTEGER size;
+    SIZE_T len = 0;
+    NTSTATUS status;
+    HANDLE mapping;
 
     size.QuadPart = 0;
     status = NtCreateSection( &mapping, STANDARD_RIGHTS_REQUIRED | SECTION_QUERY |
@@ -2113,23 +3052,328 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm,
 }
 
 
+/***********************************************************************
+ *	open_dll_file
+ *
+ * Open a file for a new dll. Helper for find_dll_file.
+ * When called from a loader worker thread to prefetch a dll, the loaded modules
+ * are not looked at; the loader thread checks them when it takes the image.
+ */
+static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm, void **module,
+                               pe_image_info_t *image_info, struct stat *st, BOOL prefetch )
+{
+    NTSTATUS status;
+    HANDLE handle;
+    int fd, needs_close;
+
+    if (prefetch) *pwm = NULL;
+    else if ((*pwm = find_fullname_module( nt_name ))) return STATUS_SUCCESS;
+
+    if ((status = open_dll_handle( nt_name, &handle ))) return status;
+
+    if (!server_get_unix_fd( handle, 0, &fd, &needs_close, NULL, NULL ))
+    {
+        fstat( fd, st );
+        if (needs_close) close( fd );
+        if (!prefetch && (*pwm = find_fileid_module( st )))
+        {
+            TRACE( "%s is the same file as existing module %p %s\n", debugstr_w( nt_name->Buffer ),
+                   (*pwm)->ldr.BaseAddress, debugstr_w( (*pwm)->ldr.FullDllName.Buffer ));
+            NtClose( handle );
+            return STATUS_SUCCESS;
+        }
+    }
+
+    return map_dll_file( nt_name, handle, module, image_info );
+}
+
+
+/***********************************************************************
+ *	prefetch_dll_file
+ *
+ * Search, map and relocate a dll image on a loader worker thread, the same way
+ * find_dll_file would. This must not access any loader state.
+ */
+static void prefetch_dll_file( struct prefetch_dll *prefetch )
+{
+    IMAGE_NT_HEADERS *nt;
+    WINE_MODREF *wm;
+    NTSTATUS status;
+
+    if (RtlDetermineDosPathNameType_U( prefetch->name ) == RELATIVE_PATH)
+        status = search_dll_file( prefetch->load_path, prefetch->name, &prefetch->nt_name, &wm,
+                                  &prefetch->module, &prefetch->image_info, &prefetch->st, TRUE );
+    else if (!(status = RtlDosPathNameToNtPathName_U_WithStatus( prefetch->name, &prefetch->nt_name,
+                                                                 NULL, NULL )))
+        status = open_dll_file( &prefetch->nt_name, &wm, &prefetch->module, &prefetch->image_info,
+                                &prefetch->st, TRUE );
+
+    if (status || !prefetch->module)
+    {
+        /* let the loader thread search again and fail or load the builtin the normal way */
+        if (prefetch->module) NtUnmapViewOfSection( NtCurrentProcess(), prefetch->module );
+        RtlFreeUnicodeString( &prefetch->nt_name );
+        prefetch->module = NULL;
+        return;
+    }
+    if (prefetch->image_info.image_flags & (IMAGE_FLAGS_WineBuiltin | IMAGE_FLAGS_WineFakeDll)) return;
+
+    nt = RtlImageNtHeader( prefetch->module );
+    if (!relocate_image( prefetch->module, nt, prefetch->image_info.map_size ))
+        prefetch->relocated = TRUE;
+    else
+    {
+        NtUnmapViewOfSection( NtCurrentProcess(), prefetch->module );
+        RtlFreeUnicodeString( &prefetch->nt_name );
+        prefetch->module = NULL;
+    }
+}
+
+
+/***********************************************************************
+ *	free_prefetched_dll
+ *
+ * Free a prefetched dll, unmapping its image if it hasn't been taken.
+ */
+static void free_prefetched_dll( struct prefetch_dll *prefetch )
+{
+    if (prefetch->module) NtUnmapViewOfSection( NtCurrentProcess(), prefetch->module );
+    RtlFreeUnicodeString( &prefetch->nt_name );
+    RtlFreeHeap( GetProcessHeap(), 0, prefetch->name );
+    RtlFreeHeap( GetProcessHeap(), 0, prefetch );
+}
+
+
+/***********************************************************************
+ *	loader_worker_proc
+ *
+ * Thread pool callback that processes queued prefetch jobs until the queue is empty.
+ * It runs on normal pool threads, so a newly created thread only starts
+ * working once the loader_section is released.
+ */
+static void CALLBACK loader_worker_proc( TP_CALLBACK_INSTANCE *instance, void *arg )
+{
+    struct prefetch_dll *prefetch = NULL;
+    struct list *ptr;
+    BOOL cancelled;
+
+    for (;;)
+    {
+        RtlEnterCriticalSection( &loader_work_section );
+        if ((ptr = list_head( &loader_work_queue )))
+        {
+            list_remove( ptr );
+            prefetch = LIST_ENTRY( ptr, struct prefetch_dll, entry );
+            prefetch->state = PREFETCH_RUNNING;
+        }
+        RtlLeaveCriticalSection( &loader_work_section );
+        if (!ptr) break;  /* done, or taken back by the loader thread */
+
+        prefetch_dll_file( prefetch );
+
+        RtlEnterCriticalSection( &loader_work_section );
+        cancelled = (prefetch->state == PREFETCH_CANCELLED);
+        prefetch->state = PREFETCH_DONE;
+        RtlLeaveCriticalSection( &loader_work_section );
+        if (cancelled) free_prefetched_dll( prefetch );
+    }
+}
+
+
+/***********************************************************************
+ *	prefetch_imports
+ *
+ * Queue the dlls imported by a module that are not loaded yet, so that thread pool
+ * callbacks search, map and relocate them while the imports are being processed.
+ * The import fixups then pick them up in import order, so that dll initialization
+ * order is not affected. This doesn't wait for the workers.
+ * The loader_section must be locked while calling this function.
+ */
+static void prefetch_imports( const void *batch, HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *imports,
+                              int nb_imports, LPCWSTR load_path )
+{
+    struct list jobs = LIST_INIT( jobs );
+    struct prefetch_dll *prefetch;
+    WCHAR buffer[MAX_PATH], *dllname;
+    const WCHAR *search;
+    WINE_MODREF *wm;
+    const char *name;
+    int i, count = 0;
+    DWORD len;
+
+    if (!loader_worker_count || nb_imports < 2) return;
+
+    /* the first import is needed right away, leave it to the loader thread */
+    for (i = 1; i < nb_imports; i++)
+    {
+        name = get_rva( module, imports[i].Name );
+        len = strlen( name );
+        while (len && name[len-1] == ' ') len--;  /* remove trailing spaces */
+        if (!len || len >= ARRAY_SIZE(buffer)) continue;
+        ascii_to_unicode( buffer, name, len );
+        buffer[len] = 0;
+
+        /* use the same name as find_dll_file, skipping dlls that are already loaded */
+        if (get_dll_search_name( buffer, &search, &dllname, &wm ) || wm)
+        {
+            RtlFreeHeap( GetProcessHeap(), 0, dllname );
+            continue;
+        }
+        if (!(prefetch = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*prefetch) )) ||
+            !(prefetch->name = RtlAllocateHeap( GetProcessHeap(), 0, (strlenW( search ) + 1) * sizeof(WCHAR) )))
+        {
+            RtlFreeHeap( GetProcessHeap(), 0, prefetch );
+            RtlFreeHeap( GetProcessHeap(), 0, dllname );
+            break;
+        }
+        strcpyW( prefetch->name, search );
+        RtlFreeHeap( GetProcessHeap(), 0, dllname );
+        prefetch->batch = batch;
+        prefetch->load_path = load_path;
+        prefetch->state = PREFETCH_QUEUED;
+        list_add_tail( &prefetched_dlls, &prefetch->batch_entry );
+        list_add_tail( &jobs, &prefetch->entry );
+        count++;
+    }
+    if (!count) return;
+
+    RtlEnterCriticalSection( &loader_work_section );
+    list_move_tail( &loader_work_queue, &jobs );
+    RtlLeaveCriticalSection( &loader_work_section );
+
+    /* jobs that no callback gets to are taken back by the loader thread */
+    for (i = 0; i < min( count, loader_worker_count ); i++)
+        if (TpSimpleTryPost( loader_worker_proc, NULL, NULL )) break;
+}
+
+
+/***********************************************************************
+ *	complete_prefetch
+ *
+ * Remove a prefetched dll from its batch. Returns TRUE if the worker is done with it,
+ * otherwise it is cancelled: it's freed right away if no worker has started on it yet,
+ * or by the worker when it's done. The loader thread never waits for the workers.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL complete_prefetch( struct prefetch_dll *prefetch )
+{
+    BOOL done = FALSE, unused = FALSE;
+
+    list_remove( &prefetch->batch_entry );
+
+    RtlEnterCriticalSection( &loader_work_section );
+    switch (prefetch->state)
+    {
+    case PREFETCH_QUEUED:
+        list_remove( &prefetch->entry );
+        unused = TRUE;
+        break;
+    case PREFETCH_RUNNING:
+        prefetch->state = PREFETCH_CANCELLED;
+        break;
+    case PREFETCH_CANCELLED:
+        break;
+    case PREFETCH_DONE:
+        done = TRUE;
+        break;
+    }
+    RtlLeaveCriticalSection( &loader_work_section );
+
+    if (unused) free_prefetched_dll( prefetch );
+    return done;
+}
+
+
+/***********************************************************************
+ *	take_prefetched_dll
+ *
+ * Get the image of a dll if it has been mapped by the loader workers. If the workers
+ * haven't finished with it, the loader thread searches for it itself.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL take_prefetched_dll( LPCWSTR load_path, const WCHAR *name, UNICODE_STRING *nt_name,
+                                 WINE_MODREF **pwm, void **module, pe_image_info_t *image_info,
+                                 struct stat *st )
+{
+    struct prefetch_dll *prefetch;
+
+    LIST_FOR_EACH_ENTRY( prefetch, &prefetched_dlls, struct prefetch_dll, batch_entry )
+    {
+        if (prefetch->load_path != load_path || strcmpiW( prefetch->name, name )) continue;
+
+        if (!complete_prefetch( prefetch )) return FALSE;
+        if (!prefetch->module)
+        {
+            free_prefetched_dll( prefetch );
+            return FALSE;
+        }
+
+        *nt_name = prefetch->nt_name;
+        prefetch->nt_name.Buffer = NULL;
+        if ((*pwm = find_fullname_module( nt_name )) || (*pwm = find_fileid_module( &prefetch->st )))
+        {
+            TRACE( "%s is the same file as existing module %p %s\n", debugstr_us( nt_name ),
+                   (*pwm)->ldr.BaseAddress, debugstr_w( (*pwm)->ldr.FullDllName.Buffer ));
+        }
+        else
+        {
+            TRACE( "using prefetched %s at %p\n", debugstr_us( nt_name ), prefetch->module );
+            *module = prefetch->module;
+            *image_info = prefetch->image_info;
+            *st = prefetch->st;
+            if (prefetch->relocated) prefetched_module = prefetch->module;
+            prefetch->module = NULL;
+        }
+        free_prefetched_dll( prefetch );
+        return TRUE;
+    }
+    return FALSE;
+}
+
+
+/***********************************************************************
+ *	discard_prefetched_dlls
+ *
+ * Release the images prefetched for an import fixup batch that ended up not being used.
+ * The loader_section must be locked while calling this function.
+ */
+static void discard_prefetched_dlls( const void *batch )
+{
+    struct prefetch_dll *prefetch, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( prefetch, next, &prefetched_dlls, struct prefetch_dll, batch_entry )
+    {
+        if (prefetch->batch != batch) continue;
+        if (!complete_prefetch( prefetch )) continue;
+        TRACE( "discarding %s at %p\n", debugstr_us(&prefetch->nt_name), prefetch->module );
+        free_prefetched_dll( prefetch );
+    }
+}
+
+
 /******************************************************************************
  *	load_native_dll  (internal)
+ *
+ * The relocated flag is set if a loader worker already applied the relocations.
  */
 static NTSTATUS load_native_dll( LPCWSTR load_path, const UNICODE_STRING *nt_name, void *module,
                                  const pe_image_info_t *image_info, DWORD flags, WINE_MODREF** pwm,
-                                 struct stat *st )
+                                 struct stat *st, BOOL relocated )
 {
     IMAGE_NT_HEADERS *nt = RtlImageNtHeader( module );
     WINE_MODREF *wm;
     NTSTATUS status;
+    enum load_phase phase;
     const char *dll_type = (image_info->image_flags & IMAGE_FLAGS_WineBuiltin) ? "PE builtin" : "native";
 
     TRACE("Trying %s dll %s\n", dll_type, debugstr_us(nt_name) );
 
     /* perform base relocation, if necessary */
 
-    if ((status = perform_relocations( module, nt, image_info->map_size )))
+    phase = set_load_phase( LOAD_PHASE_RELOCATE );
+    status = relocated ? STATUS_SUCCESS : relocate_image( module, nt, image_info->map_size );
+    set_load_phase( phase );
+    if (status)
     {
         NtUnmapViewOfSection( NtCurrentProcess(), module );
         return status;
@@ -2143,8 +3387,7 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, const UNICODE_STRING *nt_nam
         return STATUS_NO_MEMORY;
     }
 
-    wm->dev = st->st_dev;
-    wm->ino = st->st_ino;
+    set_module_fileid( wm, st );
     if (image_info->loader_flags) wm->ldr.Flags |= LDR_COR_IMAGE;
     if (image_info->image_flags & IMAGE_FLAGS_ComPlusILOnly) wm->ldr.Flags |= LDR_COR_ILONLY;
 
@@ -2165,6 +3408,7 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, const UNICODE_STRING *nt_nam
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderModuleList);
             RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
+            remove_module_hash( wm );
 
             /* FIXME: there are several more dangling references
              * left. Including dlls loaded by this dll before the
@@ -2257,7 +3501,7 @@ static NTSTATUS open_builtin_file( char *name, WINE_MODREF **pwm, void **module,
     RtlInitString( &strA, name );
     if ((status = wine_unix_to_nt_file_name( &strA, &nt_name ))) return status;
 
-    status = open_dll_file( &nt_name, pwm, module, image_info, st );
+    status = open_dll_file( &nt_name, pwm, module, image_info, st, FALSE );
     RtlFreeUnicodeString( &nt_name );
 
     /* ignore non-builtins */
@@ -2431,7 +3675,7 @@ static NTSTATUS load_builtin_dll( LPCWSTR load_path, const UNICODE_STRING *nt_na
         if (module)
         {
             TRACE( "loading %s from PE builtin %s\n", debugstr_w(name), debugstr_us(nt_name) );
-            return load_native_dll( load_path, nt_name, module, &image_info, flags, pwm, &st );
+            return load_native_dll( load_path, nt_name, module, &image_info, flags, pwm, &st, FALSE );
         }
 
         TRACE( "loading %s from so lib %s\n", debugstr_w(name), debugstr_a(so_name) );
@@ -2586,10 +3830,11 @@ done:
  *	search_dll_file
  *
  * Search for dll in the specified paths.
+ * The prefetch flag is set when called from a loader worker thread, see open_dll_file.
  */
 static NTSTATUS search_dll_file( LPCWSTR paths, LPCWSTR search, UNICODE_STRING *nt_name,
                                  WINE_MODREF **pwm, void **module, pe_image_info_t *image_info,
-                                 struct stat *st )
+                                 struct stat *st, BOOL prefetch )
 {
     WCHAR *name;
     BOOL found_image = FALSE;
@@ -2616,7 +3861,7 @@ static NTSTATUS search_dll_file( LPCWSTR paths, LPCWSTR search, UNICODE_STRING *
         nt_name->Buffer = NULL;
         if ((status = RtlDosPathNameToNtPathName_U_WithStatus( name, nt_name, NULL, NULL ))) goto done;
 
-        status = open_dll_file( nt_name, pwm, module, image_info, st );
+        status = open_dll_file( nt_name, pwm, module, image_info, st, prefetch );
         if (status == STATUS_IMAGE_MACHINE_TYPE_MISMATCH) found_image = TRUE;
         else if (status != STATUS_DLL_NOT_FOUND) goto done;
         RtlFreeUnicodeString( nt_name );
@@ -2639,22 +3884,24 @@ done:
 
 
 /***********************************************************************
- *	find_dll_file
+ *	get_dll_search_name
  *
- * Find the file (or already loaded module) for a given dll name.
+ * Get the name to search for a dll: append .dll if needed and apply the activation
+ * context redirection. *pwm is set if a module with that base name is already loaded.
+ * The returned buffer, if any, must be freed by the caller.
+ * The loader_section must be locked while calling this function.
  */
-static NTSTATUS find_dll_file( const WCHAR *load_path, const WCHAR *libname,
-                               UNICODE_STRING *nt_name, WINE_MODREF **pwm,
-                               void **module, pe_image_info_t *image_info, struct stat *st )
+static NTSTATUS get_dll_search_name( const WCHAR *libname, const WCHAR **search, WCHAR **buffer,
+                                     WINE_MODREF **pwm )
 {
-    WCHAR *ext, *dllname;
+    WCHAR *ext, *dllname = NULL;
     NTSTATUS status = STATUS_SUCCESS;
 
+    *pwm = NULL;
+    *buffer = NULL;
+
     /* first append .dll if needed */
 
-    *pwm = NULL;
-    *module = NULL;
-    dllname = NULL;
     if (!(ext = strrchrW( libname, '.')) || strchrW( ext, '/' ) || strchrW( ext, '\\'))
     {
         if (!(dllname = RtlAllocateHeap( GetProcessHeap(), 0,
@@ -2665,8 +3912,6 @@ static NTSTATUS find_dll_file( const WCHAR *load_path, const WCHAR *libname,
         libname = dllname;
     }
 
-    nt_name->Buffer = NULL;
-
     if (!contains_path( libname ))
     {
         WCHAR *fullname = NULL;
@@ -2681,12 +3926,39 @@ static NTSTATUS find_dll_file( const WCHAR *load_path, const WCHAR *libname,
             libname = dllname = fullname;
         }
         else if (status != STATUS_SXS_KEY_NOT_FOUND) goto done;
+        status = STATUS_SUCCESS;
     }
 
+done:
+    *search = libname;
+    *buffer = dllname;
+    return status;
+}
+
+
+/***********************************************************************
+ *	find_dll_file
+ *
+ * Find the file (or already loaded module) for a given dll name.
+ */
+static NTSTATUS find_dll_file( const WCHAR *load_path, const WCHAR *libname,
+                               UNICODE_STRING *nt_name, WINE_MODREF **pwm,
+                               void **module, pe_image_info_t *image_info, struct stat *st )
+{
+    WCHAR *dllname;
+    NTSTATUS status;
+
+    *module = NULL;
+    nt_name->Buffer = NULL;
+
+    if ((status = get_dll_search_name( libname, &libname, &dllname, pwm )) || *pwm) goto done;
+
+    if (take_prefetched_dll( load_path, libname, nt_name, pwm, module, image_info, st )) goto done;
+
     if (RtlDetermineDosPathNameType_U( libname ) == RELATIVE_PATH)
-        status = search_dll_file( load_path, libname, nt_name, pwm, module, image_info, st );
+        status = search_dll_file( load_path, libname, nt_name, pwm, module, image_info, st, FALSE );
     else if (!(status = RtlDosPathNameToNtPathName_U_WithStatus( libname, nt_name, NULL, NULL )))
-        status = open_dll_file( nt_name, pwm, module, image_info, st );
+        status = open_dll_file( nt_name, pwm, module, image_info, st, FALSE );
 
     if (status == STATUS_IMAGE_MACHINE_TYPE_MISMATCH) status = STATUS_INVALID_IMAGE_FORMAT;
 
@@ -2711,10 +3983,15 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
     void *module;
     pe_image_info_t image_info;
     NTSTATUS nts;
+    enum load_phase phase;
+    BOOL relocated;
 
     TRACE( "looking for %s in %s\n", debugstr_w(libname), debugstr_w(load_path) );
 
+    phase = set_load_phase( LOAD_PHASE_MAP );
     nts = find_dll_file( load_path, libname, &nt_name, pwm, &module, &image_info, &st );
+    relocated = (module && module == prefetched_module);
+    prefetched_module = NULL;
 
     if (*pwm)  /* found already loaded module */
     {
@@ -2724,6 +4001,7 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
               debugstr_w((*pwm)->ldr.FullDllName.Buffer), debugstr_w(libname),
               (*pwm)->ldr.BaseAddress, (*pwm)->ldr.LoadCount);
         RtlFreeUnicodeString( &nt_name );
+        set_load_phase( phase );
         return STATUS_SUCCESS;
     }
 
@@ -2774,7 +4052,7 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
             {
             case LO_NATIVE:
             case LO_NATIVE_BUILTIN:
-                nts = load_native_dll( load_path, &nt_name, module, &image_info, flags, pwm, &st );
+                nts = load_native_dll( load_path, &nt_name, module, &image_info, flags, pwm, &st, relocated );
                 module = NULL;
                 break;
             case LO_BUILTIN:
@@ -2793,7 +4071,7 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
                 }
                 if (nts == STATUS_DLL_NOT_FOUND)
                 {
-                    nts = load_native_dll( load_path, &nt_name, module, &image_info, flags, pwm, &st );
+                    nts = load_native_dll( load_path, &nt_name, module, &image_info, flags, pwm, &st, relocated );
                     module = NULL;
                 }
                 break;
@@ -2831,6 +4109,7 @@ done:
         WARN("Failed to load module %s; status=%x\n", debugstr_w(libname), nts);
 
     RtlFreeUnicodeString( &nt_name );
+    set_load_phase( phase );
     return nts;
 }
 
@@ -3324,6 +4603,7 @@ static void free_modref( WINE_MODREF *wm )
     RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
     if (wm->ldr.InInitializationOrderModuleList.Flink)
         RemoveEntryList(&wm->ldr.InInitializationOrderModuleList);
+    remove_module_hash( wm );
 
     TRACE(" unloading %s\n", debugstr_w(wm->ldr.FullDllName.Buffer));
     if (!TRACE_ON(module))
@@ -3344,6 +4624,7 @@ static void free_modref( WINE_MODREF *wm )
     NtUnmapViewOfSection( NtCurrentProcess(), wm->ldr.BaseAddress );
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
@@ -3484,6 +4765,28 @@ PIMAGE_NT_HEADERS WINAPI RtlImageNtHeader(HMODULE hModule)
 }
 
 
+/***********************************************************************
+ *           dump_load_times
+ *
+ * Report the time spent in the various loader phases during process startup.
+ */
+static void dump_load_times(void)
+{
+    ULONGLONG total = 0;
+    unsigned int i;
+
+    set_load_phase( LOAD_PHASE_OTHER );
+    for (i = 0; i < NB_LOAD_PHASES; i++) total += load_phase_time[i];
+    for (i = 0; i < NB_LOAD_PHASES; i++)
+        TRACE_(loaddll)( "startup %-8s %6u.%03u ms\n", load_phase_names[i],
+                         (unsigned int)(load_phase_time[i] / 10000),
+                         (unsigned int)(load_phase_time[i] / 10 % 1000) );
+    TRACE_(loaddll)( "startup total    %6u.%03u ms, %u bound imports, %u cached imports\n",
+                     (unsigned int)(total / 10000), (unsigned int)(total / 10 % 1000),
+                     bound_import_count, cached_import_count );
+}
+
+
 /******************************************************************
  *		LdrInitializeThunk (NTDLL.@)
  *
@@ -3545,6 +4848,7 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, void **entry, ULONG_PTR unknow
         }
         attach_implicitly_loaded_dlls( context );
         virtual_release_address_space();
+        if (TRACE_ON(loaddll)) dump_load_times();
     }
     else
     {
@@ -3744,6 +5048,7 @@ void __wine_process_init(void)
                                       's','y','s','t','e','m','3','2','\\',
                                       'k','e','r','n','e','l','3','2','.','d','l','l',0};
     static const WCHAR globalflagW[] = {'G','l','o','b','a','l','F','l','a','g',0};
+    static const WCHAR maxloaderthreadsW[] = {'M','a','x','L','o','a','d','e','r','T','h','r','e','a','d','s',0};
 
     WINE_MODREF *wm;
     NTSTATUS status;
@@ -3793,6 +5098,9 @@ void __wine_process_init(void)
 
     LdrQueryImageFileExecutionOptions( &wm->ldr.FullDllName, globalflagW, REG_DWORD,
                                        &NtCurrentTeb()->Peb->NtGlobalFlag, sizeof(DWORD), NULL );
+    LdrQueryImageFileExecutionOptions( &wm->ldr.FullDllName, maxloaderthreadsW, REG_DWORD,
+                                       &loader_worker_count, sizeof(DWORD), NULL );
+    loader_worker_count = min( loader_worker_count, 16 );
     heap_set_debug_flags( GetProcessHeap() );
 
     /* the main exe needs to be the first in the load order list */
@@ -3800,6 +5108,12 @@ void __wine_process_init(void)
     InsertHeadList( &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList, &wm->ldr.InLoadOrderModuleList );
     RemoveEntryList( &wm->ldr.InMemoryOrderModuleList );
     InsertHeadList( &NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList, &wm->ldr.InMemoryOrderModuleList );
+    list_remove( &wm->basename_entry );
+    list_add_head( get_module_hash_bucket( basename_hash, hash_basename( wm->ldr.BaseDllName.Buffer )),
+                   &wm->basename_entry );
+    list_remove( &wm->fullname_entry );
+    list_add_head( get_module_hash_bucket( fullname_hash, hash_fullname( &wm->ldr.FullDllName )),
+                   &wm->fullname_entry );
 
     if ((status = virtual_alloc_thread_stack( NtCurrentTeb(), 0, 0, NULL )) != STATUS_SUCCESS)
     {
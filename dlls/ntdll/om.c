@@ -35,6 +35,7 @@
 #include "winternl.h"
 #include "ntdll_misc.h"
 #include "esync.h"
+#include "uring.h"
 #include "wine/server.h"
 #include "wine/exception.h"
 
@@ -390,6 +391,8 @@ NTSTATUS close_handle( HANDLE handle )
 
     if (do_esync())
         esync_close( handle );
+    if (do_uring())
+        uring_close_handle( handle, fd );
 
     SERVER_START_REQ( close_handle )
     {
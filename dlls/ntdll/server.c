@@ -1042,6 +1042,27 @@ int CDECL wine_server_handle_to_fd( HANDLE handle, unsigned int access, int *uni
 }
 
 
+/***********************************************************************
+ *           __wine_server_get_cached_fd   (NTDLL.@)
+ *
+ * Retrieve the cached unix fd of a handle, without duplicating it.
+ * The fd must not be closed, and is only valid until the handle is closed.
+ * Fails with STATUS_NOT_SUPPORTED if the fd can't be cached.
+ */
+int CDECL __wine_server_get_cached_fd( HANDLE handle, int *unix_fd )
+{
+    int needs_close, ret = server_get_unix_fd( handle, 0, unix_fd, &needs_close, NULL, NULL );
+
+    if (!ret && needs_close)
+    {
+        close( *unix_fd );
+        *unix_fd = -1;
+        ret = STATUS_NOT_SUPPORTED;
+    }
+    return ret;
+}
+
+
 /***********************************************************************
  *           wine_server_release_fd   (NTDLL.@)
  *
@@ -1387,6 +1387,14 @@ NTSTATUS WINAPI NtSetIoCompletion( HANDLE CompletionPort, ULONG_PTR CompletionKe
     TRACE("(%p, %lx, %lx, %x, %lx)\n", CompletionPort, CompletionKey,
           CompletionValue, Status, NumberOfBytesTransferred);
 
+    if (do_esync())
+    {
+        status = esync_set_io_completion( CompletionPort, CompletionKey, CompletionValue,
+                                          Status, NumberOfBytesTransferred );
+        if (status != STATUS_NOT_IMPLEMENTED)
+            return status;
+    }
+
     SERVER_START_REQ( add_completion )
     {
         req->handle      = wine_server_obj_handle( CompletionPort );
@@ -1423,6 +1431,22 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE CompletionPort, PULONG_PTR Completi
     TRACE("(%p, %p, %p, %p, %p)\n", CompletionPort, CompletionKey,
           CompletionValue, iosb, WaitTime);
 
+    if (do_esync())
+    {
+        FILE_IO_COMPLETION_INFORMATION info;
+        ULONG written;
+
+        status = esync_remove_io_completion( CompletionPort, &info, 1, &written, WaitTime, FALSE );
+        if (status == STATUS_SUCCESS)
+        {
+            *CompletionKey    = info.CompletionKey;
+            *CompletionValue  = info.CompletionValue;
+            *iosb             = info.IoStatusBlock;
+        }
+        if (status != STATUS_NOT_IMPLEMENTED)
+            return status;
+    }
+
     for(;;)
     {
         SERVER_START_REQ( remove_completion )
@@ -1445,6 +1469,34 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE CompletionPort, PULONG_PTR Completi
     return status;
 }
 
+/* retrieve up to count packets from the server queue of a completion port */
+NTSTATUS server_remove_completions( HANDLE port, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
+                                    ULONG *written )
+{
+    struct completion_packet packets[64];
+    NTSTATUS ret;
+    ULONG i;
+
+    SERVER_START_REQ( remove_completions )
+    {
+        req->handle = wine_server_obj_handle( port );
+        wine_server_set_reply( req, packets, min( count, ARRAY_SIZE(packets) ) * sizeof(packets[0]) );
+        if (!(ret = wine_server_call( req )))
+        {
+            *written = wine_server_reply_size( reply ) / sizeof(packets[0]);
+            for (i = 0; i < *written; i++)
+            {
+                info[i].CompletionKey             = packets[i].ckey;
+                info[i].CompletionValue           = packets[i].cvalue;
+                info[i].IoStatusBlock.Information = packets[i].information;
+                info[i].IoStatusBlock.u.Status    = packets[i].status;
+            }
+        }
+    }
+    SERVER_END_REQ;
+    return ret;
+}
+
 /******************************************************************
  *              NtRemoveIoCompletionEx (NTDLL.@)
  *              ZwRemoveIoCompletionEx (NTDLL.@)
@@ -1453,30 +1505,23 @@ NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE port, FILE_IO_COMPLETION_INFORMAT
                                         ULONG *written, LARGE_INTEGER *timeout, BOOLEAN alertable )
 {
     NTSTATUS ret;
-    ULONG i = 0;
+    ULONG i = 0, n;
 
     TRACE("%p %p %u %p %p %u\n", port, info, count, written, timeout, alertable);
 
+    if (do_esync())
+    {
+        ret = esync_remove_io_completion( port, info, count, written, timeout, alertable );
+        if (ret != STATUS_NOT_IMPLEMENTED)
+            return ret;
+    }
+
     for (;;)
     {
         while (i < count)
         {
-            SERVER_START_REQ( remove_completion )
-            {
-                req->handle = wine_server_obj_handle( port );
-                if (!(ret = wine_server_call( req )))
-                {
-                    info[i].CompletionKey             = reply->ckey;
-                    info[i].CompletionValue           = reply->cvalue;
-                    info[i].IoStatusBlock.Information = reply->information;
-                    info[i].IoStatusBlock.u.Status    = reply->status;
-                }
-            }
-            SERVER_END_REQ;
-
-            if (ret != STATUS_SUCCESS) break;
-
-            ++i;
+            if ((ret = server_remove_completions( port, info + i, count - i, &n ))) break;
+            i += n;
         }
 
         if (i || ret != STATUS_PENDING)
@@ -1054,6 +1054,87 @@ static void test_set_io_completion(void)
     pNtClose( h );
 }
 
+static DWORD WINAPI completion_wait_thread( void *arg )
+{
+    return WaitForSingleObject( arg, 5000 );
+}
+
+static DWORD WINAPI completion_close_thread( void *arg )
+{
+    IO_STATUS_BLOCK iosb;
+    LARGE_INTEGER timeout = {{0}};
+    ULONG_PTR key, value;
+    NTSTATUS res;
+
+    /* keep using the port until the main thread closes it */
+    for (;;)
+    {
+        res = pNtSetIoCompletion( arg, 1, 2, 3, 4 );
+        if (res) break;
+        res = pNtRemoveIoCompletion( arg, &key, &value, &iosb, &timeout );
+        if (res && res != STATUS_TIMEOUT) break;
+    }
+    return res;
+}
+
+static void test_completion_port_wait(void)
+{
+    LARGE_INTEGER timeout = {{0}};
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    HANDLE h, threads[4];
+    NTSTATUS res;
+    DWORD ret;
+    int i;
+
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+
+    ret = WaitForSingleObject( h, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+
+    /* the port is signaled while it has packets, waiting doesn't remove them */
+    res = pNtSetIoCompletion( h, 123, 456, 789, 0 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ret = WaitForSingleObject( h, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    ret = WaitForSingleObject( h, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == 123, "wrong key %#lx\n", key );
+    ret = WaitForSingleObject( h, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+
+    /* a packet posted from another thread wakes up a wait on the port */
+    threads[0] = CreateThread( NULL, 0, completion_wait_thread, h, 0, NULL );
+    ok( WaitForSingleObject( threads[0], 100 ) == WAIT_TIMEOUT, "thread didn't wait\n" );
+    res = pNtSetIoCompletion( h, 12, 34, 56, 0 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ret = WaitForSingleObject( threads[0], 5000 );
+    ok( ret == WAIT_OBJECT_0, "thread didn't finish: %u\n", ret );
+    GetExitCodeThread( threads[0], &ret );
+    ok( ret == WAIT_OBJECT_0, "wait returned %u\n", ret );
+    CloseHandle( threads[0] );
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == 12, "wrong key %#lx\n", key );
+
+    /* closing the port while other threads use it */
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+        threads[i] = CreateThread( NULL, 0, completion_close_thread, h, 0, NULL );
+    Sleep( 50 );
+    pNtClose( h );
+    ret = WaitForMultipleObjects( ARRAY_SIZE(threads), threads, TRUE, 5000 );
+    ok( ret == WAIT_OBJECT_0, "threads didn't finish: %u\n", ret );
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        GetExitCodeThread( threads[i], &ret );
+        ok( ret == STATUS_INVALID_HANDLE || ret == STATUS_ABANDONED_WAIT_0, "thread %u got %#x\n", i, ret );
+        CloseHandle( threads[i] );
+    }
+}
+
 static void test_file_io_completion(void)
 {
     static const char pipe_name[] = "\\\\.\\pipe\\iocompletiontestnamedpipe";
@@ -4881,6 +4962,7 @@ START_TEST(file)
     append_file_test();
     nt_mailslot_test();
     test_set_io_completion();
+    test_completion_port_wait();
     test_file_io_completion();
     test_file_basic_information();
     test_file_all_information();
@@ -22,18 +22,21 @@
 
 static HMODULE hntdll = 0;
 static NTSTATUS (WINAPI *pTpAllocCleanupGroup)(TP_CLEANUP_GROUP **);
+static NTSTATUS (WINAPI *pTpAllocIoCompletion)(TP_IO **,HANDLE,PTP_IO_CALLBACK,void *,TP_CALLBACK_ENVIRON *);
 static NTSTATUS (WINAPI *pTpAllocPool)(TP_POOL **,PVOID);
 static NTSTATUS (WINAPI *pTpAllocTimer)(TP_TIMER **,PTP_TIMER_CALLBACK,PVOID,TP_CALLBACK_ENVIRON *);
 static NTSTATUS (WINAPI *pTpAllocWait)(TP_WAIT **,PTP_WAIT_CALLBACK,PVOID,TP_CALLBACK_ENVIRON *);
 static NTSTATUS (WINAPI *pTpAllocWork)(TP_WORK **,PTP_WORK_CALLBACK,PVOID,TP_CALLBACK_ENVIRON *);
 static NTSTATUS (WINAPI *pTpCallbackMayRunLong)(TP_CALLBACK_INSTANCE *);
 static VOID     (WINAPI *pTpCallbackReleaseSemaphoreOnCompletion)(TP_CALLBACK_INSTANCE *,HANDLE,DWORD);
+static VOID     (WINAPI *pTpCancelAsyncIoOperation)(TP_IO *);
 static VOID     (WINAPI *pTpDisassociateCallback)(TP_CALLBACK_INSTANCE *);
 static BOOL     (WINAPI *pTpIsTimerSet)(TP_TIMER *);
 static VOID     (WINAPI *pTpReleaseWait)(TP_WAIT *);
 static VOID     (WINAPI *pTpPostWork)(TP_WORK *);
 static VOID     (WINAPI *pTpReleaseCleanupGroup)(TP_CLEANUP_GROUP *);
 static VOID     (WINAPI *pTpReleaseCleanupGroupMembers)(TP_CLEANUP_GROUP *,BOOL,PVOID);
+static VOID     (WINAPI *pTpReleaseIoCompletion)(TP_IO *);
 static VOID     (WINAPI *pTpReleasePool)(TP_POOL *);
 static VOID     (WINAPI *pTpReleaseTimer)(TP_TIMER *);
 static VOID     (WINAPI *pTpReleaseWork)(TP_WORK *);
@@ -41,6 +44,8 @@ static VOID     (WINAPI *pTpSetPoolMaxThreads)(TP_POOL *,DWORD);
 static VOID     (WINAPI *pTpSetTimer)(TP_TIMER *,LARGE_INTEGER *,LONG,LONG);
 static VOID     (WINAPI *pTpSetWait)(TP_WAIT *,HANDLE,LARGE_INTEGER *);
 static NTSTATUS (WINAPI *pTpSimpleTryPost)(PTP_SIMPLE_CALLBACK,PVOID,TP_CALLBACK_ENVIRON *);
+static VOID     (WINAPI *pTpStartAsyncIoOperation)(TP_IO *);
+static VOID     (WINAPI *pTpWaitForIoCompletion)(TP_IO *,BOOL);
 static VOID     (WINAPI *pTpWaitForTimer)(TP_TIMER *,BOOL);
 static VOID     (WINAPI *pTpWaitForWait)(TP_WAIT *,BOOL);
 static VOID     (WINAPI *pTpWaitForWork)(TP_WORK *,BOOL);
@@ -63,17 +68,20 @@ static BOOL init_threadpool(void)
     }
 
     NTDLL_GET_PROC(TpAllocCleanupGroup);
+    NTDLL_GET_PROC(TpAllocIoCompletion);
     NTDLL_GET_PROC(TpAllocPool);
     NTDLL_GET_PROC(TpAllocTimer);
     NTDLL_GET_PROC(TpAllocWait);
     NTDLL_GET_PROC(TpAllocWork);
     NTDLL_GET_PROC(TpCallbackMayRunLong);
     NTDLL_GET_PROC(TpCallbackReleaseSemaphoreOnCompletion);
+    NTDLL_GET_PROC(TpCancelAsyncIoOperation);
     NTDLL_GET_PROC(TpDisassociateCallback);
     NTDLL_GET_PROC(TpIsTimerSet);
     NTDLL_GET_PROC(TpPostWork);
     NTDLL_GET_PROC(TpReleaseCleanupGroup);
     NTDLL_GET_PROC(TpReleaseCleanupGroupMembers);
+    NTDLL_GET_PROC(TpReleaseIoCompletion);
     NTDLL_GET_PROC(TpReleasePool);
     NTDLL_GET_PROC(TpReleaseTimer);
     NTDLL_GET_PROC(TpReleaseWait);
@@ -82,6 +90,8 @@ static BOOL init_threadpool(void)
     NTDLL_GET_PROC(TpSetTimer);
     NTDLL_GET_PROC(TpSetWait);
     NTDLL_GET_PROC(TpSimpleTryPost);
+    NTDLL_GET_PROC(TpStartAsyncIoOperation);
+    NTDLL_GET_PROC(TpWaitForIoCompletion);
     NTDLL_GET_PROC(TpWaitForTimer);
     NTDLL_GET_PROC(TpWaitForWait);
     NTDLL_GET_PROC(TpWaitForWork);
@@ -714,6 +724,91 @@ static void test_tp_work_scheduler(void)
     pTpReleasePool(pool);
 }
 
+#define STRESS_THREADS 4
+#define STRESS_ITEMS   10000
+
+static struct
+{
+    TP_CALLBACK_ENVIRON environment;
+    TP_WORK *work;
+    HANDLE start_event;
+    HANDLE done_event;
+    LONG simple_count;
+    LONG work_count;
+} stress;
+
+static void CALLBACK stress_simple_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    if (InterlockedIncrement(&stress.simple_count) == STRESS_THREADS * STRESS_ITEMS)
+        SetEvent(stress.done_event);
+}
+
+static void CALLBACK stress_work_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_WORK *work)
+{
+    InterlockedIncrement(&stress.work_count);
+}
+
+static DWORD WINAPI stress_thread(void *arg)
+{
+    NTSTATUS status;
+    int i;
+
+    WaitForSingleObject(stress.start_event, INFINITE);
+    for (i = 0; i < STRESS_ITEMS; i++)
+    {
+        status = pTpSimpleTryPost(stress_simple_cb, NULL, &stress.environment);
+        ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+        pTpPostWork(stress.work);
+    }
+    return 0;
+}
+
+static void test_tp_work_stress(void)
+{
+    HANDLE threads[STRESS_THREADS];
+    NTSTATUS status;
+    TP_POOL *pool;
+    DWORD result;
+    int i;
+
+    /* post lots of tiny work items from several threads at once */
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+    pTpSetPoolMaxThreads(pool, 8);
+
+    memset(&stress, 0, sizeof(stress));
+    stress.environment.Version = 1;
+    stress.environment.Pool = pool;
+    stress.start_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    stress.done_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    status = pTpAllocWork(&stress.work, stress_work_cb, NULL, &stress.environment);
+    ok(!status, "TpAllocWork failed with status %x\n", status);
+
+    for (i = 0; i < STRESS_THREADS; i++)
+        threads[i] = CreateThread(NULL, 0, stress_thread, NULL, 0, NULL);
+    SetEvent(stress.start_event);
+    result = WaitForMultipleObjects(STRESS_THREADS, threads, TRUE, 30000);
+    ok(result == WAIT_OBJECT_0, "WaitForMultipleObjects returned %u\n", result);
+
+    result = WaitForSingleObject(stress.done_event, 30000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    ok(stress.simple_count == STRESS_THREADS * STRESS_ITEMS, "expected %u simple callbacks, got %u\n",
+       STRESS_THREADS * STRESS_ITEMS, stress.simple_count);
+
+    pTpWaitForWork(stress.work, FALSE);
+    ok(stress.work_count == STRESS_THREADS * STRESS_ITEMS, "expected %u work callbacks, got %u\n",
+       STRESS_THREADS * STRESS_ITEMS, stress.work_count);
+
+    for (i = 0; i < STRESS_THREADS; i++)
+        CloseHandle(threads[i]);
+    CloseHandle(stress.start_event);
+    CloseHandle(stress.done_event);
+    pTpReleaseWork(stress.work);
+    pTpReleasePool(pool);
+}
+
 static void CALLBACK simple_release_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
 {
     HANDLE *semaphores = userdata;
@@ -1520,7 +1615,6 @@ static void test_tp_window_length(void)
     ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
     ok(info1.ticks != 0 && info2.ticks != 0, "expected that ticks are nonzero\n");
     merged = info2.ticks >= info1.ticks - 50 && info2.ticks <= info1.ticks + 50;
-    todo_wine
     ok(merged || broken(!merged) /* Win 10 */, "expected that timers are merged\n");
 
     /* cleanup */
@@ -1906,6 +2000,143 @@ static void test_tp_multi_wait(void)
     CloseHandle(semaphore);
 }
 
+static struct
+{
+    HANDLE semaphore;
+    LONG count;
+    LONG running;
+    LONG max_running;
+    void *ovl;
+    IO_STATUS_BLOCK iosb;
+    TP_IO *io;
+    DWORD sleep;
+} io_cb_info;
+
+static void CALLBACK io_cb(TP_CALLBACK_INSTANCE *instance, void *userdata,
+                           void *cvalue, IO_STATUS_BLOCK *iosb, TP_IO *io)
+{
+    LONG running = InterlockedIncrement(&io_cb_info.running);
+    LONG max_running;
+
+    while ((max_running = io_cb_info.max_running) < running &&
+           InterlockedCompareExchange(&io_cb_info.max_running, running, max_running) != max_running);
+
+    ok(userdata == &io_cb_info, "got userdata %p\n", userdata);
+    io_cb_info.ovl = cvalue;
+    io_cb_info.iosb = *iosb;
+    io_cb_info.io = io;
+    if (io_cb_info.sleep) Sleep(io_cb_info.sleep);
+
+    InterlockedDecrement(&io_cb_info.running);
+    InterlockedIncrement(&io_cb_info.count);
+    ReleaseSemaphore(io_cb_info.semaphore, 1, NULL);
+}
+
+static void test_tp_io(void)
+{
+    static const char pipe_name[] = "\\\\.\\pipe\\wine_tp_io_test";
+    TP_CALLBACK_ENVIRON environment = {1};
+    OVERLAPPED ovl[8], *first = &ovl[0];
+    char in[ARRAY_SIZE(ovl)], out[ARRAY_SIZE(ovl)];
+    HANDLE client, server;
+    NTSTATUS status;
+    TP_POOL *pool;
+    TP_IO *io;
+    DWORD ret, size;
+    int i;
+
+    if (!pTpAllocIoCompletion)
+    {
+        win_skip("TpAllocIoCompletion is not available\n");
+        return;
+    }
+
+    memset(&io_cb_info, 0, sizeof(io_cb_info));
+    io_cb_info.semaphore = CreateSemaphoreA(NULL, 0, ARRAY_SIZE(ovl), NULL);
+    ok(io_cb_info.semaphore != NULL, "failed to create semaphore, error %u\n", GetLastError());
+
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    pTpSetPoolMaxThreads(pool, 4);
+    environment.Pool = pool;
+
+    server = CreateNamedPipeA(pipe_name, PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED,
+                              PIPE_TYPE_BYTE, 1, 1024, 1024, 0, NULL);
+    ok(server != INVALID_HANDLE_VALUE, "failed to create pipe, error %u\n", GetLastError());
+    client = CreateFileA(pipe_name, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, 0);
+    ok(client != INVALID_HANDLE_VALUE, "failed to open pipe, error %u\n", GetLastError());
+
+    io = NULL;
+    status = pTpAllocIoCompletion(&io, server, io_cb, &io_cb_info, &environment);
+    ok(!status, "TpAllocIoCompletion failed with status %x\n", status);
+    ok(io != NULL, "expected io != NULL\n");
+
+    /* a single operation */
+    memset(ovl, 0, sizeof(ovl));
+    pTpStartAsyncIoOperation(io);
+    ret = ReadFile(server, in, 1, NULL, &ovl[0]);
+    ok(!ret && GetLastError() == ERROR_IO_PENDING, "got %d, error %u\n", ret, GetLastError());
+    ret = WriteFile(client, "a", 1, &size, NULL);
+    ok(ret, "WriteFile failed, error %u\n", GetLastError());
+
+    ret = WaitForSingleObject(io_cb_info.semaphore, 1000);
+    ok(!ret, "WaitForSingleObject returned %u\n", ret);
+    ok(io_cb_info.count == 1, "callback was called %u times\n", io_cb_info.count);
+    ok(io_cb_info.ovl == first, "expected %p, got %p\n", first, io_cb_info.ovl);
+    ok(io_cb_info.iosb.Status == STATUS_SUCCESS, "got status %x\n", io_cb_info.iosb.Status);
+    ok(io_cb_info.iosb.Information == 1, "got information %lu\n", io_cb_info.iosb.Information);
+    ok(io_cb_info.io == io, "expected %p, got %p\n", io, io_cb_info.io);
+    ok(in[0] == 'a', "got %#x\n", in[0]);
+
+    /* completions of several operations are dispatched to concurrent workers */
+    io_cb_info.count = 0;
+    io_cb_info.sleep = 100;
+    for (i = 0; i < ARRAY_SIZE(ovl); i++)
+    {
+        pTpStartAsyncIoOperation(io);
+        ret = ReadFile(server, &in[i], 1, NULL, &ovl[i]);
+        ok(!ret && GetLastError() == ERROR_IO_PENDING, "got %d, error %u\n", ret, GetLastError());
+        out[i] = 'b' + i;
+    }
+    ret = WriteFile(client, out, sizeof(out), &size, NULL);
+    ok(ret, "WriteFile failed, error %u\n", GetLastError());
+
+    for (i = 0; i < ARRAY_SIZE(ovl); i++)
+    {
+        ret = WaitForSingleObject(io_cb_info.semaphore, 2000);
+        ok(!ret, "WaitForSingleObject returned %u\n", ret);
+    }
+    pTpWaitForIoCompletion(io, FALSE);
+    ok(io_cb_info.count == ARRAY_SIZE(ovl), "callback was called %u times\n", io_cb_info.count);
+    ok(io_cb_info.max_running > 1, "callbacks were not run concurrently\n");
+    ok(!memcmp(in, out, sizeof(out)), "got wrong data\n");
+    io_cb_info.sleep = 0;
+
+    /* an operation which failed synchronously is cancelled */
+    io_cb_info.count = 0;
+    pTpStartAsyncIoOperation(io);
+    pTpCancelAsyncIoOperation(io);
+    pTpWaitForIoCompletion(io, FALSE);
+    ok(!io_cb_info.count, "callback was called %u times\n", io_cb_info.count);
+
+    /* the object stays alive until the started operation completes */
+    pTpStartAsyncIoOperation(io);
+    ret = ReadFile(server, in, 1, NULL, &ovl[0]);
+    ok(!ret && GetLastError() == ERROR_IO_PENDING, "got %d, error %u\n", ret, GetLastError());
+    pTpReleaseIoCompletion(io);
+    ret = WriteFile(client, "z", 1, &size, NULL);
+    ok(ret, "WriteFile failed, error %u\n", GetLastError());
+    ret = WaitForSingleObject(io_cb_info.semaphore, 1000);
+    ok(!ret, "WaitForSingleObject returned %u\n", ret);
+    ok(io_cb_info.count == 1, "callback was called %u times\n", io_cb_info.count);
+    ok(in[0] == 'z', "got %#x\n", in[0]);
+
+    CloseHandle(client);
+    CloseHandle(server);
+    CloseHandle(io_cb_info.semaphore);
+    pTpReleasePool(pool);
+}
+
 START_TEST(threadpool)
 {
     test_RtlQueueWorkItem();
@@ -1917,6 +2148,7 @@ START_TEST(threadpool)
     test_tp_simple();
     test_tp_work();
     test_tp_work_scheduler();
+    test_tp_work_stress();
     test_tp_group_wait();
     test_tp_group_cancel();
     test_tp_instance();
@@ -1925,4 +2157,5 @@ START_TEST(threadpool)
     test_tp_window_length();
     test_tp_wait();
     test_tp_multi_wait();
+    test_tp_io();
 }
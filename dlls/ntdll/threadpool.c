@@ -50,6 +50,7 @@ struct rtl_work_item
 
 #define EXPIRE_NEVER       (~(ULONGLONG)0)
 #define TIMER_QUEUE_MAGIC  0x516d6954   /* TimQ */
+#define TIMER_HEAP_NONE    (~0u)
 
 static RTL_CRITICAL_SECTION_DEBUG critsect_compl_debug;
 
@@ -84,6 +85,22 @@ struct wait_work_item
     int CallbackInProgress;
 };
 
+/* timer in a timer heap, shared by the old and new timer queues */
+struct timer_heap_entry
+{
+    ULONGLONG expire;           /* expiration time, EXPIRE_NEVER if not queued */
+    ULONGLONG deadline;         /* latest time at which the timer may fire */
+    unsigned int index;         /* index in the heap, TIMER_HEAP_NONE if not queued */
+};
+
+/* binary min-heap of timers, ordered by expiration time */
+struct timer_heap
+{
+    struct timer_heap_entry **entries;
+    unsigned int count;
+    unsigned int size;
+};
+
 struct timer_queue;
 struct queue_timer
 {
@@ -94,7 +111,7 @@ struct queue_timer
     PVOID param;
     DWORD period;
     ULONG flags;
-    ULONGLONG expire;
+    struct timer_heap_entry expire;
     BOOL destroy;               /* timer should be deleted; once set, never unset */
     HANDLE event;               /* removal event */
 };
@@ -103,7 +120,9 @@ struct timer_queue
 {
     DWORD magic;
     RTL_CRITICAL_SECTION cs;
-    struct list timers;         /* sorted by expiration time */
+    struct list timers;         /* all timers of the queue */
+    unsigned int timer_count;
+    struct timer_heap heap;     /* timers that are set to expire */
     BOOL quit;                  /* queue should be deleted; once set, never unset */
     HANDLE event;
     HANDLE thread;
@@ -114,8 +133,17 @@ struct timer_queue
  */
 
 #define THREADPOOL_WORKER_TIMEOUT 5000
+#define THREADPOOL_MAX_QUEUES 16
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
 
+/* work queue of a threadpool */
+struct threadpool_queue
+{
+    CRITICAL_SECTION        cs;
+    /* Pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
+    struct list             pools[3];
+};
+
 /* internal threadpool representation */
 struct threadpool
 {
@@ -123,14 +151,22 @@ struct threadpool
     LONG                    objcount;
     BOOL                    shutdown;
     CRITICAL_SECTION        cs;
-    /* Pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
-    struct list             pools[3];
+    /* Work queues, objects are assigned to one of them. Workers look at their
+     * own queue first and steal work from the other queues when it is empty. */
+    struct threadpool_queue queues[THREADPOOL_MAX_QUEUES];
+    unsigned int            num_queues;
+    LONG                    next_object_queue;
+    LONG                    next_worker_queue;
+    /* number of queued objects for each priority, modified via interlocked functions */
+    LONG                    num_queued[3];
     RTL_CONDITION_VARIABLE  update_event;
     /* information about worker threads, locked via .cs */
     int                     max_workers;
     int                     min_workers;
     int                     num_workers;
-    int                     num_busy_workers;
+    /* modified via interlocked functions, may be read without lock */
+    LONG                    num_busy_workers;
+    LONG                    num_waiting_workers;
 };
 
 enum threadpool_objtype
@@ -138,12 +174,21 @@ enum threadpool_objtype
     TP_OBJECT_TYPE_SIMPLE,
     TP_OBJECT_TYPE_WORK,
     TP_OBJECT_TYPE_TIMER,
-    TP_OBJECT_TYPE_WAIT
+    TP_OBJECT_TYPE_WAIT,
+    TP_OBJECT_TYPE_IO
+};
+
+/* completion packet received for an I/O object */
+struct io_completion
+{
+    IO_STATUS_BLOCK         iosb;
+    ULONG_PTR               cvalue;
 };
 
 /* internal threadpool object representation */
 struct threadpool_object
 {
+    void                   *win32_callback; /* leave space for kernel32 to store the win32 callback */
     LONG                    refcount;
     BOOL                    shutdown;
     /* read-only information */
@@ -159,7 +204,8 @@ struct threadpool_object
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
-    /* information about the pool, locked via .pool->cs */
+    /* information about the pool, locked via .queue->cs */
+    struct threadpool_queue *queue;
     struct list             pool_entry;
     RTL_CONDITION_VARIABLE  finished_event;
     RTL_CONDITION_VARIABLE  group_finished_event;
@@ -183,9 +229,8 @@ struct threadpool_object
             /* information about the timer, locked via timerqueue.cs */
             BOOL            timer_initialized;
             BOOL            timer_pending;
-            struct list     timer_entry;
+            struct timer_heap_entry timer_entry;
             BOOL            timer_set;
-            ULONGLONG       timeout;
             LONG            period;
             LONG            window_length;
         } timer;
@@ -200,6 +245,17 @@ struct threadpool_object
             ULONGLONG       timeout;
             HANDLE          handle;
         } wait;
+        struct
+        {
+            PTP_IO_CALLBACK callback;
+            /* information about the I/O object, locked via .queue->cs */
+            unsigned int    pending_count;
+            BOOL            shutting_down;
+            struct io_completion *completions;
+            unsigned int    completion_head;
+            unsigned int    completion_count;
+            unsigned int    completion_max;
+        } io;
     } u;
 };
 
@@ -239,7 +295,8 @@ static struct
     CRITICAL_SECTION        cs;
     LONG                    objcount;
     BOOL                    thread_running;
-    struct list             pending_timers;
+    struct timer_heap       pending_timers;
+    ULONGLONG               deadline;   /* deadline of the thread's current wait */
     RTL_CONDITION_VARIABLE  update_event;
 }
 timerqueue =
@@ -247,7 +304,8 @@ timerqueue =
     { &timerqueue_debug, -1, 0, 0, 0, 0 },      /* cs */
     0,                                          /* objcount */
     FALSE,                                      /* thread_running */
-    LIST_INIT( timerqueue.pending_timers ),     /* pending_timers */
+    { NULL, 0, 0 },                             /* pending_timers */
+    EXPIRE_NEVER,                               /* deadline */
     RTL_CONDITION_VARIABLE_INIT                 /* update_event */
 };
 
@@ -258,6 +316,29 @@ static RTL_CRITICAL_SECTION_DEBUG timerqueue_debug =
       0, 0, { (DWORD_PTR)(__FILE__ ": timerqueue.cs") }
 };
 
+/* global I/O completion queue object */
+static RTL_CRITICAL_SECTION_DEBUG ioqueue_debug;
+
+static struct
+{
+    CRITICAL_SECTION        cs;
+    BOOL                    thread_running;
+    HANDLE                  port;
+}
+ioqueue =
+{
+    { &ioqueue_debug, -1, 0, 0, 0, 0 },         /* cs */
+    FALSE,                                      /* thread_running */
+    NULL                                        /* port */
+};
+
+static RTL_CRITICAL_SECTION_DEBUG ioqueue_debug =
+{
+    0, 0, &ioqueue.cs,
+    { &ioqueue_debug.ProcessLocksList, &ioqueue_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": ioqueue.cs") }
+};
+
 /* global waitqueue object */
 static RTL_CRITICAL_SECTION_DEBUG waitqueue_debug;
 
@@ -316,6 +397,13 @@ static inline struct threadpool_object *impl_from_TP_WAIT( TP_WAIT *wait )
     return object;
 }
 
+static inline struct threadpool_object *impl_from_TP_IO( TP_IO *io )
+{
+    struct threadpool_object *object = (struct threadpool_object *)io;
+    assert( object->type == TP_OBJECT_TYPE_IO );
+    return object;
+}
+
 static inline struct threadpool_group *impl_from_TP_CLEANUP_GROUP( TP_CLEANUP_GROUP *group )
 {
     return (struct threadpool_group *)group;
@@ -709,6 +797,145 @@ NTSTATUS WINAPI RtlDeregisterWait(HANDLE WaitHandle)
 }
 
 
+/************************** Timer Heap Impl **************************/
+
+static NTSTATUS timer_heap_reserve(struct timer_heap *heap, unsigned int count)
+{
+    struct timer_heap_entry **entries;
+    unsigned int size;
+
+    if (count <= heap->size) return STATUS_SUCCESS;
+
+    size = max(count, max(16, heap->size * 2));
+    if (heap->entries)
+        entries = RtlReAllocateHeap(GetProcessHeap(), 0, heap->entries, size * sizeof(*entries));
+    else
+        entries = RtlAllocateHeap(GetProcessHeap(), 0, size * sizeof(*entries));
+    if (!entries) return STATUS_NO_MEMORY;
+
+    heap->entries = entries;
+    heap->size = size;
+    return STATUS_SUCCESS;
+}
+
+static inline void timer_heap_set(struct timer_heap *heap, unsigned int index,
+                                  struct timer_heap_entry *entry)
+{
+    heap->entries[index] = entry;
+    entry->index = index;
+}
+
+static void timer_heap_sift_up(struct timer_heap *heap, unsigned int index,
+                               struct timer_heap_entry *entry)
+{
+    while (index)
+    {
+        unsigned int parent = (index - 1) / 2;
+        if (heap->entries[parent]->expire <= entry->expire) break;
+        timer_heap_set(heap, index, heap->entries[parent]);
+        index = parent;
+    }
+    timer_heap_set(heap, index, entry);
+}
+
+static void timer_heap_sift_down(struct timer_heap *heap, unsigned int index,
+                                 struct timer_heap_entry *entry)
+{
+    unsigned int child;
+
+    while ((child = 2 * index + 1) < heap->count)
+    {
+        if (child + 1 < heap->count && heap->entries[child + 1]->expire < heap->entries[child]->expire)
+            child++;
+        if (entry->expire <= heap->entries[child]->expire) break;
+        timer_heap_set(heap, index, heap->entries[child]);
+        index = child;
+    }
+    timer_heap_set(heap, index, entry);
+}
+
+/* The caller must have reserved room for the entry with timer_heap_reserve. */
+static void timer_heap_insert(struct timer_heap *heap, struct timer_heap_entry *entry)
+{
+    assert(entry->index == TIMER_HEAP_NONE);
+    assert(heap->count < heap->size);
+    timer_heap_sift_up(heap, heap->count++, entry);
+}
+
+static void timer_heap_remove(struct timer_heap *heap, struct timer_heap_entry *entry)
+{
+    unsigned int index = entry->index;
+    struct timer_heap_entry *last;
+
+    assert(index < heap->count && heap->entries[index] == entry);
+    entry->index = TIMER_HEAP_NONE;
+
+    last = heap->entries[--heap->count];
+    if (last == entry) return;
+
+    if (index && heap->entries[(index - 1) / 2]->expire > last->expire)
+        timer_heap_sift_up(heap, index, last);
+    else
+        timer_heap_sift_down(heap, index, last);
+}
+
+static inline struct timer_heap_entry *timer_heap_top(const struct timer_heap *heap)
+{
+    return heap->count ? heap->entries[0] : NULL;
+}
+
+/* Only subtrees whose root expires before the bound need to be visited, so
+ * the cost is proportional to the number of timers fired by the next wake-up. */
+static void timer_heap_min_deadline(const struct timer_heap *heap, unsigned int index,
+                                    ULONGLONG *deadline)
+{
+    const struct timer_heap_entry *entry;
+
+    if (index >= heap->count) return;
+    entry = heap->entries[index];
+    if (entry->expire >= *deadline) return;
+    if (entry->deadline < *deadline) *deadline = entry->deadline;
+    timer_heap_min_deadline(heap, 2 * index + 1, deadline);
+    timer_heap_min_deadline(heap, 2 * index + 2, deadline);
+}
+
+static void timer_heap_max_expire(const struct timer_heap *heap, unsigned int index,
+                                  ULONGLONG deadline, ULONGLONG *expire)
+{
+    const struct timer_heap_entry *entry;
+
+    if (index >= heap->count) return;
+    entry = heap->entries[index];
+    if (entry->expire > deadline) return;
+    if (entry->expire > *expire) *expire = entry->expire;
+    timer_heap_max_expire(heap, 2 * index + 1, deadline, expire);
+    timer_heap_max_expire(heap, 2 * index + 2, deadline, expire);
+}
+
+/***********************************************************************
+ *           timer_heap_next_wakeup    (internal)
+ *
+ * Returns the time at which the owner of the heap has to wake up, or
+ * EXPIRE_NEVER if the heap is empty. Instead of waking up for the first
+ * timer, we wake up for the last one which expires before the earliest
+ * deadline, so that timers are coalesced according to their window. The
+ * earliest deadline is returned in the deadline parameter; a new timer
+ * expiring before it may change the wake-up time.
+ */
+static ULONGLONG timer_heap_next_wakeup(const struct timer_heap *heap, ULONGLONG *deadline)
+{
+    ULONGLONG wakeup;
+
+    *deadline = EXPIRE_NEVER;
+    if (!heap->count) return EXPIRE_NEVER;
+
+    timer_heap_min_deadline(heap, 0, deadline);
+    wakeup = heap->entries[0]->expire;
+    timer_heap_max_expire(heap, 0, *deadline, &wakeup);
+    return wakeup;
+}
+
+
 /************************** Timer Queue Impl **************************/
 
 static void queue_remove_timer(struct queue_timer *t)
@@ -721,7 +948,10 @@ static void queue_remove_timer(struct queue_timer *t)
     assert(t->runcount == 0);
     assert(t->destroy);
 
+    if (t->expire.index != TIMER_HEAP_NONE)
+        timer_heap_remove(&q->heap, &t->expire);
     list_remove(&t->entry);
+    q->timer_count--;
     if (t->event)
         NtSetEvent(t->event, NULL);
     RtlFreeHeap(GetProcessHeap(), 0, t);
@@ -764,24 +994,19 @@ static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
 {
     /* We MUST hold the queue cs while calling this function.  */
     struct timer_queue *q = t->q;
-    struct list *ptr = &q->timers;
 
     assert(!q->quit || (t->destroy && time == EXPIRE_NEVER));
 
-    if (time != EXPIRE_NEVER)
-        LIST_FOR_EACH(ptr, &q->timers)
-        {
-            struct queue_timer *cur = LIST_ENTRY(ptr, struct queue_timer, entry);
-            if (time < cur->expire)
-                break;
-        }
-    list_add_before(ptr, &t->entry);
-
-    t->expire = time;
+    /* Timers of the old API have no window, they fire at their
+       expiration time.  */
+    t->expire.expire = t->expire.deadline = time;
+    if (time == EXPIRE_NEVER)
+        return;
+    timer_heap_insert(&q->heap, &t->expire);
 
-    /* If we insert at the head of the list, we need to expire sooner
+    /* If the timer is now the first to expire, we need to expire sooner
        than expected.  */
-    if (set_event && &t->entry == list_head(&q->timers))
+    if (set_event && timer_heap_top(&q->heap) == &t->expire)
         NtSetEvent(q->event, NULL);
 }
 
@@ -789,25 +1014,32 @@ static inline void queue_move_timer(struct queue_timer *t, ULONGLONG time,
                                     BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
-    list_remove(&t->entry);
+    if (t->expire.index != TIMER_HEAP_NONE)
+        timer_heap_remove(&t->q->heap, &t->expire);
     queue_add_timer(t, time, set_event);
 }
 
 static void queue_timer_expire(struct timer_queue *q)
 {
-    struct queue_timer *t = NULL;
+    ULONGLONG now = queue_current_time();
+    struct timer_heap_entry *entry;
+    struct queue_timer *t;
 
-    RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    /* Fire all the timers that expired while we were waiting.  */
+    for (;;)
     {
-        ULONGLONG now, next;
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
-        if (!t->destroy && t->expire <= ((now = queue_current_time())))
+        t = NULL;
+
+        RtlEnterCriticalSection(&q->cs);
+        if ((entry = timer_heap_top(&q->heap)) && entry->expire <= now)
         {
+            ULONGLONG next;
+            t = CONTAINING_RECORD(entry, struct queue_timer, expire);
+            assert(!t->destroy);
             ++t->runcount;
             if (t->period)
             {
-                next = t->expire + t->period;
+                next = t->expire.expire + t->period;
                 /* avoid trigger cascade if overloaded / hibernated */
                 if (next < now)
                     next = now + t->period;
@@ -816,13 +1048,11 @@ static void queue_timer_expire(struct timer_queue *q)
                 next = EXPIRE_NEVER;
             queue_move_timer(t, next, FALSE);
         }
-        else
-            t = NULL;
-    }
-    RtlLeaveCriticalSection(&q->cs);
+        RtlLeaveCriticalSection(&q->cs);
+
+        if (!t)
+            break;
 
-    if (t)
-    {
         if (t->flags & WT_EXECUTEINTIMERTHREAD)
             timer_callback_wrapper(t);
         else
@@ -840,20 +1070,15 @@ static void queue_timer_expire(struct timer_queue *q)
 
 static ULONG queue_get_timeout(struct timer_queue *q)
 {
-    struct queue_timer *t;
+    ULONGLONG wakeup, deadline;
     ULONG timeout = INFINITE;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    wakeup = timer_heap_next_wakeup(&q->heap, &deadline);
+    if (wakeup != EXPIRE_NEVER)
     {
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
-        assert(!t->destroy || t->expire == EXPIRE_NEVER);
-
-        if (t->expire != EXPIRE_NEVER)
-        {
-            ULONGLONG time = queue_current_time();
-            timeout = t->expire < time ? 0 : t->expire - time;
-        }
+        ULONGLONG time = queue_current_time();
+        timeout = wakeup < time ? 0 : wakeup - time;
     }
     RtlLeaveCriticalSection(&q->cs);
 
@@ -898,6 +1123,7 @@ static void WINAPI timer_queue_thread_proc(LPVOID p)
     NtClose(q->event);
     RtlDeleteCriticalSection(&q->cs);
     q->magic = 0;
+    RtlFreeHeap(GetProcessHeap(), 0, q->heap.entries);
     RtlFreeHeap(GetProcessHeap(), 0, q);
     RtlExitUserThread( 0 );
 }
@@ -912,8 +1138,7 @@ static void queue_destroy_timer(struct queue_timer *t)
            cleanup wrapper.  */
         queue_remove_timer(t);
     else
-        /* Make sure no destroyed timer masks an active timer at the head
-           of the sorted list.  */
+        /* Make sure a destroyed timer doesn't fire anymore.  */
         queue_move_timer(t, EXPIRE_NEVER, FALSE);
 }
 
@@ -938,6 +1163,10 @@ NTSTATUS WINAPI RtlCreateTimerQueue(PHANDLE NewTimerQueue)
 
     RtlInitializeCriticalSection(&q->cs);
     list_init(&q->timers);
+    q->timer_count = 0;
+    q->heap.entries = NULL;
+    q->heap.count = 0;
+    q->heap.size = 0;
     q->quit = FALSE;
     q->magic = TIMER_QUEUE_MAGIC;
     status = NtCreateEvent(&q->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
@@ -1091,15 +1320,19 @@ NTSTATUS WINAPI RtlCreateTimer(PHANDLE NewTimer, HANDLE TimerQueue,
     t->param = Parameter;
     t->period = Period;
     t->flags = Flags;
+    t->expire.index = TIMER_HEAP_NONE;
     t->destroy = FALSE;
     t->event = NULL;
 
-    status = STATUS_SUCCESS;
     RtlEnterCriticalSection(&q->cs);
     if (q->quit)
         status = STATUS_INVALID_HANDLE;
-    else
+    else if (!(status = timer_heap_reserve(&q->heap, q->timer_count + 1)))
+    {
+        list_add_tail(&q->timers, &t->entry);
+        q->timer_count++;
         queue_add_timer(t, queue_current_time() + DueTime, TRUE);
+    }
     RtlLeaveCriticalSection(&q->cs);
 
     if (status == STATUS_SUCCESS)
@@ -1136,7 +1369,7 @@ NTSTATUS WINAPI RtlUpdateTimer(HANDLE TimerQueue, HANDLE Timer,
 
     RtlEnterCriticalSection(&q->cs);
     /* Can't change a timer if it was once-only or destroyed.  */
-    if (t->expire != EXPIRE_NEVER)
+    if (t->expire.expire != EXPIRE_NEVER)
     {
         t->period = Period;
         queue_move_timer(t, queue_current_time() + DueTime, TRUE);
@@ -1204,15 +1437,31 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+/***********************************************************************
+ *           tp_timerqueue_add    (internal)
+ *
+ * Adds a timer to the pending timers. The timerqueue lock must be held.
+ */
+static void tp_timerqueue_add( struct threadpool_object *timer, ULONGLONG expire )
+{
+    timer->u.timer.timer_entry.expire   = expire;
+    timer->u.timer.timer_entry.deadline = expire + (ULONGLONG)timer->u.timer.window_length * 10000;
+    timer_heap_insert( &timerqueue.pending_timers, &timer->u.timer.timer_entry );
+    timer->u.timer.timer_pending = TRUE;
+
+    /* Wake up the timer thread when the timeout has to be updated. */
+    if (expire <= timerqueue.deadline)
+        RtlWakeAllConditionVariable( &timerqueue.update_event );
+}
+
 /***********************************************************************
  *           timerqueue_thread_proc    (internal)
  */
 static void CALLBACK timerqueue_thread_proc( void *param )
 {
-    ULONGLONG timeout_lower, timeout_upper, new_timeout;
-    struct threadpool_object *other_timer;
+    struct timer_heap_entry *entry;
+    ULONGLONG wakeup;
     LARGE_INTEGER now, timeout;
-    struct list *ptr;
 
     TRACE( "starting timer queue thread\n" );
 
@@ -1222,59 +1471,34 @@ static void CALLBACK timerqueue_thread_proc( void *param )
         NtQuerySystemTime( &now );
 
         /* Check for expired timers. */
-        while ((ptr = list_head( &timerqueue.pending_timers )))
+        while ((entry = timer_heap_top( &timerqueue.pending_timers )) && entry->expire <= now.QuadPart)
         {
-            struct threadpool_object *timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry );
+            struct threadpool_object *timer = CONTAINING_RECORD( entry, struct threadpool_object, u.timer.timer_entry );
             assert( timer->type == TP_OBJECT_TYPE_TIMER );
             assert( timer->u.timer.timer_pending );
-            if (timer->u.timer.timeout > now.QuadPart)
-                break;
 
             /* Queue a new callback in one of the worker threads. */
-            list_remove( &timer->u.timer.timer_entry );
+            timer_heap_remove( &timerqueue.pending_timers, entry );
             timer->u.timer.timer_pending = FALSE;
             tp_object_submit( timer, FALSE );
 
             /* Insert the timer back into the queue, except it's marked for shutdown. */
             if (timer->u.timer.period && !timer->shutdown)
             {
-                timer->u.timer.timeout += (ULONGLONG)timer->u.timer.period * 10000;
-                if (timer->u.timer.timeout <= now.QuadPart)
-                    timer->u.timer.timeout = now.QuadPart + 1;
-
-                LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                                     struct threadpool_object, u.timer.timer_entry )
-                {
-                    assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                    if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                        break;
-                }
-                list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
-                timer->u.timer.timer_pending = TRUE;
+                ULONGLONG expire = entry->expire + (ULONGLONG)timer->u.timer.period * 10000;
+                if (expire <= now.QuadPart)
+                    expire = now.QuadPart + 1;
+                tp_timerqueue_add( timer, expire );
             }
         }
 
-        timeout_lower = TIMEOUT_INFINITE;
-        timeout_upper = TIMEOUT_INFINITE;
-
         /* Determine next timeout and use the window length to optimize wakeup times. */
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (other_timer->u.timer.timeout >= timeout_upper)
-                break;
-
-            timeout_lower = other_timer->u.timer.timeout;
-            new_timeout   = timeout_lower + (ULONGLONG)other_timer->u.timer.window_length * 10000;
-            if (new_timeout < timeout_upper)
-                timeout_upper = new_timeout;
-        }
+        wakeup = timer_heap_next_wakeup( &timerqueue.pending_timers, &timerqueue.deadline );
 
         /* Wait for timer update events or until the next timer expires. */
         if (timerqueue.objcount)
         {
-            timeout.QuadPart = timeout_lower;
+            timeout.QuadPart = wakeup == EXPIRE_NEVER ? TIMEOUT_INFINITE : wakeup;
             RtlSleepConditionVariableCS( &timerqueue.update_event, &timerqueue.cs, &timeout );
             continue;
         }
@@ -1312,7 +1536,7 @@ static NTSTATUS tp_new_worker_thread( struct threadpool *pool )
     {
         interlocked_inc( &pool->refcount );
         pool->num_workers++;
-        pool->num_busy_workers++;
+        interlocked_inc( &pool->num_busy_workers );
         NtClose( thread );
     }
     return status;
@@ -1331,8 +1555,9 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
 
     timer->u.timer.timer_initialized    = FALSE;
     timer->u.timer.timer_pending        = FALSE;
+    timer->u.timer.timer_entry.expire   = 0;
+    timer->u.timer.timer_entry.index    = TIMER_HEAP_NONE;
     timer->u.timer.timer_set            = FALSE;
-    timer->u.timer.timeout              = 0;
     timer->u.timer.period               = 0;
     timer->u.timer.window_length        = 0;
 
@@ -1351,6 +1576,10 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
         }
     }
 
+    /* Make sure that there is room for the timer in the pending timers. */
+    if (status == STATUS_SUCCESS)
+        status = timer_heap_reserve( &timerqueue.pending_timers, timerqueue.objcount + 1 );
+
     if (status == STATUS_SUCCESS)
     {
         timer->u.timer.timer_initialized = TRUE;
@@ -1376,14 +1605,14 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
         /* If timer was pending, remove it. */
         if (timer->u.timer.timer_pending)
         {
-            list_remove( &timer->u.timer.timer_entry );
+            timer_heap_remove( &timerqueue.pending_timers, &timer->u.timer.timer_entry );
             timer->u.timer.timer_pending = FALSE;
         }
 
         /* If the last timer object was destroyed, then wake up the thread. */
         if (!--timerqueue.objcount)
         {
-            assert( list_empty( &timerqueue.pending_timers ) );
+            assert( !timerqueue.pending_timers.count );
             RtlWakeAllConditionVariable( &timerqueue.update_event );
         }
 
@@ -1641,6 +1870,165 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
     RtlLeaveCriticalSection( &waitqueue.cs );
 }
 
+/***********************************************************************
+ *           tp_ioqueue_dispatch    (internal)
+ *
+ * Queues a completion packet received for an I/O object.
+ */
+static void tp_ioqueue_dispatch( struct threadpool_object *io, const IO_STATUS_BLOCK *iosb, ULONG_PTR cvalue )
+{
+    struct io_completion *completion;
+    BOOL release = FALSE;
+
+    RtlEnterCriticalSection( &io->queue->cs );
+
+    if (!io->u.io.pending_count)
+    {
+        WARN( "ignoring completion %lx for io %p without pending operation\n", cvalue, io );
+        RtlLeaveCriticalSection( &io->queue->cs );
+        return;
+    }
+
+    if (io->u.io.completion_count == io->u.io.completion_max)
+    {
+        unsigned int i, new_max = max( 4, io->u.io.completion_max * 2 );
+        struct io_completion *new_completions;
+
+        if (!(new_completions = RtlAllocateHeap( GetProcessHeap(), 0, new_max * sizeof(*new_completions) )))
+        {
+            /* The operation still has to be accounted for, or waiting for the
+             * object would never finish. */
+            ERR( "failed to allocate memory, dropping completion for io %p\n", io );
+            if (!--io->u.io.pending_count && io->u.io.shutting_down)
+                release = TRUE;
+            RtlLeaveCriticalSection( &io->queue->cs );
+            if (release)
+                tp_object_release( io );
+            return;
+        }
+        for (i = 0; i < io->u.io.completion_count; i++)
+            new_completions[i] = io->u.io.completions[(io->u.io.completion_head + i) % io->u.io.completion_max];
+        RtlFreeHeap( GetProcessHeap(), 0, io->u.io.completions );
+        io->u.io.completions    = new_completions;
+        io->u.io.completion_max = new_max;
+        io->u.io.completion_head = 0;
+    }
+
+    completion = &io->u.io.completions[(io->u.io.completion_head + io->u.io.completion_count++) %
+                                       io->u.io.completion_max];
+    completion->iosb   = *iosb;
+    completion->cvalue = cvalue;
+
+    /* The last completion after the object was released drops the queue reference. */
+    if (!--io->u.io.pending_count && io->u.io.shutting_down)
+        release = TRUE;
+
+    tp_object_submit( io, FALSE );
+    RtlLeaveCriticalSection( &io->queue->cs );
+
+    if (release)
+        tp_object_release( io );
+}
+
+/***********************************************************************
+ *           ioqueue_thread_proc    (internal)
+ */
+static void CALLBACK ioqueue_thread_proc( void *param )
+{
+    FILE_IO_COMPLETION_INFORMATION info[16];
+    NTSTATUS status;
+    ULONG i, count;
+
+    TRACE( "starting I/O completion thread\n" );
+
+    for (;;)
+    {
+        status = NtRemoveIoCompletionEx( ioqueue.port, info, ARRAY_SIZE(info), &count, NULL, FALSE );
+        if (status)
+        {
+            ERR( "NtRemoveIoCompletionEx failed with status %x\n", status );
+            break;
+        }
+
+        for (i = 0; i < count; i++)
+        {
+            struct threadpool_object *io = (struct threadpool_object *)info[i].CompletionKey;
+            if (io) tp_ioqueue_dispatch( io, &info[i].IoStatusBlock, info[i].CompletionValue );
+        }
+    }
+
+    RtlEnterCriticalSection( &ioqueue.cs );
+    ioqueue.thread_running = FALSE;
+    RtlLeaveCriticalSection( &ioqueue.cs );
+
+    TRACE( "terminating I/O completion thread\n" );
+    RtlExitUserThread( 0 );
+}
+
+/***********************************************************************
+ *           tp_ioqueue_lock    (internal)
+ *
+ * Associates a file with the global I/O completion port. When this
+ * succeeds, it is guaranteed that the completion thread is running.
+ */
+static NTSTATUS tp_ioqueue_lock( struct threadpool_object *io, HANDLE file )
+{
+    FILE_COMPLETION_INFORMATION info;
+    IO_STATUS_BLOCK iosb;
+    NTSTATUS status = STATUS_SUCCESS;
+
+    assert( io->type == TP_OBJECT_TYPE_IO );
+
+    RtlEnterCriticalSection( &ioqueue.cs );
+
+    if (!ioqueue.port)
+        status = NtCreateIoCompletion( &ioqueue.port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+
+    /* Make sure that the completion thread is running. */
+    if (status == STATUS_SUCCESS && !ioqueue.thread_running)
+    {
+        HANDLE thread;
+        status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                                      ioqueue_thread_proc, NULL, &thread, NULL );
+        if (status == STATUS_SUCCESS)
+        {
+            ioqueue.thread_running = TRUE;
+            NtClose( thread );
+        }
+    }
+
+    if (status == STATUS_SUCCESS)
+    {
+        info.CompletionPort = ioqueue.port;
+        info.CompletionKey  = (ULONG_PTR)io;
+        status = NtSetInformationFile( file, &iosb, &info, sizeof(info), FileCompletionInformation );
+    }
+
+    RtlLeaveCriticalSection( &ioqueue.cs );
+    return status;
+}
+
+/***********************************************************************
+ *           tp_ioqueue_unlock    (internal)
+ *
+ * Releases the completion queue reference of an I/O object, or defers
+ * that until the completions of all started operations have arrived.
+ */
+static void tp_ioqueue_unlock( struct threadpool_object *io )
+{
+    BOOL release;
+
+    assert( io->type == TP_OBJECT_TYPE_IO );
+
+    RtlEnterCriticalSection( &io->queue->cs );
+    release = !io->u.io.shutting_down && !io->u.io.pending_count;
+    io->u.io.shutting_down = TRUE;
+    RtlLeaveCriticalSection( &io->queue->cs );
+
+    if (release)
+        tp_object_release( io );
+}
+
 /***********************************************************************
  *           tp_threadpool_alloc    (internal)
  *
@@ -1662,14 +2050,30 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     RtlInitializeCriticalSection( &pool->cs );
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-        list_init( &pool->pools[i] );
+    /* one queue per processor, so that workers rarely contend for the same lock */
+    pool->num_queues            = NtCurrentTeb()->Peb->NumberOfProcessors;
+    pool->num_queues            = max( 1, min( pool->num_queues, THREADPOOL_MAX_QUEUES ) );
+    pool->next_object_queue     = 0;
+    pool->next_worker_queue     = 0;
+    for (i = 0; i < pool->num_queues; ++i)
+    {
+        struct threadpool_queue *queue = &pool->queues[i];
+        unsigned int j;
+
+        RtlInitializeCriticalSection( &queue->cs );
+        queue->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool_queue.cs");
+        for (j = 0; j < ARRAY_SIZE(queue->pools); ++j)
+            list_init( &queue->pools[j] );
+    }
+    for (i = 0; i < ARRAY_SIZE(pool->num_queued); ++i)
+        pool->num_queued[i] = 0;
     RtlInitializeConditionVariable( &pool->update_event );
 
     pool->max_workers           = 500;
     pool->min_workers           = 0;
     pool->num_workers           = 0;
     pool->num_busy_workers      = 0;
+    pool->num_waiting_workers   = 0;
 
     TRACE( "allocated threadpool %p\n", pool );
 
@@ -1708,8 +2112,16 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
 
     assert( pool->shutdown );
     assert( !pool->objcount );
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-        assert( list_empty( &pool->pools[i] ) );
+    for (i = 0; i < pool->num_queues; ++i)
+    {
+        struct threadpool_queue *queue = &pool->queues[i];
+        unsigned int j;
+
+        for (j = 0; j < ARRAY_SIZE(queue->pools); ++j)
+            assert( list_empty( &queue->pools[j] ) );
+        queue->cs.DebugInfo->Spare[0] = 0;
+        RtlDeleteCriticalSection( &queue->cs );
+    }
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1889,6 +2301,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     memset( &object->group_entry, 0, sizeof(object->group_entry) );
     object->is_group_member         = FALSE;
 
+    object->queue = &pool->queues[(ULONG)interlocked_inc( &pool->next_object_queue ) % pool->num_queues];
     memset( &object->pool_entry, 0, sizeof(object->pool_entry) );
     RtlInitializeConditionVariable( &object->finished_event );
     RtlInitializeConditionVariable( &object->group_finished_event );
@@ -1911,7 +2324,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
             TP_CALLBACK_ENVIRON_V3 *environment_v3 = (TP_CALLBACK_ENVIRON_V3 *)environment;
 
             object->priority = environment_v3->CallbackPriority;
-            assert( object->priority < ARRAY_SIZE(pool->pools) );
+            assert( object->priority < ARRAY_SIZE(pool->num_queued) );
         }
 
         if (environment->ActivationContext)
@@ -1950,22 +2363,25 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
 
 static void tp_object_prio_queue( struct threadpool_object *object )
 {
-    list_add_tail( &object->pool->pools[object->priority], &object->pool_entry );
+    list_add_tail( &object->queue->pools[object->priority], &object->pool_entry );
 }
 
 /***********************************************************************
- *           tp_object_submit    (internal)
+ *           tp_threadpool_notify    (internal)
  *
- * Submits a threadpool object to the associated threadpool. This
- * function has to be VOID because TpPostWork can never fail on Windows.
+ * Makes sure that a worker thread picks up newly queued work, starting
+ * a new thread if all of them are busy.
  */
-static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
+static void tp_threadpool_notify( struct threadpool *pool )
 {
-    struct threadpool *pool = object->pool;
     NTSTATUS status = STATUS_UNSUCCESSFUL;
 
-    assert( !object->shutdown );
-    assert( !pool->shutdown );
+    /* The pool lock is only needed when a thread has to be started or woken up. A worker
+     * increments num_waiting_workers before checking num_queued for the last time, so
+     * either it sees the new item or we see that it is waiting. */
+    if (!pool->num_waiting_workers &&
+        (pool->num_busy_workers < pool->num_workers || pool->num_workers >= pool->max_workers))
+        return;
 
     RtlEnterCriticalSection( &pool->cs );
 
@@ -1974,23 +2390,45 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
         pool->num_workers < pool->max_workers)
         status = tp_new_worker_thread( pool );
 
+    /* No new thread started - wake up one existing thread. */
+    if (status != STATUS_SUCCESS)
+    {
+        assert( pool->num_workers > 0 );
+        RtlWakeConditionVariable( &pool->update_event );
+    }
+
+    RtlLeaveCriticalSection( &pool->cs );
+}
+
+/***********************************************************************
+ *           tp_object_submit    (internal)
+ *
+ * Submits a threadpool object to the associated threadpool. This
+ * function has to be VOID because TpPostWork can never fail on Windows.
+ */
+static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
+{
+    struct threadpool *pool = object->pool;
+
+    /* I/O objects still receive the completions of operations started before they were released. */
+    assert( !object->shutdown || object->type == TP_OBJECT_TYPE_IO );
+    assert( !pool->shutdown );
+
     /* Queue work item and increment refcount. */
+    RtlEnterCriticalSection( &object->queue->cs );
     interlocked_inc( &object->refcount );
     if (!object->num_pending_callbacks++)
+    {
         tp_object_prio_queue( object );
+        interlocked_inc( &pool->num_queued[object->priority] );
+    }
 
     /* Count how often the object was signaled. */
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
+    RtlLeaveCriticalSection( &object->queue->cs );
 
-    /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
-    {
-        assert( pool->num_workers > 0 );
-        RtlWakeConditionVariable( &pool->update_event );
-    }
-
-    RtlLeaveCriticalSection( &pool->cs );
+    tp_threadpool_notify( pool );
 }
 
 /***********************************************************************
@@ -2003,17 +2441,20 @@ static void tp_object_cancel( struct threadpool_object *object )
     struct threadpool *pool = object->pool;
     LONG pending_callbacks = 0;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &object->queue->cs );
     if (object->num_pending_callbacks)
     {
         pending_callbacks = object->num_pending_callbacks;
         object->num_pending_callbacks = 0;
         list_remove( &object->pool_entry );
+        interlocked_dec( &pool->num_queued[object->priority] );
 
         if (object->type == TP_OBJECT_TYPE_WAIT)
             object->u.wait.signaled = 0;
+        if (object->type == TP_OBJECT_TYPE_IO)
+            object->u.io.completion_count = 0;
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &object->queue->cs );
 
     while (pending_callbacks--)
         tp_object_release( object );
@@ -2027,20 +2468,20 @@ static void tp_object_cancel( struct threadpool_object *object )
  */
 static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
 {
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
     if (group_wait)
     {
         while (object->num_pending_callbacks || object->num_running_callbacks)
-            RtlSleepConditionVariableCS( &object->group_finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->group_finished_event, &queue->cs, NULL );
     }
     else
     {
         while (object->num_pending_callbacks || object->num_associated_callbacks)
-            RtlSleepConditionVariableCS( &object->finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->finished_event, &queue->cs, NULL );
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
 }
 
 /***********************************************************************
@@ -2054,6 +2495,8 @@ static void tp_object_prepare_shutdown( struct threadpool_object *object )
         tp_timerqueue_unlock( object );
     else if (object->type == TP_OBJECT_TYPE_WAIT)
         tp_waitqueue_unlock( object );
+    else if (object->type == TP_OBJECT_TYPE_IO)
+        tp_ioqueue_unlock( object );
 }
 
 /***********************************************************************
@@ -2094,46 +2537,57 @@ static BOOL tp_object_release( struct threadpool_object *object )
     if (object->race_dll)
         LdrUnloadDll( object->race_dll );
 
+    if (object->type == TP_OBJECT_TYPE_IO)
+        RtlFreeHeap( GetProcessHeap(), 0, object->u.io.completions );
+
     RtlFreeHeap( GetProcessHeap(), 0, object );
     return TRUE;
 }
 
-static struct list *threadpool_get_next_item( const struct threadpool *pool )
+static BOOL threadpool_has_work( const struct threadpool *pool )
 {
-    struct list *ptr;
     unsigned int i;
 
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-    {
-        if ((ptr = list_head( &pool->pools[i] )))
-            break;
-    }
+    for (i = 0; i < ARRAY_SIZE(pool->num_queued); ++i)
+        if (pool->num_queued[i]) return TRUE;
 
-    return ptr;
+    return FALSE;
 }
 
 /***********************************************************************
- *           threadpool_worker_proc    (internal)
+ *           threadpool_get_next_item    (internal)
+ *
+ * Dequeues the next callback with the highest priority. Each worker starts
+ * looking at its own position in the queue array and steals from the other
+ * queues if there is nothing at that priority. The position then moves past
+ * the queue the work was taken from, so that queues are served round-robin.
  */
-static void CALLBACK threadpool_worker_proc( void *param )
+static struct threadpool_object *threadpool_get_next_item( struct threadpool *pool, unsigned int *pos,
+                                                           TP_WAIT_RESULT *wait_result,
+                                                           struct io_completion *completion )
 {
-    TP_CALLBACK_INSTANCE *callback_instance;
-    struct threadpool_instance instance;
-    struct threadpool *pool = param;
-    TP_WAIT_RESULT wait_result = 0;
-    LARGE_INTEGER timeout;
+    struct threadpool_object *object;
+    struct threadpool_queue *queue;
+    unsigned int i, prio;
     struct list *ptr;
-    NTSTATUS status;
 
-    TRACE( "starting worker thread for pool %p\n", pool );
-
-    RtlEnterCriticalSection( &pool->cs );
-    pool->num_busy_workers--;
-    for (;;)
+    for (prio = 0; prio < ARRAY_SIZE(pool->num_queued); ++prio)
     {
-        while ((ptr = threadpool_get_next_item( pool )))
+        if (!pool->num_queued[prio]) continue;
+
+        for (i = 0; i < pool->num_queues; ++i)
         {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+            queue = &pool->queues[(*pos + i) % pool->num_queues];
+            if (list_empty( &queue->pools[prio] )) continue;
+
+            RtlEnterCriticalSection( &queue->cs );
+            if (!(ptr = list_head( &queue->pools[prio] )))
+            {
+                RtlLeaveCriticalSection( &queue->cs );
+                continue;
+            }
+
+            object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
             assert( object->num_pending_callbacks > 0 );
 
             /* If further pending callbacks are queued, move the work item to
@@ -2141,19 +2595,64 @@ static void CALLBACK threadpool_worker_proc( void *param )
             list_remove( &object->pool_entry );
             if (--object->num_pending_callbacks)
                 tp_object_prio_queue( object );
+            else
+                interlocked_dec( &pool->num_queued[prio] );
 
             /* For wait objects check if they were signaled or have timed out. */
             if (object->type == TP_OBJECT_TYPE_WAIT)
             {
-                wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
-                if (wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
+                *wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+                if (*wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
+            }
+
+            /* For I/O objects pass the oldest completion packet. */
+            if (object->type == TP_OBJECT_TYPE_IO)
+            {
+                assert( object->u.io.completion_count );
+                *completion = object->u.io.completions[object->u.io.completion_head];
+                object->u.io.completion_head = (object->u.io.completion_head + 1) % object->u.io.completion_max;
+                object->u.io.completion_count--;
             }
 
-            /* Leave critical section and do the actual callback. */
             object->num_associated_callbacks++;
             object->num_running_callbacks++;
-            pool->num_busy_workers++;
-            RtlLeaveCriticalSection( &pool->cs );
+            RtlLeaveCriticalSection( &queue->cs );
+
+            *pos = (*pos + i + 1) % pool->num_queues;
+            return object;
+        }
+    }
+
+    return NULL;
+}
+
+/***********************************************************************
+ *           threadpool_worker_proc    (internal)
+ */
+static void CALLBACK threadpool_worker_proc( void *param )
+{
+    TP_CALLBACK_INSTANCE *callback_instance;
+    struct threadpool_instance instance;
+    struct threadpool *pool = param;
+    struct threadpool_object *object;
+    struct io_completion completion;
+    TP_WAIT_RESULT wait_result = 0;
+    LARGE_INTEGER timeout;
+    unsigned int pos;
+    NTSTATUS status;
+
+    TRACE( "starting worker thread for pool %p\n", pool );
+
+    pos = (ULONG)interlocked_inc( &pool->next_worker_queue ) % pool->num_queues;
+    interlocked_dec( &pool->num_busy_workers );
+    for (;;)
+    {
+        while ((object = threadpool_get_next_item( pool, &pos, &wait_result, &completion )))
+        {
+            /* Do the actual callback without holding any lock. If more work is
+             * queued, e.g. a burst of I/O completions, let another thread take it. */
+            interlocked_inc( &pool->num_busy_workers );
+            if (threadpool_has_work( pool )) tp_threadpool_notify( pool );
 
             /* Initialize threadpool instance struct. */
             callback_instance = (TP_CALLBACK_INSTANCE *)&instance;
@@ -2206,6 +2705,17 @@ static void CALLBACK threadpool_worker_proc( void *param )
                     break;
                 }
 
+                case TP_OBJECT_TYPE_IO:
+                {
+                    TRACE( "executing I/O callback %p(%p, %p, %#lx, %p, %p)\n",
+                           object->u.io.callback, callback_instance, object->userdata,
+                           completion.cvalue, &completion.iosb, object );
+                    object->u.io.callback( callback_instance, object->userdata,
+                                           (void *)completion.cvalue, &completion.iosb, (TP_IO *)object );
+                    TRACE( "callback %p returned\n", object->u.io.callback );
+                    break;
+                }
+
                 default:
                     assert(0);
                     break;
@@ -2246,8 +2756,8 @@ static void CALLBACK threadpool_worker_proc( void *param )
             }
 
         skip_cleanup:
-            RtlEnterCriticalSection( &pool->cs );
-            pool->num_busy_workers--;
+            interlocked_dec( &pool->num_busy_workers );
+            RtlEnterCriticalSection( &object->queue->cs );
 
             /* Simple callbacks are automatically shutdown after execution. */
             if (object->type == TP_OBJECT_TYPE_SIMPLE)
@@ -2267,12 +2777,28 @@ static void CALLBACK threadpool_worker_proc( void *param )
                     RtlWakeAllConditionVariable( &object->finished_event );
             }
 
+            RtlLeaveCriticalSection( &object->queue->cs );
             tp_object_release( object );
         }
 
+        RtlEnterCriticalSection( &pool->cs );
+
         /* Shutdown worker thread if requested. */
         if (pool->shutdown)
+        {
+            pool->num_workers--;
             break;
+        }
+
+        /* Announce that we are about to wait before checking for work a last
+         * time, tp_object_submit checks num_waiting_workers after queuing. */
+        interlocked_inc( &pool->num_waiting_workers );
+        if (threadpool_has_work( pool ))
+        {
+            interlocked_dec( &pool->num_waiting_workers );
+            RtlLeaveCriticalSection( &pool->cs );
+            continue;
+        }
 
         /* Wait for new tasks or until the timeout expires. A thread only terminates
          * when no new tasks are available, and the number of threads can be
@@ -2280,14 +2806,23 @@ static void CALLBACK threadpool_worker_proc( void *param )
          * min_workers == 0, then objcount is used to detect if the last thread
          * can be terminated. */
         timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-        if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !threadpool_get_next_item( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
-            (!pool->min_workers && !pool->objcount)))
+        status = RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout );
+        if (status == STATUS_TIMEOUT &&
+            (pool->num_workers > max( pool->min_workers, 1 ) || (!pool->min_workers && !pool->objcount)))
         {
-            break;
+            /* Stay accounted as waiting until the thread is gone, so that
+             * tp_object_submit notices if work arrives in the meantime. */
+            pool->num_workers--;
+            if (!threadpool_has_work( pool ))
+            {
+                interlocked_dec( &pool->num_waiting_workers );
+                break;
+            }
+            pool->num_workers++;
         }
+        interlocked_dec( &pool->num_waiting_workers );
+        RtlLeaveCriticalSection( &pool->cs );
     }
-    pool->num_workers--;
     RtlLeaveCriticalSection( &pool->cs );
 
     TRACE( "terminating worker thread for pool %p\n", pool );
@@ -2305,6 +2840,57 @@ NTSTATUS WINAPI TpAllocCleanupGroup( TP_CLEANUP_GROUP **out )
     return tp_group_alloc( (struct threadpool_group **)out );
 }
 
+/***********************************************************************
+ *           TpAllocIoCompletion    (NTDLL.@)
+ */
+NTSTATUS WINAPI TpAllocIoCompletion( TP_IO **out, HANDLE file, PTP_IO_CALLBACK callback,
+                                     void *userdata, TP_CALLBACK_ENVIRON *environment )
+{
+    struct threadpool_object *object;
+    struct threadpool *pool;
+    NTSTATUS status;
+
+    TRACE( "%p %p %p %p %p\n", out, file, callback, userdata, environment );
+
+    object = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*object) );
+    if (!object)
+        return STATUS_NO_MEMORY;
+
+    status = tp_threadpool_lock( &pool, environment );
+    if (status)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, object );
+        return status;
+    }
+
+    object->type = TP_OBJECT_TYPE_IO;
+    object->u.io.callback           = callback;
+    object->u.io.pending_count      = 0;
+    object->u.io.shutting_down      = FALSE;
+    object->u.io.completions        = NULL;
+    object->u.io.completion_head    = 0;
+    object->u.io.completion_count   = 0;
+    object->u.io.completion_max     = 0;
+
+    /* Completions may arrive as soon as the file is bound to the port, so the
+     * object has to be fully set up before. */
+    tp_object_initialize( object, pool, userdata, environment );
+
+    status = tp_ioqueue_lock( object, file );
+    if (status)
+    {
+        object->shutdown = TRUE;
+        tp_object_release( object );
+        return status;
+    }
+
+    /* Keep a reference for the completion queue, released by tp_ioqueue_unlock. */
+    interlocked_inc( &object->refcount );
+
+    *out = (TP_IO *)object;
+    return STATUS_SUCCESS;
+}
+
 /***********************************************************************
  *           TpAllocPool    (NTDLL.@)
  */
@@ -2539,6 +3125,27 @@ VOID WINAPI TpCallbackUnloadDllOnCompletion( TP_CALLBACK_INSTANCE *instance, HMO
         this->cleanup.library = module;
 }
 
+/***********************************************************************
+ *           TpCancelAsyncIoOperation    (NTDLL.@)
+ */
+VOID WINAPI TpCancelAsyncIoOperation( TP_IO *io )
+{
+    struct threadpool_object *this = impl_from_TP_IO( io );
+    BOOL release = FALSE;
+
+    TRACE( "%p\n", io );
+
+    RtlEnterCriticalSection( &this->queue->cs );
+    if (!this->u.io.pending_count)
+        WARN( "no pending operation for io %p\n", io );
+    else if (!--this->u.io.pending_count && this->u.io.shutting_down)
+        release = TRUE;
+    RtlLeaveCriticalSection( &this->queue->cs );
+
+    if (release)
+        tp_object_release( this );
+}
+
 /***********************************************************************
  *           TpDisassociateCallback    (NTDLL.@)
  */
@@ -2546,7 +3153,6 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
 {
     struct threadpool_instance *this = impl_from_TP_CALLBACK_INSTANCE( instance );
     struct threadpool_object *object = this->object;
-    struct threadpool *pool;
 
     TRACE( "%p\n", instance );
 
@@ -2559,14 +3165,13 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     if (!this->associated)
         return;
 
-    pool = object->pool;
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &object->queue->cs );
 
     object->num_associated_callbacks--;
     if (!object->num_pending_callbacks && !object->num_associated_callbacks)
         RtlWakeAllConditionVariable( &object->finished_event );
 
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &object->queue->cs );
     this->associated = FALSE;
 }
 
@@ -2680,6 +3285,20 @@ VOID WINAPI TpReleaseCleanupGroupMembers( TP_CLEANUP_GROUP *group, BOOL cancel_p
     }
 }
 
+/***********************************************************************
+ *           TpReleaseIoCompletion    (NTDLL.@)
+ */
+VOID WINAPI TpReleaseIoCompletion( TP_IO *io )
+{
+    struct threadpool_object *this = impl_from_TP_IO( io );
+
+    TRACE( "%p\n", io );
+
+    tp_object_prepare_shutdown( this );
+    this->shutdown = TRUE;
+    tp_object_release( this );
+}
+
 /***********************************************************************
  *           TpReleasePool    (NTDLL.@)
  */
@@ -2785,7 +3404,6 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
     BOOL submit_timer = FALSE;
     ULONGLONG timestamp;
 
@@ -2824,31 +3442,16 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
     /* First remove existing timeout. */
     if (this->u.timer.timer_pending)
     {
-        list_remove( &this->u.timer.timer_entry );
+        timer_heap_remove( &timerqueue.pending_timers, &this->u.timer.timer_entry );
         this->u.timer.timer_pending = FALSE;
     }
 
     /* If the timer was enabled, then add it back to the queue. */
     if (timeout)
     {
-        this->u.timer.timeout       = timestamp;
         this->u.timer.period        = period;
         this->u.timer.window_length = window_length;
-
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
-
-        /* Wake up the timer thread when the timeout has to be updated. */
-        if (list_head( &timerqueue.pending_timers ) == &this->u.timer.timer_entry )
-            RtlWakeAllConditionVariable( &timerqueue.update_event );
-
-        this->u.timer.timer_pending = TRUE;
+        tp_timerqueue_add( this, timestamp );
     }
 
     RtlLeaveCriticalSection( &timerqueue.cs );
@@ -2948,6 +3551,34 @@ NTSTATUS WINAPI TpSimpleTryPost( PTP_SIMPLE_CALLBACK callback, PVOID userdata,
     return STATUS_SUCCESS;
 }
 
+/***********************************************************************
+ *           TpStartAsyncIoOperation    (NTDLL.@)
+ */
+VOID WINAPI TpStartAsyncIoOperation( TP_IO *io )
+{
+    struct threadpool_object *this = impl_from_TP_IO( io );
+
+    TRACE( "%p\n", io );
+
+    RtlEnterCriticalSection( &this->queue->cs );
+    this->u.io.pending_count++;
+    RtlLeaveCriticalSection( &this->queue->cs );
+}
+
+/***********************************************************************
+ *           TpWaitForIoCompletion    (NTDLL.@)
+ */
+VOID WINAPI TpWaitForIoCompletion( TP_IO *io, BOOL cancel_pending )
+{
+    struct threadpool_object *this = impl_from_TP_IO( io );
+
+    TRACE( "%p %d\n", io, cancel_pending );
+
+    if (cancel_pending)
+        tp_object_cancel( this );
+    tp_object_wait( this, FALSE );
+}
+
 /***********************************************************************
  *           TpWaitForTimer    (NTDLL.@)
  */
@@ -0,0 +1,889 @@
+/*
+ * io_uring-based asynchronous I/O
+ *
+ * Copyright (C) the Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <errno.h>
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+#ifdef HAVE_SYS_POLL_H
+# include <sys/poll.h>
+#endif
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+# include <linux/kcmp.h>
+#endif
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#define NONAMELESSUNION
+#include "windef.h"
+#include "winternl.h"
+#include "wine/server.h"
+#include "wine/debug.h"
+#include "wine/list.h"
+
+#include "ntdll_misc.h"
+#include "uring.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(uring);
+
+int do_uring(void)
+{
+    static int do_uring_cached = -1;
+
+    if (do_uring_cached == -1)
+        do_uring_cached = getenv("WINEURING") && atoi(getenv("WINEURING"));
+
+    return do_uring_cached;
+}
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+
+#define URING_ENTRIES 256
+
+extern ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags );
+
+/* Overlapped requests on an object have to complete in the order they were
+ * issued, so they are either all queued on the ring or all sent to the server.
+ * An object switches to the server for good once it gets a request that the
+ * ring can't handle. Objects are identified by the inode of their unix fd. */
+struct uring_object
+{
+    struct list          entry;
+    dev_t                dev;
+    ino_t                ino;
+    unsigned int         ops[2];     /* writes and reads queued on the ring or in the backlog */
+    BOOL                 use_server; /* requests are sent to the server */
+};
+
+/* An overlapped read or write which would otherwise have been queued on the
+ * server. The transfer itself is submitted to the ring, and the kernel
+ * performs it once the fd is ready. If the kernel gives up because the fd is
+ * non-blocking, we arm a poll and submit the transfer again when it fires.
+ * The reaper thread completes the request, so the server is never involved. */
+struct uring_op
+{
+    struct list          entry;      /* entry in uring_ops or uring_backlog */
+    struct uring_object *object;
+    HANDLE               handle;
+    BOOL                 own_handle; /* handle is a private duplicate */
+    int                  fd;         /* private dup of the unix fd */
+    BYTE                 opcode;     /* IORING_OP_READV, WRITEV, RECVMSG or SENDMSG */
+    BOOL                 is_read;
+    BOOL                 avail_mode;
+    BOOL                 polling;    /* waiting for a poll rather than for the transfer */
+    BOOL                 locked;     /* the buffer has write watches, read it from the reaper thread */
+    BOOL                 cancelled;  /* cancelled or being completed */
+    BOOL                 completing; /* the completion is being posted */
+    BOOL                 waiting;    /* in the backlog, not submitted yet */
+    ULONGLONG            offset;     /* file offset for READV and WRITEV */
+    ULONG                already;
+    ULONG                count;
+    int                  flags;      /* flags for RECVMSG and SENDMSG */
+    struct msghdr        msg;
+    uring_msg_callback   callback;
+    void                *callback_arg;
+    HANDLE               event;
+    PIO_APC_ROUTINE      apc;
+    void                *apc_user;
+    DWORD                tid;        /* issuing thread id */
+    HANDLE               thread;     /* issuing thread, if we need to queue an APC */
+    ULONG_PTR            cvalue;
+    IO_STATUS_BLOCK     *iosb;
+    unsigned int         iov_count;
+    unsigned int         first_iov;
+    struct iovec         iov[1];
+};
+
+static int uring_fd = -1;
+static unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+static unsigned int *cq_head, *cq_tail, *cq_mask;
+static struct io_uring_sqe *sqes;
+static struct io_uring_cqe *cqes;
+static unsigned int cq_entries;
+
+/* protects the submission ring, the lists of ops and the objects */
+static RTL_CRITICAL_SECTION uring_section;
+static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
+{
+    0, 0, &uring_section,
+    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": uring_section") }
+};
+static RTL_CRITICAL_SECTION uring_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+static struct list uring_ops = LIST_INIT( uring_ops );
+static struct list uring_backlog = LIST_INIT( uring_backlog );  /* ops waiting for room in the ring */
+static struct list uring_objects = LIST_INIT( uring_objects );
+static unsigned int uring_op_count;  /* submitted ops */
+static RTL_CONDITION_VARIABLE uring_op_done = RTL_CONDITION_VARIABLE_INIT;
+
+static RTL_RUN_ONCE init_once = RTL_RUN_ONCE_INIT;
+
+/* must be called with uring_section held */
+static BOOL uring_submit( const struct io_uring_sqe *entry )
+{
+    unsigned int tail = *sq_tail, index = tail & *sq_mask;
+    int ret;
+
+    sqes[index] = *entry;
+    sq_array[index] = index;
+    __atomic_store_n( sq_tail, tail + 1, __ATOMIC_RELEASE );
+
+    /* we submit one entry at a time with the lock held, so the ring never fills up */
+    while ((ret = syscall( __NR_io_uring_enter, uring_fd, 1, 0, 0, NULL, 0 )) == -1 && errno == EINTR);
+    if (ret != 1)
+    {
+        ERR("failed to submit, errno %d\n", errno);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* must be called with uring_section held */
+static BOOL uring_submit_transfer( struct uring_op *op )
+{
+    struct io_uring_sqe sqe;
+
+    memset( &sqe, 0, sizeof(sqe) );
+    sqe.opcode = op->opcode;
+    sqe.fd = op->fd;
+    sqe.user_data = (ULONG_PTR)op;
+    if (op->opcode == IORING_OP_RECVMSG || op->opcode == IORING_OP_SENDMSG)
+    {
+        op->msg.msg_iov = op->iov + op->first_iov;
+        op->msg.msg_iovlen = op->iov_count - op->first_iov;
+        sqe.addr = (ULONG_PTR)&op->msg;
+        sqe.len = 1;
+        sqe.msg_flags = op->flags;
+    }
+    else
+    {
+        sqe.addr = (ULONG_PTR)(op->iov + op->first_iov);
+        sqe.len = op->iov_count - op->first_iov;
+        sqe.off = op->offset + op->already;
+    }
+    op->polling = FALSE;
+    return uring_submit( &sqe );
+}
+
+/* must be called with uring_section held */
+static BOOL uring_submit_poll( struct uring_op *op )
+{
+    struct io_uring_sqe sqe;
+
+    memset( &sqe, 0, sizeof(sqe) );
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = op->fd;
+    sqe.poll_events = op->is_read ? POLLIN : POLLOUT;
+    sqe.user_data = (ULONG_PTR)op;
+    op->polling = TRUE;
+    return uring_submit( &sqe );
+}
+
+/* must be called with uring_section held */
+static void uring_submit_cancel( struct uring_op *op )
+{
+    struct io_uring_sqe sqe;
+
+    memset( &sqe, 0, sizeof(sqe) );
+    sqe.opcode = op->polling ? IORING_OP_POLL_REMOVE : IORING_OP_ASYNC_CANCEL;
+    sqe.fd = -1;
+    sqe.addr = (ULONG_PTR)op;
+    uring_submit( &sqe );
+}
+
+/* submit ops from the backlog while they can't overflow the completion ring;
+ * must be called with uring_section held */
+static void uring_submit_backlog(void)
+{
+    struct uring_op *op;
+    struct list *ptr;
+
+    while (uring_op_count < cq_entries - 1 && (ptr = list_head( &uring_backlog )))
+    {
+        op = LIST_ENTRY( ptr, struct uring_op, entry );
+        if (!uring_submit_transfer( op )) break;
+        list_remove( &op->entry );
+        list_add_tail( &uring_ops, &op->entry );
+        op->waiting = FALSE;
+        uring_op_count++;
+    }
+}
+
+/* must be called with uring_section held */
+static struct uring_object *find_uring_object( const struct stat *st )
+{
+    struct uring_object *object;
+
+    LIST_FOR_EACH_ENTRY( object, &uring_objects, struct uring_object, entry )
+        if (object->dev == st->st_dev && object->ino == st->st_ino) return object;
+    return NULL;
+}
+
+/* must be called with uring_section held */
+static struct uring_object *get_uring_object( const struct stat *st )
+{
+    struct uring_object *object;
+
+    if ((object = find_uring_object( st ))) return object;
+    if (!(object = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*object) ))) return NULL;
+    object->dev = st->st_dev;
+    object->ino = st->st_ino;
+    list_add_tail( &uring_objects, &object->entry );
+    return object;
+}
+
+/* must be called with uring_section held */
+static void release_uring_object( struct uring_object *object, BOOL is_read )
+{
+    object->ops[is_read]--;
+    if (object->ops[0] || object->ops[1] || object->use_server) return;
+    list_remove( &object->entry );
+    RtlFreeHeap( GetProcessHeap(), 0, object );
+}
+
+/* check that two fds share the same open file, not only the same inode */
+static BOOL is_same_file( int fd1, int fd2 )
+{
+#ifdef __NR_kcmp
+    pid_t pid = getpid();
+    int ret = syscall( __NR_kcmp, pid, pid, KCMP_FILE, fd1, fd2 );
+
+    if (ret != -1) return !ret;
+#endif
+    return TRUE;
+}
+
+/* account for transferred bytes; returns TRUE if the op is finished */
+static BOOL uring_advance( struct uring_op *op, ULONG size )
+{
+    op->already += size;
+    if (op->already >= op->count) return TRUE;
+    if (op->is_read)
+    {
+        /* recv() returns what is available, and so does the end of a stream */
+        if (!size || op->avail_mode || op->callback) return TRUE;
+    }
+
+    while (op->first_iov < op->iov_count && op->iov[op->first_iov].iov_len <= size)
+        size -= op->iov[op->first_iov++].iov_len;
+    if (op->first_iov < op->iov_count)
+    {
+        op->iov[op->first_iov].iov_base = (char *)op->iov[op->first_iov].iov_base + size;
+        op->iov[op->first_iov].iov_len -= size;
+    }
+    return FALSE;
+}
+
+/* read into a buffer with write watches from the reaper thread; returns the
+ * size or -errno */
+static int uring_locked_read( struct uring_op *op )
+{
+    struct iovec *iov = op->iov + op->first_iov;
+    ssize_t ret;
+
+    if (op->opcode == IORING_OP_RECVMSG)
+    {
+        op->msg.msg_iov = iov;
+        op->msg.msg_iovlen = op->iov_count - op->first_iov;
+        ret = __wine_locked_recvmsg( op->fd, &op->msg, op->flags | MSG_DONTWAIT );
+    }
+    else if (op->offset != ~(ULONGLONG)0)
+        ret = virtual_locked_pread( op->fd, iov->iov_base, iov->iov_len, op->offset + op->already );
+    else
+        ret = virtual_locked_read( op->fd, iov->iov_base, iov->iov_len );
+
+    return ret >= 0 ? ret : -errno;
+}
+
+static void uring_complete( struct uring_op *op, int error )
+{
+    ULONG size = op->already;
+    NTSTATUS status;
+
+    if (op->callback)
+        status = op->callback( op->callback_arg, error, &size, &op->msg );
+    else if (error == ECANCELED)
+        status = STATUS_CANCELLED;
+    else if (error)
+    {
+        errno = error;
+        status = FILE_GetNtStatus();
+    }
+    else if (op->is_read && !op->already && op->count)
+        status = op->opcode == IORING_OP_READV ? STATUS_END_OF_FILE : STATUS_PIPE_BROKEN;
+    else
+        status = STATUS_SUCCESS;
+
+    TRACE("op %p, handle %p, status %#x, size %u\n", op, op->handle, status, size);
+
+    op->iosb->Information = size;
+    op->iosb->u.Status = status;
+    if (op->event) NtSetEvent( op->event, NULL );
+    if (op->apc)
+    {
+        NtQueueApcThread( op->thread, (PNTAPCFUNC)op->apc,
+                          (ULONG_PTR)op->apc_user, (ULONG_PTR)op->iosb, 0 );
+        NtClose( op->thread );
+    }
+    if (op->cvalue) NTDLL_AddCompletion( op->handle, op->cvalue, status, size, TRUE );
+}
+
+/* Post the completion of an op and free it. The op stays in its list until the
+ * completion is posted, so that closing the handle can wait for it. */
+static void uring_finish_op( struct uring_op *op, int error )
+{
+    uring_complete( op, error );
+
+    RtlEnterCriticalSection( &uring_section );
+    list_remove( &op->entry );
+    if (!op->waiting) uring_op_count--;
+    release_uring_object( op->object, op->is_read );
+    uring_submit_backlog();
+    RtlWakeAllConditionVariable( &uring_op_done );
+    RtlLeaveCriticalSection( &uring_section );
+
+    close( op->fd );
+    if (op->own_handle) NtClose( op->handle );
+    RtlFreeHeap( GetProcessHeap(), 0, op );
+}
+
+static void uring_process_cqe( const struct io_uring_cqe *cqe )
+{
+    struct uring_op *op = (struct uring_op *)(ULONG_PTR)cqe->user_data;
+    int res = cqe->res, error;
+
+    /* cancel requests carry no op */
+    if (!op) return;
+
+    RtlEnterCriticalSection( &uring_section );
+
+    for (;;)
+    {
+        if (op->polling)
+        {
+            /* the fd is ready, or the poll was removed */
+            if (op->cancelled) error = ECANCELED;
+            else if (res < 0) error = -res;
+            else if (op->locked)
+            {
+                res = uring_locked_read( op );
+                op->polling = FALSE;
+                continue;
+            }
+            else if (uring_submit_transfer( op )) goto pending;
+            else error = EIO;
+        }
+        else if (res >= 0)
+        {
+            if (uring_advance( op, res )) error = 0;
+            else if (op->cancelled) error = ECANCELED;
+            else if (op->locked || !uring_submit_transfer( op ))
+            {
+                res = -EAGAIN;
+                continue;
+            }
+            else goto pending;
+        }
+        else if (res == -EFAULT && op->is_read && !op->locked)
+        {
+            /* the kernel can't write to pages with write watches */
+            TRACE("op %p, falling back to locked reads\n", op);
+            op->locked = TRUE;
+            res = uring_locked_read( op );
+            continue;
+        }
+        else if (res == -EAGAIN || res == -EINTR)
+        {
+            if (op->cancelled) error = ECANCELED;
+            else if (uring_submit_poll( op )) goto pending;
+            else error = EIO;
+        }
+        else error = -res;
+        break;
+    }
+
+    op->cancelled = TRUE;
+    op->completing = TRUE;
+    RtlLeaveCriticalSection( &uring_section );
+
+    uring_finish_op( op, error );
+    return;
+
+pending:
+    RtlLeaveCriticalSection( &uring_section );
+}
+
+static void CALLBACK uring_reaper_proc( void *arg )
+{
+    unsigned int head, tail;
+
+    for (;;)
+    {
+        head = *cq_head;
+        tail = __atomic_load_n( cq_tail, __ATOMIC_ACQUIRE );
+
+        if (head == tail)
+        {
+            if (syscall( __NR_io_uring_enter, uring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0 ) == -1
+                    && errno != EINTR)
+                ERR("io_uring_enter failed, errno %d\n", errno);
+            continue;
+        }
+
+        while (head != tail)
+        {
+            struct io_uring_cqe cqe = cqes[head & *cq_mask];
+
+            __atomic_store_n( cq_head, ++head, __ATOMIC_RELEASE );
+            uring_process_cqe( &cqe );
+        }
+    }
+}
+
+/* check that the kernel knows about all the opcodes we use */
+static BOOL uring_check_opcodes( int fd )
+{
+    static const BYTE opcodes[] =
+    {
+        IORING_OP_READV, IORING_OP_WRITEV, IORING_OP_POLL_ADD, IORING_OP_POLL_REMOVE,
+        IORING_OP_SENDMSG, IORING_OP_RECVMSG, IORING_OP_ASYNC_CANCEL
+    };
+    struct io_uring_probe *probe;
+    unsigned int i, size = offsetof( struct io_uring_probe, ops[IORING_OP_LAST] );
+    BOOL ret = FALSE;
+
+    if (!(probe = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size ))) return FALSE;
+    if (!syscall( __NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST ))
+    {
+        for (i = 0; i < ARRAY_SIZE(opcodes); i++)
+            if (opcodes[i] > probe->last_op || !(probe->ops[opcodes[i]].flags & IO_URING_OP_SUPPORTED))
+                break;
+        ret = (i == ARRAY_SIZE(opcodes));
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, probe );
+    return ret;
+}
+
+static DWORD WINAPI uring_init_once( RTL_RUN_ONCE *once, void *param, void **context )
+{
+    struct io_uring_params params;
+    size_t sq_size, cq_size;
+    char *sq_ring, *cq_ring;
+    HANDLE thread;
+    int fd;
+
+    memset( &params, 0, sizeof(params) );
+    if ((fd = syscall( __NR_io_uring_setup, URING_ENTRIES, &params )) == -1)
+    {
+        WARN("io_uring_setup failed, errno %d\n", errno);
+        return TRUE;
+    }
+    if (!uring_check_opcodes( fd ))
+    {
+        WARN("kernel doesn't support the needed operations\n");
+        close( fd );
+        return TRUE;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        sq_size = cq_size = max( sq_size, cq_size );
+
+    sq_ring = mmap( NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    if (sq_ring == MAP_FAILED) goto failed;
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        cq_ring = sq_ring;
+    else
+    {
+        cq_ring = mmap( NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+        if (cq_ring == MAP_FAILED) goto failed;
+    }
+    sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if (sqes == MAP_FAILED) goto failed;
+
+    sq_head  = (unsigned int *)(sq_ring + params.sq_off.head);
+    sq_tail  = (unsigned int *)(sq_ring + params.sq_off.tail);
+    sq_mask  = (unsigned int *)(sq_ring + params.sq_off.ring_mask);
+    sq_array = (unsigned int *)(sq_ring + params.sq_off.array);
+    cq_head  = (unsigned int *)(cq_ring + params.cq_off.head);
+    cq_tail  = (unsigned int *)(cq_ring + params.cq_off.tail);
+    cq_mask  = (unsigned int *)(cq_ring + params.cq_off.ring_mask);
+    cqes     = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+    cq_entries = params.cq_entries;
+    uring_fd = fd;
+
+    if (RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                             uring_reaper_proc, NULL, &thread, NULL ))
+    {
+        ERR("failed to create reaper thread\n");
+        uring_fd = -1;
+        return TRUE;
+    }
+    NtClose( thread );
+
+    TRACE("initialized, %u sq entries, %u cq entries\n", params.sq_entries, params.cq_entries);
+    return TRUE;
+
+failed:
+    ERR("failed to map rings, errno %d\n", errno);
+    close( fd );
+    return TRUE;
+}
+
+static BOOL uring_init(void)
+{
+    RtlRunOnceExecuteOnce( &init_once, uring_init_once, NULL, NULL );
+    return uring_fd != -1;
+}
+
+static struct uring_op *alloc_uring_op( int unix_fd, unsigned int iov_count )
+{
+    struct uring_op *op;
+
+    if (!(op = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                offsetof( struct uring_op, iov[iov_count ? iov_count : 1] ) )))
+        return NULL;
+    if ((op->fd = dup( unix_fd )) == -1)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, op );
+        return NULL;
+    }
+    op->iov_count = iov_count;
+    return op;
+}
+
+static void free_uring_op( struct uring_op *op )
+{
+    if (op->thread) NtClose( op->thread );
+    close( op->fd );
+    RtlFreeHeap( GetProcessHeap(), 0, op );
+}
+
+/* Queue the op on the ring, or in the backlog if the completion ring is full.
+ * A NULL op stands for a request that the ring can't handle; it switches the
+ * object to the server, once its pending ops in the same direction are done.
+ * Returns STATUS_NOT_IMPLEMENTED if the request must be sent to the server. */
+static NTSTATUS start_uring_op( struct uring_op *op, int unix_fd, BOOL is_read, HANDLE handle, HANDLE event,
+                                PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *iosb )
+{
+    struct uring_object *object;
+    struct stat st;
+    NTSTATUS status;
+
+    if (fstat( unix_fd, &st ) == -1)
+    {
+        status = FILE_GetNtStatus();
+        if (op) free_uring_op( op );
+        return status;
+    }
+
+    if (op)
+    {
+        op->handle   = handle;
+        op->event    = event;
+        op->apc      = apc;
+        op->apc_user = apc_user;
+        op->tid      = GetCurrentThreadId();
+        op->cvalue   = apc ? 0 : (ULONG_PTR)apc_user;
+        op->iosb     = iosb;
+
+        if (apc && (status = NtDuplicateObject( NtCurrentProcess(), GetCurrentThread(), NtCurrentProcess(),
+                                                &op->thread, 0, 0, DUPLICATE_SAME_ACCESS )))
+        {
+            free_uring_op( op );
+            return status;
+        }
+    }
+
+    RtlEnterCriticalSection( &uring_section );
+
+    if (!(object = get_uring_object( &st )))
+    {
+        RtlLeaveCriticalSection( &uring_section );
+        if (op) free_uring_op( op );
+        return STATUS_NO_MEMORY;
+    }
+
+    if (!op || object->use_server)
+    {
+        object->use_server = TRUE;
+        while (object->ops[is_read])
+        {
+            RtlSleepConditionVariableCS( &uring_op_done, &uring_section, NULL );
+            if (!(object = find_uring_object( &st ))) break;
+        }
+        RtlLeaveCriticalSection( &uring_section );
+        if (op) free_uring_op( op );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    if (event) NtResetEvent( event, NULL );
+    iosb->u.Status = STATUS_PENDING;
+
+    op->object = object;
+    object->ops[is_read]++;
+    op->waiting = TRUE;
+    list_add_tail( &uring_backlog, &op->entry );
+    uring_submit_backlog();
+
+    TRACE("queued op %p, handle %p, opcode %u, %u bytes%s\n", op, handle, op->opcode, op->count,
+          op->waiting ? ", waiting for room" : "");
+
+    RtlLeaveCriticalSection( &uring_section );
+    return STATUS_PENDING;
+}
+
+/* Queue an overlapped read or write. Sockets are only queued once they would
+ * block; regular files are always queued, at the given offset.
+ * Returns STATUS_NOT_IMPLEMENTED if the caller should fall back to the server. */
+NTSTATUS uring_queue_io( HANDLE handle, int unix_fd, enum server_fd_type type, BOOL is_read,
+                         HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *iosb,
+                         void *buffer, ULONG already, ULONG count, ULONGLONG offset, BOOL avail_mode )
+{
+    struct uring_op *op;
+
+    /* Pipes and devices have server-side semantics (message mode, timeouts)
+     * that the ring can't express. */
+    if ((type != FD_TYPE_SOCKET && type != FD_TYPE_FILE) || !uring_init()) return STATUS_NOT_IMPLEMENTED;
+
+    /* We also need some way to report completion other than signaling the
+     * file handle itself, which is a server object. */
+    if (!event && !apc && !apc_user)
+        return start_uring_op( NULL, unix_fd, is_read, handle, event, apc, apc_user, iosb );
+
+    if (!(op = alloc_uring_op( unix_fd, 1 ))) return STATUS_INSUFFICIENT_RESOURCES;
+
+    if (type == FD_TYPE_SOCKET) op->opcode = is_read ? IORING_OP_RECVMSG : IORING_OP_SENDMSG;
+    else op->opcode = is_read ? IORING_OP_READV : IORING_OP_WRITEV;
+    op->is_read         = is_read;
+    op->avail_mode      = avail_mode;
+    op->offset          = type == FD_TYPE_FILE ? offset : ~(ULONGLONG)0;
+    op->already         = already;
+    op->count           = count;
+    op->iov[0].iov_base = (char *)buffer + already;
+    op->iov[0].iov_len  = count - already;
+
+    return start_uring_op( op, unix_fd, is_read, handle, event, apc, apc_user, iosb );
+}
+
+/***********************************************************************
+ *           __wine_uring_queue_msg
+ *
+ * Queue an overlapped sendmsg() or recvmsg() on a socket, for ws2_32. The
+ * name and the buffers of the message must stay valid until the callback
+ * is called from the reaper thread; it returns the status of the request.
+ * A NULL msg means that the request can't be queued on the ring.
+ * Returns STATUS_NOT_IMPLEMENTED if the caller should send it to the server.
+ */
+NTSTATUS CDECL __wine_uring_queue_msg( HANDLE handle, int unix_fd, BOOL is_read, const struct msghdr *msg,
+                                       int flags, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
+                                       IO_STATUS_BLOCK *iosb, uring_msg_callback callback, void *arg )
+{
+    struct uring_op *op;
+    unsigned int i;
+
+    if (!do_uring() || !uring_init()) return STATUS_NOT_IMPLEMENTED;
+
+    if (!msg || msg->msg_controllen || (!event && !apc && !apc_user))
+        return start_uring_op( NULL, unix_fd, is_read, handle, event, apc, apc_user, iosb );
+
+    if (!(op = alloc_uring_op( unix_fd, msg->msg_iovlen ))) return STATUS_INSUFFICIENT_RESOURCES;
+
+    op->opcode       = is_read ? IORING_OP_RECVMSG : IORING_OP_SENDMSG;
+    op->is_read      = is_read;
+    op->offset       = ~(ULONGLONG)0;
+    op->flags        = flags;
+    op->callback     = callback;
+    op->callback_arg = arg;
+    op->msg.msg_name    = msg->msg_name;
+    op->msg.msg_namelen = msg->msg_namelen;
+    for (i = 0; i < msg->msg_iovlen; i++)
+    {
+        op->iov[i] = msg->msg_iov[i];
+        op->count += msg->msg_iov[i].iov_len;
+    }
+
+    return start_uring_op( op, unix_fd, is_read, handle, event, apc, apc_user, iosb );
+}
+
+/* Cancel the ops matching an object, or a handle value if st is NULL, and
+ * optionally an iosb or the current thread. Returns TRUE if anything was found. */
+static BOOL cancel_uring_ops( HANDLE handle, const struct stat *st, int unix_fd,
+                              IO_STATUS_BLOCK *iosb, BOOL only_thread )
+{
+    struct list *lists[] = { &uring_ops, &uring_backlog };
+    struct list cancelled = LIST_INIT( cancelled );
+    struct uring_op *op, *next;
+    BOOL found = FALSE;
+    unsigned int i;
+
+    RtlEnterCriticalSection( &uring_section );
+    for (i = 0; i < ARRAY_SIZE(lists); i++)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE( op, next, lists[i], struct uring_op, entry )
+        {
+            if (op->cancelled) continue;
+            if (st)
+            {
+                if (op->object->dev != st->st_dev || op->object->ino != st->st_ino) continue;
+                if (!is_same_file( op->fd, unix_fd )) continue;
+            }
+            else if (op->handle != handle) continue;
+            if (iosb && op->iosb != iosb) continue;
+            if (only_thread && op->tid != GetCurrentThreadId()) continue;
+
+            op->cancelled = TRUE;
+            found = TRUE;
+            if (op->waiting)
+            {
+                list_remove( &op->entry );
+                list_add_tail( &cancelled, &op->entry );
+            }
+            /* If the transfer is already running, it finishes normally, and
+             * the op is not submitted again. */
+            else uring_submit_cancel( op );
+        }
+    }
+    RtlLeaveCriticalSection( &uring_section );
+
+    /* ops from the backlog were never submitted */
+    LIST_FOR_EACH_ENTRY_SAFE( op, next, &cancelled, struct uring_op, entry )
+        uring_finish_op( op, ECANCELED );
+
+    return found;
+}
+
+/* Cancel ops queued on the object of the given handle, through any handle,
+ * optionally only those matching iosb or issued by the current thread.
+ * Returns TRUE if anything was found. */
+BOOL uring_cancel_io( HANDLE handle, IO_STATUS_BLOCK *iosb, BOOL only_thread )
+{
+    struct stat st;
+    int unix_fd, needs_close;
+    BOOL found;
+
+    if (uring_fd == -1) return FALSE;
+
+    if (server_get_unix_fd( handle, 0, &unix_fd, &needs_close, NULL, NULL ))
+        return cancel_uring_ops( handle, NULL, -1, iosb, only_thread );
+
+    if (fstat( unix_fd, &st ) == -1) found = cancel_uring_ops( handle, NULL, -1, iosb, only_thread );
+    else found = cancel_uring_ops( handle, &st, unix_fd, iosb, only_thread );
+    if (needs_close) close( unix_fd );
+    return found;
+}
+
+/* Cancel the ops queued through a handle which is about to be closed. Those
+ * that report to a completion port get a duplicate of the handle to post their
+ * completion, so this only has to wait for completions that are being posted
+ * right now, not for the cancellations. unix_fd is the cached fd of the
+ * handle, or -1. */
+void uring_close_handle( HANDLE handle, int unix_fd )
+{
+    struct uring_object *object;
+    struct uring_op *op;
+    struct stat st;
+    BOOL busy;
+
+    if (uring_fd == -1) return;
+
+    cancel_uring_ops( handle, NULL, -1, NULL, FALSE );
+
+    RtlEnterCriticalSection( &uring_section );
+    do
+    {
+        busy = FALSE;
+        LIST_FOR_EACH_ENTRY( op, &uring_ops, struct uring_op, entry )
+        {
+            if (op->handle != handle || op->own_handle || !op->cvalue) continue;
+            if (op->completing) busy = TRUE;
+            else if (!NtDuplicateObject( NtCurrentProcess(), handle, NtCurrentProcess(), &op->handle,
+                                         0, 0, DUPLICATE_SAME_ACCESS ))
+                op->own_handle = TRUE;
+            else
+            {
+                WARN("op %p, failed to duplicate handle %p, dropping completion\n", op, handle);
+                op->cvalue = 0;
+            }
+        }
+        if (busy) RtlSleepConditionVariableCS( &uring_op_done, &uring_section, NULL );
+    } while (busy);
+
+    /* forget that the object uses the server, it may be a new one next time */
+    if (unix_fd != -1 && !fstat( unix_fd, &st ) && (object = find_uring_object( &st )) &&
+        !object->ops[0] && !object->ops[1])
+    {
+        list_remove( &object->entry );
+        RtlFreeHeap( GetProcessHeap(), 0, object );
+    }
+    RtlLeaveCriticalSection( &uring_section );
+}
+
+#else
+
+NTSTATUS uring_queue_io( HANDLE handle, int unix_fd, enum server_fd_type type, BOOL is_read,
+                         HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *iosb,
+                         void *buffer, ULONG already, ULONG count, ULONGLONG offset, BOOL avail_mode )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+NTSTATUS CDECL __wine_uring_queue_msg( HANDLE handle, int unix_fd, BOOL is_read, const struct msghdr *msg,
+                                       int flags, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
+                                       IO_STATUS_BLOCK *iosb, uring_msg_callback callback, void *arg )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+BOOL uring_cancel_io( HANDLE handle, IO_STATUS_BLOCK *iosb, BOOL only_thread )
+{
+    return FALSE;
+}
+
+void uring_close_handle( HANDLE handle, int unix_fd )
+{
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * io_uring-based asynchronous I/O
+ *
+ * Copyright (C) the Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+struct msghdr;
+
+/* called from the reaper thread when a queued message is done; error is an
+ * errno value, ECANCELED if the request was cancelled, and size the number of
+ * bytes transferred, which the callback may adjust */
+typedef NTSTATUS (CDECL *uring_msg_callback)( void *arg, int error, ULONG *size, const struct msghdr *msg );
+
+extern int do_uring(void) DECLSPEC_HIDDEN;
+extern NTSTATUS uring_queue_io( HANDLE handle, int unix_fd, enum server_fd_type type, BOOL is_read,
+    HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *iosb,
+    void *buffer, ULONG already, ULONG count, ULONGLONG offset, BOOL avail_mode ) DECLSPEC_HIDDEN;
+extern NTSTATUS CDECL __wine_uring_queue_msg( HANDLE handle, int unix_fd, BOOL is_read, const struct msghdr *msg,
+    int flags, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *iosb,
+    uring_msg_callback callback, void *arg );
+extern BOOL uring_cancel_io( HANDLE handle, IO_STATUS_BLOCK *iosb, BOOL only_thread ) DECLSPEC_HIDDEN;
+extern void uring_close_handle( HANDLE handle, int unix_fd ) DECLSPEC_HIDDEN;
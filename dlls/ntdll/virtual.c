@@ -1921,6 +1921,71 @@ NTSTATUS virtual_create_builtin_view( void *module )
 }
 
 
+/***********************************************************************
+ *           virtual_map_relocated_pages
+ *
+ * Replace a range of pages of an image view by private copies of the
+ * relocated pages found at the same offset in fd, keeping the current
+ * page protections.
+ */
+NTSTATUS virtual_map_relocated_pages( void *module, SIZE_T offset, SIZE_T size, int fd )
+{
+    struct file_view *view;
+    sigset_t sigset;
+    NTSTATUS status = STATUS_SUCCESS;
+    char *base = (char *)module + offset, *addr, *end;
+    size_t i;
+
+    if (((UINT_PTR)base | size) & page_mask) return STATUS_INVALID_PARAMETER;
+
+    server_enter_uninterrupted_section( &csVirtual, &sigset );
+
+    if (!(view = VIRTUAL_FindView( base, size )) || !(view->protect & SEC_IMAGE) || view->base != module)
+        status = STATUS_INVALID_PARAMETER;
+    else
+    {
+        /* shared sections must stay mapped from the shared file */
+        for (i = 0; i < size; i += page_size)
+        {
+            BYTE vprot = get_page_vprot( base + i );
+            if (!(vprot & VPROT_COMMITTED) || (vprot & VPROT_WRITE))
+            {
+                status = STATUS_INVALID_PAGE_PROTECTION;
+                break;
+            }
+        }
+    }
+
+    for (addr = base, end = base + size; !status && addr < end; addr += i)
+    {
+        BYTE vprot = get_page_vprot( addr );
+        int prot = VIRTUAL_GetUnixProt( vprot );
+        off_t pos = addr - (char *)module;
+
+        for (i = page_size; addr + i < end; i += page_size)
+            if (get_page_vprot( addr + i ) != vprot) break;
+
+        if (force_exec_prot && (vprot & VPROT_READ)) prot |= PROT_EXEC;
+
+        if (mmap( addr, i, prot, MAP_FIXED | MAP_PRIVATE, fd, pos ) != (void *)-1) continue;
+
+        /* the original pages are gone from here on, so always fall back to read() */
+        WARN( "mmap failed for %p-%p, falling back to read\n", addr, addr + i - 1 );
+        if (wine_anon_mmap( addr, i, PROT_READ | PROT_WRITE, MAP_FIXED ) == (void *)-1)
+        {
+            ERR( "failed to replace pages %p-%p\n", addr, addr + i - 1 );
+            status = FILE_GetNtStatus();
+            break;
+        }
+        pread( fd, addr, i, pos );
+        if (prot != (PROT_READ|PROT_WRITE)) mprotect( addr, i, prot );
+    }
+
+    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    return status;
+}
+
+
 /***********************************************************************
  *           virtual_alloc_thread_stack
  */
@@ -2169,6 +2234,56 @@ ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
 }
 
 
+/***********************************************************************
+ *           __wine_locked_recvmmsg
+ */
+int CDECL __wine_locked_recvmmsg( int fd, struct mmsghdr *msgs, unsigned int count, int flags )
+{
+#ifdef HAVE_RECVMMSG
+    sigset_t sigset;
+    unsigned int i, j = 0;
+    BOOL has_write_watch = FALSE;
+    int err = EFAULT;
+
+    int ret = recvmmsg( fd, msgs, count, flags, NULL );
+    if (ret != -1 || errno != EFAULT) return ret;
+
+    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    for (i = 0; i < count; i++)
+    {
+        struct msghdr *hdr = &msgs[i].msg_hdr;
+
+        for (j = 0; j < hdr->msg_iovlen; j++)
+            if (check_write_access( hdr->msg_iov[j].iov_base, hdr->msg_iov[j].iov_len, &has_write_watch ))
+                break;
+        if (j < hdr->msg_iovlen) break;
+    }
+    if (i == count)
+    {
+        ret = recvmmsg( fd, msgs, count, flags, NULL );
+        err = errno;
+    }
+    if (has_write_watch)
+    {
+        if (i < count)
+            while (j--) update_write_watches( msgs[i].msg_hdr.msg_iov[j].iov_base,
+                                              msgs[i].msg_hdr.msg_iov[j].iov_len, 0 );
+        while (i--)
+            for (j = 0; j < msgs[i].msg_hdr.msg_iovlen; j++)
+                update_write_watches( msgs[i].msg_hdr.msg_iov[j].iov_base,
+                                      msgs[i].msg_hdr.msg_iov[j].iov_len, 0 );
+    }
+
+    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    errno = err;
+    return ret;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+
 /***********************************************************************
  *           virtual_is_valid_code_address
  */
@@ -798,6 +798,8 @@ ULONG CDECL wined3d_buffer_decref(struct wined3d_buffer *buffer)
 
     if (!refcount)
     {
+        if (buffer->upload_region)
+            wined3d_cs_release_upload_region(buffer->resource.device->cs, buffer->upload_region);
         buffer->resource.parent_ops->wined3d_object_destroyed(buffer->resource.parent);
         resource_cleanup(&buffer->resource);
         wined3d_cs_destroy_object(buffer->resource.device->cs,
@@ -1242,6 +1244,82 @@ void wined3d_buffer_upload_data(struct wined3d_buffer *buffer, struct wined3d_co
     wined3d_buffer_gl_upload_ranges(wined3d_buffer_gl(buffer), context, data, range.offset, 1, &range);
 }
 
+/* Context activation is done by the caller. */
+void wined3d_buffer_upload_region(struct wined3d_buffer *buffer, struct wined3d_context *context,
+        const struct wined3d_upload_region *region, unsigned int offset, unsigned int size, BOOL discard)
+{
+    struct wined3d_buffer_gl *buffer_gl = wined3d_buffer_gl(buffer);
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    struct wined3d_map_range range;
+    void *map_ptr;
+
+    TRACE("buffer %p, context %p, region %p, offset %u, size %u, discard %#x.\n",
+            buffer, context, region, offset, size, discard);
+
+    if (!(buffer->flags & WINED3D_BUFFER_USE_BO) || (buffer->flags & WINED3D_BUFFER_PIN_SYSMEM)
+            || buffer->conversion_map)
+        goto sysmem;
+
+    if (discard)
+    {
+        if (!wined3d_buffer_prepare_location(buffer, context, WINED3D_LOCATION_BUFFER))
+            goto sysmem;
+
+        /* Orphan the old storage. Draws that are still in flight keep using
+         * it, and the driver hands us a fresh one. */
+        wined3d_buffer_gl_bind(buffer_gl, context);
+        GL_EXTCALL(glBufferData(buffer_gl->buffer_type_hint, buffer->resource.size,
+                NULL, buffer_gl->buffer_object_usage));
+        checkGLcall("glBufferData");
+        wined3d_buffer_validate_location(buffer, WINED3D_LOCATION_BUFFER);
+    }
+    else if (!wined3d_buffer_load_location(buffer, context, WINED3D_LOCATION_BUFFER))
+    {
+        goto sysmem;
+    }
+    else if (gl_info->supported[ARB_MAP_BUFFER_RANGE])
+    {
+        /* The application promised not to touch data the GPU may still use. */
+        wined3d_buffer_gl_bind(buffer_gl, context);
+        map_ptr = GL_EXTCALL(glMapBufferRange(buffer_gl->buffer_type_hint, offset, size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        checkGLcall("glMapBufferRange");
+        if (map_ptr)
+        {
+            memcpy(map_ptr, region->data + offset, size);
+            GL_EXTCALL(glUnmapBuffer(buffer_gl->buffer_type_hint));
+            checkGLcall("glUnmapBuffer");
+            wined3d_buffer_invalidate_location(buffer, ~WINED3D_LOCATION_BUFFER);
+            return;
+        }
+    }
+
+    range.offset = offset;
+    range.size = size;
+    wined3d_buffer_gl_upload_ranges(buffer_gl, context, region->data, 0, 1, &range);
+    wined3d_buffer_invalidate_location(buffer, ~WINED3D_LOCATION_BUFFER);
+    return;
+
+sysmem:
+    if (discard)
+    {
+        if (!wined3d_buffer_prepare_location(buffer, context, WINED3D_LOCATION_SYSMEM))
+        {
+            ERR("Failed to prepare system memory for buffer %p.\n", buffer);
+            return;
+        }
+        wined3d_buffer_validate_location(buffer, WINED3D_LOCATION_SYSMEM);
+    }
+    else if (!wined3d_buffer_load_location(buffer, context, WINED3D_LOCATION_SYSMEM))
+    {
+        ERR("Failed to load system memory for buffer %p.\n", buffer);
+        return;
+    }
+
+    memcpy((BYTE *)buffer->resource.heap_memory + offset, region->data + offset, size);
+    wined3d_buffer_invalidate_range(buffer, ~WINED3D_LOCATION_SYSMEM, offset, size);
+}
+
 static void wined3d_buffer_init_data(struct wined3d_buffer *buffer,
         struct wined3d_device *device, const struct wined3d_sub_resource_data *data)
 {
@@ -4036,6 +4036,15 @@ static BOOL context_apply_draw_state(struct wined3d_context *context,
     context->last_was_blit = FALSE;
     context->last_was_ffp_blit = FALSE;
 
+    if (context->shader_program_pending)
+    {
+        /* The shader backend is still compiling the program in the
+         * background. Skip the draw and select the program again next time. */
+        context->shader_update_mask |= ~(1u << WINED3D_SHADER_TYPE_COMPUTE)
+                & ((1u << WINED3D_SHADER_TYPE_COUNT) - 1);
+        return FALSE;
+    }
+
     return TRUE;
 }
 
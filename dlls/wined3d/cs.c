@@ -21,6 +21,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
 #define WINED3D_INITIAL_CS_SIZE 4096
 
@@ -69,10 +70,14 @@ enum wined3d_cs_op
     WINED3D_CS_OP_UNMAP,
     WINED3D_CS_OP_BLT_SUB_RESOURCE,
     WINED3D_CS_OP_UPDATE_SUB_RESOURCE,
+    WINED3D_CS_OP_UPLOAD_SUB_RESOURCE,
     WINED3D_CS_OP_ADD_DIRTY_TEXTURE_REGION,
     WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW,
     WINED3D_CS_OP_COPY_UAV_COUNTER,
     WINED3D_CS_OP_GENERATE_MIPMAPS,
+    WINED3D_CS_OP_UPLOAD_REGION,
+    WINED3D_CS_OP_BEGIN_COMMAND_LIST,
+    WINED3D_CS_OP_END_COMMAND_LIST,
     WINED3D_CS_OP_STOP,
 };
 
@@ -96,6 +101,7 @@ struct wined3d_cs_present
     RECT dst_rect;
     unsigned int swap_interval;
     DWORD flags;
+    struct wined3d_cs_profile_frame *profile_frame;
 };
 
 struct wined3d_cs_clear
@@ -411,6 +417,17 @@ struct wined3d_cs_update_sub_resource
     struct wined3d_sub_resource_data data;
 };
 
+struct wined3d_cs_upload_sub_resource
+{
+    enum wined3d_cs_op opcode;
+    struct wined3d_resource *resource;
+    unsigned int sub_resource_idx;
+    struct wined3d_box box;
+    unsigned int row_pitch, slice_pitch;
+    unsigned int offset;
+    ULONG end;
+};
+
 struct wined3d_cs_add_dirty_texture_region
 {
     enum wined3d_cs_op opcode;
@@ -439,14 +456,51 @@ struct wined3d_cs_generate_mipmaps
     struct wined3d_shader_resource_view *view;
 };
 
+struct wined3d_cs_upload_region
+{
+    enum wined3d_cs_op opcode;
+    struct wined3d_buffer *buffer;
+    struct wined3d_upload_region *region;
+    unsigned int offset, size;
+    BOOL discard;
+};
+
+struct wined3d_cs_saved_state
+{
+    struct wined3d_state state;
+    struct wined3d_fb_state fb;
+};
+
+struct wined3d_cs_begin_command_list
+{
+    enum wined3d_cs_op opcode;
+    struct wined3d_cs_saved_state *saved;
+};
+
+struct wined3d_cs_end_command_list
+{
+    enum wined3d_cs_op opcode;
+    struct wined3d_cs_saved_state *saved;
+};
+
 struct wined3d_cs_stop
 {
     enum wined3d_cs_op opcode;
 };
 
+static const struct wined3d_cs_ops wined3d_cs_mt_ops;
+static const struct wined3d_cs_ops wined3d_cs_deferred_ops;
+
+static struct wined3d_deferred_context *wined3d_deferred_context_from_cs(struct wined3d_cs *cs)
+{
+    return CONTAINING_RECORD(cs, struct wined3d_deferred_context, cs);
+}
+
 static inline void *wined3d_cs_require_space(struct wined3d_cs *cs,
         size_t size, enum wined3d_cs_queue_id queue_id)
 {
+    if (cs->draw_pending)
+        wined3d_cs_emit_pending_draw(cs);
     return cs->ops->require_space(cs, size, queue_id);
 }
 
@@ -455,6 +509,18 @@ static inline void wined3d_cs_submit(struct wined3d_cs *cs, enum wined3d_cs_queu
     cs->ops->submit(cs, queue_id);
 }
 
+static inline void wined3d_cs_acquire_resource(struct wined3d_cs *cs, struct wined3d_resource *resource)
+{
+    cs->ops->acquire_resource(cs, resource);
+}
+
+/* Deferred contexts never execute their packets, so their CS state is the
+ * state the recording thread has set. */
+static inline const struct wined3d_state *wined3d_cs_get_client_state(const struct wined3d_cs *cs)
+{
+    return cs->ops == &wined3d_cs_deferred_ops ? &cs->state : &cs->device->state;
+}
+
 static const char *debug_cs_op(enum wined3d_cs_op op)
 {
     switch (op)
@@ -503,10 +569,14 @@ static const char *debug_cs_op(enum wined3d_cs_op op)
         WINED3D_TO_STR(WINED3D_CS_OP_UNMAP);
         WINED3D_TO_STR(WINED3D_CS_OP_BLT_SUB_RESOURCE);
         WINED3D_TO_STR(WINED3D_CS_OP_UPDATE_SUB_RESOURCE);
+        WINED3D_TO_STR(WINED3D_CS_OP_UPLOAD_SUB_RESOURCE);
         WINED3D_TO_STR(WINED3D_CS_OP_ADD_DIRTY_TEXTURE_REGION);
         WINED3D_TO_STR(WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW);
         WINED3D_TO_STR(WINED3D_CS_OP_COPY_UAV_COUNTER);
         WINED3D_TO_STR(WINED3D_CS_OP_GENERATE_MIPMAPS);
+        WINED3D_TO_STR(WINED3D_CS_OP_UPLOAD_REGION);
+        WINED3D_TO_STR(WINED3D_CS_OP_BEGIN_COMMAND_LIST);
+        WINED3D_TO_STR(WINED3D_CS_OP_END_COMMAND_LIST);
         WINED3D_TO_STR(WINED3D_CS_OP_STOP);
 #undef WINED3D_TO_STR
         default:
@@ -518,6 +588,652 @@ static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
 
+struct wined3d_cs_op_stats
+{
+    unsigned int op_count[WINED3D_CS_OP_STOP];
+    SIZE_T bytes;
+    unsigned int queue_full_count;
+    unsigned int merged_draw_count;
+    unsigned int frame_count;
+    unsigned int last_wait_count;
+    LONGLONG last_wait_time;
+};
+
+static void wined3d_cs_count_op(struct wined3d_cs *cs, const void *data, size_t size)
+{
+    enum wined3d_cs_op opcode = *(const enum wined3d_cs_op *)data;
+
+    if (opcode < WINED3D_CS_OP_STOP)
+        ++cs->op_stats->op_count[opcode];
+    cs->op_stats->bytes += size;
+}
+
+/* Called by the application thread for every frame. */
+static void wined3d_cs_report_op_stats(struct wined3d_cs *cs)
+{
+    const struct wined3d_cs_wait_stats *client = &cs->client_stats;
+    struct wined3d_cs_op_stats *stats = cs->op_stats;
+    LONGLONG wait_time;
+    LARGE_INTEGER freq;
+    unsigned int i;
+
+    if (++stats->frame_count < wined3d_settings.cs_stats_interval)
+        return;
+
+    QueryPerformanceFrequency(&freq);
+    wait_time = client->spin_time + client->sleep_time;
+    MESSAGE("wined3d: %u frame(s): %lu bytes queued, %u redundant state changes dropped, %u draws merged, "
+            "%u waits for the command stream (%.3f ms), %u of them for queue space.\n",
+            stats->frame_count, (unsigned long)stats->bytes, cs->redundant_state_count, stats->merged_draw_count,
+            client->wait_count - stats->last_wait_count,
+            (wait_time - stats->last_wait_time) * 1000.0 / freq.QuadPart, stats->queue_full_count);
+    for (i = 0; i < ARRAY_SIZE(stats->op_count); ++i)
+    {
+        if (stats->op_count[i])
+            MESSAGE("wined3d:     %s: %u.\n", debug_cs_op(i), stats->op_count[i]);
+    }
+
+    memset(stats->op_count, 0, sizeof(stats->op_count));
+    stats->bytes = 0;
+    stats->queue_full_count = 0;
+    stats->merged_draw_count = 0;
+    stats->frame_count = 0;
+    stats->last_wait_count = client->wait_count;
+    stats->last_wait_time = wait_time;
+    cs->redundant_state_count = 0;
+}
+
+/* Frame profiling, enabled by setting WINE_D3D_CS_PROFILE to a file name.
+ * Every command stream writes its own file; the process id and a per-process
+ * counter are inserted before the extension, e.g. "profile-1234-0.csv".
+ * The application thread collects its part of a frame in a
+ * wined3d_cs_profile_frame, which travels to the command stream thread with
+ * the PRESENT packet. The command stream thread times every packet it
+ * executes, and writes out the frame once PRESENT has been executed. File
+ * names ending in ".csv" get one line per frame; anything else gets a trace
+ * in the Trace Event Format, which can be loaded in chrome://tracing. Traces
+ * also mark when each packet was submitted by the application thread. */
+#define WINED3D_CS_PROFILE_TID_APPLICATION 1
+#define WINED3D_CS_PROFILE_TID_CS          2
+
+struct wined3d_cs_profile_event
+{
+    enum wined3d_cs_op opcode;
+    LONGLONG start;
+    LONGLONG duration;
+};
+
+struct wined3d_cs_profile_frame
+{
+    LONGLONG start, end;
+    LONGLONG wait_time;
+    unsigned int wait_count;
+    unsigned int packet_count;
+    size_t max_queue_depth;
+
+    struct wined3d_cs_profile_event *waits;
+    SIZE_T waits_size, waits_count;
+    struct wined3d_cs_profile_event *submits;
+    SIZE_T submits_size, submits_count;
+};
+
+struct wined3d_cs_profiler
+{
+    HANDLE file;
+    BOOL csv;
+    BOOL event_written;
+    LONGLONG frequency;
+    LONGLONG origin;
+    unsigned int frame_idx;
+    struct wined3d_string_buffer buffer;
+
+    /* Application thread. */
+    struct wined3d_cs_profile_frame *client_frame;
+
+    /* Command stream thread. */
+    struct wined3d_cs_profile_frame *present_frame;
+    LONGLONG frame_start;
+    LONGLONG busy_time;
+    struct wined3d_cs_profile_event *events;
+    SIZE_T events_size, event_count;
+};
+
+static double wined3d_cs_profiler_us(const struct wined3d_cs_profiler *profiler, LONGLONG ticks)
+{
+    return ticks * 1000000.0 / profiler->frequency;
+}
+
+static double wined3d_cs_profiler_ms(const struct wined3d_cs_profiler *profiler, LONGLONG ticks)
+{
+    return ticks * 1000.0 / profiler->frequency;
+}
+
+static void wined3d_cs_profiler_flush(struct wined3d_cs_profiler *profiler)
+{
+    DWORD written;
+
+    if (profiler->buffer.content_size && (!WriteFile(profiler->file, profiler->buffer.buffer,
+            profiler->buffer.content_size, &written, NULL) || written != profiler->buffer.content_size))
+        WARN("Failed to write profile, error %u.\n", GetLastError());
+    string_buffer_clear(&profiler->buffer);
+}
+
+static void wined3d_cs_profiler_write_event(struct wined3d_cs_profiler *profiler,
+        const char *name, unsigned int tid, LONGLONG start, LONGLONG duration)
+{
+    shader_addline(&profiler->buffer, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+            "\"ts\":%.3f,\"dur\":%.3f}", profiler->event_written ? ",\n" : "", name, tid,
+            wined3d_cs_profiler_us(profiler, start - profiler->origin),
+            wined3d_cs_profiler_us(profiler, duration));
+    profiler->event_written = TRUE;
+}
+
+static void wined3d_cs_profiler_write_instant(struct wined3d_cs_profiler *profiler,
+        const char *name, unsigned int tid, LONGLONG time)
+{
+    shader_addline(&profiler->buffer, "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,"
+            "\"ts\":%.3f}", profiler->event_written ? ",\n" : "", name, tid,
+            wined3d_cs_profiler_us(profiler, time - profiler->origin));
+    profiler->event_written = TRUE;
+}
+
+static void wined3d_cs_profiler_write_counter(struct wined3d_cs_profiler *profiler,
+        const char *name, LONGLONG time, double value)
+{
+    shader_addline(&profiler->buffer, "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,"
+            "\"ts\":%.3f,\"args\":{\"value\":%.3f}}", profiler->event_written ? ",\n" : "", name,
+            wined3d_cs_profiler_us(profiler, time - profiler->origin), value);
+    profiler->event_written = TRUE;
+}
+
+static void wined3d_cs_profile_frame_destroy(struct wined3d_cs_profile_frame *frame)
+{
+    if (!frame)
+        return;
+    heap_free(frame->waits);
+    heap_free(frame->submits);
+    heap_free(frame);
+}
+
+static struct wined3d_cs_profiler *wined3d_cs_profiler_create(const char *path)
+{
+    static LONG profiler_count;
+    struct wined3d_cs_profiler *profiler;
+    const char *ext, *sep;
+    LARGE_INTEGER now, freq;
+    char *name;
+    size_t len;
+
+    if (!(profiler = heap_alloc_zero(sizeof(*profiler))))
+        return NULL;
+
+    if (!(profiler->client_frame = heap_alloc_zero(sizeof(*profiler->client_frame))))
+    {
+        heap_free(profiler);
+        return NULL;
+    }
+
+    if (!string_buffer_init(&profiler->buffer))
+    {
+        heap_free(profiler->client_frame);
+        heap_free(profiler);
+        return NULL;
+    }
+
+    len = strlen(path);
+    if (!(ext = strrchr(path, '.')) || ((sep = strrchr(path, '\\')) && sep > ext)
+            || ((sep = strrchr(path, '/')) && sep > ext))
+        ext = path + len;
+    profiler->csv = !strcasecmp(ext, ".csv");
+
+    /* Room for "-<pid>-<index>". */
+    if (!(name = heap_alloc(len + 24)))
+    {
+        string_buffer_free(&profiler->buffer);
+        heap_free(profiler->client_frame);
+        heap_free(profiler);
+        return NULL;
+    }
+    sprintf(name, "%.*s-%u-%u%s", (int)(ext - path), path, GetCurrentProcessId(),
+            InterlockedIncrement(&profiler_count) - 1, ext);
+
+    if ((profiler->file = CreateFileA(name, GENERIC_WRITE, FILE_SHARE_READ,
+            NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        ERR("Failed to create command stream profile %s, error %u.\n", debugstr_a(name), GetLastError());
+        heap_free(name);
+        string_buffer_free(&profiler->buffer);
+        heap_free(profiler->client_frame);
+        heap_free(profiler);
+        return NULL;
+    }
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    profiler->frequency = freq.QuadPart;
+    profiler->origin = now.QuadPart;
+    profiler->frame_start = now.QuadPart;
+    profiler->client_frame->start = now.QuadPart;
+
+    if (profiler->csv)
+    {
+        shader_addline(&profiler->buffer, "frame,time_ms,frame_ms,app_ms,app_wait_ms,app_waits,packets,"
+                "max_queue_bytes,cs_busy_ms,cs_present_ms,cs_idle_ms,latency_ms\n");
+    }
+    else
+    {
+        shader_addline(&profiler->buffer, "[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":\"application\"}},\n", WINED3D_CS_PROFILE_TID_APPLICATION);
+        shader_addline(&profiler->buffer, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":\"command stream\"}}", WINED3D_CS_PROFILE_TID_CS);
+        profiler->event_written = TRUE;
+    }
+    wined3d_cs_profiler_flush(profiler);
+
+    TRACE("Writing command stream profile to %s.\n", debugstr_a(name));
+    heap_free(name);
+
+    return profiler;
+}
+
+static void wined3d_cs_profiler_destroy(struct wined3d_cs_profiler *profiler)
+{
+    if (!profiler->csv)
+        shader_addline(&profiler->buffer, "\n]\n");
+    wined3d_cs_profiler_flush(profiler);
+    CloseHandle(profiler->file);
+
+    wined3d_cs_profile_frame_destroy(profiler->client_frame);
+    wined3d_cs_profile_frame_destroy(profiler->present_frame);
+    heap_free(profiler->events);
+    string_buffer_free(&profiler->buffer);
+    heap_free(profiler);
+}
+
+/* Called by the application thread for every packet submitted to a queue. */
+static void wined3d_cs_profile_submit(struct wined3d_cs_profiler *profiler,
+        const struct wined3d_cs_queue *queue, enum wined3d_cs_op opcode)
+{
+    struct wined3d_cs_profile_frame *frame = profiler->client_frame;
+    struct wined3d_cs_profile_event *event;
+    LARGE_INTEGER now;
+    size_t depth;
+
+    depth = (queue->head - *(volatile LONG *)&queue->tail) & (WINED3D_CS_QUEUE_SIZE - 1);
+    frame->max_queue_depth = max(frame->max_queue_depth, depth);
+    ++frame->packet_count;
+    if (profiler->csv || !wined3d_array_reserve((void **)&frame->submits,
+            &frame->submits_size, frame->submits_count + 1, sizeof(*frame->submits)))
+        return;
+
+    QueryPerformanceCounter(&now);
+    event = &frame->submits[frame->submits_count++];
+    event->opcode = opcode;
+    event->start = now.QuadPart;
+    event->duration = 0;
+}
+
+/* Called by the application thread when it had to wait for the command
+ * stream. */
+static void wined3d_cs_profile_wait(struct wined3d_cs_profiler *profiler, LONGLONG start, LONGLONG duration)
+{
+    struct wined3d_cs_profile_frame *frame = profiler->client_frame;
+    struct wined3d_cs_profile_event *event;
+
+    frame->wait_time += duration;
+    ++frame->wait_count;
+    if (profiler->csv || !wined3d_array_reserve((void **)&frame->waits,
+            &frame->waits_size, frame->waits_count + 1, sizeof(*frame->waits)))
+        return;
+
+    event = &frame->waits[frame->waits_count++];
+    event->opcode = WINED3D_CS_OP_NOP;
+    event->start = start;
+    event->duration = duration;
+}
+
+/* Called by the application thread when it presents. Returns the frame that
+ * ended, to be passed along with the PRESENT packet. */
+static struct wined3d_cs_profile_frame *wined3d_cs_profile_present(struct wined3d_cs_profiler *profiler)
+{
+    struct wined3d_cs_profile_frame *frame, *next;
+    LARGE_INTEGER now;
+
+    /* If we can't start a new frame, the current one just continues. */
+    if (!(next = heap_alloc_zero(sizeof(*next))))
+        return NULL;
+
+    QueryPerformanceCounter(&now);
+    frame = profiler->client_frame;
+    frame->end = now.QuadPart;
+    next->start = now.QuadPart;
+    profiler->client_frame = next;
+
+    return frame;
+}
+
+static void wined3d_cs_profiler_write_frame(struct wined3d_cs_profiler *profiler,
+        LONGLONG present_end, LONGLONG present_time)
+{
+    const struct wined3d_cs_profile_frame *frame = profiler->present_frame;
+    LONGLONG frame_time = present_end - profiler->frame_start;
+    const struct wined3d_cs_profile_event *event;
+    char name[32];
+    SIZE_T i;
+
+    if (profiler->csv)
+    {
+        shader_addline(&profiler->buffer, "%u,%.3f,%.3f,", profiler->frame_idx,
+                wined3d_cs_profiler_ms(profiler, present_end - profiler->origin),
+                wined3d_cs_profiler_ms(profiler, frame_time));
+        if (frame)
+            shader_addline(&profiler->buffer, "%.3f,%.3f,%u,%u,%lu,",
+                    wined3d_cs_profiler_ms(profiler, frame->end - frame->start),
+                    wined3d_cs_profiler_ms(profiler, frame->wait_time), frame->wait_count,
+                    frame->packet_count, (unsigned long)frame->max_queue_depth);
+        else
+            shader_addline(&profiler->buffer, ",,,,,");
+        shader_addline(&profiler->buffer, "%.3f,%.3f,%.3f,",
+                wined3d_cs_profiler_ms(profiler, profiler->busy_time),
+                wined3d_cs_profiler_ms(profiler, present_time),
+                wined3d_cs_profiler_ms(profiler, frame_time - profiler->busy_time));
+        if (frame)
+            shader_addline(&profiler->buffer, "%.3f\n", wined3d_cs_profiler_ms(profiler, present_end - frame->end));
+        else
+            shader_addline(&profiler->buffer, "\n");
+    }
+    else
+    {
+        sprintf(name, "frame %u", profiler->frame_idx);
+        if (frame)
+        {
+            wined3d_cs_profiler_write_event(profiler, name,
+                    WINED3D_CS_PROFILE_TID_APPLICATION, frame->start, frame->end - frame->start);
+            for (i = 0; i < frame->waits_count; ++i)
+            {
+                event = &frame->waits[i];
+                wined3d_cs_profiler_write_event(profiler, "wait",
+                        WINED3D_CS_PROFILE_TID_APPLICATION, event->start, event->duration);
+            }
+            for (i = 0; i < frame->submits_count; ++i)
+            {
+                event = &frame->submits[i];
+                wined3d_cs_profiler_write_instant(profiler, debug_cs_op(event->opcode),
+                        WINED3D_CS_PROFILE_TID_APPLICATION, event->start);
+            }
+            wined3d_cs_profiler_write_counter(profiler, "max queue bytes",
+                    frame->end, frame->max_queue_depth);
+            wined3d_cs_profiler_write_counter(profiler, "latency ms", present_end,
+                    wined3d_cs_profiler_ms(profiler, present_end - frame->end));
+        }
+        wined3d_cs_profiler_write_event(profiler, name,
+                WINED3D_CS_PROFILE_TID_CS, profiler->frame_start, frame_time);
+        for (i = 0; i < profiler->event_count; ++i)
+        {
+            event = &profiler->events[i];
+            wined3d_cs_profiler_write_event(profiler, debug_cs_op(event->opcode),
+                    WINED3D_CS_PROFILE_TID_CS, event->start, event->duration);
+        }
+    }
+    wined3d_cs_profiler_flush(profiler);
+
+    wined3d_cs_profile_frame_destroy(profiler->present_frame);
+    profiler->present_frame = NULL;
+    profiler->frame_start = present_end;
+    profiler->busy_time = 0;
+    profiler->event_count = 0;
+    ++profiler->frame_idx;
+}
+
+/* Called by the command stream thread for every packet it executed. */
+static void wined3d_cs_profile_packet(struct wined3d_cs_profiler *profiler,
+        enum wined3d_cs_op opcode, LONGLONG start)
+{
+    struct wined3d_cs_profile_event *event;
+    LARGE_INTEGER end;
+
+    QueryPerformanceCounter(&end);
+    profiler->busy_time += end.QuadPart - start;
+
+    if (!profiler->csv && wined3d_array_reserve((void **)&profiler->events,
+            &profiler->events_size, profiler->event_count + 1, sizeof(*profiler->events)))
+    {
+        event = &profiler->events[profiler->event_count++];
+        event->opcode = opcode;
+        event->start = start;
+        event->duration = end.QuadPart - start;
+    }
+
+    if (opcode == WINED3D_CS_OP_PRESENT)
+        wined3d_cs_profiler_write_frame(profiler, end.QuadPart, end.QuadPart - start);
+}
+
+void wined3d_cs_wait_init(struct wined3d_cs *cs, struct wined3d_cs_wait *wait)
+{
+    wait->progress = *(volatile LONG *)&cs->progress;
+    wait->spin_count = 0;
+    wait->sleep_time = 0;
+}
+
+/* Spin for a while, then sleep until the command stream executes another
+ * packet. The timeout covers several threads waiting at the same time,
+ * since only one of them is woken up. */
+void wined3d_cs_wait(struct wined3d_cs *cs, struct wined3d_cs_wait *wait)
+{
+    LARGE_INTEGER start, end;
+
+    if (!wait->spin_count++)
+        QueryPerformanceCounter(&wait->start);
+
+    if (wait->spin_count <= wined3d_settings.cs_client_spin_count)
+    {
+        wined3d_pause();
+    }
+    else
+    {
+        InterlockedExchange(&cs->client_waiting, TRUE);
+        /* Packets executed after the caller tested its condition may have
+         * happened before "client_waiting" was set. */
+        if (InterlockedCompareExchange(&cs->progress, 0, 0) == wait->progress)
+        {
+            QueryPerformanceCounter(&start);
+            WaitForSingleObject(cs->client_event, WINED3D_CS_WAIT_TIMEOUT);
+            QueryPerformanceCounter(&end);
+            wait->sleep_time += end.QuadPart - start.QuadPart;
+            ++cs->client_stats.sleep_count;
+        }
+    }
+
+    wait->progress = *(volatile LONG *)&cs->progress;
+}
+
+void wined3d_cs_wait_done(struct wined3d_cs *cs, struct wined3d_cs_wait *wait)
+{
+    LARGE_INTEGER end;
+
+    if (!wait->spin_count)
+        return;
+
+    QueryPerformanceCounter(&end);
+    ++cs->client_stats.wait_count;
+    cs->client_stats.spin_time += end.QuadPart - wait->start.QuadPart - wait->sleep_time;
+    cs->client_stats.sleep_time += wait->sleep_time;
+    if (cs->profiler)
+        wined3d_cs_profile_wait(cs->profiler, wait->start.QuadPart, end.QuadPart - wait->start.QuadPart);
+}
+
+static void wined3d_cs_report_wait_stats(struct wined3d_cs *cs, BOOL force)
+{
+    const struct wined3d_cs_wait_stats *worker = &cs->worker_stats, *client = &cs->client_stats;
+    LARGE_INTEGER now, freq;
+    double ms;
+
+    if (!cs->thread || !TRACE_ON(d3d_perf))
+        return;
+
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    if (!force && now.QuadPart - cs->stats_time.QuadPart < freq.QuadPart)
+        return;
+    cs->stats_time = now;
+
+    ms = 1000.0 / freq.QuadPart;
+    TRACE_(d3d_perf)("Worker: %u waits, spun %.3f ms, slept %.3f ms in %u sleeps.\n",
+            worker->wait_count, worker->spin_time * ms, worker->sleep_time * ms, worker->sleep_count);
+    TRACE_(d3d_perf)("Client: %u waits, spun %.3f ms, slept %.3f ms in %u sleeps.\n",
+            client->wait_count, client->spin_time * ms, client->sleep_time * ms, client->sleep_count);
+}
+
+/* Context activation is done by the caller. */
+void wined3d_cs_create_upload_ring(struct wined3d_cs *cs, struct wined3d_context *context)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    struct wined3d_upload_ring *ring = &cs->upload_ring;
+    unsigned int i;
+
+    if (!cs->thread || !gl_info->supported[ARB_BUFFER_STORAGE])
+        return;
+
+    for (i = 0; i < ARRAY_SIZE(ring->fences); ++i)
+    {
+        if (FAILED(wined3d_fence_create(cs->device, &ring->fences[i].fence)))
+        {
+            WARN("Failed to create upload ring fences.\n");
+            goto fail;
+        }
+    }
+
+    GL_EXTCALL(glGenBuffers(1, &ring->buffer_object));
+    context_bind_bo(context, GL_PIXEL_UNPACK_BUFFER, ring->buffer_object);
+    GL_EXTCALL(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, WINED3D_UPLOAD_RING_SIZE, NULL,
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    ring->map_ptr = GL_EXTCALL(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, WINED3D_UPLOAD_RING_SIZE,
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    context_bind_bo(context, GL_PIXEL_UNPACK_BUFFER, 0);
+    checkGLcall("create upload ring");
+
+    if (!ring->map_ptr)
+    {
+        WARN("Failed to map the upload ring.\n");
+        GL_EXTCALL(glDeleteBuffers(1, &ring->buffer_object));
+        ring->buffer_object = 0;
+        goto fail;
+    }
+
+    ring->head = ring->submitted = ring->fenced = 0;
+    ring->retired = 0;
+    ring->fence_start = ring->fence_count = 0;
+
+    TRACE("Created upload ring %p, buffer object %u.\n", ring->map_ptr, ring->buffer_object);
+    return;
+
+fail:
+    for (i = 0; i < ARRAY_SIZE(ring->fences) && ring->fences[i].fence; ++i)
+    {
+        wined3d_fence_destroy(ring->fences[i].fence);
+        ring->fences[i].fence = NULL;
+    }
+}
+
+/* Context activation is done by the caller. */
+void wined3d_cs_destroy_upload_ring(struct wined3d_cs *cs, struct wined3d_context *context)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    struct wined3d_upload_ring *ring = &cs->upload_ring;
+    unsigned int i;
+
+    if (!ring->map_ptr)
+        return;
+
+    /* The application thread checks "map_ptr" before allocating. */
+    ring->map_ptr = NULL;
+    GL_EXTCALL(glDeleteBuffers(1, &ring->buffer_object));
+    checkGLcall("destroy upload ring");
+    ring->buffer_object = 0;
+
+    for (i = 0; i < ARRAY_SIZE(ring->fences); ++i)
+    {
+        wined3d_fence_destroy(ring->fences[i].fence);
+        ring->fences[i].fence = NULL;
+    }
+}
+
+static void wined3d_cs_retire_upload_ring(struct wined3d_cs *cs, BOOL wait)
+{
+    struct wined3d_upload_ring *ring = &cs->upload_ring;
+    enum wined3d_fence_result ret;
+    unsigned int idx;
+
+    while (ring->fence_count)
+    {
+        idx = ring->fence_start;
+        if (wait)
+            ret = wined3d_fence_wait(ring->fences[idx].fence, cs->device);
+        else
+            ret = wined3d_fence_test(ring->fences[idx].fence, cs->device, 0);
+        if (ret == WINED3D_FENCE_WAITING)
+            break;
+        if (ret != WINED3D_FENCE_OK)
+            ERR("Upload ring fence %u returned %#x.\n", idx, ret);
+
+        InterlockedExchange(&ring->retired, ring->fences[idx].end);
+        ring->fence_start = (idx + 1) % ARRAY_SIZE(ring->fences);
+        --ring->fence_count;
+        wait = FALSE;
+    }
+}
+
+/* Fence everything submitted from the upload ring so far, and give back the
+ * space covered by fences that have already signalled. */
+static void wined3d_cs_fence_upload_ring(struct wined3d_cs *cs)
+{
+    struct wined3d_upload_ring *ring = &cs->upload_ring;
+    unsigned int idx;
+
+    if (!ring->map_ptr)
+        return;
+
+    wined3d_cs_retire_upload_ring(cs, FALSE);
+    if (ring->submitted == ring->fenced)
+        return;
+
+    if (ring->fence_count == ARRAY_SIZE(ring->fences))
+        wined3d_cs_retire_upload_ring(cs, TRUE);
+
+    idx = (ring->fence_start + ring->fence_count) % ARRAY_SIZE(ring->fences);
+    wined3d_fence_issue(ring->fences[idx].fence, cs->device);
+    ring->fences[idx].end = ring->submitted;
+    ring->fenced = ring->submitted;
+    ++ring->fence_count;
+}
+
+static BOOL wined3d_cs_alloc_upload_ring(struct wined3d_cs *cs, unsigned int size,
+        unsigned int *offset, ULONG *end)
+{
+    struct wined3d_upload_ring *ring = &cs->upload_ring;
+    ULONG start;
+
+    if (!ring->map_ptr || size > WINED3D_UPLOAD_RING_SIZE / 4)
+        return FALSE;
+
+    size = (size + WINED3D_UPLOAD_RING_ALIGNMENT - 1) & ~(WINED3D_UPLOAD_RING_ALIGNMENT - 1);
+    start = ring->head;
+    if ((start % WINED3D_UPLOAD_RING_SIZE) + size > WINED3D_UPLOAD_RING_SIZE)
+        start += WINED3D_UPLOAD_RING_SIZE - (start % WINED3D_UPLOAD_RING_SIZE);
+
+    if (start + size - (ULONG)InterlockedCompareExchange(&ring->retired, 0, 0) > WINED3D_UPLOAD_RING_SIZE)
+    {
+        TRACE("Upload ring is full.\n");
+        return FALSE;
+    }
+
+    ring->head = start + size;
+    *offset = start % WINED3D_UPLOAD_RING_SIZE;
+    *end = ring->head;
+
+    return TRUE;
+}
+
 static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_present *op = data;
@@ -528,6 +1244,10 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
     wined3d_swapchain_set_window(swapchain, op->dst_window_override);
 
     swapchain->swapchain_ops->swapchain_present(swapchain, &op->src_rect, &op->dst_rect, op->swap_interval, op->flags);
+    wined3d_cs_fence_upload_ring(cs);
+    wined3d_cs_report_wait_stats(cs, FALSE);
+    if (cs->profiler)
+        cs->profiler->present_frame = op->profile_frame;
 
     wined3d_resource_release(&swapchain->front_buffer->resource);
     for (i = 0; i < swapchain->desc.backbuffer_count; ++i)
@@ -543,6 +1263,7 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
         unsigned int swap_interval, DWORD flags)
 {
     struct wined3d_cs_present *op;
+    struct wined3d_cs_wait wait;
     unsigned int i;
     LONG pending;
 
@@ -554,52 +1275,63 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
     op->dst_rect = *dst_rect;
     op->swap_interval = swap_interval;
     op->flags = flags;
+    op->profile_frame = cs->profiler ? wined3d_cs_profile_present(cs->profiler) : NULL;
 
     pending = InterlockedIncrement(&cs->pending_presents);
 
-    wined3d_resource_acquire(&swapchain->front_buffer->resource);
+    wined3d_cs_acquire_resource(cs, &swapchain->front_buffer->resource);
     for (i = 0; i < swapchain->desc.backbuffer_count; ++i)
     {
-        wined3d_resource_acquire(&swapchain->back_buffers[i]->resource);
+        wined3d_cs_acquire_resource(cs, &swapchain->back_buffers[i]->resource);
     }
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 
     /* Limit input latency by limiting the number of presents that we can get
      * ahead of the worker thread. */
+    wined3d_cs_wait_init(cs, &wait);
     while (pending >= swapchain->max_frame_latency)
     {
-        wined3d_pause();
+        wined3d_cs_wait(cs, &wait);
         pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
     }
+    wined3d_cs_wait_done(cs, &wait);
+
+    if (cs->op_stats)
+        wined3d_cs_report_op_stats(cs);
 }
 
 static void wined3d_cs_exec_clear(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_clear *op = data;
+    const struct wined3d_fb_state *fb;
     struct wined3d_device *device;
     unsigned int i;
 
+    /* Single view clears store the framebuffer state after the rectangle,
+     * so that the packet can be copied. */
+    fb = op->fb ? op->fb : (const struct wined3d_fb_state *)&op->rects[1];
+
     device = cs->device;
-    device->blitter->ops->blitter_clear(device->blitter, device, op->rt_count, op->fb,
+    device->blitter->ops->blitter_clear(device->blitter, device, op->rt_count, fb,
             op->rect_count, op->rects, &op->draw_rect, op->flags, &op->color, op->depth, op->stencil);
 
     if (op->flags & WINED3DCLEAR_TARGET)
     {
         for (i = 0; i < op->rt_count; ++i)
         {
-            if (op->fb->render_targets[i])
-                wined3d_resource_release(op->fb->render_targets[i]->resource);
+            if (fb->render_targets[i])
+                wined3d_resource_release(fb->render_targets[i]->resource);
         }
     }
     if (op->flags & (WINED3DCLEAR_ZBUFFER | WINED3DCLEAR_STENCIL))
-        wined3d_resource_release(op->fb->depth_stencil->resource);
+        wined3d_resource_release(fb->depth_stencil->resource);
 }
 
 void wined3d_cs_emit_clear(struct wined3d_cs *cs, DWORD rect_count, const RECT *rects,
         DWORD flags, const struct wined3d_color *color, float depth, DWORD stencil)
 {
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = wined3d_cs_get_client_state(cs);
     const struct wined3d_viewport *vp = &state->viewports[0];
     struct wined3d_rendertarget_view *view;
     struct wined3d_cs_clear *op;
@@ -625,12 +1357,12 @@ void wined3d_cs_emit_clear(struct wined3d_cs *cs, DWORD rect_count, const RECT *
     for (i = 0; i < rt_count; ++i)
     {
         if ((view = state->fb->render_targets[i]))
-            wined3d_resource_acquire(view->resource);
+            wined3d_cs_acquire_resource(cs, view->resource);
     }
     if (flags & (WINED3DCLEAR_ZBUFFER | WINED3DCLEAR_STENCIL))
     {
         view = state->fb->depth_stencil;
-        wined3d_resource_acquire(view->resource);
+        wined3d_cs_acquire_resource(cs, view->resource);
     }
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
@@ -639,27 +1371,29 @@ void wined3d_cs_emit_clear(struct wined3d_cs *cs, DWORD rect_count, const RECT *
 void wined3d_cs_emit_clear_rendertarget_view(struct wined3d_cs *cs, struct wined3d_rendertarget_view *view,
         const RECT *rect, DWORD flags, const struct wined3d_color *color, float depth, DWORD stencil)
 {
+    struct wined3d_fb_state *fb;
     struct wined3d_cs_clear *op;
     size_t size;
 
     size = FIELD_OFFSET(struct wined3d_cs_clear, rects[1]) + sizeof(struct wined3d_fb_state);
     op = wined3d_cs_require_space(cs, size, WINED3D_CS_QUEUE_DEFAULT);
-    op->fb = (void *)&op->rects[1];
+    op->fb = NULL;
+    fb = (struct wined3d_fb_state *)&op->rects[1];
 
     op->opcode = WINED3D_CS_OP_CLEAR;
     op->flags = flags & (WINED3DCLEAR_TARGET | WINED3DCLEAR_ZBUFFER | WINED3DCLEAR_STENCIL);
     if (flags & WINED3DCLEAR_TARGET)
     {
         op->rt_count = 1;
-        op->fb->render_targets[0] = view;
-        op->fb->depth_stencil = NULL;
+        fb->render_targets[0] = view;
+        fb->depth_stencil = NULL;
         op->color = *color;
     }
     else
     {
         op->rt_count = 0;
-        op->fb->render_targets[0] = NULL;
-        op->fb->depth_stencil = view;
+        fb->render_targets[0] = NULL;
+        fb->depth_stencil = view;
         op->depth = depth;
         op->stencil = stencil;
     }
@@ -667,14 +1401,15 @@ void wined3d_cs_emit_clear_rendertarget_view(struct wined3d_cs *cs, struct wined
     op->rect_count = 1;
     op->rects[0] = *rect;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_cs_acquire_resource(cs, view->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
     if (flags & WINED3DCLEAR_SYNCHRONOUS)
         wined3d_cs_finish(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-static void acquire_shader_resources(const struct wined3d_state *state, unsigned int shader_mask)
+static void acquire_shader_resources(struct wined3d_cs *cs,
+        const struct wined3d_state *state, unsigned int shader_mask)
 {
     struct wined3d_shader_sampler_map_entry *entry;
     struct wined3d_shader_resource_view *view;
@@ -692,7 +1427,7 @@ static void acquire_shader_resources(const struct wined3d_state *state, unsigned
         for (j = 0; j < WINED3D_MAX_CBS; ++j)
         {
             if (state->cb[i][j])
-                wined3d_resource_acquire(&state->cb[i][j]->resource);
+                wined3d_cs_acquire_resource(cs, &state->cb[i][j]->resource);
         }
 
         for (j = 0; j < shader->reg_maps.sampler_map.count; ++j)
@@ -702,7 +1437,7 @@ static void acquire_shader_resources(const struct wined3d_state *state, unsigned
             if (!(view = state->shader_resource_view[i][entry->resource_idx]))
                 continue;
 
-            wined3d_resource_acquire(view->resource);
+            wined3d_cs_acquire_resource(cs, view->resource);
         }
     }
 }
@@ -740,7 +1475,7 @@ static void release_shader_resources(const struct wined3d_state *state, unsigned
     }
 }
 
-static void acquire_unordered_access_resources(const struct wined3d_shader *shader,
+static void acquire_unordered_access_resources(struct wined3d_cs *cs, const struct wined3d_shader *shader,
         struct wined3d_unordered_access_view * const *views)
 {
     unsigned int i;
@@ -756,7 +1491,7 @@ static void acquire_unordered_access_resources(const struct wined3d_shader *shad
         if (!views[i])
             continue;
 
-        wined3d_resource_acquire(views[i]->resource);
+        wined3d_cs_acquire_resource(cs, views[i]->resource);
     }
 }
 
@@ -795,17 +1530,17 @@ static void wined3d_cs_exec_dispatch(struct wined3d_cs *cs, const void *data)
             state->unordered_access_view[WINED3D_PIPELINE_COMPUTE]);
 }
 
-static void acquire_compute_pipeline_resources(const struct wined3d_state *state)
+static void acquire_compute_pipeline_resources(struct wined3d_cs *cs, const struct wined3d_state *state)
 {
-    acquire_shader_resources(state, 1u << WINED3D_SHADER_TYPE_COMPUTE);
-    acquire_unordered_access_resources(state->shader[WINED3D_SHADER_TYPE_COMPUTE],
+    acquire_shader_resources(cs, state, 1u << WINED3D_SHADER_TYPE_COMPUTE);
+    acquire_unordered_access_resources(cs, state->shader[WINED3D_SHADER_TYPE_COMPUTE],
             state->unordered_access_view[WINED3D_PIPELINE_COMPUTE]);
 }
 
 void wined3d_cs_emit_dispatch(struct wined3d_cs *cs,
         unsigned int group_count_x, unsigned int group_count_y, unsigned int group_count_z)
 {
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = wined3d_cs_get_client_state(cs);
     struct wined3d_cs_dispatch *op;
 
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
@@ -815,7 +1550,7 @@ void wined3d_cs_emit_dispatch(struct wined3d_cs *cs,
     op->parameters.u.direct.group_count_y = group_count_y;
     op->parameters.u.direct.group_count_z = group_count_z;
 
-    acquire_compute_pipeline_resources(state);
+    acquire_compute_pipeline_resources(cs, state);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -823,7 +1558,7 @@ void wined3d_cs_emit_dispatch(struct wined3d_cs *cs,
 void wined3d_cs_emit_dispatch_indirect(struct wined3d_cs *cs,
         struct wined3d_buffer *buffer, unsigned int offset)
 {
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = wined3d_cs_get_client_state(cs);
     struct wined3d_cs_dispatch *op;
 
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
@@ -832,8 +1567,8 @@ void wined3d_cs_emit_dispatch_indirect(struct wined3d_cs *cs,
     op->parameters.u.indirect.buffer = buffer;
     op->parameters.u.indirect.offset = offset;
 
-    acquire_compute_pipeline_resources(state);
-    wined3d_resource_acquire(&buffer->resource);
+    acquire_compute_pipeline_resources(cs, state);
+    wined3d_cs_acquire_resource(cs, &buffer->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -925,48 +1660,134 @@ static void wined3d_cs_exec_draw(struct wined3d_cs *cs, const void *data)
             state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS]);
 }
 
-static void acquire_graphics_pipeline_resources(const struct wined3d_state *state,
+static void acquire_graphics_pipeline_resources(struct wined3d_cs *cs, const struct wined3d_state *state,
         BOOL indexed, const struct wined3d_d3d_info *d3d_info)
 {
     unsigned int i;
 
     if (indexed)
-        wined3d_resource_acquire(&state->index_buffer->resource);
+        wined3d_cs_acquire_resource(cs, &state->index_buffer->resource);
     for (i = 0; i < ARRAY_SIZE(state->streams); ++i)
     {
         if (state->streams[i].buffer)
-            wined3d_resource_acquire(&state->streams[i].buffer->resource);
+            wined3d_cs_acquire_resource(cs, &state->streams[i].buffer->resource);
     }
     for (i = 0; i < ARRAY_SIZE(state->stream_output); ++i)
     {
         if (state->stream_output[i].buffer)
-            wined3d_resource_acquire(&state->stream_output[i].buffer->resource);
+            wined3d_cs_acquire_resource(cs, &state->stream_output[i].buffer->resource);
     }
     for (i = 0; i < ARRAY_SIZE(state->textures); ++i)
     {
         if (state->textures[i])
-            wined3d_resource_acquire(&state->textures[i]->resource);
+            wined3d_cs_acquire_resource(cs, &state->textures[i]->resource);
     }
     for (i = 0; i < d3d_info->limits.max_rt_count; ++i)
     {
         if (state->fb->render_targets[i])
-            wined3d_resource_acquire(state->fb->render_targets[i]->resource);
+            wined3d_cs_acquire_resource(cs, state->fb->render_targets[i]->resource);
     }
     if (state->fb->depth_stencil)
-        wined3d_resource_acquire(state->fb->depth_stencil->resource);
-    acquire_shader_resources(state, ~(1u << WINED3D_SHADER_TYPE_COMPUTE));
-    acquire_unordered_access_resources(state->shader[WINED3D_SHADER_TYPE_PIXEL],
+        wined3d_cs_acquire_resource(cs, state->fb->depth_stencil->resource);
+    acquire_shader_resources(cs, state, ~(1u << WINED3D_SHADER_TYPE_COMPUTE));
+    acquire_unordered_access_resources(cs, state->shader[WINED3D_SHADER_TYPE_PIXEL],
             state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS]);
 }
 
+/* Non-indexed list draws are held back by the application thread, so that a
+ * following draw continuing the same vertex range can be merged into them.
+ * This mostly helps immediate-mode D3D8/D3D9 draws, which append their
+ * vertices to a single dynamic buffer. Anything else going through the
+ * command stream emits the held back draw first, so the state it was
+ * recorded with is still current when it's merged. */
+static BOOL wined3d_cs_can_hold_draw(const struct wined3d_cs *cs, const struct wined3d_state *state,
+        GLenum primitive_type, unsigned int vertex_count, unsigned int start_instance,
+        unsigned int instance_count, BOOL indexed)
+{
+    const struct wined3d_shader *vs = state->shader[WINED3D_SHADER_TYPE_VERTEX];
+    const struct wined3d_shader *ps = state->shader[WINED3D_SHADER_TYPE_PIXEL];
+
+    if (cs->ops != &wined3d_cs_mt_ops || indexed || start_instance || instance_count)
+        return FALSE;
+
+    /* Merged draws would change vertex and primitive IDs. */
+    if ((vs && vs->reg_maps.shader_version.major >= 4) || (ps && ps->reg_maps.shader_version.major >= 4)
+            || state->shader[WINED3D_SHADER_TYPE_HULL] || state->shader[WINED3D_SHADER_TYPE_DOMAIN]
+            || state->shader[WINED3D_SHADER_TYPE_GEOMETRY])
+        return FALSE;
+
+    switch (primitive_type)
+    {
+        case GL_POINTS:
+            return TRUE;
+        case GL_LINES:
+            return !(vertex_count % 2);
+        case GL_TRIANGLES:
+            return !(vertex_count % 3);
+        default:
+            return FALSE;
+    }
+}
+
+void wined3d_cs_emit_pending_draw(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_draw *op;
+
+    if (cs->thread_id == GetCurrentThreadId())
+        return;
+
+    cs->draw_pending = FALSE;
+
+    op = cs->ops->require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_DRAW;
+    op->primitive_type = cs->pending_draw_primitive_type;
+    op->patch_vertex_count = cs->pending_draw_patch_vertex_count;
+    op->parameters.indirect = FALSE;
+    op->parameters.u.direct = cs->pending_draw;
+    op->parameters.indexed = FALSE;
+
+    /* The resources were acquired when the draw was held back. */
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+}
+
 void wined3d_cs_emit_draw(struct wined3d_cs *cs, GLenum primitive_type, unsigned int patch_vertex_count,
         int base_vertex_idx, unsigned int start_idx, unsigned int index_count,
         unsigned int start_instance, unsigned int instance_count, BOOL indexed)
 {
     const struct wined3d_d3d_info *d3d_info = &cs->device->adapter->d3d_info;
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = wined3d_cs_get_client_state(cs);
+    struct wined3d_direct_draw_parameters *pending = &cs->pending_draw;
     struct wined3d_cs_draw *op;
 
+    if (wined3d_cs_can_hold_draw(cs, state, primitive_type, index_count, start_instance, instance_count, indexed))
+    {
+        if (cs->draw_pending)
+        {
+            if (cs->pending_draw_primitive_type == primitive_type
+                    && pending->start_idx + pending->index_count == start_idx)
+            {
+                TRACE("Merging draw %u, %u into pending draw %u, %u.\n",
+                        start_idx, index_count, pending->start_idx, pending->index_count);
+                pending->index_count += index_count;
+                if (cs->op_stats)
+                    ++cs->op_stats->merged_draw_count;
+                return;
+            }
+            wined3d_cs_emit_pending_draw(cs);
+        }
+
+        cs->pending_draw_primitive_type = primitive_type;
+        cs->pending_draw_patch_vertex_count = patch_vertex_count;
+        pending->base_vertex_idx = base_vertex_idx;
+        pending->start_idx = start_idx;
+        pending->index_count = index_count;
+        pending->start_instance = start_instance;
+        pending->instance_count = instance_count;
+        acquire_graphics_pipeline_resources(cs, state, FALSE, d3d_info);
+        cs->draw_pending = TRUE;
+        return;
+    }
+
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_DRAW;
     op->primitive_type = primitive_type;
@@ -979,7 +1800,7 @@ void wined3d_cs_emit_draw(struct wined3d_cs *cs, GLenum primitive_type, unsigned
     op->parameters.u.direct.instance_count = instance_count;
     op->parameters.indexed = indexed;
 
-    acquire_graphics_pipeline_resources(state, indexed, d3d_info);
+    acquire_graphics_pipeline_resources(cs, state, indexed, d3d_info);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -988,7 +1809,7 @@ void wined3d_cs_emit_draw_indirect(struct wined3d_cs *cs, GLenum primitive_type,
         struct wined3d_buffer *buffer, unsigned int offset, BOOL indexed)
 {
     const struct wined3d_d3d_info *d3d_info = &cs->device->adapter->d3d_info;
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = wined3d_cs_get_client_state(cs);
     struct wined3d_cs_draw *op;
 
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
@@ -1000,8 +1821,8 @@ void wined3d_cs_emit_draw_indirect(struct wined3d_cs *cs, GLenum primitive_type,
     op->parameters.u.indirect.offset = offset;
     op->parameters.indexed = indexed;
 
-    acquire_graphics_pipeline_resources(state, indexed, d3d_info);
-    wined3d_resource_acquire(&buffer->resource);
+    acquire_graphics_pipeline_resources(cs, state, indexed, d3d_info);
+    wined3d_cs_acquire_resource(cs, &buffer->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -1954,26 +2775,72 @@ static void wined3d_cs_mt_push_constants(struct wined3d_cs *cs, enum wined3d_pus
     op->count = count;
     memcpy(op->constants, constants, size);
 
-    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+}
+
+static void wined3d_cs_exec_reset_state(struct wined3d_cs *cs, const void *data)
+{
+    struct wined3d_adapter *adapter = cs->device->adapter;
+
+    state_cleanup(&cs->state);
+    memset(&cs->state, 0, sizeof(cs->state));
+    state_init(&cs->state, &cs->fb, &adapter->d3d_info, WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
+}
+
+void wined3d_cs_emit_reset_state(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_reset_state *op;
+
+    op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_RESET_STATE;
+
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+}
+
+static void wined3d_cs_invalidate_state(struct wined3d_cs *cs)
+{
+    struct wined3d_device *device = cs->device;
+    unsigned int i, j;
+
+    for (i = 0; i <= STATE_HIGHEST; ++i)
+    {
+        if (device->state_table[i].representative)
+            device_invalidate_state(device, i);
+    }
+
+    for (i = 0; i < device->context_count; ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(wined3d_cs_push_constant_info); ++j)
+            device->contexts[i]->constant_update_mask |= wined3d_cs_push_constant_info[j].mask;
+    }
 }
 
-static void wined3d_cs_exec_reset_state(struct wined3d_cs *cs, const void *data)
+static void wined3d_cs_exec_begin_command_list(struct wined3d_cs *cs, const void *data)
 {
+    const struct wined3d_cs_begin_command_list *op = data;
     struct wined3d_adapter *adapter = cs->device->adapter;
 
-    state_cleanup(&cs->state);
+    /* Command lists are recorded against the default state. The light lists
+     * of the saved copy still link to cs->state, which is fine as long as
+     * they are only used again after the copy is restored in place. */
+    op->saved->state = cs->state;
+    op->saved->fb = cs->fb;
+
     memset(&cs->state, 0, sizeof(cs->state));
+    memset(&cs->fb, 0, sizeof(cs->fb));
     state_init(&cs->state, &cs->fb, &adapter->d3d_info, WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
+    wined3d_cs_invalidate_state(cs);
 }
 
-void wined3d_cs_emit_reset_state(struct wined3d_cs *cs)
+static void wined3d_cs_exec_end_command_list(struct wined3d_cs *cs, const void *data)
 {
-    struct wined3d_cs_reset_state *op;
-
-    op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
-    op->opcode = WINED3D_CS_OP_RESET_STATE;
+    const struct wined3d_cs_end_command_list *op = data;
 
-    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+    state_cleanup(&cs->state);
+    cs->state = op->saved->state;
+    cs->fb = op->saved->fb;
+    heap_free(op->saved);
+    wined3d_cs_invalidate_state(cs);
 }
 
 static void wined3d_cs_exec_callback(struct wined3d_cs *cs, const void *data)
@@ -2077,7 +2944,7 @@ void wined3d_cs_emit_preload_resource(struct wined3d_cs *cs, struct wined3d_reso
     op->opcode = WINED3D_CS_OP_PRELOAD_RESOURCE;
     op->resource = resource;
 
-    wined3d_resource_acquire(resource);
+    wined3d_cs_acquire_resource(cs, resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2099,11 +2966,114 @@ void wined3d_cs_emit_unload_resource(struct wined3d_cs *cs, struct wined3d_resou
     op->opcode = WINED3D_CS_OP_UNLOAD_RESOURCE;
     op->resource = resource;
 
-    wined3d_resource_acquire(resource);
+    wined3d_cs_acquire_resource(cs, resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
+static struct wined3d_upload_region *wined3d_cs_get_upload_region(struct wined3d_cs *cs, unsigned int size)
+{
+    struct wined3d_upload_region *region;
+
+    EnterCriticalSection(&cs->upload_pool_cs);
+    LIST_FOR_EACH_ENTRY(region, &cs->upload_pool, struct wined3d_upload_region, entry)
+    {
+        if (region->size != size)
+            continue;
+
+        list_remove(&region->entry);
+        cs->upload_pool_size -= size;
+        LeaveCriticalSection(&cs->upload_pool_cs);
+
+        region->refcount = 1;
+        return region;
+    }
+    LeaveCriticalSection(&cs->upload_pool_cs);
+
+    if (InterlockedExchangeAdd(&cs->upload_size, size) + size > WINED3D_CS_UPLOAD_LIMIT)
+    {
+        TRACE("Too much memory in upload regions, falling back to a synchronous map.\n");
+        InterlockedExchangeAdd(&cs->upload_size, -(LONG)size);
+        return NULL;
+    }
+
+    if (!(region = heap_alloc(sizeof(*region) + size + RESOURCE_ALIGNMENT - 1)))
+    {
+        InterlockedExchangeAdd(&cs->upload_size, -(LONG)size);
+        return NULL;
+    }
+
+    region->refcount = 1;
+    region->size = size;
+    region->data = (BYTE *)(((ULONG_PTR)(region + 1) + RESOURCE_ALIGNMENT - 1) & ~(ULONG_PTR)(RESOURCE_ALIGNMENT - 1));
+
+    return region;
+}
+
+void wined3d_cs_release_upload_region(struct wined3d_cs *cs, struct wined3d_upload_region *region)
+{
+    if (InterlockedDecrement(&region->refcount))
+        return;
+
+    EnterCriticalSection(&cs->upload_pool_cs);
+    if (cs->upload_pool_size + region->size <= WINED3D_CS_UPLOAD_POOL_SIZE)
+    {
+        list_add_head(&cs->upload_pool, &region->entry);
+        cs->upload_pool_size += region->size;
+        region = NULL;
+    }
+    LeaveCriticalSection(&cs->upload_pool_cs);
+
+    if (region)
+    {
+        InterlockedExchangeAdd(&cs->upload_size, -(LONG)region->size);
+        heap_free(region);
+    }
+}
+
+/* Resources written by a command list. The region is NULL for packets that
+ * write the resource on the GPU. */
+static BOOL wined3d_deferred_context_add_upload(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource, struct wined3d_upload_region *region)
+{
+    if (!wined3d_array_reserve((void **)&context->uploads, &context->uploads_size,
+            context->upload_count + 1, sizeof(*context->uploads)))
+    {
+        ERR("Failed to record upload for resource %p.\n", resource);
+        context->hr = E_OUTOFMEMORY;
+        return FALSE;
+    }
+
+    context->uploads[context->upload_count].resource = resource;
+    context->uploads[context->upload_count].region = region;
+    ++context->upload_count;
+    return TRUE;
+}
+
+/* The client copy is only complete if every write since the last DISCARD map
+ * went through it. Writes recorded by deferred contexts drop it when the
+ * command list is executed. */
+static void wined3d_cs_drop_upload_region(struct wined3d_cs *cs, struct wined3d_resource *resource)
+{
+    struct wined3d_buffer *buffer;
+
+    if (resource->type != WINED3D_RTYPE_BUFFER)
+        return;
+
+    if (cs->ops == &wined3d_cs_deferred_ops)
+    {
+        wined3d_deferred_context_add_upload(wined3d_deferred_context_from_cs(cs), resource, NULL);
+        return;
+    }
+
+    buffer = buffer_from_resource(resource);
+    if (!buffer->upload_region || buffer->upload_map_count)
+        return;
+
+    wined3d_cs_release_upload_region(cs, buffer->upload_region);
+    buffer->upload_region = NULL;
+}
+
 static void wined3d_cs_exec_map(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_map *op = data;
@@ -2123,6 +3093,9 @@ HRESULT wined3d_cs_map(struct wined3d_cs *cs, struct wined3d_resource *resource,
      * increasing the map count would be visible to applications. */
     wined3d_not_from_cs(cs);
 
+    if (flags & WINED3D_MAP_WRITE)
+        wined3d_cs_drop_upload_region(cs, resource);
+
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_MAP);
     op->opcode = WINED3D_CS_OP_MAP;
     op->resource = resource;
@@ -2165,6 +3138,135 @@ HRESULT wined3d_cs_unmap(struct wined3d_cs *cs, struct wined3d_resource *resourc
     return hr;
 }
 
+/* DISCARD and NOOVERWRITE maps of dynamic buffers don't need to synchronise
+ * with the command stream. The application writes to system memory owned by
+ * the buffer, and the upload is queued on unmap. DISCARD renames that memory,
+ * so uploads that are still queued keep reading the previous region. */
+BOOL wined3d_cs_map_upload_region(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc,
+        const struct wined3d_box *box, unsigned int flags)
+{
+    struct wined3d_upload_region *region;
+    struct wined3d_buffer *buffer;
+    unsigned int start, end;
+
+    if (!cs->thread || resource->type != WINED3D_RTYPE_BUFFER || sub_resource_idx)
+        return FALSE;
+    if (!(flags & (WINED3D_MAP_DISCARD | WINED3D_MAP_NOOVERWRITE)) || (flags & WINED3D_MAP_READ))
+        return FALSE;
+    if (resource->bind_flags & (WINED3D_BIND_STREAM_OUTPUT | WINED3D_BIND_UNORDERED_ACCESS))
+        return FALSE;
+
+    buffer = buffer_from_resource(resource);
+    if (resource->map_count)
+        return FALSE;
+
+    if (box)
+    {
+        start = box->left;
+        end = box->right;
+    }
+    else
+    {
+        start = 0;
+        end = resource->size;
+    }
+
+    if (flags & WINED3D_MAP_DISCARD)
+    {
+        /* DISCARD invalidates the entire buffer, see wined3d_buffer_gl_map(). */
+        start = 0;
+        end = resource->size;
+
+        if (buffer->upload_map_count)
+        {
+            WARN("DISCARD map of buffer %p while it is mapped.\n", buffer);
+        }
+        else
+        {
+            if (!(region = wined3d_cs_get_upload_region(cs, resource->size)))
+                return FALSE;
+            if (buffer->upload_region)
+                wined3d_cs_release_upload_region(cs, buffer->upload_region);
+            buffer->upload_region = region;
+        }
+        buffer->upload_discard = TRUE;
+    }
+    else if (!buffer->upload_region)
+    {
+        return FALSE;
+    }
+
+    TRACE("Mapping buffer %p from upload region %p.\n", buffer, buffer->upload_region);
+
+    if (buffer->upload_map_count++)
+    {
+        buffer->upload_start = min(buffer->upload_start, start);
+        buffer->upload_end = max(buffer->upload_end, end);
+    }
+    else
+    {
+        buffer->upload_start = start;
+        buffer->upload_end = end;
+    }
+
+    map_desc->row_pitch = map_desc->slice_pitch = resource->size;
+    map_desc->data = buffer->upload_region->data + (box ? box->left : 0);
+
+    return TRUE;
+}
+
+static void wined3d_cs_exec_upload_region(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_upload_region *op = data;
+    struct wined3d_context *context;
+
+    context = context_acquire(cs->device, NULL, 0);
+    wined3d_buffer_upload_region(op->buffer, context, op->region, op->offset, op->size, op->discard);
+    context_release(context);
+
+    wined3d_cs_release_upload_region(cs, op->region);
+    wined3d_resource_release(&op->buffer->resource);
+}
+
+BOOL wined3d_cs_unmap_upload_region(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx)
+{
+    struct wined3d_cs_upload_region *op;
+    struct wined3d_buffer *buffer;
+
+    if (resource->type != WINED3D_RTYPE_BUFFER || sub_resource_idx)
+        return FALSE;
+
+    buffer = buffer_from_resource(resource);
+    if (!buffer->upload_map_count)
+        return FALSE;
+
+    if (--buffer->upload_map_count)
+        return TRUE;
+
+    /* Only DISCARD uploads can affect a held back draw. NOOVERWRITE maps
+     * promise not to touch data that's in use. */
+    if (buffer->upload_discard)
+        op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    else
+        op = cs->ops->require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_UPLOAD_REGION;
+    op->buffer = buffer;
+    op->region = buffer->upload_region;
+    op->offset = buffer->upload_start;
+    op->size = buffer->upload_end - buffer->upload_start;
+    op->discard = buffer->upload_discard;
+
+    InterlockedIncrement(&op->region->refcount);
+    wined3d_cs_acquire_resource(cs, resource);
+    buffer->upload_discard = FALSE;
+
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+
+    return TRUE;
+}
+
 static void wined3d_cs_exec_blt_sub_resource(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_blt_sub_resource *op = data;
@@ -2272,6 +3374,8 @@ void wined3d_cs_emit_blt_sub_resource(struct wined3d_cs *cs, struct wined3d_reso
 {
     struct wined3d_cs_blt_sub_resource *op;
 
+    wined3d_cs_drop_upload_region(cs, dst_resource);
+
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_BLT_SUB_RESOURCE;
     op->dst_resource = dst_resource;
@@ -2287,22 +3391,20 @@ void wined3d_cs_emit_blt_sub_resource(struct wined3d_cs *cs, struct wined3d_reso
         memset(&op->fx, 0, sizeof(op->fx));
     op->filter = filter;
 
-    wined3d_resource_acquire(dst_resource);
+    wined3d_cs_acquire_resource(cs, dst_resource);
     if (src_resource)
-        wined3d_resource_acquire(src_resource);
+        wined3d_cs_acquire_resource(cs, src_resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
     if (flags & WINED3D_BLT_SYNCHRONOUS)
         wined3d_cs_finish(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-static void wined3d_cs_exec_update_sub_resource(struct wined3d_cs *cs, const void *data)
+static void wined3d_cs_update_sub_resource(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, const struct wined3d_box *box, const struct wined3d_const_bo_address *addr,
+        unsigned int row_pitch, unsigned int slice_pitch)
 {
-    const struct wined3d_cs_update_sub_resource *op = data;
-    struct wined3d_resource *resource = op->resource;
-    const struct wined3d_box *box = &op->box;
     unsigned int width, height, depth, level;
-    struct wined3d_const_bo_address addr;
     struct wined3d_context *context;
     struct wined3d_texture *texture;
     struct wined3d_box src_box;
@@ -2312,47 +3414,335 @@ static void wined3d_cs_exec_update_sub_resource(struct wined3d_cs *cs, const voi
     if (resource->type == WINED3D_RTYPE_BUFFER)
     {
         struct wined3d_buffer *buffer = buffer_from_resource(resource);
+        struct wined3d_bo_address dst, src;
+        DWORD location;
 
-        if (!wined3d_buffer_load_location(buffer, context, WINED3D_LOCATION_BUFFER))
+        if (!addr->buffer_object)
         {
-            ERR("Failed to load buffer location.\n");
+            if (!wined3d_buffer_load_location(buffer, context, WINED3D_LOCATION_BUFFER))
+            {
+                ERR("Failed to load buffer location.\n");
+                goto done;
+            }
+
+            wined3d_buffer_upload_data(buffer, context, box, addr->addr);
+            wined3d_buffer_invalidate_location(buffer, ~WINED3D_LOCATION_BUFFER);
             goto done;
         }
 
-        wined3d_buffer_upload_data(buffer, context, box, op->data.data);
-        wined3d_buffer_invalidate_location(buffer, ~WINED3D_LOCATION_BUFFER);
+        location = WINED3D_LOCATION_BUFFER;
+        if (!wined3d_buffer_load_location(buffer, context, location))
+        {
+            location = WINED3D_LOCATION_SYSMEM;
+            if (!wined3d_buffer_load_location(buffer, context, location))
+            {
+                ERR("Failed to load buffer location.\n");
+                goto done;
+            }
+        }
+
+        wined3d_buffer_get_memory(buffer, &dst, location);
+        dst.addr += box->left;
+        src.buffer_object = addr->buffer_object;
+        src.addr = (BYTE *)addr->addr;
+        context_copy_bo_address(context, &dst, wined3d_buffer_gl(buffer)->buffer_type_hint,
+                &src, GL_PIXEL_UNPACK_BUFFER, box->right - box->left);
+        wined3d_buffer_invalidate_location(buffer, ~location);
         goto done;
     }
 
     texture = wined3d_texture_from_resource(resource);
 
-    level = op->sub_resource_idx % texture->level_count;
+    level = sub_resource_idx % texture->level_count;
     width = wined3d_texture_get_level_width(texture, level);
     height = wined3d_texture_get_level_height(texture, level);
     depth = wined3d_texture_get_level_depth(texture, level);
 
-    addr.buffer_object = 0;
-    addr.addr = op->data.data;
-
     /* Only load the sub-resource for partial updates. */
     if (!box->left && !box->top && !box->front
             && box->right == width && box->bottom == height && box->back == depth)
         wined3d_texture_prepare_texture(texture, context, FALSE);
     else
-        wined3d_texture_load_location(texture, op->sub_resource_idx, context, WINED3D_LOCATION_TEXTURE_RGB);
+        wined3d_texture_load_location(texture, sub_resource_idx, context, WINED3D_LOCATION_TEXTURE_RGB);
     wined3d_texture_gl_bind_and_dirtify(wined3d_texture_gl(texture), wined3d_context_gl(context), FALSE);
 
     wined3d_box_set(&src_box, 0, 0, box->right - box->left, box->bottom - box->top, 0, box->back - box->front);
-    wined3d_texture_upload_data(texture, op->sub_resource_idx, context, texture->resource.format, &src_box,
-            &addr, op->data.row_pitch, op->data.slice_pitch, box->left, box->top, box->front, FALSE);
+    wined3d_texture_upload_data(texture, sub_resource_idx, context, texture->resource.format, &src_box,
+            addr, row_pitch, slice_pitch, box->left, box->top, box->front, FALSE);
 
-    wined3d_texture_validate_location(texture, op->sub_resource_idx, WINED3D_LOCATION_TEXTURE_RGB);
-    wined3d_texture_invalidate_location(texture, op->sub_resource_idx, ~WINED3D_LOCATION_TEXTURE_RGB);
+    wined3d_texture_validate_location(texture, sub_resource_idx, WINED3D_LOCATION_TEXTURE_RGB);
+    wined3d_texture_invalidate_location(texture, sub_resource_idx, ~WINED3D_LOCATION_TEXTURE_RGB);
 
 done:
     context_release(context);
+}
+
+static void wined3d_cs_exec_update_sub_resource(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_update_sub_resource *op = data;
+    struct wined3d_const_bo_address addr;
+
+    addr.buffer_object = 0;
+    /* Command lists store the data after the packet. */
+    addr.addr = op->data.data ? op->data.data : (const void *)(op + 1);
+    wined3d_cs_update_sub_resource(cs, op->resource, op->sub_resource_idx, &op->box,
+            &addr, op->data.row_pitch, op->data.slice_pitch);
+
+    /* The application thread may be here because the upload ring is full. */
+    wined3d_cs_fence_upload_ring(cs);
+
+    wined3d_resource_release(op->resource);
+}
+
+static void wined3d_cs_exec_upload_sub_resource(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_upload_sub_resource *op = data;
+    struct wined3d_upload_ring *ring = &cs->upload_ring;
+    struct wined3d_const_bo_address addr;
+
+    addr.buffer_object = ring->buffer_object;
+    addr.addr = (const BYTE *)NULL + op->offset;
+    wined3d_cs_update_sub_resource(cs, op->resource, op->sub_resource_idx, &op->box,
+            &addr, op->row_pitch, op->slice_pitch);
+
+    ring->submitted = op->end;
+    if (ring->submitted - ring->fenced >= WINED3D_UPLOAD_RING_SIZE / 8)
+        wined3d_cs_fence_upload_ring(cs);
+
+    wined3d_resource_release(op->resource);
+}
+
+static void wined3d_cs_pack_sub_resource_data(BYTE *dst, unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        const BYTE *src, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int row_count, unsigned int depth)
+{
+    unsigned int row, z;
+
+    if (src_row_pitch == dst_row_pitch && (depth == 1 || src_slice_pitch == dst_slice_pitch))
+    {
+        memcpy(dst, src, dst_slice_pitch * depth);
+        return;
+    }
+
+    for (z = 0; z < depth; ++z)
+    {
+        for (row = 0; row < row_count; ++row)
+        {
+            memcpy(dst + z * dst_slice_pitch + row * dst_row_pitch,
+                    src + z * src_slice_pitch + row * src_row_pitch, dst_row_pitch);
+        }
+    }
+}
+
+/* Copy the data into the upload ring and queue the upload, instead of
+ * waiting for the command stream to read it from the application's memory. */
+static BOOL wined3d_cs_emit_upload_sub_resource(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data, unsigned int row_pitch,
+        unsigned int slice_pitch)
+{
+    unsigned int upload_row_pitch, upload_slice_pitch, row_count, depth, offset, size;
+    const struct wined3d_format *format = resource->format;
+    struct wined3d_cs_upload_sub_resource *op;
+    ULONG end;
+
+    if (!cs->upload_ring.map_ptr)
+        return FALSE;
+
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        upload_row_pitch = upload_slice_pitch = box->right - box->left;
+        row_count = depth = 1;
+        row_pitch = slice_pitch = upload_row_pitch;
+    }
+    else
+    {
+        /* These are converted on the CPU while uploading, which doesn't work
+         * from a mapped buffer object. */
+        if (format->upload || (resource->format_flags & WINED3DFMT_FLAG_DECOMPRESS)
+                || (format->flags[WINED3D_GL_RES_TYPE_TEX_2D] & WINED3DFMT_FLAG_HEIGHT_SCALE))
+            return FALSE;
+
+        wined3d_format_calculate_pitch(format, 1, box->right - box->left, box->bottom - box->top,
+                &upload_row_pitch, &upload_slice_pitch);
+        row_count = upload_slice_pitch / upload_row_pitch;
+        depth = box->back - box->front;
+    }
+    size = upload_slice_pitch * depth;
+
+    if (!wined3d_cs_alloc_upload_ring(cs, size, &offset, &end))
+        return FALSE;
+
+    wined3d_cs_pack_sub_resource_data(cs->upload_ring.map_ptr + offset, upload_row_pitch, upload_slice_pitch,
+            data, row_pitch, slice_pitch, row_count, depth);
+
+    op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_UPLOAD_SUB_RESOURCE;
+    op->resource = resource;
+    op->sub_resource_idx = sub_resource_idx;
+    op->box = *box;
+    op->row_pitch = upload_row_pitch;
+    op->slice_pitch = upload_slice_pitch;
+    op->offset = offset;
+    op->end = end;
+
+    wined3d_cs_acquire_resource(cs, resource);
+
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+
+    return TRUE;
+}
+
+/* Grows the command list so that a packet of "size" bytes fits.
+ * wined3d_cs_deferred_require_space() can only recover from allocation
+ * failures for packets up to the chunk size. */
+static BOOL wined3d_cs_deferred_reserve_space(struct wined3d_cs *cs, size_t size)
+{
+    struct wined3d_deferred_context *context = wined3d_deferred_context_from_cs(cs);
+    size_t packet_size, new_size;
+    void *new_data;
+
+    packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]) + sizeof(struct wined3d_cs_packet);
+    if (cs->data_size - cs->end >= packet_size)
+        return TRUE;
+
+    new_size = max(cs->data_size * 2, cs->end + packet_size);
+    if (!(new_data = heap_realloc(cs->data, new_size)))
+    {
+        ERR("Failed to grow command list buffer.\n");
+        context->hr = E_OUTOFMEMORY;
+        return FALSE;
+    }
+    cs->data_size = new_size;
+    cs->data = new_data;
+
+    return TRUE;
+}
+
+static void wined3d_cs_emit_deferred_update_chunk(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data, unsigned int row_pitch,
+        unsigned int slice_pitch)
+{
+    unsigned int packed_row_pitch, packed_slice_pitch, row_count, depth;
+    struct wined3d_cs_update_sub_resource *op;
+
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        packed_row_pitch = packed_slice_pitch = box->right - box->left;
+        row_count = depth = 1;
+    }
+    else
+    {
+        wined3d_format_calculate_pitch(resource->format, 1, box->right - box->left, box->bottom - box->top,
+                &packed_row_pitch, &packed_slice_pitch);
+        row_count = packed_slice_pitch / packed_row_pitch;
+        depth = box->back - box->front;
+    }
+
+    op = wined3d_cs_require_space(cs, sizeof(*op) + packed_slice_pitch * depth, WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_UPDATE_SUB_RESOURCE;
+    op->resource = resource;
+    op->sub_resource_idx = sub_resource_idx;
+    op->box = *box;
+    op->data.row_pitch = packed_row_pitch;
+    op->data.slice_pitch = packed_slice_pitch;
+    op->data.data = NULL;
+    wined3d_cs_pack_sub_resource_data((BYTE *)(op + 1), packed_row_pitch, packed_slice_pitch,
+            data, row_pitch, slice_pitch, row_count, depth);
+
+    wined3d_cs_acquire_resource(cs, resource);
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+}
+
+/* Command lists may be executed after the application has freed the data, so
+ * it's copied into the packets. Updates larger than a chunk are split into
+ * slices, rows of blocks, and runs of blocks within a row, in that order. */
+static void wined3d_cs_emit_deferred_update_sub_resource(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data, unsigned int row_pitch,
+        unsigned int slice_pitch)
+{
+    unsigned int packed_row_pitch, packed_slice_pitch, chunk_width, chunk_height;
+    unsigned int block_width, block_height, block_size, x, y, z;
+    const struct wined3d_format *format = resource->format;
+    struct wined3d_box chunk_box;
+
+    if (!wined3d_deferred_context_add_upload(wined3d_deferred_context_from_cs(cs), resource, NULL))
+        return;
+
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        chunk_box = *box;
+        for (x = box->left; x < box->right; x = chunk_box.right)
+        {
+            chunk_box.left = x;
+            chunk_box.right = min(box->right, x + WINED3D_CS_DEFERRED_CHUNK_SIZE);
+            wined3d_cs_emit_deferred_update_chunk(cs, resource, sub_resource_idx, &chunk_box,
+                    (const BYTE *)data + x - box->left, row_pitch, slice_pitch);
+        }
+        return;
+    }
+
+    wined3d_format_calculate_pitch(format, 1, box->right - box->left, box->bottom - box->top,
+            &packed_row_pitch, &packed_slice_pitch);
+    if (packed_slice_pitch * (box->back - box->front) <= WINED3D_CS_DEFERRED_CHUNK_SIZE)
+    {
+        wined3d_cs_emit_deferred_update_chunk(cs, resource, sub_resource_idx, box, data, row_pitch, slice_pitch);
+        return;
+    }
+
+    /* The planes of planar formats aren't laid out in rows of blocks, so
+     * these are only split into slices. */
+    if (format->flags[WINED3D_GL_RES_TYPE_TEX_2D] & WINED3DFMT_FLAG_HEIGHT_SCALE)
+    {
+        for (z = box->front; z < box->back; ++z)
+        {
+            if (!wined3d_cs_deferred_reserve_space(cs,
+                    sizeof(struct wined3d_cs_update_sub_resource) + packed_slice_pitch))
+                return;
+            wined3d_box_set(&chunk_box, box->left, box->top, box->right, box->bottom, z, z + 1);
+            wined3d_cs_emit_deferred_update_chunk(cs, resource, sub_resource_idx, &chunk_box,
+                    (const BYTE *)data + (z - box->front) * slice_pitch, row_pitch, slice_pitch);
+        }
+        return;
+    }
+
+    if (format->flags[WINED3D_GL_RES_TYPE_TEX_2D] & WINED3DFMT_FLAG_BLOCKS)
+    {
+        block_width = format->block_width;
+        block_height = format->block_height;
+        block_size = format->block_byte_count;
+    }
+    else
+    {
+        block_width = block_height = 1;
+        block_size = format->byte_count;
+    }
+
+    if (packed_row_pitch <= WINED3D_CS_DEFERRED_CHUNK_SIZE)
+    {
+        chunk_width = box->right - box->left;
+        chunk_height = (WINED3D_CS_DEFERRED_CHUNK_SIZE / packed_row_pitch) * block_height;
+    }
+    else
+    {
+        chunk_width = (WINED3D_CS_DEFERRED_CHUNK_SIZE / block_size) * block_width;
+        chunk_height = block_height;
+    }
 
-    wined3d_resource_release(resource);
+    for (z = box->front; z < box->back; ++z)
+    {
+        for (y = box->top; y < box->bottom; y = chunk_box.bottom)
+        {
+            for (x = box->left; x < box->right; x = chunk_box.right)
+            {
+                wined3d_box_set(&chunk_box, x, y, min(box->right, x + chunk_width),
+                        min(box->bottom, y + chunk_height), z, z + 1);
+                wined3d_cs_emit_deferred_update_chunk(cs, resource, sub_resource_idx, &chunk_box,
+                        (const BYTE *)data + (z - box->front) * slice_pitch
+                        + ((y - box->top) / block_height) * row_pitch
+                        + ((x - box->left) / block_width) * block_size, row_pitch, slice_pitch);
+            }
+        }
+    }
 }
 
 void wined3d_cs_emit_update_sub_resource(struct wined3d_cs *cs, struct wined3d_resource *resource,
@@ -2361,6 +3751,20 @@ void wined3d_cs_emit_update_sub_resource(struct wined3d_cs *cs, struct wined3d_r
 {
     struct wined3d_cs_update_sub_resource *op;
 
+    if (cs->ops == &wined3d_cs_deferred_ops)
+    {
+        wined3d_cs_emit_deferred_update_sub_resource(cs, resource, sub_resource_idx,
+                box, data, row_pitch, slice_pitch);
+        return;
+    }
+
+    wined3d_cs_drop_upload_region(cs, resource);
+
+    if (wined3d_cs_emit_upload_sub_resource(cs, resource, sub_resource_idx, box, data, row_pitch, slice_pitch))
+        return;
+
+    wined3d_resource_wait_idle(resource);
+
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_MAP);
     op->opcode = WINED3D_CS_OP_UPDATE_SUB_RESOURCE;
     op->resource = resource;
@@ -2370,7 +3774,7 @@ void wined3d_cs_emit_update_sub_resource(struct wined3d_cs *cs, struct wined3d_r
     op->data.slice_pitch = slice_pitch;
     op->data.data = data;
 
-    wined3d_resource_acquire(resource);
+    wined3d_cs_acquire_resource(cs, resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_MAP);
     /* The data pointer may go away, so we need to wait until it is read.
@@ -2409,7 +3813,7 @@ void wined3d_cs_emit_add_dirty_texture_region(struct wined3d_cs *cs,
     op->texture = texture;
     op->layer = layer;
 
-    wined3d_resource_acquire(&texture->resource);
+    wined3d_cs_acquire_resource(cs, &texture->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2437,7 +3841,7 @@ void wined3d_cs_emit_clear_unordered_access_view_uint(struct wined3d_cs *cs,
     op->view = view;
     op->clear_value = *clear_value;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_cs_acquire_resource(cs, view->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2460,13 +3864,15 @@ void wined3d_cs_emit_copy_uav_counter(struct wined3d_cs *cs, struct wined3d_buff
 {
     struct wined3d_cs_copy_uav_counter *op;
 
+    wined3d_cs_drop_upload_region(cs, &dst_buffer->resource);
+
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_COPY_UAV_COUNTER;
     op->buffer = dst_buffer;
     op->offset = offset;
     op->view = uav;
 
-    wined3d_resource_acquire(&dst_buffer->resource);
+    wined3d_cs_acquire_resource(cs, &dst_buffer->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2488,7 +3894,7 @@ void wined3d_cs_emit_generate_mipmaps(struct wined3d_cs *cs, struct wined3d_shad
     op->opcode = WINED3D_CS_OP_GENERATE_MIPMAPS;
     op->view = view;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_cs_acquire_resource(cs, view->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2549,10 +3955,14 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_UNMAP                       */ wined3d_cs_exec_unmap,
     /* WINED3D_CS_OP_BLT_SUB_RESOURCE            */ wined3d_cs_exec_blt_sub_resource,
     /* WINED3D_CS_OP_UPDATE_SUB_RESOURCE         */ wined3d_cs_exec_update_sub_resource,
+    /* WINED3D_CS_OP_UPLOAD_SUB_RESOURCE         */ wined3d_cs_exec_upload_sub_resource,
     /* WINED3D_CS_OP_ADD_DIRTY_TEXTURE_REGION    */ wined3d_cs_exec_add_dirty_texture_region,
     /* WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW */ wined3d_cs_exec_clear_unordered_access_view,
     /* WINED3D_CS_OP_COPY_UAV_COUNTER            */ wined3d_cs_exec_copy_uav_counter,
     /* WINED3D_CS_OP_GENERATE_MIPMAPS            */ wined3d_cs_exec_generate_mipmaps,
+    /* WINED3D_CS_OP_UPLOAD_REGION               */ wined3d_cs_exec_upload_region,
+    /* WINED3D_CS_OP_BEGIN_COMMAND_LIST          */ wined3d_cs_exec_begin_command_list,
+    /* WINED3D_CS_OP_END_COMMAND_LIST            */ wined3d_cs_exec_end_command_list,
 };
 
 static void *wined3d_cs_st_require_space(struct wined3d_cs *cs, size_t size, enum wined3d_cs_queue_id queue_id)
@@ -2590,6 +4000,9 @@ static void wined3d_cs_st_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id
     start = cs->start;
     cs->start = cs->end;
 
+    if (cs->op_stats && !cs->thread)
+        wined3d_cs_count_op(cs, &data[start], cs->end - start);
+
     opcode = *(const enum wined3d_cs_op *)&data[start];
     if (opcode >= WINED3D_CS_OP_STOP)
         ERR("Invalid opcode %#x.\n", opcode);
@@ -2606,12 +4019,18 @@ static void wined3d_cs_st_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id
 {
 }
 
+static void wined3d_cs_st_acquire_resource(struct wined3d_cs *cs, struct wined3d_resource *resource)
+{
+    wined3d_resource_acquire(resource);
+}
+
 static const struct wined3d_cs_ops wined3d_cs_st_ops =
 {
     wined3d_cs_st_require_space,
     wined3d_cs_st_submit,
     wined3d_cs_st_finish,
     wined3d_cs_st_push_constants,
+    wined3d_cs_st_acquire_resource,
 };
 
 static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct wined3d_cs_queue *queue)
@@ -2622,12 +4041,19 @@ static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct
 
 static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined3d_cs *cs)
 {
+    enum wined3d_cs_op opcode = WINED3D_CS_OP_NOP;
     struct wined3d_cs_packet *packet;
     size_t packet_size;
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
+    if (cs->op_stats)
+        wined3d_cs_count_op(cs, packet->data, packet_size);
+    if (cs->profiler)
+        opcode = *(const enum wined3d_cs_op *)packet->data;
     InterlockedExchange(&queue->head, (queue->head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1));
+    if (cs->profiler)
+        wined3d_cs_profile_submit(cs->profiler, queue, opcode);
 
     if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         SetEvent(cs->event);
@@ -2646,6 +4072,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
+    struct wined3d_cs_wait wait;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     size = (size + header_size - 1) & ~(header_size - 1);
@@ -2674,6 +4101,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         assert(!queue->head);
     }
 
+    wined3d_cs_wait_init(cs, &wait);
     for (;;)
     {
         LONG tail = *(volatile LONG *)&queue->tail;
@@ -2695,7 +4123,11 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
 
         TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
                 head, tail, (unsigned long)packet_size);
+        wined3d_cs_wait(cs, &wait);
     }
+    wined3d_cs_wait_done(cs, &wait);
+    if (wait.spin_count && cs->op_stats)
+        ++cs->op_stats->queue_full_count;
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
     packet->size = size;
@@ -2712,11 +4144,15 @@ static void *wined3d_cs_mt_require_space(struct wined3d_cs *cs, size_t size, enu
 
 static void wined3d_cs_mt_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
+    struct wined3d_cs_wait wait;
+
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(cs, queue_id);
 
+    wined3d_cs_wait_init(cs, &wait);
     while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
-        wined3d_pause();
+        wined3d_cs_wait(cs, &wait);
+    wined3d_cs_wait_done(cs, &wait);
 }
 
 static const struct wined3d_cs_ops wined3d_cs_mt_ops =
@@ -2725,6 +4161,75 @@ static const struct wined3d_cs_ops wined3d_cs_mt_ops =
     wined3d_cs_mt_submit,
     wined3d_cs_mt_finish,
     wined3d_cs_mt_push_constants,
+    wined3d_cs_st_acquire_resource,
+};
+
+/* Deferred packets are at most a chunk of data and a header, and the recording
+ * buffer always has room for one, so this can't fail. If the buffer can't
+ * grow, the command list is marked as failed and its buffer is reused. */
+static void *wined3d_cs_deferred_require_space(struct wined3d_cs *cs, size_t size, enum wined3d_cs_queue_id queue_id)
+{
+    struct wined3d_deferred_context *context = wined3d_deferred_context_from_cs(cs);
+    size_t header_size, packet_size, new_size;
+    struct wined3d_cs_packet *packet;
+    void *new_data;
+
+    header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
+    size = (size + header_size - 1) & ~(header_size - 1);
+    packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
+
+    if (cs->data_size - cs->end < packet_size)
+    {
+        new_size = max(cs->data_size * 2, cs->end + packet_size);
+        if (!(new_data = heap_realloc(cs->data, new_size)))
+        {
+            ERR("Failed to grow command list buffer.\n");
+            context->hr = E_OUTOFMEMORY;
+            cs->end = 0;
+        }
+        else
+        {
+            cs->data_size = new_size;
+            cs->data = new_data;
+        }
+    }
+
+    packet = (struct wined3d_cs_packet *)((BYTE *)cs->data + cs->end);
+    packet->size = size;
+    cs->end += packet_size;
+    return packet->data;
+}
+
+static void wined3d_cs_deferred_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
+{
+}
+
+static void wined3d_cs_deferred_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
+{
+}
+
+static void wined3d_cs_deferred_acquire_resource(struct wined3d_cs *cs, struct wined3d_resource *resource)
+{
+    struct wined3d_deferred_context *context = wined3d_deferred_context_from_cs(cs);
+
+    if (!wined3d_array_reserve((void **)&context->resources, &context->resources_size,
+            context->resource_count + 1, sizeof(*context->resources)))
+    {
+        ERR("Failed to record resource %p.\n", resource);
+        context->hr = E_OUTOFMEMORY;
+        return;
+    }
+
+    context->resources[context->resource_count++] = resource;
+}
+
+static const struct wined3d_cs_ops wined3d_cs_deferred_ops =
+{
+    wined3d_cs_deferred_require_space,
+    wined3d_cs_deferred_submit,
+    wined3d_cs_deferred_finish,
+    wined3d_cs_mt_push_constants,
+    wined3d_cs_deferred_acquire_resource,
 };
 
 static void poll_queries(struct wined3d_cs *cs)
@@ -2742,7 +4247,7 @@ static void poll_queries(struct wined3d_cs *cs)
     }
 }
 
-static void wined3d_cs_wait_event(struct wined3d_cs *cs)
+static void wined3d_cs_wait_event(struct wined3d_cs *cs, DWORD timeout)
 {
     InterlockedExchange(&cs->waiting_for_event, TRUE);
 
@@ -2758,11 +4263,13 @@ static void wined3d_cs_wait_event(struct wined3d_cs *cs)
             && InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         return;
 
-    WaitForSingleObject(cs->event, INFINITE);
+    if (WaitForSingleObject(cs->event, timeout) == WAIT_TIMEOUT)
+        InterlockedExchange(&cs->waiting_for_event, FALSE);
 }
 
 static DWORD WINAPI wined3d_cs_run(void *ctx)
 {
+    LARGE_INTEGER idle_start, sleep_start, now, start;
     struct wined3d_cs_packet *packet;
     struct wined3d_cs_queue *queue;
     unsigned int spin_count = 0;
@@ -2794,12 +4301,36 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
             if (wined3d_cs_queue_is_empty(cs, queue))
             {
-                if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
-                    wined3d_cs_wait_event(cs);
+                if (!spin_count++)
+                {
+                    QueryPerformanceCounter(&idle_start);
+                    ++cs->worker_stats.wait_count;
+                }
+
+                if (spin_count < wined3d_settings.cs_spin_count)
+                {
+                    wined3d_pause();
+                    continue;
+                }
+
+                /* Keep polling queries while we sleep. */
+                QueryPerformanceCounter(&sleep_start);
+                wined3d_cs_wait_event(cs, list_empty(&cs->query_poll_list) ? INFINITE : WINED3D_CS_WAIT_TIMEOUT);
+                QueryPerformanceCounter(&now);
+                cs->worker_stats.spin_time += sleep_start.QuadPart - idle_start.QuadPart;
+                cs->worker_stats.sleep_time += now.QuadPart - sleep_start.QuadPart;
+                ++cs->worker_stats.sleep_count;
+                poll = WINED3D_CS_QUERY_POLL_INTERVAL - 1;
+                spin_count = 0;
                 continue;
             }
         }
-        spin_count = 0;
+        if (spin_count)
+        {
+            QueryPerformanceCounter(&now);
+            cs->worker_stats.spin_time += now.QuadPart - idle_start.QuadPart;
+            spin_count = 0;
+        }
 
         tail = queue->tail;
         packet = (struct wined3d_cs_packet *)&queue->data[tail];
@@ -2815,13 +4346,21 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
                 break;
             }
 
+            if (cs->profiler)
+                QueryPerformanceCounter(&start);
             wined3d_cs_op_handlers[opcode](cs, packet->data);
+            if (cs->profiler)
+                wined3d_cs_profile_packet(cs->profiler, opcode, start.QuadPart);
             TRACE("%s executed.\n", debug_cs_op(opcode));
         }
 
         tail += FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
         tail &= (WINED3D_CS_QUEUE_SIZE - 1);
         InterlockedExchange(&queue->tail, tail);
+
+        InterlockedIncrement(&cs->progress);
+        if (*(volatile LONG *)&cs->client_waiting && InterlockedCompareExchange(&cs->client_waiting, FALSE, TRUE))
+            SetEvent(cs->client_event);
     }
 
     cs->queue[WINED3D_CS_QUEUE_MAP].tail = cs->queue[WINED3D_CS_QUEUE_MAP].head;
@@ -2841,29 +4380,61 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     cs->ops = &wined3d_cs_st_ops;
     cs->device = device;
 
+    InitializeCriticalSection(&cs->upload_pool_cs);
+    cs->upload_pool_cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": wined3d_cs.upload_pool_cs");
+    list_init(&cs->upload_pool);
+
     state_init(&cs->state, &cs->fb, d3d_info, WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
 
     cs->data_size = WINED3D_INITIAL_CS_SIZE;
     if (!(cs->data = heap_alloc(cs->data_size)))
         goto fail;
 
+    if (wined3d_settings.cs_stats_interval && !(cs->op_stats = heap_alloc_zero(sizeof(*cs->op_stats))))
+        ERR("Failed to allocate command stream statistics.\n");
+
     if (wined3d_settings.cs_multithreaded
             && !RtlIsCriticalSectionLockedByThread(NtCurrentTeb()->Peb->LoaderLock))
     {
         cs->ops = &wined3d_cs_mt_ops;
 
+        if (!(cs->queue = heap_alloc_zero(WINED3D_CS_QUEUE_COUNT * sizeof(*cs->queue))))
+        {
+            ERR("Failed to allocate command stream queues.\n");
+            heap_free(cs->data);
+            goto fail;
+        }
+
         if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
             ERR("Failed to create command stream event.\n");
+            heap_free(cs->queue);
+            heap_free(cs->data);
+            goto fail;
+        }
+
+        if (!(cs->client_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        {
+            ERR("Failed to create command stream client event.\n");
+            CloseHandle(cs->event);
+            heap_free(cs->queue);
             heap_free(cs->data);
             goto fail;
         }
 
+        if (wined3d_settings.cs_profile_file
+                && !(cs->profiler = wined3d_cs_profiler_create(wined3d_settings.cs_profile_file)))
+            ERR("Failed to create command stream profiler.\n");
+
         if (!(GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
                 (const WCHAR *)wined3d_cs_run, &cs->wined3d_module)))
         {
             ERR("Failed to get wined3d module handle.\n");
+            if (cs->profiler)
+                wined3d_cs_profiler_destroy(cs->profiler);
+            CloseHandle(cs->client_event);
             CloseHandle(cs->event);
+            heap_free(cs->queue);
             heap_free(cs->data);
             goto fail;
         }
@@ -2872,7 +4443,11 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
         {
             ERR("Failed to create wined3d command stream thread.\n");
             FreeLibrary(cs->wined3d_module);
+            if (cs->profiler)
+                wined3d_cs_profiler_destroy(cs->profiler);
+            CloseHandle(cs->client_event);
             CloseHandle(cs->event);
+            heap_free(cs->queue);
             heap_free(cs->data);
             goto fail;
         }
@@ -2881,22 +4456,469 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     return cs;
 
 fail:
+    cs->upload_pool_cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&cs->upload_pool_cs);
     state_cleanup(&cs->state);
+    heap_free(cs->op_stats);
     heap_free(cs);
     return NULL;
 }
 
 void wined3d_cs_destroy(struct wined3d_cs *cs)
 {
+    struct wined3d_upload_region *region, *next;
+
     if (cs->thread)
     {
         wined3d_cs_emit_stop(cs);
         CloseHandle(cs->thread);
         if (!CloseHandle(cs->event))
             ERR("Closing event failed.\n");
+        wined3d_cs_report_wait_stats(cs, TRUE);
+        CloseHandle(cs->client_event);
+        if (cs->profiler)
+            wined3d_cs_profiler_destroy(cs->profiler);
+    }
+
+    LIST_FOR_EACH_ENTRY_SAFE(region, next, &cs->upload_pool, struct wined3d_upload_region, entry)
+    {
+        heap_free(region);
     }
+    cs->upload_pool_cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&cs->upload_pool_cs);
 
     state_cleanup(&cs->state);
+    heap_free(cs->op_stats);
+    heap_free(cs->queue);
     heap_free(cs->data);
     heap_free(cs);
 }
+
+HRESULT CDECL wined3d_deferred_context_create(struct wined3d_device *device,
+        struct wined3d_deferred_context **context)
+{
+    struct wined3d_deferred_context *object;
+
+    TRACE("device %p, context %p.\n", device, context);
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->cs.data_size = WINED3D_CS_DEFERRED_MIN_SIZE;
+    if (!(object->cs.data = heap_alloc(object->cs.data_size)))
+    {
+        heap_free(object);
+        return E_OUTOFMEMORY;
+    }
+
+    object->cs.ops = &wined3d_cs_deferred_ops;
+    object->cs.device = device;
+    object->hr = WINED3D_OK;
+    state_init(&object->cs.state, &object->cs.fb, &device->adapter->d3d_info,
+            WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
+
+    TRACE("Created deferred context %p.\n", object);
+    *context = object;
+
+    return WINED3D_OK;
+}
+
+void CDECL wined3d_deferred_context_destroy(struct wined3d_deferred_context *context)
+{
+    struct wined3d_cs *device_cs = context->cs.device->cs;
+    SIZE_T i;
+
+    TRACE("context %p.\n", context);
+
+    for (i = 0; i < context->map_count; ++i)
+        wined3d_cs_release_upload_region(device_cs, context->maps[i].region);
+    for (i = 0; i < context->upload_count; ++i)
+    {
+        if (context->uploads[i].region)
+            wined3d_cs_release_upload_region(device_cs, context->uploads[i].region);
+    }
+
+    state_cleanup(&context->cs.state);
+    heap_free(context->maps);
+    heap_free(context->uploads);
+    heap_free(context->resources);
+    heap_free(context->cs.data);
+    heap_free(context);
+}
+
+/* Only DISCARD and NOOVERWRITE maps of buffers are possible on a deferred
+ * context. The application writes to an upload region, which is attached to
+ * the command list on unmap and uploaded when the list is executed. */
+HRESULT CDECL wined3d_deferred_context_map(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx,
+        struct wined3d_map_desc *map_desc, const struct wined3d_box *box, unsigned int flags)
+{
+    struct wined3d_cs *device_cs = context->cs.device->cs;
+    struct wined3d_upload_region *region = NULL;
+    struct wined3d_deferred_map *map;
+    SIZE_T i;
+
+    TRACE("context %p, resource %p, sub_resource_idx %u, map_desc %p, box %s, flags %#x.\n",
+            context, resource, sub_resource_idx, map_desc, debug_box(box), flags);
+
+    if (resource->type != WINED3D_RTYPE_BUFFER || sub_resource_idx)
+    {
+        FIXME("Not implemented for %s resources.\n", debug_d3dresourcetype(resource->type));
+        return E_NOTIMPL;
+    }
+
+    for (i = 0; i < context->map_count; ++i)
+    {
+        if (context->maps[i].resource == resource)
+        {
+            WARN("Resource %p is already mapped.\n", resource);
+            return WINED3DERR_INVALIDCALL;
+        }
+    }
+
+    if (flags & WINED3D_MAP_DISCARD)
+    {
+        if (!(region = wined3d_cs_get_upload_region(device_cs, resource->size)))
+            return E_OUTOFMEMORY;
+    }
+    else if (flags & WINED3D_MAP_NOOVERWRITE)
+    {
+        /* The previous contents are only known if the buffer was discarded
+         * earlier in the same command list, and not updated since. */
+        for (i = context->upload_count; i; --i)
+        {
+            if (context->uploads[i - 1].resource == resource)
+            {
+                if ((region = context->uploads[i - 1].region))
+                    InterlockedIncrement(&region->refcount);
+                break;
+            }
+        }
+        if (!region)
+        {
+            FIXME("NOOVERWRITE map of buffer %p without a previous DISCARD map.\n", resource);
+            return E_NOTIMPL;
+        }
+    }
+    else
+    {
+        WARN("Invalid map flags %#x.\n", flags);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (!wined3d_array_reserve((void **)&context->maps, &context->maps_size,
+            context->map_count + 1, sizeof(*context->maps)))
+    {
+        wined3d_cs_release_upload_region(device_cs, region);
+        return E_OUTOFMEMORY;
+    }
+
+    map = &context->maps[context->map_count++];
+    map->resource = resource;
+    map->region = region;
+    map->discard = !!(flags & WINED3D_MAP_DISCARD);
+
+    map_desc->row_pitch = map_desc->slice_pitch = resource->size;
+    map_desc->data = region->data + (box ? box->left : 0);
+
+    return WINED3D_OK;
+}
+
+HRESULT CDECL wined3d_deferred_context_unmap(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx)
+{
+    struct wined3d_cs *device_cs = context->cs.device->cs;
+    struct wined3d_cs_upload_region *op;
+    struct wined3d_deferred_map map;
+    SIZE_T i;
+
+    TRACE("context %p, resource %p, sub_resource_idx %u.\n", context, resource, sub_resource_idx);
+
+    for (i = 0; i < context->map_count; ++i)
+    {
+        if (context->maps[i].resource == resource)
+            break;
+    }
+    if (i == context->map_count || sub_resource_idx)
+    {
+        WARN("Resource %p is not mapped.\n", resource);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    map = context->maps[i];
+    memmove(&context->maps[i], &context->maps[i + 1], (context->map_count - i - 1) * sizeof(*context->maps));
+    --context->map_count;
+
+    if (!wined3d_deferred_context_add_upload(context, resource, map.region))
+    {
+        wined3d_cs_release_upload_region(device_cs, map.region);
+        return E_OUTOFMEMORY;
+    }
+
+    op = wined3d_cs_require_space(&context->cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_UPLOAD_REGION;
+    op->buffer = buffer_from_resource(resource);
+    op->region = map.region;
+    op->offset = 0;
+    op->size = resource->size;
+    op->discard = map.discard;
+
+    wined3d_cs_acquire_resource(&context->cs, resource);
+
+    wined3d_cs_submit(&context->cs, WINED3D_CS_QUEUE_DEFAULT);
+
+    return WINED3D_OK;
+}
+
+/* Bind the recorded state again, so that the next command list starts from
+ * it instead of from the default state. */
+static void wined3d_deferred_context_restore_state(struct wined3d_deferred_context *context,
+        const struct wined3d_state *state, const struct wined3d_fb_state *fb)
+{
+    const struct wined3d_d3d_info *d3d_info = &context->cs.device->adapter->d3d_info;
+    unsigned int i, j;
+
+    for (i = 0; i < WINED3D_SHADER_TYPE_COUNT; ++i)
+    {
+        wined3d_deferred_context_set_shader(context, i, state->shader[i]);
+        for (j = 0; j < MAX_CONSTANT_BUFFERS; ++j)
+            wined3d_deferred_context_set_constant_buffer(context, i, j, state->cb[i][j]);
+        for (j = 0; j < MAX_SAMPLER_OBJECTS; ++j)
+            wined3d_deferred_context_set_sampler(context, i, j, state->sampler[i][j]);
+        for (j = 0; j < MAX_SHADER_RESOURCE_VIEWS; ++j)
+            wined3d_deferred_context_set_shader_resource_view(context, i, j, state->shader_resource_view[i][j]);
+    }
+    for (i = 0; i < MAX_UNORDERED_ACCESS_VIEWS; ++i)
+    {
+        wined3d_deferred_context_set_unordered_access_view(context, i,
+                state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS][i], ~0u);
+        wined3d_deferred_context_set_cs_uav(context, i,
+                state->unordered_access_view[WINED3D_PIPELINE_COMPUTE][i], ~0u);
+    }
+
+    wined3d_deferred_context_set_vertex_declaration(context, state->vertex_declaration);
+    for (i = 0; i < ARRAY_SIZE(state->streams); ++i)
+        wined3d_deferred_context_set_stream_source(context, i, state->streams[i].buffer,
+                state->streams[i].offset, state->streams[i].stride);
+    wined3d_deferred_context_set_index_buffer(context, state->index_buffer,
+            state->index_format, state->index_offset);
+    context->cs.state.gl_primitive_type = state->gl_primitive_type;
+    context->cs.state.gl_patch_vertices = state->gl_patch_vertices;
+
+    for (i = 0; i < d3d_info->limits.max_rt_count; ++i)
+        wined3d_deferred_context_set_rendertarget_view(context, i, fb->render_targets[i]);
+    wined3d_deferred_context_set_depth_stencil_view(context, fb->depth_stencil);
+
+    wined3d_deferred_context_set_blend_state(context, state->blend_state, &state->blend_factor);
+    wined3d_deferred_context_set_rasterizer_state(context, state->rasterizer_state);
+    for (i = 0; i < ARRAY_SIZE(state->render_states); ++i)
+        wined3d_deferred_context_set_render_state(context, i, state->render_states[i]);
+    wined3d_deferred_context_set_viewports(context, state->viewport_count, state->viewports);
+    wined3d_deferred_context_set_scissor_rects(context, state->scissor_rect_count, state->scissor_rects);
+
+    for (i = 0; i < ARRAY_SIZE(state->stream_output); ++i)
+        wined3d_deferred_context_set_stream_output(context, i,
+                state->stream_output[i].buffer, state->stream_output[i].offset);
+    wined3d_deferred_context_set_predication(context, state->predicate, state->predicate_value);
+}
+
+/* Drop the packets recorded since the last command list. */
+static void wined3d_deferred_context_discard(struct wined3d_deferred_context *context)
+{
+    struct wined3d_cs *device_cs = context->cs.device->cs;
+    SIZE_T i;
+
+    for (i = 0; i < context->upload_count; ++i)
+    {
+        if (context->uploads[i].region)
+            wined3d_cs_release_upload_region(device_cs, context->uploads[i].region);
+    }
+    context->upload_count = 0;
+    context->resource_count = 0;
+    context->cs.start = context->cs.end = 0;
+    context->hr = WINED3D_OK;
+}
+
+HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_deferred_context *context,
+        BOOL restore, struct wined3d_command_list **list)
+{
+    struct wined3d_cs_saved_state *saved = NULL;
+    struct wined3d_cs *cs = &context->cs;
+    struct wined3d_command_list *object;
+    void *buffer, *data, *new_data;
+    HRESULT hr;
+
+    TRACE("context %p, restore %#x, list %p.\n", context, restore, list);
+
+    if (FAILED(hr = context->hr))
+    {
+        WARN("Recording failed, hr %#x.\n", hr);
+        wined3d_deferred_context_discard(context);
+        return hr;
+    }
+
+    if (context->map_count)
+        WARN("Recording a command list with %lu mapped resources.\n", (unsigned long)context->map_count);
+
+    if (restore && !(saved = heap_alloc(sizeof(*saved))))
+        return E_OUTOFMEMORY;
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+    {
+        heap_free(saved);
+        return E_OUTOFMEMORY;
+    }
+
+    /* The context needs a new recording buffer before the old one can be
+     * handed over. */
+    if (!(buffer = heap_alloc(WINED3D_CS_DEFERRED_MIN_SIZE)))
+    {
+        heap_free(object);
+        heap_free(saved);
+        return E_OUTOFMEMORY;
+    }
+
+    data = cs->data;
+    if (!cs->end)
+    {
+        heap_free(data);
+        data = NULL;
+    }
+    else if (cs->end < cs->data_size && (new_data = heap_realloc(data, cs->end)))
+    {
+        data = new_data;
+    }
+
+    object->refcount = 1;
+    object->device = cs->device;
+    object->data_size = cs->end;
+    object->data = data;
+    object->resource_count = context->resource_count;
+    object->resources = context->resources;
+    object->upload_count = context->upload_count;
+    object->uploads = context->uploads;
+
+    cs->data = buffer;
+    cs->data_size = WINED3D_CS_DEFERRED_MIN_SIZE;
+    cs->start = cs->end = 0;
+    context->resources = NULL;
+    context->resources_size = context->resource_count = 0;
+    context->uploads = NULL;
+    context->uploads_size = context->upload_count = 0;
+
+    /* Deferred contexts never enable lights, so the light lists in the copy
+     * are empty and never touched. */
+    if (saved)
+    {
+        saved->state = cs->state;
+        saved->fb = cs->fb;
+    }
+    else
+    {
+        state_cleanup(&cs->state);
+    }
+    memset(&cs->state, 0, sizeof(cs->state));
+    memset(&cs->fb, 0, sizeof(cs->fb));
+    state_init(&cs->state, &cs->fb, &cs->device->adapter->d3d_info,
+            WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
+
+    if (saved)
+    {
+        wined3d_deferred_context_restore_state(context, &saved->state, &saved->fb);
+        heap_free(saved);
+    }
+
+    TRACE("Created command list %p.\n", object);
+    *list = object;
+
+    return WINED3D_OK;
+}
+
+ULONG CDECL wined3d_command_list_incref(struct wined3d_command_list *list)
+{
+    ULONG refcount = InterlockedIncrement(&list->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", list, refcount);
+
+    return refcount;
+}
+
+ULONG CDECL wined3d_command_list_decref(struct wined3d_command_list *list)
+{
+    ULONG refcount = InterlockedDecrement(&list->refcount);
+    SIZE_T i;
+
+    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+
+    if (!refcount)
+    {
+        for (i = 0; i < list->upload_count; ++i)
+        {
+            if (list->uploads[i].region)
+                wined3d_cs_release_upload_region(list->device->cs, list->uploads[i].region);
+        }
+        heap_free(list->uploads);
+        heap_free(list->resources);
+        heap_free(list->data);
+        heap_free(list);
+    }
+
+    return refcount;
+}
+
+/* The recorded packets are copied into the device command stream as they
+ * are, between packets that switch the CS state to the default state and
+ * back. */
+void CDECL wined3d_device_execute_command_list(struct wined3d_device *device, struct wined3d_command_list *list)
+{
+    struct wined3d_cs_begin_command_list *begin_op;
+    struct wined3d_cs_end_command_list *end_op;
+    const struct wined3d_cs_packet *packet;
+    struct wined3d_cs_saved_state *saved;
+    struct wined3d_cs *cs = device->cs;
+    SIZE_T offset, i;
+    void *op;
+
+    TRACE("device %p, list %p.\n", device, list);
+
+    if (!(saved = heap_alloc(sizeof(*saved))))
+    {
+        ERR("Failed to allocate saved state.\n");
+        return;
+    }
+
+    for (i = 0; i < list->resource_count; ++i)
+        wined3d_resource_acquire(list->resources[i]);
+    for (i = 0; i < list->upload_count; ++i)
+    {
+        wined3d_cs_drop_upload_region(cs, list->uploads[i].resource);
+        if (list->uploads[i].region)
+            InterlockedIncrement(&list->uploads[i].region->refcount);
+    }
+
+    begin_op = wined3d_cs_require_space(cs, sizeof(*begin_op), WINED3D_CS_QUEUE_DEFAULT);
+    begin_op->opcode = WINED3D_CS_OP_BEGIN_COMMAND_LIST;
+    begin_op->saved = saved;
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+
+    for (offset = 0; offset < list->data_size; offset += FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]))
+    {
+        packet = (const struct wined3d_cs_packet *)((const BYTE *)list->data + offset);
+        op = wined3d_cs_require_space(cs, packet->size, WINED3D_CS_QUEUE_DEFAULT);
+        memcpy(op, packet->data, packet->size);
+        /* Queries are only issued when the command list is executed. */
+        if (*(const enum wined3d_cs_op *)op == WINED3D_CS_OP_QUERY_ISSUE)
+        {
+            const struct wined3d_cs_query_issue *query_op = op;
+
+            wined3d_query_update_issued(query_op->query, query_op->flags);
+            cs->queries_flushed = FALSE;
+        }
+        wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+    }
+
+    end_op = wined3d_cs_require_space(cs, sizeof(*end_op), WINED3D_CS_QUEUE_DEFAULT);
+    end_op->opcode = WINED3D_CS_OP_END_COMMAND_LIST;
+    end_op->saved = saved;
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+}
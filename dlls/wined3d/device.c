@@ -1032,6 +1032,7 @@ void wined3d_device_delete_opengl_contexts_cs(void *object)
     device->shader_backend->shader_free_private(device, context);
     destroy_dummy_textures(device, context);
     destroy_default_samplers(device, context);
+    wined3d_cs_destroy_upload_ring(device->cs, context);
     context_release(context);
 
     while (device->context_count)
@@ -1075,6 +1076,7 @@ void wined3d_device_create_primary_opengl_context_cs(void *object)
     context = context_acquire(device, target, 0);
     create_dummy_textures(device, context);
     create_default_samplers(device, context);
+    wined3d_cs_create_upload_ring(device->cs, context);
     context_release(context);
 }
 
@@ -1470,6 +1472,7 @@ void CDECL wined3d_device_set_transform(struct wined3d_device *device,
     if (!memcmp(&device->state.transforms[d3dts], matrix, sizeof(*matrix)))
     {
         TRACE("The application is setting the same matrix over again.\n");
+        ++device->cs->redundant_state_count;
         return;
     }
 
@@ -1801,6 +1804,13 @@ void CDECL wined3d_device_set_material(struct wined3d_device *device, const stru
         return;
     }
 
+    if (!memcmp(&device->state.material, material, sizeof(*material)))
+    {
+        TRACE("Application is setting the old material over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+        return;
+    }
+
     device->state.material = *material;
     wined3d_cs_emit_set_material(device->cs, material);
 }
@@ -1909,6 +1919,14 @@ void CDECL wined3d_device_set_viewports(struct wined3d_device *device, unsigned
         return;
     }
 
+    if (device->state.viewport_count == viewport_count
+            && !memcmp(device->state.viewports, viewports, viewport_count * sizeof(*viewports)))
+    {
+        TRACE("Application is setting the old viewports over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+        return;
+    }
+
     if (viewport_count)
         memcpy(device->state.viewports, viewports, viewport_count * sizeof(*viewports));
     else
@@ -2038,7 +2056,10 @@ void CDECL wined3d_device_set_render_state(struct wined3d_device *device,
     }
 
     if (value == device->state.render_states[state])
+    {
         TRACE("Application is setting the old value over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+    }
     else
     {
         device->state.render_states[state] = value;
@@ -2087,6 +2108,7 @@ void CDECL wined3d_device_set_sampler_state(struct wined3d_device *device,
     if (value == device->state.sampler_states[sampler_idx][state])
     {
         TRACE("Application is setting the old value over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
         return;
     }
 
@@ -2137,6 +2159,7 @@ void CDECL wined3d_device_set_scissor_rects(struct wined3d_device *device, unsig
             && !memcmp(device->state.scissor_rects, rects, rect_count * sizeof(*rects)))
     {
         TRACE("App is setting the old scissor rectangles over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
         return;
     }
 
@@ -2396,6 +2419,13 @@ HRESULT CDECL wined3d_device_set_vs_consts_b(struct wined3d_device *device,
         return WINED3D_OK;
     }
 
+    if (!memcmp(&device->state.vs_consts_b[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+        return WINED3D_OK;
+    }
+
     memcpy(&device->state.vs_consts_b[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2446,6 +2476,13 @@ HRESULT CDECL wined3d_device_set_vs_consts_i(struct wined3d_device *device,
         return WINED3D_OK;
     }
 
+    if (!memcmp(&device->state.vs_consts_i[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+        return WINED3D_OK;
+    }
+
     memcpy(&device->state.vs_consts_i[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2494,6 +2531,13 @@ HRESULT CDECL wined3d_device_set_vs_consts_f(struct wined3d_device *device,
         return WINED3D_OK;
     }
 
+    if (!memcmp(&device->state.vs_consts_f[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+        return WINED3D_OK;
+    }
+
     memcpy(&device->state.vs_consts_f[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2610,6 +2654,13 @@ HRESULT CDECL wined3d_device_set_ps_consts_b(struct wined3d_device *device,
         return WINED3D_OK;
     }
 
+    if (!memcmp(&device->state.ps_consts_b[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+        return WINED3D_OK;
+    }
+
     memcpy(&device->state.ps_consts_b[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2660,6 +2711,13 @@ HRESULT CDECL wined3d_device_set_ps_consts_i(struct wined3d_device *device,
         return WINED3D_OK;
     }
 
+    if (!memcmp(&device->state.ps_consts_i[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+        return WINED3D_OK;
+    }
+
     memcpy(&device->state.ps_consts_i[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2709,6 +2767,13 @@ HRESULT CDECL wined3d_device_set_ps_consts_f(struct wined3d_device *device,
         return WINED3D_OK;
     }
 
+    if (!memcmp(&device->state.ps_consts_f[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
+        return WINED3D_OK;
+    }
+
     memcpy(&device->state.ps_consts_f[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -3452,6 +3517,7 @@ void CDECL wined3d_device_set_texture_stage_state(struct wined3d_device *device,
     if (value == device->state.texture_states[stage][state])
     {
         TRACE("Application is setting the old value over, nothing to do.\n");
+        ++device->cs->redundant_state_count;
         return;
     }
 
@@ -3510,6 +3576,7 @@ void CDECL wined3d_device_set_texture(struct wined3d_device *device,
     if (texture == prev)
     {
         TRACE("App is setting the same texture again, nothing to do.\n");
+        ++device->cs->redundant_state_count;
         return;
     }
 
@@ -4055,15 +4122,13 @@ void CDECL wined3d_device_copy_uav_counter(struct wined3d_device *device,
     wined3d_cs_emit_copy_uav_counter(device->cs, dst_buffer, offset, uav);
 }
 
-void CDECL wined3d_device_copy_resource(struct wined3d_device *device,
+static void wined3d_copy_resource(struct wined3d_cs *cs,
         struct wined3d_resource *dst_resource, struct wined3d_resource *src_resource)
 {
     struct wined3d_texture *dst_texture, *src_texture;
     struct wined3d_box box;
     unsigned int i, j;
 
-    TRACE("device %p, dst_resource %p, src_resource %p.\n", device, dst_resource, src_resource);
-
     if (src_resource == dst_resource)
     {
         WARN("Source and destination are the same resource.\n");
@@ -4100,7 +4165,7 @@ void CDECL wined3d_device_copy_resource(struct wined3d_device *device,
     if (dst_resource->type == WINED3D_RTYPE_BUFFER)
     {
         wined3d_box_set(&box, 0, 0, src_resource->size, 1, 0, 1);
-        wined3d_cs_emit_blt_sub_resource(device->cs, dst_resource, 0, &box,
+        wined3d_cs_emit_blt_sub_resource(cs, dst_resource, 0, &box,
                 src_resource, 0, &box, WINED3D_BLT_RAW, NULL, WINED3D_TEXF_POINT);
         return;
     }
@@ -4127,24 +4192,27 @@ void CDECL wined3d_device_copy_resource(struct wined3d_device *device,
         {
             unsigned int idx = j * dst_texture->level_count + i;
 
-            wined3d_cs_emit_blt_sub_resource(device->cs, dst_resource, idx, &box,
+            wined3d_cs_emit_blt_sub_resource(cs, dst_resource, idx, &box,
                     src_resource, idx, &box, WINED3D_BLT_RAW, NULL, WINED3D_TEXF_POINT);
         }
     }
 }
 
-HRESULT CDECL wined3d_device_copy_sub_resource_region(struct wined3d_device *device,
+void CDECL wined3d_device_copy_resource(struct wined3d_device *device,
+        struct wined3d_resource *dst_resource, struct wined3d_resource *src_resource)
+{
+    TRACE("device %p, dst_resource %p, src_resource %p.\n", device, dst_resource, src_resource);
+
+    wined3d_copy_resource(device->cs, dst_resource, src_resource);
+}
+
+static HRESULT wined3d_copy_sub_resource_region(struct wined3d_cs *cs,
         struct wined3d_resource *dst_resource, unsigned int dst_sub_resource_idx, unsigned int dst_x,
         unsigned int dst_y, unsigned int dst_z, struct wined3d_resource *src_resource,
         unsigned int src_sub_resource_idx, const struct wined3d_box *src_box, unsigned int flags)
 {
     struct wined3d_box dst_box, b;
 
-    TRACE("device %p, dst_resource %p, dst_sub_resource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
-            "src_resource %p, src_sub_resource_idx %u, src_box %s, flags %#x.\n",
-            device, dst_resource, dst_sub_resource_idx, dst_x, dst_y, dst_z,
-            src_resource, src_sub_resource_idx, debug_box(src_box), flags);
-
     if (flags)
         FIXME("Ignoring flags %#x.\n", flags);
 
@@ -4273,23 +4341,33 @@ HRESULT CDECL wined3d_device_copy_sub_resource_region(struct wined3d_device *dev
         }
     }
 
-    wined3d_cs_emit_blt_sub_resource(device->cs, dst_resource, dst_sub_resource_idx, &dst_box,
+    wined3d_cs_emit_blt_sub_resource(cs, dst_resource, dst_sub_resource_idx, &dst_box,
             src_resource, src_sub_resource_idx, src_box, WINED3D_BLT_RAW, NULL, WINED3D_TEXF_POINT);
 
     return WINED3D_OK;
 }
 
-void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, struct wined3d_resource *resource,
+HRESULT CDECL wined3d_device_copy_sub_resource_region(struct wined3d_device *device,
+        struct wined3d_resource *dst_resource, unsigned int dst_sub_resource_idx, unsigned int dst_x,
+        unsigned int dst_y, unsigned int dst_z, struct wined3d_resource *src_resource,
+        unsigned int src_sub_resource_idx, const struct wined3d_box *src_box, unsigned int flags)
+{
+    TRACE("device %p, dst_resource %p, dst_sub_resource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_sub_resource_idx %u, src_box %s, flags %#x.\n",
+            device, dst_resource, dst_sub_resource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_sub_resource_idx, debug_box(src_box), flags);
+
+    return wined3d_copy_sub_resource_region(device->cs, dst_resource, dst_sub_resource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_sub_resource_idx, src_box, flags);
+}
+
+static void wined3d_update_sub_resource(struct wined3d_cs *cs, struct wined3d_resource *resource,
         unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data, unsigned int row_pitch,
         unsigned int depth_pitch, unsigned int flags)
 {
     unsigned int width, height, depth;
     struct wined3d_box b;
 
-    TRACE("device %p, resource %p, sub_resource_idx %u, box %s, data %p, row_pitch %u, depth_pitch %u, "
-            "flags %#x.\n",
-            device, resource, sub_resource_idx, debug_box(box), data, row_pitch, depth_pitch, flags);
-
     if (flags)
         FIXME("Ignoring flags %#x.\n", flags);
 
@@ -4341,9 +4419,18 @@ void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, str
         return;
     }
 
-    wined3d_resource_wait_idle(resource);
+    wined3d_cs_emit_update_sub_resource(cs, resource, sub_resource_idx, box, data, row_pitch, depth_pitch);
+}
 
-    wined3d_cs_emit_update_sub_resource(device->cs, resource, sub_resource_idx, box, data, row_pitch, depth_pitch);
+void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data, unsigned int row_pitch,
+        unsigned int depth_pitch, unsigned int flags)
+{
+    TRACE("device %p, resource %p, sub_resource_idx %u, box %s, data %p, row_pitch %u, depth_pitch %u, "
+            "flags %#x.\n",
+            device, resource, sub_resource_idx, debug_box(box), data, row_pitch, depth_pitch, flags);
+
+    wined3d_update_sub_resource(device->cs, resource, sub_resource_idx, box, data, row_pitch, depth_pitch, flags);
 }
 
 void CDECL wined3d_device_resolve_sub_resource(struct wined3d_device *device,
@@ -4392,16 +4479,13 @@ void CDECL wined3d_device_resolve_sub_resource(struct wined3d_device *device,
             src_texture, src_sub_resource_idx, &src_rect, 0, NULL, WINED3D_TEXF_POINT);
 }
 
-HRESULT CDECL wined3d_device_clear_rendertarget_view(struct wined3d_device *device,
+static HRESULT wined3d_clear_rendertarget_view(struct wined3d_cs *cs,
         struct wined3d_rendertarget_view *view, const RECT *rect, DWORD flags,
         const struct wined3d_color *color, float depth, DWORD stencil)
 {
     struct wined3d_resource *resource;
     RECT r;
 
-    TRACE("device %p, view %p, rect %s, flags %#x, color %s, depth %.8e, stencil %u.\n",
-            device, view, wine_dbgstr_rect(rect), flags, debug_color(color), depth, stencil);
-
     if (!flags)
         return WINED3D_OK;
 
@@ -4434,11 +4518,568 @@ HRESULT CDECL wined3d_device_clear_rendertarget_view(struct wined3d_device *devi
             return hr;
     }
 
-    wined3d_cs_emit_clear_rendertarget_view(device->cs, view, rect, flags, color, depth, stencil);
+    wined3d_cs_emit_clear_rendertarget_view(cs, view, rect, flags, color, depth, stencil);
+
+    return WINED3D_OK;
+}
+
+HRESULT CDECL wined3d_device_clear_rendertarget_view(struct wined3d_device *device,
+        struct wined3d_rendertarget_view *view, const RECT *rect, DWORD flags,
+        const struct wined3d_color *color, float depth, DWORD stencil)
+{
+    TRACE("device %p, view %p, rect %s, flags %#x, color %s, depth %.8e, stencil %u.\n",
+            device, view, wine_dbgstr_rect(rect), flags, debug_color(color), depth, stencil);
+
+    return wined3d_clear_rendertarget_view(device->cs, view, rect, flags, color, depth, stencil);
+}
+
+/* Deferred contexts keep their state in their CS without references; the
+ * caller keeps the bound objects alive until the command list is released. */
+void CDECL wined3d_deferred_context_set_shader(struct wined3d_deferred_context *context,
+        enum wined3d_shader_type type, struct wined3d_shader *shader)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, type %#x, shader %p.\n", context, type, shader);
+
+    if (state->shader[type] == shader)
+        return;
+
+    state->shader[type] = shader;
+    wined3d_cs_emit_set_shader(&context->cs, type, shader);
+}
+
+void CDECL wined3d_deferred_context_set_constant_buffer(struct wined3d_deferred_context *context,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_buffer *buffer)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, type %#x, idx %u, buffer %p.\n", context, type, idx, buffer);
+
+    if (idx >= MAX_CONSTANT_BUFFERS)
+    {
+        WARN("Invalid constant buffer index %u.\n", idx);
+        return;
+    }
+
+    if (state->cb[type][idx] == buffer)
+        return;
+
+    state->cb[type][idx] = buffer;
+    wined3d_cs_emit_set_constant_buffer(&context->cs, type, idx, buffer);
+}
+
+void CDECL wined3d_deferred_context_set_shader_resource_view(struct wined3d_deferred_context *context,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_shader_resource_view *view)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, type %#x, idx %u, view %p.\n", context, type, idx, view);
+
+    if (idx >= MAX_SHADER_RESOURCE_VIEWS)
+    {
+        WARN("Invalid view index %u.\n", idx);
+        return;
+    }
+
+    if (state->shader_resource_view[type][idx] == view)
+        return;
+
+    state->shader_resource_view[type][idx] = view;
+    wined3d_cs_emit_set_shader_resource_view(&context->cs, type, idx, view);
+}
+
+void CDECL wined3d_deferred_context_set_sampler(struct wined3d_deferred_context *context,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_sampler *sampler)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, type %#x, idx %u, sampler %p.\n", context, type, idx, sampler);
+
+    if (idx >= MAX_SAMPLER_OBJECTS)
+    {
+        WARN("Invalid sampler index %u.\n", idx);
+        return;
+    }
+
+    if (state->sampler[type][idx] == sampler)
+        return;
+
+    state->sampler[type][idx] = sampler;
+    wined3d_cs_emit_set_sampler(&context->cs, type, idx, sampler);
+}
+
+static void wined3d_deferred_context_set_pipeline_unordered_access_view(struct wined3d_deferred_context *context,
+        enum wined3d_pipeline pipeline, unsigned int idx, struct wined3d_unordered_access_view *uav,
+        unsigned int initial_count)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    if (idx >= MAX_UNORDERED_ACCESS_VIEWS)
+    {
+        WARN("Invalid UAV index %u.\n", idx);
+        return;
+    }
+
+    if (state->unordered_access_view[pipeline][idx] == uav && initial_count == ~0u)
+        return;
+
+    state->unordered_access_view[pipeline][idx] = uav;
+    wined3d_cs_emit_set_unordered_access_view(&context->cs, pipeline, idx, uav, initial_count);
+}
+
+void CDECL wined3d_deferred_context_set_cs_uav(struct wined3d_deferred_context *context, unsigned int idx,
+        struct wined3d_unordered_access_view *uav, unsigned int initial_count)
+{
+    TRACE("context %p, idx %u, uav %p, initial_count %#x.\n", context, idx, uav, initial_count);
+
+    wined3d_deferred_context_set_pipeline_unordered_access_view(context,
+            WINED3D_PIPELINE_COMPUTE, idx, uav, initial_count);
+}
+
+void CDECL wined3d_deferred_context_set_unordered_access_view(struct wined3d_deferred_context *context,
+        unsigned int idx, struct wined3d_unordered_access_view *uav, unsigned int initial_count)
+{
+    TRACE("context %p, idx %u, uav %p, initial_count %#x.\n", context, idx, uav, initial_count);
+
+    wined3d_deferred_context_set_pipeline_unordered_access_view(context,
+            WINED3D_PIPELINE_GRAPHICS, idx, uav, initial_count);
+}
+
+void CDECL wined3d_deferred_context_set_vertex_declaration(struct wined3d_deferred_context *context,
+        struct wined3d_vertex_declaration *declaration)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, declaration %p.\n", context, declaration);
+
+    if (state->vertex_declaration == declaration)
+        return;
+
+    state->vertex_declaration = declaration;
+    wined3d_cs_emit_set_vertex_declaration(&context->cs, declaration);
+}
+
+HRESULT CDECL wined3d_deferred_context_set_stream_source(struct wined3d_deferred_context *context,
+        unsigned int stream_idx, struct wined3d_buffer *buffer, unsigned int offset, unsigned int stride)
+{
+    struct wined3d_stream_state *stream;
+
+    TRACE("context %p, stream_idx %u, buffer %p, offset %u, stride %u.\n",
+            context, stream_idx, buffer, offset, stride);
+
+    if (stream_idx >= WINED3D_MAX_STREAMS)
+    {
+        WARN("Stream index %u out of range.\n", stream_idx);
+        return WINED3DERR_INVALIDCALL;
+    }
+    else if (offset & 0x3)
+    {
+        WARN("Offset %u is not 4 byte aligned.\n", offset);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    stream = &context->cs.state.streams[stream_idx];
+    if (stream->buffer == buffer && stream->stride == stride && stream->offset == offset)
+        return WINED3D_OK;
+
+    stream->buffer = buffer;
+    stream->stride = stride;
+    stream->offset = offset;
+    wined3d_cs_emit_set_stream_source(&context->cs, stream_idx, buffer, offset, stride);
 
     return WINED3D_OK;
 }
 
+void CDECL wined3d_deferred_context_set_index_buffer(struct wined3d_deferred_context *context,
+        struct wined3d_buffer *buffer, enum wined3d_format_id format_id, unsigned int offset)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, buffer %p, format %s, offset %u.\n",
+            context, buffer, debug_d3dformat(format_id), offset);
+
+    if (state->index_buffer == buffer && state->index_format == format_id && state->index_offset == offset)
+        return;
+
+    state->index_buffer = buffer;
+    state->index_format = format_id;
+    state->index_offset = offset;
+    wined3d_cs_emit_set_index_buffer(&context->cs, buffer, format_id, offset);
+}
+
+void CDECL wined3d_deferred_context_set_primitive_type(struct wined3d_deferred_context *context,
+        enum wined3d_primitive_type primitive_type, unsigned int patch_vertex_count)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, primitive_type %s, patch_vertex_count %u.\n",
+            context, debug_d3dprimitivetype(primitive_type), patch_vertex_count);
+
+    state->gl_primitive_type = gl_primitive_type_from_d3d(primitive_type);
+    state->gl_patch_vertices = patch_vertex_count;
+}
+
+HRESULT CDECL wined3d_deferred_context_set_rendertarget_view(struct wined3d_deferred_context *context,
+        unsigned int view_idx, struct wined3d_rendertarget_view *view)
+{
+    struct wined3d_fb_state *fb = &context->cs.fb;
+    unsigned int max_rt_count;
+
+    TRACE("context %p, view_idx %u, view %p.\n", context, view_idx, view);
+
+    max_rt_count = context->cs.device->adapter->d3d_info.limits.max_rt_count;
+    if (view_idx >= max_rt_count)
+    {
+        WARN("Only %u render targets are supported.\n", max_rt_count);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (view && !(view->resource->bind_flags & WINED3D_BIND_RENDER_TARGET))
+    {
+        WARN("View resource %p doesn't have render target bind flags.\n", view->resource);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (fb->render_targets[view_idx] == view)
+        return WINED3D_OK;
+
+    fb->render_targets[view_idx] = view;
+    wined3d_cs_emit_set_rendertarget_view(&context->cs, view_idx, view);
+
+    return WINED3D_OK;
+}
+
+HRESULT CDECL wined3d_deferred_context_set_depth_stencil_view(struct wined3d_deferred_context *context,
+        struct wined3d_rendertarget_view *view)
+{
+    struct wined3d_fb_state *fb = &context->cs.fb;
+
+    TRACE("context %p, view %p.\n", context, view);
+
+    if (view && !(view->resource->bind_flags & WINED3D_BIND_DEPTH_STENCIL))
+    {
+        WARN("View resource %p has incompatible %s bind flags.\n",
+                view->resource, wined3d_debug_bind_flags(view->resource->bind_flags));
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (fb->depth_stencil == view)
+        return WINED3D_OK;
+
+    fb->depth_stencil = view;
+    wined3d_cs_emit_set_depth_stencil_view(&context->cs, view);
+
+    return WINED3D_OK;
+}
+
+void CDECL wined3d_deferred_context_set_blend_state(struct wined3d_deferred_context *context,
+        struct wined3d_blend_state *blend_state, const struct wined3d_color *blend_factor)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, blend_state %p, blend_factor %s.\n", context, blend_state, debug_color(blend_factor));
+
+    if (state->blend_state == blend_state && !memcmp(blend_factor, &state->blend_factor, sizeof(*blend_factor)))
+        return;
+
+    state->blend_state = blend_state;
+    state->blend_factor = *blend_factor;
+    wined3d_cs_emit_set_blend_state(&context->cs, blend_state, blend_factor);
+}
+
+void CDECL wined3d_deferred_context_set_rasterizer_state(struct wined3d_deferred_context *context,
+        struct wined3d_rasterizer_state *rasterizer_state)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, rasterizer_state %p.\n", context, rasterizer_state);
+
+    if (state->rasterizer_state == rasterizer_state)
+        return;
+
+    state->rasterizer_state = rasterizer_state;
+    wined3d_cs_emit_set_rasterizer_state(&context->cs, rasterizer_state);
+}
+
+void CDECL wined3d_deferred_context_set_render_state(struct wined3d_deferred_context *context,
+        enum wined3d_render_state state, DWORD value)
+{
+    struct wined3d_state *cs_state = &context->cs.state;
+
+    TRACE("context %p, state %s (%#x), value %#x.\n", context, debug_d3drenderstate(state), state, value);
+
+    if (state > WINEHIGHEST_RENDER_STATE)
+    {
+        WARN("Unhandled render state %#x.\n", state);
+        return;
+    }
+
+    if (cs_state->render_states[state] == value)
+        return;
+
+    cs_state->render_states[state] = value;
+    wined3d_cs_emit_set_render_state(&context->cs, state, value);
+}
+
+void CDECL wined3d_deferred_context_set_viewports(struct wined3d_deferred_context *context,
+        unsigned int viewport_count, const struct wined3d_viewport *viewports)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, viewport_count %u, viewports %p.\n", context, viewport_count, viewports);
+
+    if (state->viewport_count == viewport_count
+            && !memcmp(state->viewports, viewports, viewport_count * sizeof(*viewports)))
+        return;
+
+    if (viewport_count)
+        memcpy(state->viewports, viewports, viewport_count * sizeof(*viewports));
+    else
+        memset(state->viewports, 0, sizeof(state->viewports));
+    state->viewport_count = viewport_count;
+    wined3d_cs_emit_set_viewports(&context->cs, viewport_count, viewports);
+}
+
+void CDECL wined3d_deferred_context_set_scissor_rects(struct wined3d_deferred_context *context,
+        unsigned int rect_count, const RECT *rects)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, rect_count %u, rects %p.\n", context, rect_count, rects);
+
+    if (state->scissor_rect_count == rect_count
+            && !memcmp(state->scissor_rects, rects, rect_count * sizeof(*rects)))
+        return;
+
+    if (rect_count)
+        memcpy(state->scissor_rects, rects, rect_count * sizeof(*rects));
+    else
+        memset(state->scissor_rects, 0, sizeof(state->scissor_rects));
+    state->scissor_rect_count = rect_count;
+    wined3d_cs_emit_set_scissor_rects(&context->cs, rect_count, rects);
+}
+
+void CDECL wined3d_deferred_context_draw(struct wined3d_deferred_context *context, int base_vertex_idx,
+        unsigned int start_idx, unsigned int index_count, unsigned int start_instance,
+        unsigned int instance_count, BOOL indexed)
+{
+    const struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, base_vertex_idx %d, start_idx %u, index_count %u, "
+            "start_instance %u, instance_count %u, indexed %#x.\n",
+            context, base_vertex_idx, start_idx, index_count, start_instance, instance_count, indexed);
+
+    if (indexed && !state->index_buffer)
+    {
+        WARN("Called without a valid index buffer set.\n");
+        return;
+    }
+
+    wined3d_cs_emit_draw(&context->cs, state->gl_primitive_type, state->gl_patch_vertices,
+            base_vertex_idx, start_idx, index_count, start_instance, instance_count, indexed);
+}
+
+void CDECL wined3d_deferred_context_dispatch(struct wined3d_deferred_context *context,
+        unsigned int group_count_x, unsigned int group_count_y, unsigned int group_count_z)
+{
+    TRACE("context %p, group_count_x %u, group_count_y %u, group_count_z %u.\n",
+            context, group_count_x, group_count_y, group_count_z);
+
+    wined3d_cs_emit_dispatch(&context->cs, group_count_x, group_count_y, group_count_z);
+}
+
+HRESULT CDECL wined3d_deferred_context_clear_rendertarget_view(struct wined3d_deferred_context *context,
+        struct wined3d_rendertarget_view *view, const RECT *rect, DWORD flags,
+        const struct wined3d_color *color, float depth, DWORD stencil)
+{
+    TRACE("context %p, view %p, rect %s, flags %#x, color %s, depth %.8e, stencil %u.\n",
+            context, view, wine_dbgstr_rect(rect), flags, debug_color(color), depth, stencil);
+
+    return wined3d_clear_rendertarget_view(&context->cs, view, rect, flags, color, depth, stencil);
+}
+
+void CDECL wined3d_deferred_context_update_sub_resource(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx, const struct wined3d_box *box,
+        const void *data, unsigned int row_pitch, unsigned int depth_pitch, unsigned int flags)
+{
+    TRACE("context %p, resource %p, sub_resource_idx %u, box %s, data %p, row_pitch %u, depth_pitch %u, "
+            "flags %#x.\n",
+            context, resource, sub_resource_idx, debug_box(box), data, row_pitch, depth_pitch, flags);
+
+    wined3d_update_sub_resource(&context->cs, resource, sub_resource_idx, box, data, row_pitch, depth_pitch, flags);
+}
+
+void CDECL wined3d_deferred_context_copy_resource(struct wined3d_deferred_context *context,
+        struct wined3d_resource *dst_resource, struct wined3d_resource *src_resource)
+{
+    TRACE("context %p, dst_resource %p, src_resource %p.\n", context, dst_resource, src_resource);
+
+    wined3d_copy_resource(&context->cs, dst_resource, src_resource);
+}
+
+HRESULT CDECL wined3d_deferred_context_copy_sub_resource_region(struct wined3d_deferred_context *context,
+        struct wined3d_resource *dst_resource, unsigned int dst_sub_resource_idx, unsigned int dst_x,
+        unsigned int dst_y, unsigned int dst_z, struct wined3d_resource *src_resource,
+        unsigned int src_sub_resource_idx, const struct wined3d_box *src_box, unsigned int flags)
+{
+    TRACE("context %p, dst_resource %p, dst_sub_resource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_sub_resource_idx %u, src_box %s, flags %#x.\n",
+            context, dst_resource, dst_sub_resource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_sub_resource_idx, debug_box(src_box), flags);
+
+    return wined3d_copy_sub_resource_region(&context->cs, dst_resource, dst_sub_resource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_sub_resource_idx, src_box, flags);
+}
+
+void CDECL wined3d_deferred_context_resolve_sub_resource(struct wined3d_deferred_context *context,
+        struct wined3d_resource *dst_resource, unsigned int dst_sub_resource_idx,
+        struct wined3d_resource *src_resource, unsigned int src_sub_resource_idx,
+        enum wined3d_format_id format_id)
+{
+    struct wined3d_texture *dst_texture, *src_texture;
+    struct wined3d_box dst_box, src_box;
+    unsigned int dst_level, src_level;
+
+    TRACE("context %p, dst_resource %p, dst_sub_resource_idx %u, "
+            "src_resource %p, src_sub_resource_idx %u, format %s.\n",
+            context, dst_resource, dst_sub_resource_idx,
+            src_resource, src_sub_resource_idx, debug_d3dformat(format_id));
+
+    if (dst_resource->type != WINED3D_RTYPE_TEXTURE_2D)
+    {
+        WARN("Invalid destination resource type %s.\n", debug_d3dresourcetype(dst_resource->type));
+        return;
+    }
+    if (src_resource->type != WINED3D_RTYPE_TEXTURE_2D)
+    {
+        WARN("Invalid source resource type %s.\n", debug_d3dresourcetype(src_resource->type));
+        return;
+    }
+
+    dst_texture = texture_from_resource(dst_resource);
+    src_texture = texture_from_resource(src_resource);
+
+    if (dst_sub_resource_idx >= dst_texture->level_count * dst_texture->layer_count
+            || src_sub_resource_idx >= src_texture->level_count * src_texture->layer_count)
+    {
+        WARN("Invalid sub-resources %u / %u.\n", dst_sub_resource_idx, src_sub_resource_idx);
+        return;
+    }
+
+    dst_level = dst_sub_resource_idx % dst_texture->level_count;
+    wined3d_box_set(&dst_box, 0, 0, wined3d_texture_get_level_width(dst_texture, dst_level),
+            wined3d_texture_get_level_height(dst_texture, dst_level), 0, 1);
+    src_level = src_sub_resource_idx % src_texture->level_count;
+    wined3d_box_set(&src_box, 0, 0, wined3d_texture_get_level_width(src_texture, src_level),
+            wined3d_texture_get_level_height(src_texture, src_level), 0, 1);
+    wined3d_cs_emit_blt_sub_resource(&context->cs, dst_resource, dst_sub_resource_idx, &dst_box,
+            src_resource, src_sub_resource_idx, &src_box, 0, NULL, WINED3D_TEXF_POINT);
+}
+
+void CDECL wined3d_deferred_context_copy_uav_counter(struct wined3d_deferred_context *context,
+        struct wined3d_buffer *dst_buffer, unsigned int offset, struct wined3d_unordered_access_view *uav)
+{
+    TRACE("context %p, dst_buffer %p, offset %u, uav %p.\n", context, dst_buffer, offset, uav);
+
+    wined3d_cs_emit_copy_uav_counter(&context->cs, dst_buffer, offset, uav);
+}
+
+void CDECL wined3d_deferred_context_clear_unordered_access_view_uint(struct wined3d_deferred_context *context,
+        struct wined3d_unordered_access_view *view, const struct wined3d_uvec4 *clear_value)
+{
+    TRACE("context %p, view %p, clear_value %s.\n", context, view, debug_uvec4(clear_value));
+
+    wined3d_cs_emit_clear_unordered_access_view_uint(&context->cs, view, clear_value);
+}
+
+void CDECL wined3d_deferred_context_generate_mipmaps(struct wined3d_deferred_context *context,
+        struct wined3d_shader_resource_view *view)
+{
+    TRACE("context %p, view %p.\n", context, view);
+
+    if (view->resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        WARN("Called on buffer resource %p.\n", view->resource);
+        return;
+    }
+
+    if (!(texture_from_resource(view->resource)->flags & WINED3D_TEXTURE_GENERATE_MIPMAPS))
+    {
+        WARN("Texture without the WINED3D_TEXTURE_GENERATE_MIPMAPS flag, ignoring.\n");
+        return;
+    }
+
+    wined3d_cs_emit_generate_mipmaps(&context->cs, view);
+}
+
+/* The query's client state is updated when the command list is executed. */
+void CDECL wined3d_deferred_context_issue_query(struct wined3d_deferred_context *context,
+        struct wined3d_query *query, DWORD flags)
+{
+    TRACE("context %p, query %p, flags %#x.\n", context, query, flags);
+
+    wined3d_cs_emit_query_issue(&context->cs, query, flags);
+}
+
+void CDECL wined3d_deferred_context_set_predication(struct wined3d_deferred_context *context,
+        struct wined3d_query *predicate, BOOL value)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, predicate %p, value %#x.\n", context, predicate, value);
+
+    if (state->predicate == predicate && state->predicate_value == value)
+        return;
+
+    if (predicate)
+        FIXME("Predicated rendering not implemented.\n");
+    state->predicate = predicate;
+    state->predicate_value = value;
+    wined3d_cs_emit_set_predication(&context->cs, predicate, value);
+}
+
+void CDECL wined3d_deferred_context_set_stream_output(struct wined3d_deferred_context *context,
+        unsigned int idx, struct wined3d_buffer *buffer, unsigned int offset)
+{
+    struct wined3d_stream_output *stream;
+
+    TRACE("context %p, idx %u, buffer %p, offset %u.\n", context, idx, buffer, offset);
+
+    if (idx >= WINED3D_MAX_STREAM_OUTPUT_BUFFERS)
+    {
+        WARN("Invalid stream output %u.\n", idx);
+        return;
+    }
+
+    stream = &context->cs.state.stream_output[idx];
+    if (stream->buffer == buffer && stream->offset == offset)
+        return;
+
+    stream->buffer = buffer;
+    stream->offset = offset;
+    wined3d_cs_emit_set_stream_output(&context->cs, idx, buffer, offset);
+}
+
+void CDECL wined3d_deferred_context_draw_indirect(struct wined3d_deferred_context *context,
+        struct wined3d_buffer *buffer, unsigned int offset, BOOL indexed)
+{
+    const struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, buffer %p, offset %u, indexed %#x.\n", context, buffer, offset, indexed);
+
+    wined3d_cs_emit_draw_indirect(&context->cs, state->gl_primitive_type, state->gl_patch_vertices,
+            buffer, offset, indexed);
+}
+
+void CDECL wined3d_deferred_context_dispatch_indirect(struct wined3d_deferred_context *context,
+        struct wined3d_buffer *buffer, unsigned int offset)
+{
+    TRACE("context %p, buffer %p, offset %u.\n", context, buffer, offset);
+
+    wined3d_cs_emit_dispatch_indirect(&context->cs, buffer, offset);
+}
+
 void CDECL wined3d_device_clear_unordered_access_view_uint(struct wined3d_device *device,
         struct wined3d_unordered_access_view *view, const struct wined3d_uvec4 *clear_value)
 {
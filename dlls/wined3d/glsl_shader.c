@@ -42,6 +42,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d_shader);
 WINE_DECLARE_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(winediag);
 
 #define WINED3D_GLSL_SAMPLE_PROJECTED   0x01
@@ -144,6 +145,8 @@ struct shader_glsl_priv
     struct wine_rb_tree ffp_fragment_shaders;
     BOOL ffp_proj_control;
     BOOL legacy_lighting;
+
+    struct glsl_program_cache *program_cache;
 };
 
 struct glsl_vs_program
@@ -258,7 +261,10 @@ struct glsl_shader_prog_link
     unsigned int constant_version;
     DWORD shader_controlled_clip_distances : 1;
     DWORD clip_distance_mask : 8; /* WINED3D_MAX_CLIP_DISTANCES, 8 */
-    DWORD padding : 23;
+    DWORD pending : 1;
+    DWORD store_binary : 1;
+    DWORD padding : 21;
+    UINT64 binary_hash;
 };
 
 struct glsl_program_key
@@ -559,7 +565,10 @@ static void shader_glsl_compile(const struct wined3d_gl_info *gl_info, GLuint sh
     checkGLcall("glShaderSource");
     GL_EXTCALL(glCompileShader(shader));
     checkGLcall("glCompileShader");
-    print_glsl_info_log(gl_info, shader, FALSE);
+    /* Retrieving the info log would wait for the compiler. Errors are still
+     * reported through the program info log. */
+    if (!gl_info->supported[ARB_PARALLEL_SHADER_COMPILE])
+        print_glsl_info_log(gl_info, shader, FALSE);
 }
 
 /* Context activation is done by the caller. */
@@ -632,6 +641,438 @@ void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLuint pro
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+#define WINED3D_GLSL_PROGRAM_CACHE_MAGIC    0x43504757 /* "WGPC" */
+#define WINED3D_GLSL_PROGRAM_CACHE_VERSION  1
+#define WINED3D_GLSL_PROGRAM_CACHE_MAX_SIZE (256u * 1024 * 1024)
+
+struct glsl_program_cache_header
+{
+    DWORD magic;
+    DWORD version;
+    UINT64 driver_hash;
+};
+
+struct glsl_program_cache_record
+{
+    UINT64 hash;
+    DWORD format;
+    DWORD size;
+};
+
+struct glsl_program_binary
+{
+    struct wine_rb_entry entry;
+    UINT64 hash;
+    GLenum format;
+    GLsizei size;
+    BYTE data[1];
+};
+
+/* Program binaries are stored in an append-only file. The file is read by a
+ * background thread at device creation; the first program link waits for it
+ * and validates the file against the GL driver. */
+struct glsl_program_cache
+{
+    struct wine_rb_tree binaries;
+    HANDLE file;
+    BOOL writable;
+    HANDLE load_thread;
+    BOOL ready;
+
+    UINT64 file_driver_hash;
+    BOOL file_valid;
+    DWORD file_size;
+
+    unsigned int loaded, hits, misses, stored, rejected;
+};
+
+static UINT64 glsl_hash_data(UINT64 hash, const void *data, size_t size)
+{
+    const BYTE *ptr = data;
+    size_t i;
+
+    /* 64-bit FNV-1a. */
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static UINT64 glsl_hash_string(UINT64 hash, const char *str)
+{
+    return glsl_hash_data(hash, str ? str : "", str ? strlen(str) + 1 : 1);
+}
+
+static int glsl_program_binary_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    UINT64 hash = *(const UINT64 *)key;
+    const struct glsl_program_binary *binary = WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry);
+
+    return hash < binary->hash ? -1 : hash > binary->hash;
+}
+
+static void glsl_program_binary_destroy(struct wine_rb_entry *entry, void *context)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry));
+}
+
+static struct glsl_program_binary *glsl_program_binary_create(UINT64 hash, GLenum format, GLsizei size)
+{
+    struct glsl_program_binary *binary;
+
+    if (!(binary = heap_alloc(FIELD_OFFSET(struct glsl_program_binary, data[size]))))
+        return NULL;
+    binary->hash = hash;
+    binary->format = format;
+    binary->size = size;
+    return binary;
+}
+
+static BOOL glsl_program_cache_read(HANDLE file, void *data, DWORD size)
+{
+    DWORD read;
+
+    return ReadFile(file, data, size, &read, NULL) && read == size;
+}
+
+static DWORD WINAPI glsl_program_cache_load_thread(void *ctx)
+{
+    struct glsl_program_cache *cache = ctx;
+    struct glsl_program_cache_header header;
+    struct glsl_program_cache_record record;
+    struct glsl_program_binary *binary;
+
+    if (!glsl_program_cache_read(cache->file, &header, sizeof(header))
+            || header.magic != WINED3D_GLSL_PROGRAM_CACHE_MAGIC
+            || header.version != WINED3D_GLSL_PROGRAM_CACHE_VERSION)
+        return 0;
+
+    cache->file_valid = TRUE;
+    cache->file_driver_hash = header.driver_hash;
+    cache->file_size = sizeof(header);
+
+    while (glsl_program_cache_read(cache->file, &record, sizeof(record)))
+    {
+        if (!record.size || record.size > WINED3D_GLSL_PROGRAM_CACHE_MAX_SIZE
+                || !(binary = glsl_program_binary_create(record.hash, record.format, record.size)))
+            break;
+        if (!glsl_program_cache_read(cache->file, binary->data, record.size))
+        {
+            heap_free(binary);
+            break;
+        }
+        if (wine_rb_put(&cache->binaries, &binary->hash, &binary->entry) == -1)
+            heap_free(binary);
+        else
+            ++cache->loaded;
+        cache->file_size += sizeof(record) + record.size;
+    }
+
+    return 0;
+}
+
+static struct glsl_program_cache *glsl_program_cache_create(const char *path)
+{
+    struct glsl_program_cache *cache;
+
+    if (!(cache = heap_alloc_zero(sizeof(*cache))))
+        return NULL;
+
+    wine_rb_init(&cache->binaries, glsl_program_binary_compare);
+
+    /* Only one process at a time gets to append to the file. */
+    cache->writable = TRUE;
+    if ((cache->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+            NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        cache->writable = FALSE;
+        cache->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    }
+    if (cache->file == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to open GLSL program cache %s, error %u.\n", debugstr_a(path), GetLastError());
+        heap_free(cache);
+        return NULL;
+    }
+
+    if (!(cache->load_thread = CreateThread(NULL, 0, glsl_program_cache_load_thread, cache, 0, NULL)))
+    {
+        ERR("Failed to create GLSL program cache loader thread, error %u.\n", GetLastError());
+        glsl_program_cache_load_thread(cache);
+    }
+
+    TRACE("Using GLSL program cache %s.\n", debugstr_a(path));
+
+    return cache;
+}
+
+static void glsl_program_cache_destroy(struct glsl_program_cache *cache)
+{
+    if (cache->load_thread)
+    {
+        WaitForSingleObject(cache->load_thread, INFINITE);
+        CloseHandle(cache->load_thread);
+    }
+
+    TRACE_(d3d_perf)("GLSL program cache: %u loaded, %u hits, %u misses, %u stored, %u rejected.\n",
+            cache->loaded, cache->hits, cache->misses, cache->stored, cache->rejected);
+
+    CloseHandle(cache->file);
+    wine_rb_destroy(&cache->binaries, glsl_program_binary_destroy, NULL);
+    heap_free(cache);
+}
+
+/* Context activation is done by the caller. */
+static void glsl_program_cache_init_driver(struct glsl_program_cache *cache, const struct wined3d_gl_info *gl_info)
+{
+    struct glsl_program_cache_header header;
+    UINT64 driver_hash = 0xcbf29ce484222325ull;
+    DWORD written;
+
+    if (cache->load_thread)
+    {
+        WaitForSingleObject(cache->load_thread, INFINITE);
+        CloseHandle(cache->load_thread);
+        cache->load_thread = NULL;
+    }
+    cache->ready = TRUE;
+
+    driver_hash = glsl_hash_string(driver_hash, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_VENDOR));
+    driver_hash = glsl_hash_string(driver_hash, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_RENDERER));
+    driver_hash = glsl_hash_string(driver_hash, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_VERSION));
+
+    if (cache->file_valid && cache->file_driver_hash == driver_hash)
+    {
+        TRACE("Loaded %u program binaries.\n", cache->loaded);
+        /* Drop any partially written record at the end. */
+        if (cache->writable)
+        {
+            SetFilePointer(cache->file, cache->file_size, NULL, FILE_BEGIN);
+            SetEndOfFile(cache->file);
+        }
+        return;
+    }
+
+    if (cache->file_valid)
+        TRACE("GL driver changed, discarding %u cached program binaries.\n", cache->loaded);
+    wine_rb_destroy(&cache->binaries, glsl_program_binary_destroy, NULL);
+    wine_rb_init(&cache->binaries, glsl_program_binary_compare);
+    cache->loaded = 0;
+
+    if (!cache->writable)
+        return;
+
+    header.magic = WINED3D_GLSL_PROGRAM_CACHE_MAGIC;
+    header.version = WINED3D_GLSL_PROGRAM_CACHE_VERSION;
+    header.driver_hash = driver_hash;
+    SetFilePointer(cache->file, 0, NULL, FILE_BEGIN);
+    SetEndOfFile(cache->file);
+    if (!WriteFile(cache->file, &header, sizeof(header), &written, NULL) || written != sizeof(header))
+    {
+        WARN("Failed to write GLSL program cache header, error %u.\n", GetLastError());
+        cache->writable = FALSE;
+        return;
+    }
+    cache->file_size = sizeof(header);
+}
+
+/* Context activation is done by the caller. */
+static UINT64 shader_glsl_program_source_hash(const struct wined3d_gl_info *gl_info, GLuint program)
+{
+    UINT64 hash = 0xcbf29ce484222325ull, *hashes = NULL;
+    GLint i, j, shader_count, source_size = 0;
+    GLuint *shaders = NULL;
+    char *source = NULL;
+    GLint length, type;
+
+    GL_EXTCALL(glGetProgramiv(program, GL_ATTACHED_SHADERS, &shader_count));
+    if (!shader_count || !(shaders = heap_calloc(shader_count, sizeof(*shaders)))
+            || !(hashes = heap_calloc(shader_count, sizeof(*hashes))))
+        goto done;
+    GL_EXTCALL(glGetAttachedShaders(program, shader_count, NULL, shaders));
+
+    for (i = 0; i < shader_count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length));
+        if (length > source_size)
+        {
+            heap_free(source);
+            if (!(source = heap_alloc(length)))
+            {
+                source_size = 0;
+                goto done;
+            }
+            source_size = length;
+        }
+        GL_EXTCALL(glGetShaderSource(shaders[i], source_size, &length, source));
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type));
+        hashes[i] = glsl_hash_data(0xcbf29ce484222325ull, &type, sizeof(type));
+        hashes[i] = glsl_hash_data(hashes[i], source, length);
+    }
+    checkGLcall("get program source");
+
+    /* The order of attached shaders is implementation defined. */
+    for (i = 1; i < shader_count; ++i)
+    {
+        UINT64 h = hashes[i];
+
+        for (j = i; j > 0 && hashes[j - 1] > h; --j)
+            hashes[j] = hashes[j - 1];
+        hashes[j] = h;
+    }
+    hash = glsl_hash_data(hash, hashes, shader_count * sizeof(*hashes));
+
+done:
+    heap_free(source);
+    heap_free(hashes);
+    heap_free(shaders);
+    return hash;
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_load_program_binary(struct glsl_program_cache *cache,
+        const struct wined3d_gl_info *gl_info, GLuint program, UINT64 hash)
+{
+    struct glsl_program_binary *binary;
+    struct wine_rb_entry *entry;
+    GLint status;
+
+    if (!(entry = wine_rb_get(&cache->binaries, &hash)))
+        return FALSE;
+    binary = WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry);
+
+    GL_EXTCALL(glProgramBinary(program, binary->format, binary->data, binary->size));
+    GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    checkGLcall("glProgramBinary");
+    if (status)
+    {
+        TRACE("Loaded program %u from binary %s.\n", program, wine_dbgstr_longlong(hash));
+        ++cache->hits;
+        return TRUE;
+    }
+
+    /* Drivers are allowed to reject binaries at any time. */
+    TRACE("Program binary %s was rejected.\n", wine_dbgstr_longlong(hash));
+    ++cache->rejected;
+    wine_rb_remove(&cache->binaries, entry);
+    heap_free(binary);
+    return FALSE;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_store_program_binary(struct glsl_program_cache *cache,
+        const struct wined3d_gl_info *gl_info, GLuint program, UINT64 hash)
+{
+    struct glsl_program_cache_record record;
+    struct glsl_program_binary *binary;
+    GLint status, size;
+    DWORD written;
+    GLenum format;
+
+    GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    GL_EXTCALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size));
+    checkGLcall("glGetProgramiv");
+    if (!status || size <= 0 || !(binary = glsl_program_binary_create(hash, 0, size)))
+        return;
+
+    GL_EXTCALL(glGetProgramBinary(program, size, &binary->size, &format, binary->data));
+    checkGLcall("glGetProgramBinary");
+    binary->format = format;
+    if (!binary->size || wine_rb_put(&cache->binaries, &binary->hash, &binary->entry) == -1)
+    {
+        heap_free(binary);
+        return;
+    }
+    ++cache->stored;
+
+    if (!cache->writable || cache->file_size + sizeof(record) + binary->size > WINED3D_GLSL_PROGRAM_CACHE_MAX_SIZE)
+        return;
+
+    record.hash = hash;
+    record.format = binary->format;
+    record.size = binary->size;
+    if (!WriteFile(cache->file, &record, sizeof(record), &written, NULL) || written != sizeof(record)
+            || !WriteFile(cache->file, binary->data, binary->size, &written, NULL) || written != binary->size)
+    {
+        WARN("Failed to write GLSL program binary, error %u.\n", GetLastError());
+        /* Truncate the partial record on the next start. */
+        cache->writable = FALSE;
+        return;
+    }
+    cache->file_size += sizeof(record) + binary->size;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_finish_link(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, struct glsl_shader_prog_link *entry)
+{
+    shader_glsl_validate_link(gl_info, entry->id);
+
+    if (entry->store_binary)
+        shader_glsl_store_program_binary(priv->program_cache, gl_info, entry->id, entry->binary_hash);
+    entry->store_binary = 0;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_link_program(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, struct glsl_shader_prog_link *entry, BOOL cacheable)
+{
+    struct glsl_program_cache *cache = priv->program_cache;
+    GLuint program_id = entry->id;
+
+    entry->store_binary = 0;
+
+    if (cache && cacheable)
+    {
+        if (!cache->ready)
+            glsl_program_cache_init_driver(cache, gl_info);
+
+        entry->binary_hash = shader_glsl_program_source_hash(gl_info, program_id);
+        if (shader_glsl_load_program_binary(cache, gl_info, program_id, entry->binary_hash))
+        {
+            entry->pending = 0;
+            return;
+        }
+        ++cache->misses;
+
+        GL_EXTCALL(glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+        entry->store_binary = 1;
+    }
+
+    TRACE("Linking GLSL shader program %u.\n", program_id);
+    GL_EXTCALL(glLinkProgram(program_id));
+
+    /* Querying anything about a program waits for the link to complete. */
+    if (!entry->pending)
+        shader_glsl_finish_link(gl_info, priv, entry);
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_program_ready(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, struct glsl_shader_prog_link *entry)
+{
+    GLint status;
+
+    if (!entry->pending)
+        return TRUE;
+
+    GL_EXTCALL(glGetProgramiv(entry->id, GL_COMPLETION_STATUS_ARB, &status));
+    checkGLcall("glGetProgramiv");
+    if (!status)
+    {
+        TRACE_(d3d_perf)("Program %u is still being compiled.\n", entry->id);
+        return FALSE;
+    }
+
+    TRACE("Program %u is ready.\n", entry->id);
+    entry->pending = 0;
+    shader_glsl_finish_link(gl_info, priv, entry);
+    return TRUE;
+}
+
 static BOOL shader_glsl_use_layout_qualifier(const struct wined3d_gl_info *gl_info)
 {
     /* Layout qualifiers were introduced in GLSL 1.40. The Nvidia Legacy GPU
@@ -10320,6 +10761,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     entry->cs.id = shader_id;
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
+    entry->pending = 0;
     entry->ps.np2_fixup_info = NULL;
     add_glsl_program_entry(priv, entry);
 
@@ -10329,9 +10771,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
 
     list_add_head(&shader->linked_programs, &entry->cs.shader_entry);
 
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    shader_glsl_link_program(gl_info, priv, entry, TRUE);
 
     GL_EXTCALL(glUseProgram(program_id));
     checkGLcall("glUseProgram");
@@ -10391,52 +10831,214 @@ static void set_glsl_compute_shader_program(const struct wined3d_context *contex
 }
 
 /* Context activation is done by the caller. */
-static void set_glsl_shader_program(const struct wined3d_context *context, const struct wined3d_state *state,
-        struct shader_glsl_priv *priv, struct glsl_context_data *ctx_data)
+/* Context activation is done by the caller. */
+static void shader_glsl_init_program(const struct wined3d_context *context, struct shader_glsl_priv *priv,
+        struct glsl_shader_prog_link *entry, const struct wined3d_shader *vshader,
+        const struct wined3d_shader *hshader, const struct wined3d_shader *dshader,
+        const struct wined3d_shader *gshader, const struct wined3d_shader *pshader)
 {
-    const struct wined3d_d3d_info *d3d_info = context->d3d_info;
     const struct wined3d_gl_info *gl_info = context->gl_info;
     const struct wined3d_shader *pre_rasterization_shader;
-    const struct ps_np2fixup_info *np2fixup_info = NULL;
-    struct wined3d_shader *hshader, *dshader, *gshader;
-    struct glsl_shader_prog_link *entry = NULL;
-    struct wined3d_shader *vshader = NULL;
-    struct wined3d_shader *pshader = NULL;
-    GLuint reorder_shader_id = 0;
-    struct glsl_program_key key;
-    GLuint program_id;
+    GLuint program_id = entry->id;
     unsigned int i;
-    GLuint vs_id = 0;
-    GLuint hs_id = 0;
-    GLuint ds_id = 0;
-    GLuint gs_id = 0;
-    GLuint ps_id = 0;
-    struct list *ps_list, *vs_list;
-    WORD attribs_map;
-    struct wined3d_string_buffer *tmp_name;
 
-    if (!(context->shader_update_mask & (1u << WINED3D_SHADER_TYPE_VERTEX)) && ctx_data->glsl_program)
-    {
-        vs_id = ctx_data->glsl_program->vs.id;
-        vs_list = &ctx_data->glsl_program->vs.shader_entry;
+    shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
+            vshader ? vshader->limits->constant_float : 0);
+    shader_glsl_init_ds_uniform_locations(gl_info, priv, program_id, &entry->ds);
+    shader_glsl_init_gs_uniform_locations(gl_info, priv, program_id, &entry->gs);
+    shader_glsl_init_ps_uniform_locations(gl_info, priv, program_id, &entry->ps,
+            pshader ? pshader->limits->constant_float : 0);
+    checkGLcall("find glsl program uniform locations");
 
-        if (use_vs(state))
-            vshader = state->shader[WINED3D_SHADER_TYPE_VERTEX];
-    }
-    else if (use_vs(state))
+    pre_rasterization_shader = gshader ? gshader : dshader ? dshader : vshader;
+    if (pre_rasterization_shader && pre_rasterization_shader->reg_maps.shader_version.major >= 4)
     {
-        struct vs_compile_args vs_compile_args;
-
-        vshader = state->shader[WINED3D_SHADER_TYPE_VERTEX];
+        unsigned int clip_distance_count = wined3d_popcount(pre_rasterization_shader->reg_maps.clip_distance_mask);
+        entry->shader_controlled_clip_distances = 1;
+        entry->clip_distance_mask = (1u << clip_distance_count) - 1;
+    }
 
-        find_vs_compile_args(state, vshader, context->stream_info.swizzle_map, &vs_compile_args, context);
-        vs_id = find_glsl_vshader(context, priv, vshader, &vs_compile_args);
-        vs_list = &vshader->linked_programs;
+    if (needs_legacy_glsl_syntax(gl_info))
+    {
+        if (pshader && pshader->reg_maps.shader_version.major >= 3
+                && pshader->u.ps.declared_in_count > vec4_varyings(3, gl_info))
+        {
+            TRACE("Shader %d needs vertex color clamping disabled.\n", program_id);
+            entry->vs.vertex_color_clamp = GL_FALSE;
+        }
+        else
+        {
+            entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
+        }
     }
-    else if (priv->vertex_pipe == &glsl_vertex_pipe)
+    else
     {
-        struct glsl_ffp_vertex_shader *ffp_shader;
-        struct wined3d_ffp_vs_settings settings;
+        /* With core profile we never change vertex_color_clamp from
+         * GL_FIXED_ONLY_MODE (which is also the initial value) so we never call
+         * glClampColorARB(). */
+        entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
+    }
+
+    /* Set the shader to allow uniform loading on it */
+    GL_EXTCALL(glUseProgram(program_id));
+    checkGLcall("glUseProgram");
+
+    entry->constant_update_mask = 0;
+    if (vshader)
+    {
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_F;
+        if (vshader->reg_maps.integer_constants)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_I;
+        if (vshader->reg_maps.boolean_constants)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_B;
+        if (entry->vs.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+        if (entry->vs.base_vertex_id_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_BASE_VERTEX_ID;
+
+        shader_glsl_load_program_resources(context, priv, program_id, vshader);
+    }
+    else
+    {
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MODELVIEW
+                | WINED3D_SHADER_CONST_FFP_PROJ;
+
+        for (i = 1; i < MAX_VERTEX_BLENDS; ++i)
+        {
+            if (entry->vs.modelview_matrix_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_VERTEXBLEND;
+                break;
+            }
+        }
+
+        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
+        {
+            if (entry->vs.texture_matrix_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_TEXMATRIX;
+                break;
+            }
+        }
+        if (entry->vs.material_ambient_location != -1 || entry->vs.material_diffuse_location != -1
+                || entry->vs.material_specular_location != -1
+                || entry->vs.material_emissive_location != -1
+                || entry->vs.material_shininess_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MATERIAL;
+        if (entry->vs.light_ambient_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_LIGHTS;
+    }
+    if (entry->vs.clip_planes_location != -1)
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_CLIP_PLANES;
+    if (entry->vs.pointsize_min_location != -1)
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_POINTSIZE;
+
+    if (hshader)
+        shader_glsl_load_program_resources(context, priv, program_id, hshader);
+
+    if (dshader)
+    {
+        if (entry->ds.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context, priv, program_id, dshader);
+    }
+
+    if (gshader)
+    {
+        if (entry->gs.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context, priv, program_id, gshader);
+    }
+
+    if (entry->ps.id)
+    {
+        if (pshader)
+        {
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_F;
+            if (pshader->reg_maps.integer_constants)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_I;
+            if (pshader->reg_maps.boolean_constants)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_B;
+            if (entry->ps.ycorrection_location != -1)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_Y_CORR;
+
+            shader_glsl_load_program_resources(context, priv, program_id, pshader);
+            shader_glsl_load_images(gl_info, priv, program_id, &pshader->reg_maps);
+        }
+        else
+        {
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_PS;
+
+            shader_glsl_load_samplers(context, priv, program_id, NULL);
+        }
+
+        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
+        {
+            if (entry->ps.bumpenv_mat_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_BUMP_ENV;
+                break;
+            }
+        }
+
+        if (entry->ps.fog_color_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_FOG;
+        if (entry->ps.alpha_test_ref_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_ALPHA_TEST;
+        if (entry->ps.np2_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_NP2_FIXUP;
+        if (entry->ps.color_key_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_COLOR_KEY;
+    }
+}
+
+static BOOL set_glsl_shader_program(const struct wined3d_context *context, const struct wined3d_state *state,
+        struct shader_glsl_priv *priv, struct glsl_context_data *ctx_data)
+{
+    const struct wined3d_d3d_info *d3d_info = context->d3d_info;
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    const struct ps_np2fixup_info *np2fixup_info = NULL;
+    struct wined3d_shader *hshader, *dshader, *gshader;
+    struct glsl_shader_prog_link *entry = NULL;
+    struct wined3d_shader *vshader = NULL;
+    struct wined3d_shader *pshader = NULL;
+    GLuint reorder_shader_id = 0;
+    struct glsl_program_key key;
+    GLuint program_id;
+    unsigned int i;
+    GLuint vs_id = 0;
+    GLuint hs_id = 0;
+    GLuint ds_id = 0;
+    GLuint gs_id = 0;
+    GLuint ps_id = 0;
+    struct list *ps_list, *vs_list;
+    WORD attribs_map;
+    struct wined3d_string_buffer *tmp_name;
+
+    if (!(context->shader_update_mask & (1u << WINED3D_SHADER_TYPE_VERTEX)) && ctx_data->glsl_program)
+    {
+        vs_id = ctx_data->glsl_program->vs.id;
+        vs_list = &ctx_data->glsl_program->vs.shader_entry;
+
+        if (use_vs(state))
+            vshader = state->shader[WINED3D_SHADER_TYPE_VERTEX];
+    }
+    else if (use_vs(state))
+    {
+        struct vs_compile_args vs_compile_args;
+
+        vshader = state->shader[WINED3D_SHADER_TYPE_VERTEX];
+
+        find_vs_compile_args(state, vshader, context->stream_info.swizzle_map, &vs_compile_args, context);
+        vs_id = find_glsl_vshader(context, priv, vshader, &vs_compile_args);
+        vs_list = &vshader->linked_programs;
+    }
+    else if (priv->vertex_pipe == &glsl_vertex_pipe)
+    {
+        struct glsl_ffp_vertex_shader *ffp_shader;
+        struct wined3d_ffp_vs_settings settings;
 
         wined3d_ffp_get_vs_settings(context, state, &settings);
         ffp_shader = shader_glsl_find_ffp_vertex_shader(priv, gl_info, &settings);
@@ -10519,8 +11121,17 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     key.cs_id = 0;
     if ((!vs_id && !hs_id && !ds_id && !gs_id && !ps_id) || (entry = get_glsl_program_entry(priv, &key)))
     {
+        if (entry && entry->pending)
+        {
+            if (!shader_glsl_program_ready(gl_info, priv, entry))
+            {
+                ctx_data->glsl_program = NULL;
+                return FALSE;
+            }
+            shader_glsl_init_program(context, priv, entry, vshader, hshader, dshader, gshader, pshader);
+        }
         ctx_data->glsl_program = entry;
-        return;
+        return TRUE;
     }
 
     /* If we get to this point, then no matching program exists, so we create one */
@@ -10538,6 +11149,10 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     entry->cs.id = 0;
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
+    /* Draws are skipped until programs linked in the background are ready.
+     * Stream output can't be skipped without losing data. */
+    entry->pending = gl_info->supported[ARB_PARALLEL_SHADER_COMPILE]
+            && !(gshader && gshader->u.gs.so_desc.element_count);
     entry->ps.np2_fixup_info = np2fixup_info;
     /* Add the hash table entry */
     add_glsl_program_entry(priv, entry);
@@ -10657,161 +11272,17 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
         list_add_head(ps_list, &entry->ps.shader_entry);
     }
 
-    /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
-
-    shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
-            vshader ? vshader->limits->constant_float : 0);
-    shader_glsl_init_ds_uniform_locations(gl_info, priv, program_id, &entry->ds);
-    shader_glsl_init_gs_uniform_locations(gl_info, priv, program_id, &entry->gs);
-    shader_glsl_init_ps_uniform_locations(gl_info, priv, program_id, &entry->ps,
-            pshader ? pshader->limits->constant_float : 0);
-    checkGLcall("find glsl program uniform locations");
-
-    pre_rasterization_shader = gshader ? gshader : dshader ? dshader : vshader;
-    if (pre_rasterization_shader && pre_rasterization_shader->reg_maps.shader_version.major >= 4)
-    {
-        unsigned int clip_distance_count = wined3d_popcount(pre_rasterization_shader->reg_maps.clip_distance_mask);
-        entry->shader_controlled_clip_distances = 1;
-        entry->clip_distance_mask = (1u << clip_distance_count) - 1;
-    }
-
-    if (needs_legacy_glsl_syntax(gl_info))
-    {
-        if (pshader && pshader->reg_maps.shader_version.major >= 3
-                && pshader->u.ps.declared_in_count > vec4_varyings(3, gl_info))
-        {
-            TRACE("Shader %d needs vertex color clamping disabled.\n", program_id);
-            entry->vs.vertex_color_clamp = GL_FALSE;
-        }
-        else
-        {
-            entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
-        }
-    }
-    else
-    {
-        /* With core profile we never change vertex_color_clamp from
-         * GL_FIXED_ONLY_MODE (which is also the initial value) so we never call
-         * glClampColorARB(). */
-        entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
-    }
-
-    /* Set the shader to allow uniform loading on it */
-    GL_EXTCALL(glUseProgram(program_id));
-    checkGLcall("glUseProgram");
-
-    entry->constant_update_mask = 0;
-    if (vshader)
-    {
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_F;
-        if (vshader->reg_maps.integer_constants)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_I;
-        if (vshader->reg_maps.boolean_constants)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_B;
-        if (entry->vs.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-        if (entry->vs.base_vertex_id_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_BASE_VERTEX_ID;
-
-        shader_glsl_load_program_resources(context, priv, program_id, vshader);
-    }
-    else
-    {
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MODELVIEW
-                | WINED3D_SHADER_CONST_FFP_PROJ;
-
-        for (i = 1; i < MAX_VERTEX_BLENDS; ++i)
-        {
-            if (entry->vs.modelview_matrix_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_VERTEXBLEND;
-                break;
-            }
-        }
-
-        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
-        {
-            if (entry->vs.texture_matrix_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_TEXMATRIX;
-                break;
-            }
-        }
-        if (entry->vs.material_ambient_location != -1 || entry->vs.material_diffuse_location != -1
-                || entry->vs.material_specular_location != -1
-                || entry->vs.material_emissive_location != -1
-                || entry->vs.material_shininess_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MATERIAL;
-        if (entry->vs.light_ambient_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_LIGHTS;
-    }
-    if (entry->vs.clip_planes_location != -1)
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_CLIP_PLANES;
-    if (entry->vs.pointsize_min_location != -1)
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_POINTSIZE;
-
-    if (hshader)
-        shader_glsl_load_program_resources(context, priv, program_id, hshader);
-
-    if (dshader)
+    /* Link the program. Transform feedback varyings aren't part of the
+     * shader source, so programs using them can't be cached. */
+    shader_glsl_link_program(gl_info, priv, entry, !gshader || !gshader->u.gs.so_desc.element_count);
+    if (!shader_glsl_program_ready(gl_info, priv, entry))
     {
-        if (entry->ds.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context, priv, program_id, dshader);
-    }
-
-    if (gshader)
-    {
-        if (entry->gs.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context, priv, program_id, gshader);
+        ctx_data->glsl_program = NULL;
+        return FALSE;
     }
 
-    if (ps_id)
-    {
-        if (pshader)
-        {
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_F;
-            if (pshader->reg_maps.integer_constants)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_I;
-            if (pshader->reg_maps.boolean_constants)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_B;
-            if (entry->ps.ycorrection_location != -1)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_Y_CORR;
-
-            shader_glsl_load_program_resources(context, priv, program_id, pshader);
-            shader_glsl_load_images(gl_info, priv, program_id, &pshader->reg_maps);
-        }
-        else
-        {
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_PS;
-
-            shader_glsl_load_samplers(context, priv, program_id, NULL);
-        }
-
-        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
-        {
-            if (entry->ps.bumpenv_mat_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_BUMP_ENV;
-                break;
-            }
-        }
-
-        if (entry->ps.fog_color_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_FOG;
-        if (entry->ps.alpha_test_ref_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_ALPHA_TEST;
-        if (entry->ps.np2_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_NP2_FIXUP;
-        if (entry->ps.color_key_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_COLOR_KEY;
-    }
+    shader_glsl_init_program(context, priv, entry, vshader, hshader, dshader, gshader, pshader);
+    return TRUE;
 }
 
 static void shader_glsl_precompile(void *shader_priv, struct wined3d_shader *shader)
@@ -10842,7 +11313,7 @@ static void shader_glsl_select(void *shader_priv, struct wined3d_context *contex
     priv->fragment_pipe->enable_extension(gl_info, !use_ps(state));
 
     prev_id = ctx_data->glsl_program ? ctx_data->glsl_program->id : 0;
-    set_glsl_shader_program(context, state, priv, ctx_data);
+    context->shader_program_pending = !set_glsl_shader_program(context, state, priv, ctx_data);
     glsl_program = ctx_data->glsl_program;
 
     if (glsl_program)
@@ -11194,6 +11665,26 @@ static void constant_heap_free(struct constant_heap *heap)
     heap_free(heap->entries);
 }
 
+static BOOL shader_glsl_get_program_cache_path(char *path, DWORD size)
+{
+    static const char name[] = "\\wined3d_glsl_programs.bin";
+    DWORD len;
+
+    if (wined3d_settings.shader_cache_path)
+    {
+        lstrcpynA(path, wined3d_settings.shader_cache_path, size);
+        return TRUE;
+    }
+
+    if (!(len = GetEnvironmentVariableA("LOCALAPPDATA", path, size)) || len + sizeof(name) > size)
+    {
+        WARN("Failed to get the local application data directory.\n");
+        return FALSE;
+    }
+    strcat(path, name);
+    return TRUE;
+}
+
 static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct wined3d_vertex_pipe_ops *vertex_pipe,
         const struct fragment_pipeline *fragment_pipe)
 {
@@ -11255,6 +11746,14 @@ static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct win
     priv->ffp_proj_control = fragment_caps.wined3d_caps & WINED3D_FRAGMENT_CAP_PROJ_CONTROL;
     priv->legacy_lighting = device->wined3d->flags & WINED3D_LEGACY_FFP_LIGHTING;
 
+    if (wined3d_settings.shader_cache && device->adapter->gl_info.supported[ARB_GET_PROGRAM_BINARY])
+    {
+        char path[MAX_PATH];
+
+        if (shader_glsl_get_program_cache_path(path, ARRAY_SIZE(path)))
+            priv->program_cache = glsl_program_cache_create(path);
+    }
+
     device->vertex_priv = vertex_priv;
     device->fragment_priv = fragment_priv;
     device->shader_priv = priv;
@@ -11277,6 +11776,8 @@ static void shader_glsl_free(struct wined3d_device *device, struct wined3d_conte
 {
     struct shader_glsl_priv *priv = device->shader_priv;
 
+    if (priv->program_cache)
+        glsl_program_cache_destroy(priv->program_cache);
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
     constant_heap_free(&priv->pconst_heap);
     constant_heap_free(&priv->vconst_heap);
@@ -11312,6 +11813,12 @@ static void shader_glsl_init_context_state(struct wined3d_context *context)
 
     gl_info->gl_ops.gl.p_glEnable(GL_PROGRAM_POINT_SIZE);
     checkGLcall("GL_PROGRAM_POINT_SIZE");
+
+    if (gl_info->supported[ARB_PARALLEL_SHADER_COMPILE])
+    {
+        GL_EXTCALL(glMaxShaderCompilerThreadsARB(~0u));
+        checkGLcall("glMaxShaderCompilerThreadsARB");
+    }
 }
 
 static unsigned int shader_glsl_get_shader_model(const struct wined3d_gl_info *gl_info)
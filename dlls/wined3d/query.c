@@ -179,7 +179,7 @@ static BOOL wined3d_fence_supported(const struct wined3d_gl_info *gl_info)
     return gl_info->supported[ARB_SYNC] || gl_info->supported[NV_FENCE] || gl_info->supported[APPLE_FENCE];
 }
 
-static enum wined3d_fence_result wined3d_fence_test(const struct wined3d_fence *fence,
+enum wined3d_fence_result wined3d_fence_test(const struct wined3d_fence *fence,
         const struct wined3d_device *device, DWORD flags)
 {
     const struct wined3d_gl_info *gl_info;
@@ -511,19 +511,23 @@ UINT CDECL wined3d_query_get_data_size(const struct wined3d_query *query)
     return query->data_size;
 }
 
-HRESULT CDECL wined3d_query_issue(struct wined3d_query *query, DWORD flags)
+void wined3d_query_update_issued(struct wined3d_query *query, DWORD flags)
 {
-    TRACE("query %p, flags %#x.\n", query, flags);
-
     if (flags & WINED3DISSUE_END)
         ++query->counter_main;
 
-    wined3d_cs_emit_query_issue(query->device->cs, query, flags);
-
     if (flags & WINED3DISSUE_BEGIN)
         query->state = QUERY_BUILDING;
     else
         query->state = QUERY_SIGNALLED;
+}
+
+HRESULT CDECL wined3d_query_issue(struct wined3d_query *query, DWORD flags)
+{
+    TRACE("query %p, flags %#x.\n", query, flags);
+
+    wined3d_query_update_issued(query, flags);
+    wined3d_cs_emit_query_issue(query->device->cs, query, flags);
 
     return WINED3D_OK;
 }
@@ -378,6 +378,8 @@ HRESULT CDECL wined3d_resource_map(struct wined3d_resource *resource, unsigned i
     }
 
     flags = wined3d_resource_sanitise_map_flags(resource, flags);
+    if (wined3d_cs_map_upload_region(resource->device->cs, resource, sub_resource_idx, map_desc, box, flags))
+        return WINED3D_OK;
     wined3d_resource_wait_idle(resource);
 
     return wined3d_cs_map(resource->device->cs, resource, sub_resource_idx, map_desc, box, flags);
@@ -387,6 +389,8 @@ HRESULT CDECL wined3d_resource_unmap(struct wined3d_resource *resource, unsigned
 {
     TRACE("resource %p, sub_resource_idx %u.\n", resource, sub_resource_idx);
 
+    if (wined3d_cs_unmap_upload_region(resource->device->cs, resource, sub_resource_idx))
+        return WINED3D_OK;
     return wined3d_cs_unmap(resource->device->cs, resource, sub_resource_idx);
 }
 
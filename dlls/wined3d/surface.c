@@ -30,6 +30,10 @@
 #include "wine/port.h"
 #include "wined3d_private.h"
 
+#ifdef WINED3D_SSE2
+#include <emmintrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
@@ -425,6 +429,38 @@ static void convert_r32_float_r16_float(const BYTE *src, BYTE *dst,
     }
 }
 
+#ifdef WINED3D_SSE2
+/* (x * 527 + 23) >> 6 and (x * 259 + 33) >> 6 give the same results as the
+ * lookup tables below for 5 and 6 bit values respectively. */
+static unsigned int WINED3D_SSE2_FUNC convert_r5g6b5_x8r8g8b8_sse2(const WORD *src, DWORD *dst, unsigned int w)
+{
+    const __m128i mask5 = _mm_set1_epi16(0x1f), mask6 = _mm_set1_epi16(0x3f);
+    const __m128i mul5 = _mm_set1_epi16(527), add5 = _mm_set1_epi16(23);
+    const __m128i mul6 = _mm_set1_epi16(259), add6 = _mm_set1_epi16(33);
+    const __m128i alpha = _mm_set1_epi16(0xff00);
+    __m128i p, r, g, b, bg, ra;
+    unsigned int x;
+
+    for (x = 0; x + 8 <= w; x += 8)
+    {
+        p = _mm_loadu_si128((const __m128i *)&src[x]);
+        r = _mm_srli_epi16(p, 11);
+        g = _mm_and_si128(_mm_srli_epi16(p, 5), mask6);
+        b = _mm_and_si128(p, mask5);
+        r = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(r, mul5), add5), 6);
+        g = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(g, mul6), add6), 6);
+        b = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(b, mul5), add5), 6);
+
+        bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        ra = _mm_or_si128(r, alpha);
+        _mm_storeu_si128((__m128i *)&dst[x], _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i *)&dst[x + 4], _mm_unpackhi_epi16(bg, ra));
+    }
+
+    return x;
+}
+#endif
+
 static void convert_r5g6b5_x8r8g8b8(const BYTE *src, BYTE *dst,
         DWORD pitch_in, DWORD pitch_out, unsigned int w, unsigned int h)
 {
@@ -454,7 +490,13 @@ static void convert_r5g6b5_x8r8g8b8(const BYTE *src, BYTE *dst,
     {
         const WORD *src_line = (const WORD *)(src + y * pitch_in);
         DWORD *dst_line = (DWORD *)(dst + y * pitch_out);
-        for (x = 0; x < w; ++x)
+
+        x = 0;
+#ifdef WINED3D_SSE2
+        if (wined3d_cpu_sse2)
+            x = convert_r5g6b5_x8r8g8b8_sse2(src_line, dst_line, w);
+#endif
+        for (; x < w; ++x)
         {
             WORD pixel = src_line[x];
             dst_line[x] = 0xff000000u
@@ -491,6 +533,47 @@ static inline BYTE cliptobyte(int x)
     return (BYTE)((x < 0) ? 0 : ((x > 255) ? 255 : x));
 }
 
+#ifdef WINED3D_SSE2
+/* Converts four pixels at a time, using the same fixed point arithmetic as
+ * convert_yuy2_x8r8g8b8(). Each 32-bit lane holds a pair of 16-bit factors
+ * for _mm_madd_epi16(). */
+static unsigned int WINED3D_SSE2_FUNC convert_yuy2_x8r8g8b8_sse2(const BYTE *src, DWORD *dst, unsigned int w)
+{
+    const __m128i bias = _mm_set_epi16(128, 16, 128, 16, 128, 16, 128, 16);
+    const __m128i luma_mask = _mm_set1_epi32(0x0000ffff), luma_one = _mm_set1_epi32(0x00010000);
+    const __m128i luma_mul = _mm_set_epi16(128, 298, 128, 298, 128, 298, 128, 298);
+    const __m128i r_mul = _mm_set_epi16(409, 0, 409, 0, 409, 0, 409, 0);
+    const __m128i g_mul = _mm_set_epi16(-208, -100, -208, -100, -208, -100, -208, -100);
+    const __m128i b_mul = _mm_set_epi16(0, 516, 0, 516, 0, 516, 0, 516);
+    const __m128i alpha = _mm_set1_epi8(0xff);
+    __m128i yuv, t, de, luma, r, g, b, bgr;
+    unsigned int x;
+
+    for (x = 0; x + 4 <= w; x += 4)
+    {
+        /* C0 D0 C1 E0 C2 D1 C3 E1 */
+        yuv = _mm_loadl_epi64((const __m128i *)&src[x * 2]);
+        yuv = _mm_sub_epi16(_mm_unpacklo_epi8(yuv, _mm_setzero_si128()), bias);
+
+        luma = _mm_madd_epi16(_mm_or_si128(_mm_and_si128(yuv, luma_mask), luma_one), luma_mul);
+        t = _mm_srli_epi32(yuv, 16);
+        de = _mm_or_si128(_mm_shuffle_epi32(t, _MM_SHUFFLE(2, 2, 0, 0)),
+                _mm_slli_epi32(_mm_shuffle_epi32(t, _MM_SHUFFLE(3, 3, 1, 1)), 16));
+
+        r = _mm_srai_epi32(_mm_add_epi32(luma, _mm_madd_epi16(de, r_mul)), 8);
+        g = _mm_srai_epi32(_mm_add_epi32(luma, _mm_madd_epi16(de, g_mul)), 8);
+        b = _mm_srai_epi32(_mm_add_epi32(luma, _mm_madd_epi16(de, b_mul)), 8);
+
+        /* Saturating packs clamp to 0..255: R0-3 G0-3 B0-3 B0-3. */
+        bgr = _mm_packus_epi16(_mm_packs_epi32(r, g), _mm_packs_epi32(b, b));
+        t = _mm_unpacklo_epi8(_mm_srli_si128(bgr, 8), _mm_srli_si128(bgr, 4));
+        _mm_storeu_si128((__m128i *)&dst[x], _mm_unpacklo_epi16(t, _mm_unpacklo_epi8(bgr, alpha)));
+    }
+
+    return x;
+}
+#endif
+
 static void convert_yuy2_x8r8g8b8(const BYTE *src, BYTE *dst,
         DWORD pitch_in, DWORD pitch_out, unsigned int w, unsigned int h)
 {
@@ -503,7 +586,16 @@ static void convert_yuy2_x8r8g8b8(const BYTE *src, BYTE *dst,
     {
         const BYTE *src_line = src + y * pitch_in;
         DWORD *dst_line = (DWORD *)(dst + y * pitch_out);
-        for (x = 0; x < w; ++x)
+
+        x = 0;
+#ifdef WINED3D_SSE2
+        if (wined3d_cpu_sse2)
+        {
+            x = convert_yuy2_x8r8g8b8_sse2(src_line, dst_line, w);
+            src_line += x * 2;
+        }
+#endif
+        for (; x < w; ++x)
         {
             /* YUV to RGB conversion formulas from http://en.wikipedia.org/wiki/YUV:
              *     C = Y - 16; D = U - 128; E = V - 128;
@@ -31,6 +31,10 @@
 
 #include "wined3d_private.h"
 
+#ifdef WINED3D_SSE2
+#include <emmintrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 
 #define WINED3D_FORMAT_FOURCC_BASE (WINED3DFMT_BC7_UNORM_SRGB + 1)
@@ -899,6 +903,28 @@ static void convert_r8g8_snorm_l8x8_unorm_nv(const BYTE *src, BYTE *dst, UINT sr
     }
 }
 
+#ifdef WINED3D_SSE2
+static unsigned int WINED3D_SSE2_FUNC convert_r8g8b8a8_snorm_sse2(const DWORD *src, BYTE *dst, unsigned int width)
+{
+    const __m128i bias = _mm_set1_epi32(0x80808080);
+    const __m128i mask_ga = _mm_set1_epi32(0xff00ff00);
+    const __m128i mask_b = _mm_set1_epi32(0x000000ff);
+    unsigned int x;
+
+    for (x = 0; x + 4 <= width; x += 4)
+    {
+        __m128i c = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&src[x]), bias);
+
+        c = _mm_or_si128(_mm_and_si128(c, mask_ga),
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(c, 16), mask_b),
+                _mm_slli_epi32(_mm_and_si128(c, mask_b), 16)));
+        _mm_storeu_si128((__m128i *)&dst[x * 4], c);
+    }
+
+    return x;
+}
+#endif
+
 static void convert_r8g8b8a8_snorm(const BYTE *src, BYTE *dst, UINT src_row_pitch, UINT src_slice_pitch,
         UINT dst_row_pitch, UINT dst_slice_pitch, UINT width, UINT height, UINT depth)
 {
@@ -912,7 +938,16 @@ static void convert_r8g8b8a8_snorm(const BYTE *src, BYTE *dst, UINT src_row_pitc
         {
             Source = (const DWORD *)(src + z * src_slice_pitch + y * src_row_pitch);
             Dest = dst + z * dst_slice_pitch + y * dst_row_pitch;
-            for (x = 0; x < width; x++ )
+            x = 0;
+#ifdef WINED3D_SSE2
+            if (wined3d_cpu_sse2)
+            {
+                x = convert_r8g8b8a8_snorm_sse2(Source, Dest, width);
+                Source += x;
+                Dest += x * 4;
+            }
+#endif
+            for (; x < width; x++ )
             {
                 LONG color = (*Source++);
                 /* B */ Dest[0] = ((color >> 16) & 0xff) + 128; /* W */
@@ -950,6 +985,32 @@ static void convert_r16g16_snorm(const BYTE *src, BYTE *dst, UINT src_row_pitch,
     }
 }
 
+#ifdef WINED3D_SSE2
+static unsigned int WINED3D_SSE2_FUNC convert_r16g16_sse2(const WORD *src, WORD *dst, unsigned int width)
+{
+    const __m128i blue0 = _mm_set_epi16(0, 0, 0, 0, 0, 0xffff, 0, 0);
+    const __m128i blue1 = _mm_set_epi16(0, 0, 0, 0, 0, 0, 0xffff, 0);
+    const __m128i blue2 = _mm_set_epi16(0, 0, 0, 0, 0xffff, 0, 0, 0xffff);
+    unsigned int x;
+
+    /* Four pixels are written as three quadwords: "G0 R0 B G1", "R1 B G2 R2"
+     * and "B G3 R3 B". */
+    for (x = 0; x + 4 <= width; x += 4)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)&src[x * 2]);
+
+        _mm_storel_epi64((__m128i *)&dst[x * 3],
+                _mm_or_si128(_mm_shufflelo_epi16(c, _MM_SHUFFLE(2, 0, 1, 0)), blue0));
+        _mm_storel_epi64((__m128i *)&dst[x * 3 + 4],
+                _mm_or_si128(_mm_shufflelo_epi16(_mm_srli_si128(c, 6), _MM_SHUFFLE(2, 1, 0, 0)), blue1));
+        _mm_storel_epi64((__m128i *)&dst[x * 3 + 8],
+                _mm_or_si128(_mm_shufflelo_epi16(_mm_srli_si128(c, 12), _MM_SHUFFLE(0, 1, 0, 0)), blue2));
+    }
+
+    return x;
+}
+#endif
+
 static void convert_r16g16(const BYTE *src, BYTE *dst, UINT src_row_pitch, UINT src_slice_pitch,
         UINT dst_row_pitch, UINT dst_slice_pitch, UINT width, UINT height, UINT depth)
 {
@@ -963,7 +1024,16 @@ static void convert_r16g16(const BYTE *src, BYTE *dst, UINT src_row_pitch, UINT
         {
             Source = (const WORD *)(src + z * src_slice_pitch + y * src_row_pitch);
             Dest = (WORD *) (dst + z * dst_slice_pitch + y * dst_row_pitch);
-            for (x = 0; x < width; x++ )
+            x = 0;
+#ifdef WINED3D_SSE2
+            if (wined3d_cpu_sse2)
+            {
+                x = convert_r16g16_sse2(Source, Dest, width);
+                Source += x * 2;
+                Dest += x * 3;
+            }
+#endif
+            for (; x < width; x++ )
             {
                 WORD green = (*Source++);
                 WORD red = (*Source++);
@@ -1191,6 +1261,41 @@ static void convert_b8g8r8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, unsig
     }
 }
 
+#ifdef WINED3D_SSE2
+/* Returns a mask of the pixels outside the color key range. SSE2 only has
+ * signed comparisons, so the values are biased first. */
+static inline __m128i WINED3D_SSE2_FUNC color_out_of_range_sse2(__m128i color, __m128i low, __m128i high)
+{
+    const __m128i sign = _mm_set1_epi32(0x80000000);
+
+    color = _mm_xor_si128(color, sign);
+    return _mm_or_si128(_mm_cmplt_epi32(color, low), _mm_cmpgt_epi32(color, high));
+}
+
+static unsigned int WINED3D_SSE2_FUNC convert_color_key_sse2(const DWORD *src, DWORD *dst,
+        unsigned int width, const struct wined3d_color_key *color_key, BOOL force_alpha)
+{
+    const __m128i low = _mm_set1_epi32(color_key->color_space_low_value ^ 0x80000000);
+    const __m128i high = _mm_set1_epi32(color_key->color_space_high_value ^ 0x80000000);
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    unsigned int x;
+
+    for (x = 0; x + 4 <= width; x += 4)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)&src[x]);
+        __m128i out = color_out_of_range_sse2(c, low, high);
+
+        if (force_alpha)
+            c = _mm_or_si128(_mm_andnot_si128(alpha, c), _mm_and_si128(out, alpha));
+        else
+            c = _mm_and_si128(c, _mm_or_si128(out, _mm_andnot_si128(alpha, _mm_set1_epi32(~0u))));
+        _mm_storeu_si128((__m128i *)&dst[x], c);
+    }
+
+    return x;
+}
+#endif
+
 static void convert_b8g8r8x8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, unsigned int src_pitch,
         BYTE *dst, unsigned int dst_pitch, unsigned int width, unsigned int height,
         const struct wined3d_color_key *color_key)
@@ -1203,7 +1308,12 @@ static void convert_b8g8r8x8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, uns
     {
         src_row = (DWORD *)&src[src_pitch * y];
         dst_row = (DWORD *)&dst[dst_pitch * y];
-        for (x = 0; x < width; ++x)
+        x = 0;
+#ifdef WINED3D_SSE2
+        if (wined3d_cpu_sse2)
+            x = convert_color_key_sse2(src_row, dst_row, width, color_key, TRUE);
+#endif
+        for (; x < width; ++x)
         {
             DWORD src_color = src_row[x];
             if (color_in_range(color_key, src_color))
@@ -1226,7 +1336,12 @@ static void convert_b8g8r8a8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, uns
     {
         src_row = (DWORD *)&src[src_pitch * y];
         dst_row = (DWORD *)&dst[dst_pitch * y];
-        for (x = 0; x < width; ++x)
+        x = 0;
+#ifdef WINED3D_SSE2
+        if (wined3d_cpu_sse2)
+            x = convert_color_key_sse2(src_row, dst_row, width, color_key, FALSE);
+#endif
+        for (; x < width; ++x)
         {
             DWORD src_color = src_row[x];
             if (color_in_range(color_key, src_color))
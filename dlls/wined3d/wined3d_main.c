@@ -68,11 +68,17 @@ static CRITICAL_SECTION_DEBUG wined3d_wndproc_cs_debug =
 };
 static CRITICAL_SECTION wined3d_wndproc_cs = {&wined3d_wndproc_cs_debug, -1, 0, 0, 0, 0};
 
+BOOL wined3d_cpu_sse2;
+
 /* When updating default value here, make sure to update winecfg as well,
  * where appropriate. */
 struct wined3d_settings wined3d_settings =
 {
     TRUE,           /* Multithreaded CS by default. */
+    WINED3D_CS_SPIN_COUNT,        /* CS thread spins before sleeping. */
+    WINED3D_CS_CLIENT_SPIN_COUNT, /* Application thread spins before sleeping. */
+    0,              /* No command stream statistics by default. */
+    NULL,           /* No command stream profile by default. */
     MAKEDWORD_VERSION(4, 4), /* Default to OpenGL 4.4 */
     ORM_FBO,        /* Use FBOs to do offscreen rendering */
     PCI_VENDOR_NONE,/* PCI Vendor ID */
@@ -89,6 +95,9 @@ struct wined3d_settings wined3d_settings =
     ~0U,            /* No GS shader model limit by default. */
     ~0U,            /* No PS shader model limit by default. */
     ~0u,            /* No CS shader model limit by default. */
+    TRUE,           /* Cache linked GLSL programs by default. */
+    NULL,           /* Store the program cache in the local application data directory. */
+    FALSE,          /* Don't defer draws until shaders are compiled by default. */
     WINED3D_RENDERER_AUTO,
     WINED3D_SHADER_BACKEND_AUTO,
 };
@@ -212,6 +221,9 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
 
     DisableThreadLibraryCalls(hInstDLL);
 
+    if ((wined3d_cpu_sse2 = IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE)))
+        TRACE("Using SSE2 format conversion functions.\n");
+
     /* @@ Wine registry key: HKCU\Software\Wine\Direct3D */
     if ( RegOpenKeyA( HKEY_CURRENT_USER, "Software\\Wine\\Direct3D", &hkey ) ) hkey = 0;
 
@@ -232,6 +244,10 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
     {
         if (!get_config_key_dword(hkey, appkey, "csmt", &wined3d_settings.cs_multithreaded))
             ERR_(winediag)("Setting multithreaded command stream to %#x.\n", wined3d_settings.cs_multithreaded);
+        if (!get_config_key_dword(hkey, appkey, "CSSpinCount", &wined3d_settings.cs_spin_count))
+            TRACE("Setting command stream spin count to %u.\n", wined3d_settings.cs_spin_count);
+        if (!get_config_key_dword(hkey, appkey, "CSClientSpinCount", &wined3d_settings.cs_client_spin_count))
+            TRACE("Setting command stream client spin count to %u.\n", wined3d_settings.cs_client_spin_count);
         if (!get_config_key_dword(hkey, appkey, "MaxVersionGL", &tmpvalue))
         {
             ERR_(winediag)("Setting maximum allowed wined3d GL version to %u.%u.\n",
@@ -346,6 +362,20 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Limiting PS shader model to %u.\n", wined3d_settings.max_sm_ps);
         if (!get_config_key_dword(hkey, appkey, "MaxShaderModelCS", &wined3d_settings.max_sm_cs))
             TRACE("Limiting CS shader model to %u.\n", wined3d_settings.max_sm_cs);
+        if (!get_config_key_dword(hkey, appkey, "ShaderCache", &wined3d_settings.shader_cache))
+            TRACE("Setting GLSL program cache to %#x.\n", wined3d_settings.shader_cache);
+        if (!get_config_key_dword(hkey, appkey, "AsyncShaderCompile", &wined3d_settings.async_shader_compile))
+            ERR_(winediag)("Setting asynchronous shader compilation to %#x.\n",
+                    wined3d_settings.async_shader_compile);
+        if (!get_config_key(hkey, appkey, "ShaderCachePath", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_path = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+                memcpy(wined3d_settings.shader_cache_path, buffer, len);
+        }
         if (!get_config_key(hkey, appkey, "renderer", buffer, size)
                 || !get_config_key(hkey, appkey, "DirectDrawRenderer", buffer, size))
         {
@@ -370,6 +400,23 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
     if (appkey) RegCloseKey( appkey );
     if (hkey) RegCloseKey( hkey );
 
+    /* Number of frames to accumulate command stream statistics over. */
+    if (GetEnvironmentVariableA("WINE_D3D_CS_STATS", buffer, size))
+    {
+        wined3d_settings.cs_stats_interval = atoi(buffer);
+        TRACE("Reporting command stream statistics every %u frames.\n", wined3d_settings.cs_stats_interval);
+    }
+    /* File to write a per-frame command stream profile to. */
+    if (GetEnvironmentVariableA("WINE_D3D_CS_PROFILE", buffer, size))
+    {
+        size_t len = strlen(buffer) + 1;
+
+        if (!(wined3d_settings.cs_profile_file = heap_alloc(len)))
+            ERR("Failed to allocate command stream profile path memory.\n");
+        else
+            memcpy(wined3d_settings.cs_profile_file, buffer, len);
+    }
+
     return TRUE;
 }
 
@@ -396,6 +443,8 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     }
     heap_free(wndproc_table.entries);
 
+    heap_free(wined3d_settings.cs_profile_file);
+    heap_free(wined3d_settings.shader_cache_path);
     heap_free(wined3d_settings.logo);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
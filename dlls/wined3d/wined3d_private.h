@@ -402,6 +402,10 @@ enum wined3d_shader_backend
 struct wined3d_settings
 {
     unsigned int cs_multithreaded;
+    unsigned int cs_spin_count;
+    unsigned int cs_client_spin_count;
+    unsigned int cs_stats_interval;
+    char *cs_profile_file;
     DWORD max_gl_version;
     int offscreen_rendering_mode;
     unsigned short pci_vendor_id;
@@ -419,12 +423,25 @@ struct wined3d_settings
     unsigned int max_sm_gs;
     unsigned int max_sm_ps;
     unsigned int max_sm_cs;
+    unsigned int shader_cache;
+    char *shader_cache_path;
+    unsigned int async_shader_compile;
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
 
+/* SSE2 versions of some format conversion functions. These are compiled
+ * regardless of the target CPU and selected at runtime. */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) \
+        && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define WINED3D_SSE2
+#define WINED3D_SSE2_FUNC __attribute__((target("sse2")))
+#endif
+
+extern BOOL wined3d_cpu_sse2 DECLSPEC_HIDDEN;
+
 enum wined3d_shader_byte_code_format
 {
     WINED3D_SHADER_BYTE_CODE_FORMAT_SM1,
@@ -1732,6 +1749,8 @@ struct wined3d_fence
 HRESULT wined3d_fence_create(struct wined3d_device *device, struct wined3d_fence **fence) DECLSPEC_HIDDEN;
 void wined3d_fence_destroy(struct wined3d_fence *fence) DECLSPEC_HIDDEN;
 void wined3d_fence_issue(struct wined3d_fence *fence, const struct wined3d_device *device) DECLSPEC_HIDDEN;
+enum wined3d_fence_result wined3d_fence_test(const struct wined3d_fence *fence,
+        const struct wined3d_device *device, DWORD flags) DECLSPEC_HIDDEN;
 enum wined3d_fence_result wined3d_fence_wait(const struct wined3d_fence *fence,
         const struct wined3d_device *device) DECLSPEC_HIDDEN;
 
@@ -1772,6 +1791,8 @@ struct wined3d_query
     UINT64 *map_ptr;
 };
 
+void wined3d_query_update_issued(struct wined3d_query *query, DWORD flags) DECLSPEC_HIDDEN;
+
 struct wined3d_event_query
 {
     struct wined3d_query query;
@@ -1944,7 +1965,8 @@ struct wined3d_context
     DWORD shader_update_mask : 6; /* WINED3D_SHADER_TYPE_COUNT, 6 */
     DWORD clip_distance_mask : 8; /* WINED3D_MAX_CLIP_DISTANCES, 8 */
     DWORD num_untracked_materials : 2;  /* Max value 2 */
-    DWORD padding : 8;
+    DWORD shader_program_pending : 1;
+    DWORD padding : 7;
 
     DWORD constant_update_mask;
     DWORD numbered_array_mask;
@@ -3795,7 +3817,13 @@ enum wined3d_push_constants
 
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
-#define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_SPIN_COUNT           10000u
+#define WINED3D_CS_CLIENT_SPIN_COUNT    4000u
+#define WINED3D_CS_WAIT_TIMEOUT         1u
+#define WINED3D_CS_UPLOAD_POOL_SIZE     0x1000000u
+#define WINED3D_CS_UPLOAD_LIMIT         0x4000000u
+#define WINED3D_CS_DEFERRED_CHUNK_SIZE  0x10000u
+#define WINED3D_CS_DEFERRED_MIN_SIZE    0x20000u
 
 struct wined3d_cs_queue
 {
@@ -3803,6 +3831,61 @@ struct wined3d_cs_queue
     BYTE data[WINED3D_CS_QUEUE_SIZE];
 };
 
+#define WINED3D_UPLOAD_RING_SIZE        0x2000000u
+#define WINED3D_UPLOAD_RING_ALIGNMENT   64u
+#define WINED3D_UPLOAD_RING_FENCE_COUNT 16u
+
+/* Persistently mapped staging memory for sub-resource updates. Offsets are
+ * byte counts since the ring was created, wrapping at 4 GiB. The application
+ * thread allocates at "head", and the command stream moves "retired" forward
+ * once the fences covering the uploads have signalled. */
+struct wined3d_upload_ring
+{
+    GLuint buffer_object;
+    BYTE *map_ptr;
+    ULONG head;
+    LONG retired;
+    ULONG submitted, fenced;
+    struct
+    {
+        struct wined3d_fence *fence;
+        ULONG end;
+    } fences[WINED3D_UPLOAD_RING_FENCE_COUNT];
+    unsigned int fence_start, fence_count;
+};
+
+/* System memory handed out to the application for DISCARD and NOOVERWRITE
+ * buffer maps. The buffer holds one reference while the region is its
+ * current backing storage, and every queued upload from it holds another. */
+struct wined3d_upload_region
+{
+    struct list entry;
+    LONG refcount;
+    unsigned int size;
+    BYTE *data;
+};
+
+/* Time spent spinning and sleeping while waiting, in performance counter
+ * ticks. */
+struct wined3d_cs_wait_stats
+{
+    LONGLONG spin_time;
+    LONGLONG sleep_time;
+    unsigned int wait_count;
+    unsigned int sleep_count;
+};
+
+/* Waits by the application thread for the command stream. The caller takes
+ * a snapshot with wined3d_cs_wait_init() before testing its condition, and
+ * calls wined3d_cs_wait() each time the condition isn't met yet. */
+struct wined3d_cs_wait
+{
+    LONG progress;
+    unsigned int spin_count;
+    LARGE_INTEGER start;
+    LONGLONG sleep_time;
+};
+
 struct wined3d_cs_ops
 {
     void *(*require_space)(struct wined3d_cs *cs, size_t size, enum wined3d_cs_queue_id queue_id);
@@ -3810,6 +3893,7 @@ struct wined3d_cs_ops
     void (*finish)(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id);
     void (*push_constants)(struct wined3d_cs *cs, enum wined3d_push_constants p,
             unsigned int start_idx, unsigned int count, const void *constants);
+    void (*acquire_resource)(struct wined3d_cs *cs, struct wined3d_resource *resource);
 };
 
 struct wined3d_cs
@@ -3822,7 +3906,7 @@ struct wined3d_cs
     HANDLE thread;
     DWORD thread_id;
 
-    struct wined3d_cs_queue queue[WINED3D_CS_QUEUE_COUNT];
+    struct wined3d_cs_queue *queue;
     size_t data_size, start, end;
     void *data;
     struct list query_poll_list;
@@ -3831,6 +3915,73 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+
+    HANDLE client_event;
+    LONG client_waiting;
+    LONG progress;
+    struct wined3d_cs_wait_stats worker_stats;
+    struct wined3d_cs_wait_stats client_stats;
+    LARGE_INTEGER stats_time;
+    struct wined3d_cs_op_stats *op_stats;
+    unsigned int redundant_state_count;
+    struct wined3d_cs_profiler *profiler;
+
+    /* A draw held back by the application thread, see wined3d_cs_emit_draw(). */
+    BOOL draw_pending;
+    GLenum pending_draw_primitive_type;
+    unsigned int pending_draw_patch_vertex_count;
+    struct wined3d_direct_draw_parameters pending_draw;
+
+    CRITICAL_SECTION upload_pool_cs;
+    struct list upload_pool;
+    SIZE_T upload_pool_size;
+    LONG upload_size;
+
+    struct wined3d_upload_ring upload_ring;
+};
+
+struct wined3d_deferred_upload
+{
+    struct wined3d_resource *resource;
+    struct wined3d_upload_region *region;
+};
+
+struct wined3d_deferred_map
+{
+    struct wined3d_resource *resource;
+    struct wined3d_upload_region *region;
+    BOOL discard;
+};
+
+/* A deferred context records packets into cs.data instead of executing them.
+ * Resources aren't acquired while recording, since a command list may be
+ * executed several times; they are acquired again for every execution.
+ * Allocation failures while recording are kept in "hr", and returned when the
+ * command list is recorded. */
+struct wined3d_deferred_context
+{
+    struct wined3d_cs cs;
+    HRESULT hr;
+
+    SIZE_T resources_size, resource_count;
+    struct wined3d_resource **resources;
+    SIZE_T uploads_size, upload_count;
+    struct wined3d_deferred_upload *uploads;
+    SIZE_T maps_size, map_count;
+    struct wined3d_deferred_map *maps;
+};
+
+struct wined3d_command_list
+{
+    LONG refcount;
+    struct wined3d_device *device;
+
+    SIZE_T data_size;
+    void *data;
+    SIZE_T resource_count;
+    struct wined3d_resource **resources;
+    SIZE_T upload_count;
+    struct wined3d_deferred_upload *uploads;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device) DECLSPEC_HIDDEN;
@@ -3862,6 +4013,7 @@ void wined3d_cs_emit_draw_indirect(struct wined3d_cs *cs, GLenum primitive_type,
         struct wined3d_buffer *buffer, unsigned int offset, BOOL indexed) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_flush(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_generate_mipmaps(struct wined3d_cs *cs, struct wined3d_shader_resource_view *view) DECLSPEC_HIDDEN;
+void wined3d_cs_emit_pending_draw(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_preload_resource(struct wined3d_cs *cs, struct wined3d_resource *resource) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *swapchain, const RECT *src_rect,
         const RECT *dst_rect, HWND dst_window_override, unsigned int swap_interval, DWORD flags) DECLSPEC_HIDDEN;
@@ -3926,9 +4078,23 @@ HRESULT wined3d_cs_map(struct wined3d_cs *cs, struct wined3d_resource *resource,
         struct wined3d_map_desc *map_desc, const struct wined3d_box *box, unsigned int flags) DECLSPEC_HIDDEN;
 HRESULT wined3d_cs_unmap(struct wined3d_cs *cs, struct wined3d_resource *resource,
         unsigned int sub_resource_idx) DECLSPEC_HIDDEN;
+BOOL wined3d_cs_map_upload_region(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc,
+        const struct wined3d_box *box, unsigned int flags) DECLSPEC_HIDDEN;
+BOOL wined3d_cs_unmap_upload_region(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx) DECLSPEC_HIDDEN;
+void wined3d_cs_release_upload_region(struct wined3d_cs *cs,
+        struct wined3d_upload_region *region) DECLSPEC_HIDDEN;
+void wined3d_cs_create_upload_ring(struct wined3d_cs *cs, struct wined3d_context *context) DECLSPEC_HIDDEN;
+void wined3d_cs_wait_init(struct wined3d_cs *cs, struct wined3d_cs_wait *wait) DECLSPEC_HIDDEN;
+void wined3d_cs_wait(struct wined3d_cs *cs, struct wined3d_cs_wait *wait) DECLSPEC_HIDDEN;
+void wined3d_cs_wait_done(struct wined3d_cs *cs, struct wined3d_cs_wait *wait) DECLSPEC_HIDDEN;
+void wined3d_cs_destroy_upload_ring(struct wined3d_cs *cs, struct wined3d_context *context) DECLSPEC_HIDDEN;
 
 static inline void wined3d_cs_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
+    if (cs->draw_pending)
+        wined3d_cs_emit_pending_draw(cs);
     cs->ops->finish(cs, queue_id);
 }
 
@@ -3940,13 +4106,18 @@ static inline void wined3d_cs_push_constants(struct wined3d_cs *cs, enum wined3d
 
 static inline void wined3d_resource_wait_idle(struct wined3d_resource *resource)
 {
-    const struct wined3d_cs *cs = resource->device->cs;
+    struct wined3d_cs *cs = resource->device->cs;
+    struct wined3d_cs_wait wait;
 
     if (!cs->thread || cs->thread_id == GetCurrentThreadId())
         return;
 
+    if (cs->draw_pending)
+        wined3d_cs_emit_pending_draw(cs);
+    wined3d_cs_wait_init(cs, &wait);
     while (InterlockedCompareExchange(&resource->access_count, 0, 0))
-        wined3d_pause();
+        wined3d_cs_wait(cs, &wait);
+    wined3d_cs_wait_done(cs, &wait);
 }
 
 /* TODO: Add tests and support for FLOAT16_4 POSITIONT, D3DCOLOR position, other
@@ -3983,6 +4154,12 @@ struct wined3d_buffer
     UINT stride;                                            /* 0 if no conversion */
     enum wined3d_buffer_conversion_type *conversion_map;    /* NULL if no conversion */
     UINT conversion_stride;                                 /* 0 if no shifted conversion */
+
+    /* Client side maps, only accessed from the application thread. */
+    struct wined3d_upload_region *upload_region;
+    unsigned int upload_map_count;
+    unsigned int upload_start, upload_end;
+    BOOL upload_discard;
 };
 
 static inline struct wined3d_buffer *buffer_from_resource(struct wined3d_resource *resource)
@@ -4002,6 +4179,9 @@ void wined3d_buffer_copy(struct wined3d_buffer *dst_buffer, unsigned int dst_off
         struct wined3d_buffer *src_buffer, unsigned int src_offset, unsigned int size) DECLSPEC_HIDDEN;
 void wined3d_buffer_upload_data(struct wined3d_buffer *buffer, struct wined3d_context *context,
         const struct wined3d_box *box, const void *data) DECLSPEC_HIDDEN;
+void wined3d_buffer_upload_region(struct wined3d_buffer *buffer, struct wined3d_context *context,
+        const struct wined3d_upload_region *region, unsigned int offset, unsigned int size,
+        BOOL discard) DECLSPEC_HIDDEN;
 
 struct wined3d_buffer_gl
 {
@@ -33,10 +33,17 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <limits.h>
 #ifdef HAVE_SYS_IPC_H
 # include <sys/ipc.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
 #ifdef HAVE_SYS_IOCTL_H
 # include <sys/ioctl.h>
 #endif
@@ -67,6 +74,9 @@
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_NETINET_IN_H
 # include <netinet/in.h>
 #endif
@@ -159,6 +169,9 @@
 #include "wine/exception.h"
 #include "wine/unicode.h"
 #include "wine/heap.h"
+#include "wine/list.h"
+#include "wine/rbtree.h"
+#include "wine/ws2_32.h"
 
 #if defined(linux) && !defined(IP_UNICAST_IF)
 #define IP_UNICAST_IF 50
@@ -243,6 +256,13 @@ static struct interface_filter generic_interface_filter = {
 #endif /* LINUX_BOUND_IF */
 
 extern ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags );
+extern int CDECL __wine_server_get_cached_fd( HANDLE handle, int *unix_fd );
+extern NTSTATUS CDECL __wine_uring_queue_msg( HANDLE handle, int unix_fd, BOOL is_read, const struct msghdr *msg,
+        int flags, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *iosb,
+        NTSTATUS (CDECL *callback)( void *arg, int error, ULONG *size, const struct msghdr *msg ), void *arg );
+#ifdef HAVE_RECVMMSG
+extern int CDECL __wine_locked_recvmmsg( int fd, struct mmsghdr *msgs, unsigned int count, int flags );
+#endif
 
 /*
  * The actual definition of WSASendTo, wrapped in a different function name
@@ -505,6 +525,11 @@ struct ws2_async
     DWORD                               flags;
     DWORD                              *lpFlags;
     WSABUF                             *control;
+    union generic_unix_sockaddr         unix_addr;  /* address of io_uring requests */
+    struct recv_batch                  *batch;      /* recv batch that the operation is queued on */
+    struct list                         entry;      /* entry in the recv batch queue */
+    BOOL                                batch_done; /* filled by another operation of the batch */
+    ULONG                               batch_len;  /* size received in that case */
     unsigned int                        n_iovecs;
     unsigned int                        first_iovec;
     struct iovec                        iovec[1];
@@ -529,6 +554,7 @@ struct ws2_transmitfile_async
     struct ws2_async_io   io;
     char                  *buffer;
     HANDLE                file;
+    int                   file_fd;  /* unix fd of the file for sendfile(), or -1 */
     DWORD                 file_read;
     DWORD                 file_bytes;
     DWORD                 bytes_per_send;
@@ -617,6 +643,21 @@ struct per_thread_data
     struct WS_protoent *pe_buffer;
     struct pollfd *fd_cache;
     unsigned int fd_count;
+    int epoll_fd;                        /* persistent epoll set for large selects */
+    struct wine_rb_tree poll_entries;    /* struct poll_entry, by socket handle */
+    unsigned int poll_entry_count;
+    unsigned int poll_generation;
+    unsigned int poll_serial;            /* last serial given to an epoll registration */
+    struct list poll_thread_entry;       /* entry in poll_threads, while epoll_fd is valid */
+    SOCKET *poll_stale;                  /* handles logged since the last call, protected by poll_cs */
+    unsigned int poll_stale_count;
+    unsigned int poll_stale_size;
+    unsigned int poll_stale_limit;       /* flush the whole set beyond this many handles */
+    BOOL poll_stale_overflow;
+    struct poll_entry **poll_refs;       /* entry for each socket of the current call */
+    unsigned int poll_refs_size;
+    void *poll_events;                   /* struct epoll_event array */
+    unsigned int poll_events_size;
     int he_len;
     int se_len;
     int pe_len;
@@ -1133,6 +1174,165 @@ static inline void release_sock_fd( SOCKET s, int fd )
     wine_server_release_fd( SOCKET2HANDLE(s), fd );
 }
 
+/* The server mirrors the state and event mask of sockets in a shared file, so
+ * that we don't need a server call to know whether a socket is blocking, or
+ * whether anybody selected for its events. Only the server writes to the file,
+ * we map it read-only.
+ *
+ * Entries are cached by handle. An entry is only used if its serial number is
+ * still the one the server gave us, and if it records the inode of the unix
+ * socket that the handle refers to now, so that neither reused entries nor
+ * reused handles return the state of another socket. */
+
+#define SHARED_CACHE_BLOCK_SIZE  4096
+#define SHARED_CACHE_ENTRIES     128
+#define SHARED_MAX_PAGES         1024
+
+static LONG64 *shared_cache[SHARED_CACHE_ENTRIES];  /* entry index, serial number << 32 */
+static void *shared_pages[SHARED_MAX_PAGES];
+static int shared_fd = -1;
+static BOOL shared_disabled;
+
+static CRITICAL_SECTION shared_cs;
+static CRITICAL_SECTION_DEBUG shared_cs_debug =
+{
+    0, 0, &shared_cs,
+    { &shared_cs_debug.ProcessLocksList, &shared_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": shared_cs") }
+};
+static CRITICAL_SECTION shared_cs = { &shared_cs_debug, -1, 0, 0, 0, 0 };
+
+static LONG64 *get_shared_cache_entry( SOCKET s, BOOL alloc )
+{
+    UINT_PTR idx = (s >> 2) - 1, entry = idx / SHARED_CACHE_BLOCK_SIZE;
+
+    if (!s || entry >= SHARED_CACHE_ENTRIES) return NULL;
+    if (!shared_cache[entry])
+    {
+        LONG64 *block;
+
+        if (!alloc) return NULL;
+        block = heap_alloc_zero( SHARED_CACHE_BLOCK_SIZE * sizeof(*block) );
+        if (!block) return NULL;
+        if (interlocked_cmpxchg_ptr( (void **)&shared_cache[entry], block, NULL ))
+            heap_free( block );
+    }
+    return &shared_cache[entry][idx % SHARED_CACHE_BLOCK_SIZE];
+}
+
+static void set_shared_cache_entry( LONG64 *cache, LONG64 data )
+{
+    LONG64 old;
+
+    do old = *cache;
+    while (interlocked_cmpxchg64( cache, data, old ) != old);
+}
+
+static void reset_sock_shared( SOCKET s )
+{
+    LONG64 *cache = get_shared_cache_entry( s, FALSE );
+    if (cache) set_shared_cache_entry( cache, 0 );
+}
+
+static volatile struct socket_shared_state *map_sock_shared( unsigned int index )
+{
+    static long pagesize;
+    unsigned int page;
+
+    if (!pagesize) pagesize = sysconf( _SC_PAGESIZE );
+    page = index / (pagesize / sizeof(struct socket_shared_state));
+    if (page >= SHARED_MAX_PAGES) return NULL;
+
+    if (!shared_pages[page])
+    {
+        void *ptr = mmap( NULL, pagesize, PROT_READ, MAP_SHARED, shared_fd, (off_t)page * pagesize );
+        if (ptr == MAP_FAILED) return NULL;
+        if (interlocked_cmpxchg_ptr( &shared_pages[page], ptr, NULL ))
+            munmap( ptr, pagesize );
+    }
+    return (struct socket_shared_state *)shared_pages[page] + index % (pagesize / sizeof(struct socket_shared_state));
+}
+
+static LONG64 query_sock_shared( SOCKET s )
+{
+    unsigned int index = 0, serial = 0;
+    HANDLE file = 0;
+    LONG64 *cache;
+    NTSTATUS status;
+    int fd;
+
+    EnterCriticalSection( &shared_cs );
+
+    SERVER_START_REQ( get_socket_shared_state )
+    {
+        req->handle    = wine_server_obj_handle( SOCKET2HANDLE(s) );
+        req->need_file = (shared_fd == -1);
+        if (!(status = wine_server_call( req )))
+        {
+            index  = reply->index;
+            serial = reply->serial;
+            file   = wine_server_ptr_handle( reply->file );
+        }
+    }
+    SERVER_END_REQ;
+
+    if (file)
+    {
+        if (!wine_server_handle_to_fd( file, FILE_READ_DATA, &fd, NULL ))
+        {
+            shared_fd = dup( fd );
+            wine_server_release_fd( file, fd );
+        }
+        CloseHandle( file );
+    }
+
+    if (status == STATUS_INVALID_HANDLE || status == STATUS_OBJECT_TYPE_MISMATCH) index = 0;
+    else if (status || shared_fd == -1)
+    {
+        WARN( "shared socket state not available, status %#x\n", status );
+        shared_disabled = TRUE;
+        index = 0;
+    }
+
+    LeaveCriticalSection( &shared_cs );
+
+    if (!index || !(cache = get_shared_cache_entry( s, TRUE ))) return 0;
+    set_shared_cache_entry( cache, index | ((LONG64)serial << 32) );
+    return index | ((LONG64)serial << 32);
+}
+
+static BOOL is_sock_shared_valid( volatile struct socket_shared_state *shared, LONG64 data, ino_t inode )
+{
+    return shared->serial == (unsigned int)(data >> 32) && shared->inode == inode;
+}
+
+/* get the shared state of a socket; NULL means we need to ask the server */
+static volatile struct socket_shared_state *get_sock_shared( SOCKET s )
+{
+    volatile struct socket_shared_state *shared = NULL;
+    LONG64 *cache, data = 0;
+    struct stat st;
+    int fd, ret;
+
+    if (shared_disabled) return NULL;
+
+    /* cached fds are dropped when their handle is closed, so this is the socket
+     * that the handle refers to now */
+    if ((fd = get_sock_fd( s, 0, NULL )) == -1) return NULL;
+    ret = fstat( fd, &st );
+    release_sock_fd( s, fd );
+    if (ret == -1) return NULL;
+
+    if ((cache = get_shared_cache_entry( s, FALSE ))) data = interlocked_cmpxchg64( cache, 0, 0 );
+    if (data && (shared = map_sock_shared( (unsigned int)data )) &&
+        is_sock_shared_valid( shared, data, st.st_ino ))
+        return shared;
+
+    /* the entry is stale, or the handle was reused without us noticing */
+    if (!(data = query_sock_shared( s )) || !(shared = map_sock_shared( (unsigned int)data ))) return NULL;
+    return is_sock_shared_valid( shared, data, st.st_ino ) ? shared : NULL;
+}
+
 static void _enable_event( HANDLE s, unsigned int event,
                            unsigned int sstate, unsigned int cstate )
 {
@@ -1149,7 +1349,15 @@ static void _enable_event( HANDLE s, unsigned int event,
 
 static DWORD sock_is_blocking(SOCKET s, BOOL *ret)
 {
+    volatile struct socket_shared_state *shared;
     DWORD err;
+
+    if ((shared = get_sock_shared( s )))
+    {
+        *ret = (shared->state & FD_WINE_NONBLOCKING) == 0;
+        return 0;
+    }
+
     SERVER_START_REQ( get_socket_event )
     {
         req->handle  = wine_server_obj_handle( SOCKET2HANDLE(s) );
@@ -1164,7 +1372,11 @@ static DWORD sock_is_blocking(SOCKET s, BOOL *ret)
 
 static unsigned int _get_sock_mask(SOCKET s)
 {
+    volatile struct socket_shared_state *shared;
     unsigned int ret;
+
+    if ((shared = get_sock_shared( s ))) return shared->mask;
+
     SERVER_START_REQ( get_socket_event )
     {
         req->handle  = wine_server_obj_handle( SOCKET2HANDLE(s) );
@@ -1179,10 +1391,16 @@ static unsigned int _get_sock_mask(SOCKET s)
 
 static void _sync_sock_state(SOCKET s)
 {
-    BOOL dummy;
     /* do a dummy wineserver request in order to let
        the wineserver run through its select loop once */
-    sock_is_blocking(s, &dummy);
+    SERVER_START_REQ( get_socket_event )
+    {
+        req->handle  = wine_server_obj_handle( SOCKET2HANDLE(s) );
+        req->service = FALSE;
+        req->c_event = 0;
+        wine_server_call( req );
+    }
+    SERVER_END_REQ;
 }
 
 static void _get_sock_errors(SOCKET s, int *events)
@@ -1315,6 +1533,108 @@ static BOOL get_dont_fragment(SOCKET s, int level, BOOL *out)
     return value;
 }
 
+/* Large select() and WSAPoll() calls are serviced from a persistent per-thread
+ * epoll set, keyed by socket handle, so that calling them repeatedly on mostly
+ * the same sockets neither duplicates every unix fd nor makes the kernel scan
+ * every socket. Sockets which are created or closed are logged to every thread
+ * with an epoll set, which drops entries whose handle may have been reused
+ * on its next call. A thread which falls further behind than the size of its
+ * set just flushes the set, so the cost stays proportional to the changes.
+ *
+ * The entries use the fd from the ntdll fd cache and don't own it, so closing
+ * the handle in any thread closes the unix socket, and the kernel drops it
+ * from every epoll set. Since that fd number may then be reused, we only pass
+ * it to epoll_ctl() while the handle still refers to it. Registrations which
+ * we couldn't remove are recognized by their serial number when they report
+ * events, and are removed by recreating the epoll set. */
+
+#define POLL_EPOLL_THRESHOLD  32
+#define POLL_STALE_MIN_LIMIT  256
+
+/* poll_entry flags */
+#define POLL_SELECT_READ      0x1
+#define POLL_SELECT_WRITE     0x2
+#define POLL_SELECT_EXCEPT    0x4
+#define POLL_WSAPOLL          0x8
+
+struct poll_entry
+{
+    struct wine_rb_entry entry;
+    SOCKET               socket;
+    int                  fd;          /* cached unix fd of the handle, not owned */
+    int                  type;        /* unix socket type */
+    BOOL                 bound;       /* known to be bound */
+    BOOL                 registered;  /* present in the epoll set */
+    unsigned int         events;      /* events registered in the epoll set */
+    unsigned int         serial;      /* serial number of the registration */
+    unsigned int         generation;  /* call which last used the entry */
+    unsigned int         wanted;      /* events wanted by that call */
+    unsigned int         flags;       /* POLL_* flags for that call */
+    unsigned int         revents;     /* events returned to that call */
+};
+
+static struct list poll_threads = LIST_INIT( poll_threads );
+
+static CRITICAL_SECTION poll_cs;
+static CRITICAL_SECTION_DEBUG poll_cs_debug =
+{
+    0, 0, &poll_cs,
+    { &poll_cs_debug.ProcessLocksList, &poll_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": poll_cs") }
+};
+static CRITICAL_SECTION poll_cs = { &poll_cs_debug, -1, 0, 0, 0, 0 };
+
+static int poll_entry_compare( const void *key, const struct wine_rb_entry *entry )
+{
+    SOCKET s = *(const SOCKET *)key;
+    const struct poll_entry *poll_entry = WINE_RB_ENTRY_VALUE( entry, const struct poll_entry, entry );
+
+    return (s > poll_entry->socket) - (s < poll_entry->socket);
+}
+
+static void free_poll_entry( struct wine_rb_entry *entry, void *context )
+{
+    struct poll_entry *poll_entry = WINE_RB_ENTRY_VALUE( entry, struct poll_entry, entry );
+
+    HeapFree( GetProcessHeap(), 0, poll_entry );
+}
+
+/* record that a handle now refers to a different socket */
+static void poll_log_socket( SOCKET s )
+{
+    struct per_thread_data *ptb;
+    unsigned int size;
+    SOCKET *stale;
+
+    EnterCriticalSection( &poll_cs );
+    LIST_FOR_EACH_ENTRY( ptb, &poll_threads, struct per_thread_data, poll_thread_entry )
+    {
+        if (ptb->poll_stale_overflow) continue;
+        if (ptb->poll_stale_count >= ptb->poll_stale_limit)
+        {
+            ptb->poll_stale_overflow = TRUE;
+            continue;
+        }
+        if (ptb->poll_stale_count == ptb->poll_stale_size)
+        {
+            size = max( ptb->poll_stale_size * 2, 16 );
+            if (ptb->poll_stale)
+                stale = HeapReAlloc( GetProcessHeap(), 0, ptb->poll_stale, size * sizeof(*stale) );
+            else
+                stale = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*stale) );
+            if (!stale)
+            {
+                ptb->poll_stale_overflow = TRUE;
+                continue;
+            }
+            ptb->poll_stale = stale;
+            ptb->poll_stale_size = size;
+        }
+        ptb->poll_stale[ptb->poll_stale_count++] = s;
+    }
+    LeaveCriticalSection( &poll_cs );
+}
+
 static struct per_thread_data *get_per_thread_data(void)
 {
     struct per_thread_data * ptb = NtCurrentTeb()->WinSockData;
@@ -1322,6 +1642,8 @@ static struct per_thread_data *get_per_thread_data(void)
     if (!ptb)
     {
         ptb = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*ptb) );
+        ptb->epoll_fd = -1;
+        wine_rb_init( &ptb->poll_entries, poll_entry_compare );
         NtCurrentTeb()->WinSockData = ptb;
     }
     return ptb;
@@ -1338,6 +1660,18 @@ static void free_per_thread_data(void)
     HeapFree( GetProcessHeap(), 0, ptb->se_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->pe_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->fd_cache );
+    HeapFree( GetProcessHeap(), 0, ptb->poll_refs );
+    HeapFree( GetProcessHeap(), 0, ptb->poll_events );
+
+    if (ptb->epoll_fd >= 0)
+    {
+        EnterCriticalSection( &poll_cs );
+        list_remove( &ptb->poll_thread_entry );
+        LeaveCriticalSection( &poll_cs );
+        close( ptb->epoll_fd );
+    }
+    HeapFree( GetProcessHeap(), 0, ptb->poll_stale );
+    wine_rb_destroy( &ptb->poll_entries, free_poll_entry, NULL );
 
     HeapFree( GetProcessHeap(), 0, ptb );
     NtCurrentTeb()->WinSockData = NULL;
@@ -2478,6 +2812,344 @@ static NTSTATUS WS2_async_recv( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS stat
     return status;
 }
 
+/* Overlapped datagram receives without flags, control buffer or completion
+ * routine are batched. Each of them is registered with the server as usual,
+ * and also queued on the socket's batch in the same order. When the server
+ * wakes up one of them, we fill it and the following ones with a single
+ * recvmmsg() call. The server still considers the others pending, so we wake
+ * them up by cancelling them; their handler then reports the data that they
+ * already received, which also takes precedence over a real cancellation. */
+
+#define RECV_BATCH_MAX 16
+
+struct recv_batch
+{
+    struct wine_rb_entry entry;
+    SOCKET               socket;
+    BOOL                 closed;  /* removed from the tree by closesocket() */
+    struct list          queue;   /* pending operations, in the order they were registered */
+};
+
+static int recv_batch_compare( const void *key, const struct wine_rb_entry *entry )
+{
+    SOCKET s = *(const SOCKET *)key;
+    SOCKET other = WINE_RB_ENTRY_VALUE( entry, const struct recv_batch, entry )->socket;
+
+    if (s < other) return -1;
+    return s > other;
+}
+
+static struct wine_rb_tree recv_batches = { recv_batch_compare };
+
+static CRITICAL_SECTION recv_batch_cs;
+static CRITICAL_SECTION_DEBUG recv_batch_cs_debug =
+{
+    0, 0, &recv_batch_cs,
+    { &recv_batch_cs_debug.ProcessLocksList, &recv_batch_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": recv_batch_cs") }
+};
+static CRITICAL_SECTION recv_batch_cs = { &recv_batch_cs_debug, -1, 0, 0, 0, 0 };
+
+static struct recv_batch *get_recv_batch( SOCKET s )
+{
+    struct wine_rb_entry *entry = wine_rb_get( &recv_batches, &s );
+    return entry ? WINE_RB_ENTRY_VALUE( entry, struct recv_batch, entry ) : NULL;
+}
+
+/***********************************************************************
+ *              WS2_recv_batch          (INTERNAL)
+ *
+ * Receive up to count datagrams, returning the number of datagrams received
+ * and their sizes in lens.
+ */
+static int WS2_recv_batch( int fd, struct ws2_async **ops, unsigned int count, unsigned int *lens )
+{
+    int n;
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr msgs[RECV_BATCH_MAX];
+    union generic_unix_sockaddr addrs[RECV_BATCH_MAX];
+    unsigned int i;
+
+    for (i = 0; i < count; i++)
+    {
+        struct msghdr *hdr = &msgs[i].msg_hdr;
+
+        hdr->msg_name       = ops[i]->addr ? &addrs[i] : NULL;
+        hdr->msg_namelen    = ops[i]->addr ? sizeof(addrs[i]) : 0;
+        hdr->msg_iov        = ops[i]->iovec + ops[i]->first_iovec;
+        hdr->msg_iovlen     = ops[i]->n_iovecs - ops[i]->first_iovec;
+        hdr->msg_control    = NULL;
+        hdr->msg_controllen = 0;
+        hdr->msg_flags      = 0;
+    }
+
+    while ((n = __wine_locked_recvmmsg( fd, msgs, count, 0 )) == -1)
+    {
+        if (errno != EINTR) break;
+    }
+
+    if (n != -1 || errno != ENOSYS)
+    {
+        for (i = 0; n > 0 && i < n; i++)
+        {
+            /* see WS2_recv() for why msg_namelen may be zero */
+            if (ops[i]->addr && msgs[i].msg_hdr.msg_namelen)
+                ws_sockaddr_u2ws( &addrs[i].addr, ops[i]->addr, ops[i]->addrlen.ptr );
+            lens[i] = msgs[i].msg_len;
+        }
+        return n;
+    }
+#endif
+
+    for (n = 0; n < count; n++)
+    {
+        int ret = WS2_recv( fd, ops[n], 0 );
+        if (ret == -1) return n ? n : -1;
+        lens[n] = ret;
+    }
+    return n;
+}
+
+/* remove a completed operation from its batch */
+static void remove_recv_batch_op( struct ws2_async *wsa )
+{
+    struct recv_batch *batch = wsa->batch;
+
+    list_remove( &wsa->entry );
+    wsa->batch = NULL;
+    if (!list_empty( &batch->queue )) return;
+    if (!batch->closed) wine_rb_remove( &recv_batches, &batch->entry );
+    HeapFree( GetProcessHeap(), 0, batch );
+}
+
+/* wake up an operation that we already completed, so that the server reports it */
+static void wake_recv_batch_op( HANDLE handle, IO_STATUS_BLOCK *iosb )
+{
+    SERVER_START_REQ( cancel_async )
+    {
+        req->handle      = wine_server_obj_handle( handle );
+        req->iosb        = wine_server_client_ptr( iosb );
+        req->only_thread = FALSE;
+        wine_server_call( req );
+    }
+    SERVER_END_REQ;
+}
+
+/***********************************************************************
+ *              WS2_async_recv_batch    (INTERNAL)
+ *
+ * Handler for batched overlapped recv() operations.
+ */
+static NTSTATUS WS2_async_recv_batch( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS status )
+{
+    struct ws2_async *wsa = user, *ops[RECV_BATCH_MAX], *next;
+    IO_STATUS_BLOCK *woken[RECV_BATCH_MAX];
+    struct list *ptr;
+    unsigned int lens[RECV_BATCH_MAX], count = 1, i;
+    ULONG result = 0;
+    int n = 0, fd;
+
+    EnterCriticalSection( &recv_batch_cs );
+
+    if (wsa->batch_done)
+    {
+        /* filled by another operation of the batch */
+        status = STATUS_SUCCESS;
+        result = wsa->batch_len;
+    }
+    else if (status == STATUS_ALERTED && !(status = wine_server_handle_to_fd( wsa->hSocket, FILE_READ_DATA, &fd, NULL )))
+    {
+        ops[0] = wsa;
+        for (ptr = list_next( &wsa->batch->queue, &wsa->entry ); ptr && count < RECV_BATCH_MAX;
+             ptr = list_next( &wsa->batch->queue, ptr ))
+        {
+            next = LIST_ENTRY( ptr, struct ws2_async, entry );
+            if (!next->batch_done) ops[count++] = next;
+        }
+
+        n = WS2_recv_batch( fd, ops, count, lens );
+        wine_server_release_fd( wsa->hSocket, fd );
+        if (n > 0)
+        {
+            TRACE( "socket %p: received %d datagrams\n", wsa->hSocket, n );
+            for (i = 1; i < n; i++)
+            {
+                ops[i]->batch_done = TRUE;
+                ops[i]->batch_len  = lens[i];
+                woken[i] = (IO_STATUS_BLOCK *)ops[i]->user_overlapped;
+            }
+            status = STATUS_SUCCESS;
+            result = lens[0];
+            _enable_event( wsa->hSocket, FD_READ, 0, 0 );
+        }
+        else if (errno == EAGAIN)
+        {
+            status = STATUS_PENDING;
+            _enable_event( wsa->hSocket, FD_READ, 0, 0 );
+        }
+        else
+            status = wsaErrStatus();
+    }
+
+    if (status != STATUS_PENDING) remove_recv_batch_op( wsa );
+
+    LeaveCriticalSection( &recv_batch_cs );
+
+    for (i = 1; i < n; i++) wake_recv_batch_op( wsa->hSocket, woken[i] );
+
+    if (status != STATUS_PENDING)
+    {
+        iosb->u.Status = status;
+        iosb->Information = result;
+        release_async_io( &wsa->io );
+    }
+    return status;
+}
+
+/* Add an operation to the batch of its socket and register it with the server.
+ * With pending_only, only do it if other operations are already pending, which
+ * it mustn't receive before; returns STATUS_NOT_FOUND otherwise. */
+static NTSTATUS queue_recv_batch( SOCKET s, struct ws2_async *wsa, BOOL pending_only )
+{
+    LPWSAOVERLAPPED ovl = wsa->user_overlapped;
+    IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)ovl;
+    ULONG_PTR cvalue = ((ULONG_PTR)ovl->hEvent & 1) == 0 ? (ULONG_PTR)ovl : 0;
+    struct recv_batch *batch;
+    NTSTATUS status;
+
+    EnterCriticalSection( &recv_batch_cs );
+    if (!(batch = get_recv_batch( s )))
+    {
+        if (pending_only)
+        {
+            LeaveCriticalSection( &recv_batch_cs );
+            return STATUS_NOT_FOUND;
+        }
+        if ((batch = HeapAlloc( GetProcessHeap(), 0, sizeof(*batch) )))
+        {
+            batch->socket = s;
+            batch->closed = FALSE;
+            list_init( &batch->queue );
+            wine_rb_put( &recv_batches, &s, &batch->entry );
+        }
+    }
+
+    iosb->u.Status = STATUS_PENDING;
+    iosb->Information = 0;
+    wsa->batch = batch;
+    wsa->batch_done = FALSE;
+    if (batch)
+    {
+        wsa->io.callback = WS2_async_recv_batch;
+        list_add_tail( &batch->queue, &wsa->entry );
+    }
+
+    /* keep the lock, so that the queue has the order of the server's queue */
+    status = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, ovl->hEvent,
+                             NULL, (void *)cvalue, iosb );
+    if (status != STATUS_PENDING && batch) remove_recv_batch_op( wsa );
+    LeaveCriticalSection( &recv_batch_cs );
+    return status;
+}
+
+/* Detach the batch of a socket that is being closed, so that a new socket
+ * reusing its handle doesn't join it. The server cancels its operations. */
+static void close_recv_batch( SOCKET s )
+{
+    struct recv_batch *batch;
+
+    EnterCriticalSection( &recv_batch_cs );
+    if ((batch = get_recv_batch( s )))
+    {
+        wine_rb_remove( &recv_batches, &batch->entry );
+        batch->closed = TRUE;
+    }
+    LeaveCriticalSection( &recv_batch_cs );
+}
+
+/***********************************************************************
+ *              WS2_recv_batch_ioctl    (INTERNAL)
+ *
+ * Implementation of SIO_WINE_RECV_BATCH.
+ */
+static DWORD WS2_recv_batch_ioctl( SOCKET s, int fd, WINE_RECV_BATCH_ENTRY *entries, unsigned int count,
+                                   DWORD *total )
+{
+    struct ws2_async ops_buf[RECV_BATCH_MAX], *ops[RECV_BATCH_MAX];
+    unsigned int lens[RECV_BATCH_MAX], done = 0, chunk, i;
+    DWORD timeout_start = GetTickCount();
+    BOOL is_blocking;
+    DWORD err;
+    int n;
+
+    for (i = 0; i < count; i++)
+    {
+        /* check buffer first to trigger write watches */
+        if (IsBadWritePtr( entries[i].buf.buf, entries[i].buf.len ))
+            return WSAEFAULT;
+    }
+
+    while (done < count)
+    {
+        chunk = min( count - done, RECV_BATCH_MAX );
+        for (i = 0; i < chunk; i++)
+        {
+            WINE_RECV_BATCH_ENTRY *entry = &entries[done + i];
+
+            ops[i] = &ops_buf[i];
+            ops[i]->addr                = entry->from;
+            ops[i]->addrlen.ptr         = &entry->fromlen;
+            ops[i]->control             = NULL;
+            ops[i]->n_iovecs            = 1;
+            ops[i]->first_iovec         = 0;
+            ops[i]->iovec[0].iov_base   = entry->buf.buf;
+            ops[i]->iovec[0].iov_len    = entry->buf.len;
+        }
+
+        if ((n = WS2_recv_batch( fd, ops, chunk, lens )) == -1)
+        {
+            struct pollfd pfd;
+            int poll_timeout = -1;
+            INT64 timeout;
+
+            if (errno != EAGAIN) return wsaErrno();
+            if (done) break;
+
+            if ((err = sock_is_blocking( s, &is_blocking ))) return err;
+            if (!is_blocking)
+            {
+                _enable_event( SOCKET2HANDLE(s), FD_READ, 0, 0 );
+                return WSAEWOULDBLOCK;
+            }
+
+            if ((timeout = get_rcvsnd_timeo( fd, TRUE )))
+            {
+                timeout -= GetTickCount() - timeout_start;
+                if (timeout < 0) poll_timeout = 0;
+                else poll_timeout = timeout <= INT_MAX ? timeout : INT_MAX;
+            }
+
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            if (!poll_timeout || !poll( &pfd, 1, poll_timeout ))
+            {
+                _enable_event( SOCKET2HANDLE(s), FD_READ, 0, 0 );
+                return WSAETIMEDOUT;
+            }
+            continue;
+        }
+
+        for (i = 0; i < n; i++) entries[done + i].len = lens[i];
+        done += n;
+        if (n < chunk) break;
+    }
+
+    TRACE( "socket %04lx: received %u datagrams\n", s, done );
+    _enable_event( SOCKET2HANDLE(s), FD_READ, 0, 0 );
+    *total = done;
+    return 0;
+}
+
 /***********************************************************************
  *              WS2_async_accept_recv            (INTERNAL)
  *
@@ -2734,6 +3406,89 @@ static NTSTATUS WS2_async_shutdown( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS
     return status;
 }
 
+/***********************************************************************
+ *              WS2_uring_send_done     (INTERNAL)
+ *
+ * Called from the io_uring reaper thread of ntdll when an overlapped
+ * operation queued with WS2_uring_queue() is done.
+ */
+static NTSTATUS CDECL WS2_uring_send_done( void *arg, int error, ULONG *size, const struct msghdr *msg )
+{
+    struct ws2_async *wsa = arg;
+    IO_STATUS_BLOCK *iosb = wsa->user_overlapped ? (IO_STATUS_BLOCK *)wsa->user_overlapped : &wsa->local_iosb;
+    NTSTATUS status = STATUS_SUCCESS;
+
+    if (error == ECANCELED)
+        status = STATUS_CANCELLED;
+    else if (error)
+    {
+        errno = error;
+        status = wsaErrStatus();
+    }
+
+    /* add what was sent before the operation was queued */
+    *size += iosb->Information;
+    if (!wsa->completion_func) release_async_io( &wsa->io );
+    return status;
+}
+
+/***********************************************************************
+ *              WS2_uring_recv_done     (INTERNAL)
+ */
+static NTSTATUS CDECL WS2_uring_recv_done( void *arg, int error, ULONG *size, const struct msghdr *msg )
+{
+    struct ws2_async *wsa = arg;
+
+    if (!error)
+    {
+        if (wsa->addr && msg->msg_namelen)
+            ws_sockaddr_u2ws( &wsa->unix_addr.addr, wsa->addr, wsa->addrlen.ptr );
+        _enable_event( wsa->hSocket, FD_READ, 0, 0 );
+    }
+    return WS2_uring_send_done( arg, error, size, msg );
+}
+
+/***********************************************************************
+ *              WS2_uring_queue         (INTERNAL)
+ *
+ * Queue an overlapped operation that would block on the io_uring backend of
+ * ntdll, which submits the transfer to the kernel directly. Returns
+ * STATUS_NOT_IMPLEMENTED if the operation should be registered with the server.
+ */
+static NTSTATUS WS2_uring_queue( int fd, struct ws2_async *wsa, BOOL is_read, int flags,
+                                 HANDLE event, PIO_APC_ROUTINE apc, void *apc_context, IO_STATUS_BLOCK *iosb )
+{
+    struct msghdr hdr, *msg = &hdr;
+
+    memset( &hdr, 0, sizeof(hdr) );
+    if (wsa->control || (flags & MSG_OOB))
+        msg = NULL;
+    else if (wsa->addr && is_read)
+    {
+        hdr.msg_name = &wsa->unix_addr;
+        hdr.msg_namelen = sizeof(wsa->unix_addr);
+    }
+    else if (wsa->addr)
+    {
+        socklen_t len = sizeof(int);
+        int type;
+
+        /* connected sockets may refuse the address, WS2_send() deals with that */
+        if (getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &len ) || type != SOCK_DGRAM ||
+            wsa->addr->sa_family == WS_AF_IPX ||
+            !(hdr.msg_namelen = ws_sockaddr_ws2u( wsa->addr, wsa->addrlen.val, &wsa->unix_addr )))
+            msg = NULL;
+        else
+            hdr.msg_name = &wsa->unix_addr;
+    }
+    hdr.msg_iov = wsa->iovec + wsa->first_iovec;
+    hdr.msg_iovlen = wsa->n_iovecs - wsa->first_iovec;
+
+    /* a NULL msg makes ntdll send this and the following requests on the socket to the server */
+    return __wine_uring_queue_msg( wsa->hSocket, fd, is_read, msg, flags, event, apc, apc_context, iosb,
+                                   is_read ? WS2_uring_recv_done : WS2_uring_send_done, wsa );
+}
+
 /***********************************************************************
  *  WS2_register_async_shutdown         (INTERNAL)
  *
@@ -2791,6 +3546,8 @@ SOCKET WINAPI WS_accept(SOCKET s, struct WS_sockaddr *addr, int *addrlen32)
         SERVER_END_REQ;
         if (!err)
         {
+            reset_sock_shared(as);
+            poll_log_socket(as);
             if (addr && addrlen32 && WS_getpeername(as, addr, addrlen32))
             {
                 WS_closesocket(as);
@@ -2987,6 +3744,13 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
     }
 
     /* process the main file */
+    if (wsa->file && wsa->file_fd != -1)
+    {
+        /* no buffer, the file is sent directly by WS2_transmitfile_sendfile() */
+        wsa->write.first_iovec = 0;
+        wsa->write.n_iovecs    = 0;
+        return STATUS_PENDING;
+    }
     if (wsa->file)
     {
         DWORD bytes_per_send = wsa->bytes_per_send;
@@ -3036,6 +3800,52 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
     return STATUS_SUCCESS;
 }
 
+/***********************************************************************
+ *     WS2_transmitfile_sendfile        (INTERNAL)
+ *
+ * Send the next chunk of the main file directly from the page cache.
+ * Returns -1 with errno set on failure, 0 at the end of the file.
+ */
+static int WS2_transmitfile_sendfile( int fd, struct ws2_transmitfile_async *wsa )
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    DWORD bytes_per_send = wsa->bytes_per_send;
+    off_t offset;
+    int n;
+
+    if (wsa->file_bytes != 0)
+        bytes_per_send = min(bytes_per_send, wsa->file_bytes - wsa->file_read);
+
+    do
+    {
+        if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+        {
+            offset = wsa->offset.QuadPart;
+            n = sendfile( fd, wsa->file_fd, &offset, bytes_per_send );
+        }
+        else
+            n = sendfile( fd, wsa->file_fd, NULL, bytes_per_send );
+    }
+    while (n == -1 && errno == EINTR);
+
+    if (n > 0)
+    {
+        if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+            wsa->offset.QuadPart += n;
+        wsa->file_read += n;
+        if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
+            wsa->file = NULL;
+    }
+    else if (!n)
+        wsa->file = NULL; /* continue on to the footer */
+
+    return n;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
 /***********************************************************************
  *     WS2_transmitfile_base            (INTERNAL)
  *
@@ -3043,24 +3853,52 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
  */
 static NTSTATUS WS2_transmitfile_base( int fd, struct ws2_transmitfile_async *wsa )
 {
+    IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
     NTSTATUS status;
+    int n;
 
-    status = WS2_transmitfile_getbuffer( fd, wsa );
-    if (status == STATUS_PENDING)
+    for (;;)
     {
-        IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
-        int n;
+        status = WS2_transmitfile_getbuffer( fd, wsa );
+        if (status != STATUS_PENDING) return status;
+
+        if (!wsa->write.n_iovecs)
+        {
+            if ((n = WS2_transmitfile_sendfile( fd, wsa )) >= 0)
+            {
+                /* keep going until the socket buffer is full or the file is done */
+                if (iosb) iosb->Information += n;
+                continue;
+            }
+            if (errno == EINVAL || errno == ENOSYS)
+            {
+                /* not supported for this file, fall back to reading into our buffer */
+                TRACE("sendfile() not supported, falling back to read()\n");
+                close( wsa->file_fd );
+                wsa->file_fd = -1;
+                continue;
+            }
+        }
+        else
+            n = WS2_send( fd, &wsa->write, convert_flags(wsa->write.flags) );
 
-        n = WS2_send( fd, &wsa->write, convert_flags(wsa->write.flags) );
         if (n >= 0)
         {
             if (iosb) iosb->Information += n;
         }
         else if (errno != EAGAIN)
             return wsaErrStatus();
+        return STATUS_PENDING;
     }
+}
 
-    return status;
+/***********************************************************************
+ *     WS2_transmitfile_free            (INTERNAL)
+ */
+static void WS2_transmitfile_free( struct ws2_transmitfile_async *wsa )
+{
+    if (wsa->file_fd != -1) close( wsa->file_fd );
+    HeapFree( GetProcessHeap(), 0, wsa );
 }
 
 /***********************************************************************
@@ -3085,6 +3923,7 @@ static NTSTATUS WS2_async_transmitfile( void *user, IO_STATUS_BLOCK *iosb, NTSTA
     }
 
     iosb->u.Status = status;
+    if (wsa->file_fd != -1) close( wsa->file_fd );
     release_async_io( &wsa->io );
     return status;
 }
@@ -3145,6 +3984,7 @@ static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD
         memset(&wsa->buffers, 0x0, sizeof(wsa->buffers));
     wsa->buffer                = (char *)(wsa + 1);
     wsa->file                  = h;
+    wsa->file_fd               = -1;
     wsa->file_read             = 0;
     wsa->file_bytes            = file_bytes;
     wsa->bytes_per_send        = bytes_per_send;
@@ -3159,6 +3999,12 @@ static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD
     wsa->write.n_iovecs        = 0;
     wsa->write.first_iovec     = 0;
     wsa->write.user_overlapped = overlapped;
+#ifdef HAVE_SYS_SENDFILE_H
+    /* let the kernel copy the file straight to the socket; we fall back to a
+     * buffered copy if it refuses */
+    if (h && wine_server_handle_to_fd( h, FILE_READ_DATA, &wsa->file_fd, NULL ))
+        wsa->file_fd = -1;
+#endif
     if (overlapped)
     {
         IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)overlapped;
@@ -3170,7 +4016,7 @@ static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD
         iosb->Information = 0;
         status = register_async( ASYNC_TYPE_WRITE, SOCKET2HANDLE(s), &wsa->io,
                                  overlapped->hEvent, NULL, NULL, iosb );
-        if(status != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
+        if(status != STATUS_PENDING) WS2_transmitfile_free( wsa );
         release_sock_fd( s, fd );
         WSASetLastError( NtStatusToWSAError(status) );
         return FALSE;
@@ -3191,7 +4037,7 @@ static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD
 
     if (status != STATUS_SUCCESS)
         WSASetLastError( NtStatusToWSAError(status) );
-    HeapFree( GetProcessHeap(), 0, wsa );
+    WS2_transmitfile_free( wsa );
     return (status == STATUS_SUCCESS);
 }
 
@@ -3426,6 +4272,9 @@ int WINAPI WS_closesocket(SOCKET s)
         if (fd >= 0)
         {
             release_sock_fd(s, fd);
+            reset_sock_shared(s);
+            poll_log_socket(s);
+            close_recv_batch(s);
             if (CloseHandle(SOCKET2HANDLE(s)))
                 res = 0;
         }
@@ -4519,6 +5368,7 @@ static const char *debugstr_wsaioctl(DWORD code)
         IOCTL_NAME(WS_SIO_SET_QOS);
         IOCTL_NAME(WS_SIO_TRANSLATE_HANDLE);
         IOCTL_NAME(WS_SIO_UDP_CONNRESET);
+        IOCTL_NAME(WS_SIO_WINE_RECV_BATCH);
     }
 #undef IOCTL_NAME
 
@@ -5068,6 +5918,16 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
    case WS_SIO_UDP_CONNRESET:
        FIXME("WS_SIO_UDP_CONNRESET stub\n");
        break;
+    case WS_SIO_WINE_RECV_BATCH:
+        if (!in_buff || !in_size || in_size % sizeof(WINE_RECV_BATCH_ENTRY))
+        {
+            SetLastError(WSAEFAULT);
+            return SOCKET_ERROR;
+        }
+        if ((fd = get_sock_fd( s, FILE_READ_DATA, NULL )) == -1) return SOCKET_ERROR;
+        status = WS2_recv_batch_ioctl( s, fd, in_buff, in_size / sizeof(WINE_RECV_BATCH_ENTRY), &total );
+        release_sock_fd( s, fd );
+        break;
     case 0x667e: /* Netscape tries hard to use bogus ioctl 0x667e */
         SetLastError(WSAEOPNOTSUPP);
         return SOCKET_ERROR;
@@ -5273,82 +6133,421 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
                 int oob_inlined = 0;
                 socklen_t olen = sizeof(oob_inlined);
 
-                fds[j].events = POLLHUP;
+                fds[j].events = POLLHUP;
+
+                /* Check if we need to test for urgent data or not */
+                getsockopt(fds[j].fd, SOL_SOCKET, SO_OOBINLINE, (char*) &oob_inlined, &olen);
+                if (!oob_inlined)
+                    fds[j].events |= POLLPRI;
+            }
+            else
+            {
+                release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
+                fds[j].fd = -1;
+                fds[j].events = 0;
+            }
+        }
+    return fds;
+
+failed:
+    count = j;
+    j = 0;
+    if (readfds)
+        for (i = 0; i < readfds->fd_count && j < count; i++, j++)
+            if (fds[j].fd != -1) release_sock_fd( readfds->fd_array[i], fds[j].fd );
+    if (writefds)
+        for (i = 0; i < writefds->fd_count && j < count; i++, j++)
+            if (fds[j].fd != -1) release_sock_fd( writefds->fd_array[i], fds[j].fd );
+    if (exceptfds)
+        for (i = 0; i < exceptfds->fd_count && j < count; i++, j++)
+            if (fds[j].fd != -1) release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
+    return NULL;
+}
+
+/* release the file descriptor obtained in fd_sets_to_poll */
+/* must be called with the original fd_set arrays, before calling get_poll_results */
+static void release_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefds,
+                              const WS_fd_set *exceptfds, struct pollfd *fds )
+{
+    unsigned int i, j = 0;
+
+    if (readfds)
+    {
+        for (i = 0; i < readfds->fd_count; i++, j++)
+            if (fds[j].fd != -1) release_sock_fd( readfds->fd_array[i], fds[j].fd );
+    }
+    if (writefds)
+    {
+        for (i = 0; i < writefds->fd_count; i++, j++)
+            if (fds[j].fd != -1) release_sock_fd( writefds->fd_array[i], fds[j].fd );
+    }
+    if (exceptfds)
+    {
+        for (i = 0; i < exceptfds->fd_count; i++, j++)
+        {
+            if (fds[j].fd == -1) continue;
+            release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
+            if (fds[j].revents & POLLHUP)
+            {
+                int fd = get_sock_fd( exceptfds->fd_array[i], 0, NULL );
+                if (fd != -1)
+                    release_sock_fd( exceptfds->fd_array[i], fd );
+                else
+                    fds[j].revents = 0;
+            }
+        }
+    }
+}
+
+static int do_poll(struct pollfd *pollfds, int count, int timeout)
+{
+    struct timeval tv1, tv2;
+    int ret, torig = timeout;
+
+    if (timeout > 0) gettimeofday( &tv1, 0 );
+
+    while ((ret = poll( pollfds, count, timeout )) < 0)
+    {
+        if (errno != EINTR) break;
+        if (timeout < 0) continue;
+        if (timeout == 0) return 0;
+
+        gettimeofday( &tv2, 0 );
+
+        tv2.tv_sec  -= tv1.tv_sec;
+        tv2.tv_usec -= tv1.tv_usec;
+        if (tv2.tv_usec < 0)
+        {
+            tv2.tv_usec += 1000000;
+            tv2.tv_sec  -= 1;
+        }
+
+        timeout = torig - (tv2.tv_sec * 1000) - (tv2.tv_usec + 999) / 1000;
+        if (timeout <= 0) return 0;
+    }
+    return ret;
+}
+
+/* map the poll results back into the Windows fd sets */
+static int get_poll_results( WS_fd_set *readfds, WS_fd_set *writefds, WS_fd_set *exceptfds,
+                             const struct pollfd *fds )
+{
+    const struct pollfd *poll_writefds  = fds + (readfds ? readfds->fd_count : 0);
+    const struct pollfd *poll_exceptfds = poll_writefds + (writefds ? writefds->fd_count : 0);
+    unsigned int i, k, total = 0;
+
+    if (readfds)
+    {
+        for (i = k = 0; i < readfds->fd_count; i++)
+        {
+            if (fds[i].revents ||
+                    (readfds == writefds && (poll_writefds[i].revents & POLLOUT) && !(poll_writefds[i].revents & POLLHUP)) ||
+                    (readfds == exceptfds && poll_exceptfds[i].revents))
+                readfds->fd_array[k++] = readfds->fd_array[i];
+        }
+        readfds->fd_count = k;
+        total += k;
+    }
+    if (writefds && writefds != readfds)
+    {
+        for (i = k = 0; i < writefds->fd_count; i++)
+        {
+            if (((poll_writefds[i].revents & POLLOUT) && !(poll_writefds[i].revents & POLLHUP)) ||
+                    (writefds == exceptfds && poll_exceptfds[i].revents))
+                writefds->fd_array[k++] = writefds->fd_array[i];
+        }
+        writefds->fd_count = k;
+        total += k;
+    }
+    if (exceptfds && exceptfds != readfds && exceptfds != writefds)
+    {
+        for (i = k = 0; i < exceptfds->fd_count; i++)
+            if (poll_exceptfds[i].revents) exceptfds->fd_array[k++] = exceptfds->fd_array[i];
+        exceptfds->fd_count = k;
+        total += k;
+    }
+    return total;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+
+static void remove_poll_entry( struct per_thread_data *ptb, struct poll_entry *entry )
+{
+    wine_rb_remove( &ptb->poll_entries, &entry->entry );
+    ptb->poll_entry_count--;
+    free_poll_entry( &entry->entry, NULL );
+}
+
+/* create the epoll set, and start receiving logged handles */
+static BOOL create_epoll_set( struct per_thread_data *ptb )
+{
+    if ((ptb->epoll_fd = epoll_create( 128 )) == -1)
+    {
+        WARN("failed to create epoll set, errno %d\n", errno);
+        ptb->epoll_fd = -2;
+        return FALSE;
+    }
+
+    EnterCriticalSection( &poll_cs );
+    ptb->poll_stale_count = 0;
+    ptb->poll_stale_limit = POLL_STALE_MIN_LIMIT;
+    ptb->poll_stale_overflow = FALSE;
+    list_add_tail( &poll_threads, &ptb->poll_thread_entry );
+    LeaveCriticalSection( &poll_cs );
+    return TRUE;
+}
+
+/* the entries can't be kept, since we stop receiving logged handles */
+static void destroy_epoll_set( struct per_thread_data *ptb )
+{
+    EnterCriticalSection( &poll_cs );
+    list_remove( &ptb->poll_thread_entry );
+    LeaveCriticalSection( &poll_cs );
+    close( ptb->epoll_fd );
+    ptb->epoll_fd = -1;
+    wine_rb_clear( &ptb->poll_entries, free_poll_entry, NULL );
+    ptb->poll_entry_count = 0;
+}
+
+/* recreate the epoll set, to get rid of registrations that we can't remove */
+static BOOL reset_epoll_set( struct per_thread_data *ptb )
+{
+    struct poll_entry *entry;
+    int fd;
+
+    WINE_RB_FOR_EACH_ENTRY( entry, &ptb->poll_entries, struct poll_entry, entry )
+        entry->registered = FALSE;
+
+    if ((fd = epoll_create( 128 )) == -1 || dup2( fd, ptb->epoll_fd ) == -1)
+    {
+        WARN("failed to recreate epoll set, errno %d\n", errno);
+        if (fd != -1) close( fd );
+        destroy_epoll_set( ptb );
+        return FALSE;
+    }
+    close( fd );
+    return TRUE;
+}
+
+/* drop cached entries for handles which were logged since the last call */
+static void sync_poll_log( struct per_thread_data *ptb, unsigned int count )
+{
+    struct wine_rb_entry *entry;
+    unsigned int i;
+    BOOL flush;
+
+    EnterCriticalSection( &poll_cs );
+    for (i = 0; i < ptb->poll_stale_count; i++)
+    {
+        /* The handle was closed, so its fd may now belong to another handle and
+         * we can't remove it from the epoll set. The kernel did that if the
+         * socket is gone, otherwise we'll notice when it reports events. */
+        if ((entry = wine_rb_get( &ptb->poll_entries, &ptb->poll_stale[i] )))
+            remove_poll_entry( ptb, WINE_RB_ENTRY_VALUE( entry, struct poll_entry, entry ) );
+    }
+    flush = ptb->poll_stale_overflow;
+    ptb->poll_stale_count = 0;
+    ptb->poll_stale_overflow = FALSE;
+    /* Flushing costs as much as the entries we may have by the end of this
+     * call, which is then no more than the number of logged handles. */
+    ptb->poll_stale_limit = max( ptb->poll_entry_count + count, POLL_STALE_MIN_LIMIT );
+    LeaveCriticalSection( &poll_cs );
 
-                /* Check if we need to test for urgent data or not */
-                getsockopt(fds[j].fd, SOL_SOCKET, SO_OOBINLINE, (char*) &oob_inlined, &olen);
-                if (!oob_inlined)
-                    fds[j].events |= POLLPRI;
-            }
-            else
-            {
-                release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
-                fds[j].fd = -1;
-                fds[j].events = 0;
-            }
+    if (flush)
+    {
+        TRACE("too many sockets changed, flushing the epoll set\n");
+        wine_rb_clear( &ptb->poll_entries, free_poll_entry, NULL );
+        ptb->poll_entry_count = 0;
+        reset_epoll_set( ptb );
+    }
+}
+
+/* prepare the epoll set and scratch buffers for a call on count sockets */
+static BOOL begin_epoll( struct per_thread_data *ptb, unsigned int count )
+{
+    if (ptb->epoll_fd == -1 && !create_epoll_set( ptb )) return FALSE;
+    if (ptb->epoll_fd < 0) return FALSE;
+
+    sync_poll_log( ptb, count );
+    if (ptb->epoll_fd < 0) return FALSE;
+
+    if (ptb->poll_refs_size < count)
+    {
+        struct poll_entry **refs;
+        struct epoll_event *events;
+
+        if (!(refs = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*refs) ))) return FALSE;
+        if (!(events = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*events) )))
+        {
+            HeapFree( GetProcessHeap(), 0, refs );
+            return FALSE;
         }
-    return fds;
+        HeapFree( GetProcessHeap(), 0, ptb->poll_refs );
+        HeapFree( GetProcessHeap(), 0, ptb->poll_events );
+        ptb->poll_refs = refs;
+        ptb->poll_events = events;
+        ptb->poll_refs_size = ptb->poll_events_size = count;
+    }
 
-failed:
-    count = j;
-    j = 0;
-    if (readfds)
-        for (i = 0; i < readfds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( readfds->fd_array[i], fds[j].fd );
-    if (writefds)
-        for (i = 0; i < writefds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( writefds->fd_array[i], fds[j].fd );
-    if (exceptfds)
-        for (i = 0; i < exceptfds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
-    return NULL;
+    ptb->poll_generation++;
+    return TRUE;
 }
 
-/* release the file descriptor obtained in fd_sets_to_poll */
-/* must be called with the original fd_set arrays, before calling get_poll_results */
-static void release_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefds,
-                              const WS_fd_set *exceptfds, struct pollfd *fds )
+/* Find or create the entry for a socket, and reset it for the current call.
+ * Returns STATUS_NOT_SUPPORTED if the socket's fd isn't cached, in which
+ * case the call has to use poll(). */
+static NTSTATUS get_poll_entry( struct per_thread_data *ptb, SOCKET s, unsigned int *used,
+                                struct poll_entry **ret )
 {
-    unsigned int i, j = 0;
+    struct wine_rb_entry *entry;
+    struct poll_entry *poll_entry = NULL;
+    NTSTATUS status;
+    int fd;
 
-    if (readfds)
+    /* this is only a lookup, unless the fd isn't cached yet */
+    if ((status = __wine_server_get_cached_fd( SOCKET2HANDLE(s), &fd ))) return status;
+
+    if ((entry = wine_rb_get( &ptb->poll_entries, &s )))
     {
-        for (i = 0; i < readfds->fd_count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( readfds->fd_array[i], fds[j].fd );
+        poll_entry = WINE_RB_ENTRY_VALUE( entry, struct poll_entry, entry );
+        /* the handle was closed and reused without going through closesocket() */
+        if (poll_entry->fd != fd)
+        {
+            remove_poll_entry( ptb, poll_entry );
+            poll_entry = NULL;
+        }
     }
-    if (writefds)
+    if (!poll_entry)
     {
-        for (i = 0; i < writefds->fd_count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( writefds->fd_array[i], fds[j].fd );
+        if (!(poll_entry = HeapAlloc( GetProcessHeap(), 0, sizeof(*poll_entry) ))) return STATUS_NO_MEMORY;
+        poll_entry->socket     = s;
+        poll_entry->fd         = fd;
+        poll_entry->type       = _get_fd_type( fd );
+        poll_entry->bound      = FALSE;
+        poll_entry->registered = FALSE;
+        poll_entry->events     = 0;
+        poll_entry->serial     = 0;
+        poll_entry->generation = ptb->poll_generation - 1;
+        wine_rb_put( &ptb->poll_entries, &s, &poll_entry->entry );
+        ptb->poll_entry_count++;
     }
-    if (exceptfds)
+
+    if (poll_entry->generation != ptb->poll_generation)
     {
-        for (i = 0; i < exceptfds->fd_count; i++, j++)
+        (*used)++;
+        poll_entry->generation = ptb->poll_generation;
+        poll_entry->wanted     = 0;
+        poll_entry->flags      = 0;
+        poll_entry->revents    = 0;
+    }
+    *ret = poll_entry;
+    return STATUS_SUCCESS;
+}
+
+static void update_poll_entry( struct per_thread_data *ptb, struct poll_entry *entry )
+{
+    struct epoll_event event;
+
+    /* sockets skipped by select() shouldn't report ERR or HUP either */
+    if (!entry->flags)
+    {
+        if (entry->registered) epoll_ctl( ptb->epoll_fd, EPOLL_CTL_DEL, entry->fd, NULL );
+        entry->registered = FALSE;
+        return;
+    }
+    if (entry->registered && entry->events == entry->wanted) return;
+
+    event.events = entry->wanted;
+    if (entry->registered)
+    {
+        event.data.u64 = ((ULONG64)entry->serial << 32) | (ULONG)entry->socket;
+        if (!epoll_ctl( ptb->epoll_fd, EPOLL_CTL_MOD, entry->fd, &event ))
         {
-            if (fds[j].fd == -1) continue;
-            release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
-            if (fds[j].revents & POLLHUP)
-            {
-                int fd = get_sock_fd( exceptfds->fd_array[i], 0, NULL );
-                if (fd != -1)
-                    release_sock_fd( exceptfds->fd_array[i], fd );
-                else
-                    fds[j].revents = 0;
-            }
+            entry->events = entry->wanted;
+            return;
         }
+        /* the registration went away with a previous socket using the same fd */
+        if (errno != ENOENT)
+            ERR("epoll_ctl(MOD) failed for socket %04lx, errno %d\n", entry->socket, errno);
     }
+
+    entry->serial = ++ptb->poll_serial;
+    event.data.u64 = ((ULONG64)entry->serial << 32) | (ULONG)entry->socket;
+    if (epoll_ctl( ptb->epoll_fd, EPOLL_CTL_ADD, entry->fd, &event ) == -1)
+        ERR("epoll_ctl(ADD) failed for socket %04lx, errno %d\n", entry->socket, errno);
+    entry->registered = TRUE;
+    entry->events = entry->wanted;
 }
 
-static int do_poll(struct pollfd *pollfds, int count, int timeout)
+/* Drop the entries of sockets which aren't part of the current call; they
+ * can't stay in the epoll set, since ERR and HUP are reported even for an
+ * empty event mask. */
+static void prune_poll_entries( struct per_thread_data *ptb, unsigned int used )
+{
+    struct wine_rb_entry *cursor, *next;
+    int fd;
+
+    if (used == ptb->poll_entry_count) return;
+
+    for (cursor = wine_rb_head( ptb->poll_entries.root ); cursor; cursor = next)
+    {
+        struct poll_entry *entry = WINE_RB_ENTRY_VALUE( cursor, struct poll_entry, entry );
+
+        next = wine_rb_next( cursor );
+        if (entry->generation == ptb->poll_generation) continue;
+        if (entry->registered && !__wine_server_get_cached_fd( SOCKET2HANDLE(entry->socket), &fd ) &&
+            fd == entry->fd)
+            epoll_ctl( ptb->epoll_fd, EPOLL_CTL_DEL, entry->fd, NULL );
+        remove_poll_entry( ptb, entry );
+    }
+}
+
+/* find the entry that an event was reported for, or NULL for a stale registration */
+static struct poll_entry *get_epoll_event_entry( struct per_thread_data *ptb, const struct epoll_event *event )
+{
+    SOCKET s = (ULONG)event->data.u64;
+    struct wine_rb_entry *entry;
+    struct poll_entry *poll_entry;
+
+    if (!(entry = wine_rb_get( &ptb->poll_entries, &s ))) return NULL;
+    poll_entry = WINE_RB_ENTRY_VALUE( entry, struct poll_entry, entry );
+    if (!poll_entry->registered || poll_entry->serial != (unsigned int)(event->data.u64 >> 32)) return NULL;
+    return poll_entry;
+}
+
+static int do_epoll_wait( struct per_thread_data *ptb, unsigned int count, int timeout )
 {
+    struct epoll_event *events = ptb->poll_events;
+    struct poll_entry *entry;
     struct timeval tv1, tv2;
-    int ret, torig = timeout;
+    int ret, i, ready, torig = timeout;
+    BOOL stale;
 
     if (timeout > 0) gettimeofday( &tv1, 0 );
 
-    while ((ret = poll( pollfds, count, timeout )) < 0)
+    for (;;)
     {
-        if (errno != EINTR) break;
+        if ((ret = epoll_wait( ptb->epoll_fd, events, count, timeout )) < 0 && errno != EINTR) return -1;
+
+        for (i = ready = 0, stale = FALSE; i < ret; i++)
+        {
+            if ((entry = get_epoll_event_entry( ptb, &events[i] )))
+            {
+                entry->revents = events[i].events;
+                ready++;
+            }
+            else stale = TRUE;
+        }
+        if (stale)
+        {
+            TRACE("recreating the epoll set\n");
+            if (!reset_epoll_set( ptb )) return -1;
+            WINE_RB_FOR_EACH_ENTRY( entry, &ptb->poll_entries, struct poll_entry, entry )
+                update_poll_entry( ptb, entry );
+        }
+        if (ready || (ret >= 0 && !stale)) return ready;
+
+        /* interrupted, or only stale events */
         if (timeout < 0) continue;
         if (timeout == 0) return 0;
 
@@ -5365,24 +6564,124 @@ static int do_poll(struct pollfd *pollfds, int count, int timeout)
         timeout = torig - (tv2.tv_sec * 1000) - (tv2.tv_usec + 999) / 1000;
         if (timeout <= 0) return 0;
     }
-    return ret;
 }
 
-/* map the poll results back into the Windows fd sets */
-static int get_poll_results( WS_fd_set *readfds, WS_fd_set *writefds, WS_fd_set *exceptfds,
-                             const struct pollfd *fds )
+/* check whether a socket which reported POLLHUP still exists */
+static BOOL poll_socket_exists( SOCKET s )
 {
-    const struct pollfd *poll_writefds  = fds + (readfds ? readfds->fd_count : 0);
-    const struct pollfd *poll_exceptfds = poll_writefds + (writefds ? writefds->fd_count : 0);
-    unsigned int i, k, total = 0;
+    int fd = get_sock_fd( s, 0, NULL );
+
+    if (fd == -1) return FALSE;
+    release_sock_fd( s, fd );
+    return TRUE;
+}
+
+static NTSTATUS fd_set_to_epoll( struct per_thread_data *ptb, const WS_fd_set *set, unsigned int flag,
+                                 unsigned int *pos, unsigned int *used )
+{
+    NTSTATUS status;
+    unsigned int i;
+
+    if (!set) return STATUS_SUCCESS;
+
+    for (i = 0; i < set->fd_count; i++)
+    {
+        struct poll_entry *entry;
+
+        if ((status = get_poll_entry( ptb, set->fd_array[i], used, &entry ))) return status;
+        ptb->poll_refs[(*pos)++] = entry;
+
+        if (!entry->bound) entry->bound = (is_fd_bound( entry->fd, NULL, NULL ) == 1);
+
+        switch (flag)
+        {
+        case POLL_SELECT_READ:
+            if (!entry->bound) continue;
+            entry->wanted |= EPOLLIN;
+            break;
+        case POLL_SELECT_WRITE:
+            if (!entry->bound && entry->type != SOCK_DGRAM) continue;
+            entry->wanted |= EPOLLOUT;
+            break;
+        case POLL_SELECT_EXCEPT:
+        {
+            int oob_inlined = 0;
+            socklen_t olen = sizeof(oob_inlined);
+
+            if (!entry->bound) continue;
+            /* Check if we need to test for urgent data or not */
+            getsockopt( entry->fd, SOL_SOCKET, SO_OOBINLINE, (char *)&oob_inlined, &olen );
+            if (!oob_inlined) entry->wanted |= EPOLLPRI;
+            break;
+        }
+        }
+        entry->flags |= flag;
+    }
+    return STATUS_SUCCESS;
+}
+
+static BOOL poll_entry_select_ready( const struct poll_entry *entry, unsigned int flag )
+{
+    if (!(entry->flags & flag)) return FALSE;
+
+    switch (flag)
+    {
+    case POLL_SELECT_READ:
+        return !!(entry->revents & (EPOLLIN | EPOLLHUP | EPOLLERR));
+    case POLL_SELECT_WRITE:
+        return (entry->revents & EPOLLOUT) && !(entry->revents & EPOLLHUP);
+    case POLL_SELECT_EXCEPT:
+        if (entry->revents & EPOLLHUP) return poll_socket_exists( entry->socket );
+        return !!(entry->revents & (EPOLLPRI | EPOLLERR));
+    }
+    return FALSE;
+}
+
+/* select() on the per-thread epoll set; returns FALSE if we should fall back to poll() */
+static BOOL epoll_select( WS_fd_set *readfds, WS_fd_set *writefds, WS_fd_set *exceptfds,
+                          int timeout, int *ret )
+{
+    struct per_thread_data *ptb = get_per_thread_data();
+    unsigned int read_count = readfds ? readfds->fd_count : 0;
+    unsigned int write_count = writefds ? writefds->fd_count : 0;
+    unsigned int except_count = exceptfds ? exceptfds->fd_count : 0;
+    unsigned int i, k, pos = 0, used = 0, count = read_count + write_count + except_count, total = 0;
+    struct poll_entry **read_refs, **write_refs, **except_refs;
+    NTSTATUS status;
+
+    if (count < POLL_EPOLL_THRESHOLD || !begin_epoll( ptb, count )) return FALSE;
+
+    if ((status = fd_set_to_epoll( ptb, readfds, POLL_SELECT_READ, &pos, &used )) ||
+        (status = fd_set_to_epoll( ptb, writefds, POLL_SELECT_WRITE, &pos, &used )) ||
+        (status = fd_set_to_epoll( ptb, exceptfds, POLL_SELECT_EXCEPT, &pos, &used )))
+    {
+        if (status == STATUS_NOT_SUPPORTED) return FALSE;
+        set_error( status );
+        *ret = SOCKET_ERROR;
+        return TRUE;
+    }
+
+    for (i = 0; i < count; i++) update_poll_entry( ptb, ptb->poll_refs[i] );
+    prune_poll_entries( ptb, used );
 
+    if (do_epoll_wait( ptb, max( used, 1 ), timeout ) == -1)
+    {
+        SetLastError( wsaErrno() );
+        *ret = SOCKET_ERROR;
+        return TRUE;
+    }
+
+    /* map the results back into the Windows fd sets, like get_poll_results() */
+    read_refs   = ptb->poll_refs;
+    write_refs  = read_refs + read_count;
+    except_refs = write_refs + write_count;
     if (readfds)
     {
-        for (i = k = 0; i < readfds->fd_count; i++)
+        for (i = k = 0; i < read_count; i++)
         {
-            if (fds[i].revents ||
-                    (readfds == writefds && (poll_writefds[i].revents & POLLOUT) && !(poll_writefds[i].revents & POLLHUP)) ||
-                    (readfds == exceptfds && poll_exceptfds[i].revents))
+            if (poll_entry_select_ready( read_refs[i], POLL_SELECT_READ ) ||
+                    (readfds == writefds && poll_entry_select_ready( write_refs[i], POLL_SELECT_WRITE )) ||
+                    (readfds == exceptfds && poll_entry_select_ready( except_refs[i], POLL_SELECT_EXCEPT )))
                 readfds->fd_array[k++] = readfds->fd_array[i];
         }
         readfds->fd_count = k;
@@ -5390,10 +6689,10 @@ static int get_poll_results( WS_fd_set *readfds, WS_fd_set *writefds, WS_fd_set
     }
     if (writefds && writefds != readfds)
     {
-        for (i = k = 0; i < writefds->fd_count; i++)
+        for (i = k = 0; i < write_count; i++)
         {
-            if (((poll_writefds[i].revents & POLLOUT) && !(poll_writefds[i].revents & POLLHUP)) ||
-                    (writefds == exceptfds && poll_exceptfds[i].revents))
+            if (poll_entry_select_ready( write_refs[i], POLL_SELECT_WRITE ) ||
+                    (writefds == exceptfds && poll_entry_select_ready( except_refs[i], POLL_SELECT_EXCEPT )))
                 writefds->fd_array[k++] = writefds->fd_array[i];
         }
         writefds->fd_count = k;
@@ -5401,14 +6700,86 @@ static int get_poll_results( WS_fd_set *readfds, WS_fd_set *writefds, WS_fd_set
     }
     if (exceptfds && exceptfds != readfds && exceptfds != writefds)
     {
-        for (i = k = 0; i < exceptfds->fd_count; i++)
-            if (poll_exceptfds[i].revents) exceptfds->fd_array[k++] = exceptfds->fd_array[i];
+        for (i = k = 0; i < except_count; i++)
+            if (poll_entry_select_ready( except_refs[i], POLL_SELECT_EXCEPT ))
+                exceptfds->fd_array[k++] = exceptfds->fd_array[i];
         exceptfds->fd_count = k;
         total += k;
     }
-    return total;
+
+    *ret = total;
+    return TRUE;
+}
+
+/* WSAPoll() on the per-thread epoll set; returns FALSE if we should fall back to poll() */
+static BOOL epoll_wsapoll( WSAPOLLFD *wfds, ULONG count, int timeout, int *ret )
+{
+    struct per_thread_data *ptb = get_per_thread_data();
+    unsigned int i, used = 0;
+
+    if (count < POLL_EPOLL_THRESHOLD || !begin_epoll( ptb, count )) return FALSE;
+
+    for (i = 0; i < count; i++)
+    {
+        struct poll_entry *entry;
+        NTSTATUS status = get_poll_entry( ptb, wfds[i].fd, &used, &entry );
+
+        if (status == STATUS_NOT_SUPPORTED) return FALSE;
+        if ((ptb->poll_refs[i] = status ? NULL : entry))
+        {
+            entry->flags |= POLL_WSAPOLL;
+            entry->wanted |= convert_poll_w2u( wfds[i].events );
+        }
+    }
+
+    for (i = 0; i < count; i++)
+        if (ptb->poll_refs[i]) update_poll_entry( ptb, ptb->poll_refs[i] );
+    prune_poll_entries( ptb, used );
+
+    if (do_epoll_wait( ptb, max( used, 1 ), timeout ) == -1)
+    {
+        SetLastError( wsaErrno() );
+        *ret = SOCKET_ERROR;
+        return TRUE;
+    }
+
+    *ret = 0;
+    for (i = 0; i < count; i++)
+    {
+        struct poll_entry *entry = ptb->poll_refs[i];
+        unsigned int revents;
+
+        if (!entry)
+        {
+            wfds[i].revents = WS_POLLNVAL;
+            continue;
+        }
+
+        revents = entry->revents & (convert_poll_w2u( wfds[i].events ) | EPOLLERR | EPOLLHUP);
+        if (revents & EPOLLHUP)
+            wfds[i].revents = poll_socket_exists( wfds[i].fd ) ? WS_POLLHUP : WS_POLLNVAL;
+        else
+            wfds[i].revents = convert_poll_u2w( revents );
+        if (revents) (*ret)++;
+    }
+    return TRUE;
+}
+
+#else
+
+static BOOL epoll_select( WS_fd_set *readfds, WS_fd_set *writefds, WS_fd_set *exceptfds,
+                          int timeout, int *ret )
+{
+    return FALSE;
+}
+
+static BOOL epoll_wsapoll( WSAPOLLFD *wfds, ULONG count, int timeout, int *ret )
+{
+    return FALSE;
 }
 
+#endif
+
 /***********************************************************************
  *		select			(WS2_32.18)
  */
@@ -5422,12 +6793,15 @@ int WINAPI WS_select(int nfds, WS_fd_set *ws_readfds,
     TRACE("read %p, write %p, excp %p timeout %p\n",
           ws_readfds, ws_writefds, ws_exceptfds, ws_timeout);
 
-    if (!(pollfds = fd_sets_to_poll( ws_readfds, ws_writefds, ws_exceptfds, &count )))
-        return SOCKET_ERROR;
-
     if (ws_timeout)
         timeout = (ws_timeout->tv_sec * 1000) + (ws_timeout->tv_usec + 999) / 1000;
 
+    if (epoll_select( ws_readfds, ws_writefds, ws_exceptfds, timeout, &ret ))
+        return ret;
+
+    if (!(pollfds = fd_sets_to_poll( ws_readfds, ws_writefds, ws_exceptfds, &count )))
+        return SOCKET_ERROR;
+
     ret = do_poll(pollfds, count, timeout);
     release_poll_fds( ws_readfds, ws_writefds, ws_exceptfds, pollfds );
 
@@ -5455,6 +6829,9 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
         return SOCKET_ERROR;
     }
 
+    if (epoll_wsapoll( wfds, count, timeout, &ret ))
+        return ret;
+
     if (!(ufds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(ufds[0]))))
     {
         SetLastError(WSAENOBUFS);
@@ -5625,7 +7002,6 @@ static int WS2_sendto( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
 
         wsa->user_overlapped = lpOverlapped;
         wsa->completion_func = lpCompletionRoutine;
-        release_sock_fd( s, fd );
 
         if (n == -1 || n < totalLength)
         {
@@ -5633,11 +7009,20 @@ static int WS2_sendto( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
             iosb->Information = n == -1 ? 0 : n;
 
             if (wsa->completion_func)
-                err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, NULL,
-                                      ws2_async_apc, wsa, iosb );
+            {
+                err = WS2_uring_queue( fd, wsa, FALSE, flags, NULL, ws2_async_apc, wsa, iosb );
+                if (err == STATUS_NOT_IMPLEMENTED)
+                    err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, NULL,
+                                          ws2_async_apc, wsa, iosb );
+            }
             else
-                err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
-                                      NULL, (void *)cvalue, iosb );
+            {
+                err = WS2_uring_queue( fd, wsa, FALSE, flags, lpOverlapped->hEvent, NULL, (void *)cvalue, iosb );
+                if (err == STATUS_NOT_IMPLEMENTED)
+                    err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
+                                          NULL, (void *)cvalue, iosb );
+            }
+            release_sock_fd( s, fd );
 
             /* Enable the event only after starting the async. The server will deliver it as soon as
                the async is done. */
@@ -5648,6 +7033,7 @@ static int WS2_sendto( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
             return SOCKET_ERROR;
         }
 
+        release_sock_fd( s, fd );
         iosb->u.Status = STATUS_SUCCESS;
         iosb->Information = n;
         if (lpNumberOfBytesSent) *lpNumberOfBytesSent = n;
@@ -7632,6 +9018,8 @@ SOCKET WINAPI WSASocketW(int af, int type, int protocol,
     if (ret)
     {
         TRACE("\tcreated %04lx\n", ret );
+        reset_sock_shared(ret);
+        poll_log_socket(ret);
         if (ipxptype > 0)
             set_ipx_packettype(ret, ipxptype);
 
@@ -7958,7 +9346,7 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
     unsigned int i, options;
     int n, fd, err, overlapped, flags;
     struct ws2_async *wsa = NULL, localwsa;
-    BOOL is_blocking;
+    BOOL is_blocking, batch;
     DWORD timeout_start = GetTickCount();
     ULONG_PTR cvalue = (lpOverlapped && ((ULONG_PTR)lpOverlapped->hEvent & 1) == 0) ? (ULONG_PTR)lpOverlapped : 0;
 
@@ -8018,6 +9406,20 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
         wsa->iovec[i].iov_len  = lpBuffers[i].len;
     }
 
+    batch = overlapped && lpOverlapped && !lpCompletionRoutine && !lpControlBuffer && !wsa->flags;
+    if (batch)
+    {
+        wsa->user_overlapped = lpOverlapped;
+        wsa->completion_func = NULL;
+        if ((err = queue_recv_batch( s, wsa, TRUE )) != STATUS_NOT_FOUND)
+        {
+            release_sock_fd( s, fd );
+            if (err != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
+            SetLastError( NtStatusToWSAError( err ));
+            return SOCKET_ERROR;
+        }
+    }
+
     flags = convert_flags(wsa->flags);
     for (;;)
     {
@@ -8043,7 +9445,12 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
 
             wsa->user_overlapped = lpOverlapped;
             wsa->completion_func = lpCompletionRoutine;
-            release_sock_fd( s, fd );
+            if (n == -1 && batch)
+            {
+                int type;
+                socklen_t len = sizeof(type);
+                batch = !getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &len ) && type == SOCK_DGRAM;
+            }
 
             if (n == -1)
             {
@@ -8051,17 +9458,29 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
                 iosb->Information = 0;
 
                 if (wsa->completion_func)
-                    err = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, NULL,
-                                          ws2_async_apc, wsa, iosb );
+                {
+                    err = WS2_uring_queue( fd, wsa, TRUE, flags, NULL, ws2_async_apc, wsa, iosb );
+                    if (err == STATUS_NOT_IMPLEMENTED)
+                        err = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, NULL,
+                                              ws2_async_apc, wsa, iosb );
+                }
                 else
-                    err = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
-                                          NULL, (void *)cvalue, iosb );
+                {
+                    err = WS2_uring_queue( fd, wsa, TRUE, flags, lpOverlapped->hEvent, NULL, (void *)cvalue, iosb );
+                    if (err == STATUS_NOT_IMPLEMENTED && batch)
+                        err = queue_recv_batch( s, wsa, FALSE );
+                    else if (err == STATUS_NOT_IMPLEMENTED)
+                        err = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
+                                              NULL, (void *)cvalue, iosb );
+                }
+                release_sock_fd( s, fd );
 
                 if (err != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
                 SetLastError(NtStatusToWSAError( err ));
                 return SOCKET_ERROR;
             }
 
+            release_sock_fd( s, fd );
             iosb->u.Status = STATUS_SUCCESS;
             iosb->Information = n;
             if (!wsa->completion_func)
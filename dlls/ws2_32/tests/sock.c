@@ -33,6 +33,7 @@
 #include <mstcpip.h>
 #include <iphlpapi.h>
 #include <stdio.h>
+#include "wine/ws2_32.h"
 #include "wine/test.h"
 
 #define MAX_CLIENTS 4      /* Max number of clients */
@@ -91,6 +92,8 @@ static DWORD (WINAPI *pGetIpForwardTable)(PMIB_IPFORWARDTABLE,PULONG,BOOL);
 
 /* Function pointers from ntdll */
 static DWORD (WINAPI *pNtClose)(HANDLE);
+static NTSTATUS (WINAPI *pNtReadFile)(HANDLE,HANDLE,PIO_APC_ROUTINE,void *,IO_STATUS_BLOCK *,void *,ULONG,
+                                      LARGE_INTEGER *,ULONG *);
 
 /**************** Structs and typedefs ***************/
 
@@ -1310,7 +1313,10 @@ static void Init (void)
 
     ntdll = LoadLibraryA("ntdll.dll");
     if (ntdll)
+    {
         pNtClose = (void *)GetProcAddress(ntdll, "NtClose");
+        pNtReadFile = (void *)GetProcAddress(ntdll, "NtReadFile");
+    }
 
     ok ( WSAStartup ( ver, &data ) == 0, "WSAStartup failed\n" );
     tls = TlsAlloc();
@@ -4186,6 +4192,238 @@ todo_wine
     ok(FD_ISSET(fdWrite, &writefds), "fdWrite socket is not in the set\n");
     closesocket(fdWrite);
 }
+
+static void test_select_many(void)
+{
+    static const struct timeval zero_timeout = {0, 0}, timeout = {1, 0};
+    SOCKET src[40], dst[40];
+    fd_set readfds, writefds;
+    struct timeval tv;
+    char buffer[4];
+    int i, j, ret, count;
+
+    for (count = 0; count < ARRAY_SIZE(src); count++)
+        if (tcp_socketpair(&src[count], &dst[count])) break;
+    if (count < ARRAY_SIZE(src))
+    {
+        skip("failed to create socket pairs\n");
+        goto done;
+    }
+
+    /* repeat the same calls, so that the sockets can be reused between them */
+    for (i = 0; i < 3; i++)
+    {
+        FD_ZERO(&readfds);
+        FD_ZERO(&writefds);
+        for (j = 0; j < count; j++)
+        {
+            FD_SET(dst[j], &readfds);
+            FD_SET(dst[j], &writefds);
+        }
+        tv = zero_timeout;
+        ret = select(0, &readfds, &writefds, NULL, &tv);
+        ok(ret == count, "%d: expected %d, got %d\n", i, count, ret);
+        ok(!readfds.fd_count, "%d: got %u readable sockets\n", i, readfds.fd_count);
+        ok(writefds.fd_count == count, "%d: got %u writable sockets\n", i, writefds.fd_count);
+    }
+
+    ret = send(src[7], "data", 4, 0);
+    ok(ret == 4, "send returned %d\n", ret);
+
+    FD_ZERO(&readfds);
+    for (j = 0; j < count; j++) FD_SET(dst[j], &readfds);
+    tv = timeout;
+    ret = select(0, &readfds, NULL, NULL, &tv);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    ok(readfds.fd_count == 1, "got %u readable sockets\n", readfds.fd_count);
+    ok(readfds.fd_array[0] == dst[7], "wrong socket %lx\n", readfds.fd_array[0]);
+
+    ret = recv(dst[7], buffer, sizeof(buffer), 0);
+    ok(ret == 4, "recv returned %d\n", ret);
+
+    /* replace a socket; its handle may be reused */
+    closesocket(src[3]);
+    closesocket(dst[3]);
+    ret = tcp_socketpair(&src[3], &dst[3]);
+    ok(!ret, "failed to create socket pair\n");
+    ret = send(src[3], "data", 4, 0);
+    ok(ret == 4, "send returned %d\n", ret);
+
+    FD_ZERO(&readfds);
+    for (j = 0; j < count; j++) FD_SET(dst[j], &readfds);
+    tv = timeout;
+    ret = select(0, &readfds, NULL, NULL, &tv);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    ok(readfds.fd_count == 1, "got %u readable sockets\n", readfds.fd_count);
+    ok(readfds.fd_array[0] == dst[3], "wrong socket %lx\n", readfds.fd_array[0]);
+
+    /* a smaller set after a large one */
+    FD_ZERO(&readfds);
+    FD_SET(dst[3], &readfds);
+    FD_SET(dst[7], &readfds);
+    tv = zero_timeout;
+    ret = select(0, &readfds, NULL, NULL, &tv);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    ok(readfds.fd_array[0] == dst[3], "wrong socket %lx\n", readfds.fd_array[0]);
+
+done:
+    for (j = 0; j < count; j++)
+    {
+        closesocket(src[j]);
+        closesocket(dst[j]);
+    }
+}
+struct select_close_params
+{
+    SOCKET *sockets;
+    int count;
+};
+
+static DWORD WINAPI select_close_thread(void *arg)
+{
+    static const struct timeval zero_timeout = {0, 0};
+    struct select_close_params *params = arg;
+    fd_set readfds;
+    struct timeval tv;
+    int i, ret;
+
+    FD_ZERO(&readfds);
+    for (i = 0; i < params->count; i++) FD_SET(params->sockets[i], &readfds);
+    tv = zero_timeout;
+    ret = select(0, &readfds, NULL, NULL, &tv);
+    ok(!ret, "expected 0, got %d\n", ret);
+    return 0;
+}
+
+static void test_select_many_close(void)
+{
+    struct select_close_params params;
+    struct sockaddr_in addr = {0};
+    SOCKET src[40], dst[40], sockets[41], listener, s;
+    DWORD timeout = 1000;
+    int i, ret, count, len;
+    char buffer[4];
+    HANDLE thread;
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ok(listener != INVALID_SOCKET, "failed to create socket, error %u\n", WSAGetLastError());
+    ret = bind(listener, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %u\n", WSAGetLastError());
+    ret = listen(listener, 1);
+    ok(!ret, "listen failed, error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(listener, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %u\n", WSAGetLastError());
+
+    for (count = 0; count < ARRAY_SIZE(src); count++)
+    {
+        if (tcp_socketpair(&src[count], &dst[count])) break;
+        sockets[count] = dst[count];
+    }
+    if (count < ARRAY_SIZE(src))
+    {
+        skip("failed to create socket pairs\n");
+        goto done;
+    }
+    sockets[count] = listener;
+
+    /* select on every socket both here and in another thread, so that each
+     * thread may keep them in its own set */
+    params.sockets = sockets;
+    params.count = count + 1;
+    select_close_thread(&params);
+    thread = CreateThread(NULL, 0, select_close_thread, &params, 0, NULL);
+    ok(WaitForSingleObject(thread, 10000) == WAIT_OBJECT_0, "wait timed out\n");
+    CloseHandle(thread);
+
+    /* the peer should see the sockets closed right away */
+    ret = setsockopt(src[5], SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout));
+    ok(!ret, "setsockopt failed, error %u\n", WSAGetLastError());
+    closesocket(dst[5]);
+    dst[5] = INVALID_SOCKET;
+    ret = recv(src[5], buffer, sizeof(buffer), 0);
+    ok(!ret, "expected 0, got %d, error %u\n", ret, WSAGetLastError());
+
+    ret = setsockopt(src[9], SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout));
+    ok(!ret, "setsockopt failed, error %u\n", WSAGetLastError());
+    CloseHandle((HANDLE)dst[9]);
+    dst[9] = INVALID_SOCKET;
+    ret = recv(src[9], buffer, sizeof(buffer), 0);
+    ok(!ret, "expected 0, got %d, error %u\n", ret, WSAGetLastError());
+
+    /* and the port of a closed listening socket should be free again */
+    closesocket(listener);
+    listener = INVALID_SOCKET;
+    s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ok(s != INVALID_SOCKET, "failed to create socket, error %u\n", WSAGetLastError());
+    ret = bind(s, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %u\n", WSAGetLastError());
+    closesocket(s);
+
+done:
+    for (i = 0; i < count; i++)
+    {
+        closesocket(src[i]);
+        if (dst[i] != INVALID_SOCKET) closesocket(dst[i]);
+    }
+    if (listener != INVALID_SOCKET) closesocket(listener);
+}
+
+static void test_socket_state_handle_reuse(void)
+{
+    struct sockaddr_in addr = {0};
+    SOCKET s, s2, dup;
+    u_long nonblocking = 1;
+    DWORD timeout = 100;
+    char buffer[4];
+    BOOL bret;
+    int ret;
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ok(s != INVALID_SOCKET, "failed to create socket, error %u\n", WSAGetLastError());
+    ret = bind(s, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %u\n", WSAGetLastError());
+    ret = ioctlsocket(s, FIONBIO, &nonblocking);
+    ok(!ret, "ioctlsocket failed, error %u\n", WSAGetLastError());
+
+    WSASetLastError(0xdeadbeef);
+    ret = recv(s, buffer, sizeof(buffer), 0);
+    ok(ret == -1, "got %d\n", ret);
+    ok(WSAGetLastError() == WSAEWOULDBLOCK, "got error %u\n", WSAGetLastError());
+
+    /* keep the socket alive through another handle, so that its state stays valid */
+    bret = DuplicateHandle(GetCurrentProcess(), (HANDLE)s, GetCurrentProcess(),
+                           (HANDLE *)&dup, 0, FALSE, DUPLICATE_SAME_ACCESS);
+    ok(bret, "DuplicateHandle failed, error %u\n", GetLastError());
+    CloseHandle((HANDLE)s);
+
+    /* the new socket may get the same handle value, but it is blocking */
+    s2 = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ok(s2 != INVALID_SOCKET, "failed to create socket, error %u\n", WSAGetLastError());
+    ret = bind(s2, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %u\n", WSAGetLastError());
+    ret = setsockopt(s2, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout));
+    ok(!ret, "setsockopt failed, error %u\n", WSAGetLastError());
+
+    WSASetLastError(0xdeadbeef);
+    ret = recv(s2, buffer, sizeof(buffer), 0);
+    ok(ret == -1, "got %d\n", ret);
+    ok(WSAGetLastError() == WSAETIMEDOUT, "got error %u\n", WSAGetLastError());
+
+    WSASetLastError(0xdeadbeef);
+    ret = recv(dup, buffer, sizeof(buffer), 0);
+    ok(ret == -1, "got %d\n", ret);
+    ok(WSAGetLastError() == WSAEWOULDBLOCK, "got error %u\n", WSAGetLastError());
+
+    closesocket(s2);
+    closesocket(dup);
+}
+
 #undef FD_SET_ALL
 #undef FD_ZERO_ALL
 
@@ -6922,6 +7160,233 @@ end:
         WSACloseEvent(event);
 }
 
+struct recv_batch_thread_params
+{
+    SOCKET s;
+    WSABUF *wsabuf;
+    WSAOVERLAPPED *ov;
+    HANDLE posted, done;
+};
+
+static DWORD WINAPI recv_batch_thread(void *arg)
+{
+    struct recv_batch_thread_params *params = arg;
+    DWORD flags = 0;
+    int ret;
+
+    ret = WSARecvFrom(params->s, params->wsabuf, 1, NULL, &flags, NULL, NULL, params->ov, NULL);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING,
+       "got %d, error %u\n", ret, WSAGetLastError());
+    SetEvent(params->posted);
+    /* keep the thread alive, its pending I/O may be cancelled when it exits */
+    WaitForSingleObject(params->done, INFINITE);
+    return 0;
+}
+
+static void test_WSARecvFrom_batch(void)
+{
+    struct recv_batch_thread_params params;
+    HANDLE thread = NULL;
+    SOCKET src, dst;
+    struct sockaddr_in addr, from[4];
+    WINE_RECV_BATCH_ENTRY entries[5];
+    WSAOVERLAPPED ov[4];
+    char bufs[5][16];
+    WSABUF wsabuf;
+    DWORD flags, size, count, i;
+    int len, ret;
+
+    dst = socket(AF_INET, SOCK_DGRAM, 0);
+    ok(dst != INVALID_SOCKET, "socket failed, error %u\n", WSAGetLastError());
+    src = socket(AF_INET, SOCK_DGRAM, 0);
+    ok(src != INVALID_SOCKET, "socket failed, error %u\n", WSAGetLastError());
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ret = bind(dst, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(dst, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %u\n", WSAGetLastError());
+
+    /* several overlapped receives pending on the same socket complete in order */
+    for (i = 0; i < 4; i++)
+    {
+        memset(&ov[i], 0, sizeof(ov[i]));
+        ov[i].hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        wsabuf.buf = bufs[i];
+        wsabuf.len = sizeof(bufs[i]);
+        flags = 0;
+        len = sizeof(from[i]);
+        ret = WSARecvFrom(dst, &wsabuf, 1, NULL, &flags, (struct sockaddr *)&from[i], &len, &ov[i], NULL);
+        ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING,
+           "got %d, error %u\n", ret, WSAGetLastError());
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        char data[2] = {'0' + i, 0};
+        ret = sendto(src, data, i + 1, 0, (struct sockaddr *)&addr, sizeof(addr));
+        ok(ret == i + 1, "got %d, error %u\n", ret, WSAGetLastError());
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        ret = WaitForSingleObject(ov[i].hEvent, 1000);
+        ok(!ret, "wait %u failed, got %d\n", i, ret);
+        ret = WSAGetOverlappedResult(dst, &ov[i], &size, FALSE, &flags);
+        ok(ret, "WSAGetOverlappedResult failed, error %u\n", WSAGetLastError());
+        ok(size == i + 1, "operation %u: got size %u\n", i, size);
+        ok(bufs[i][0] == '0' + i, "operation %u: got data %#x\n", i, bufs[i][0]);
+        ok(from[i].sin_family == AF_INET, "operation %u: got family %u\n", i, from[i].sin_family);
+        CloseHandle(ov[i].hEvent);
+    }
+
+    /* receives queued behind a pending one reset their event, and can be
+     * cancelled on their own, also when issued by another thread */
+    params.s = dst;
+    params.wsabuf = &wsabuf;
+    params.ov = &ov[1];
+    params.posted = CreateEventA(NULL, FALSE, FALSE, NULL);
+    params.done = CreateEventA(NULL, TRUE, FALSE, NULL);
+    for (i = 0; i < 3; i++)
+    {
+        memset(&ov[i], 0, sizeof(ov[i]));
+        ov[i].hEvent = CreateEventA(NULL, TRUE, TRUE, NULL);
+        wsabuf.buf = bufs[i];
+        wsabuf.len = sizeof(bufs[i]);
+        flags = 0;
+        if (i == 1)
+        {
+            thread = CreateThread(NULL, 0, recv_batch_thread, &params, 0, NULL);
+            ret = WaitForSingleObject(params.posted, 1000);
+            ok(!ret, "wait failed, got %d\n", ret);
+        }
+        else
+        {
+            ret = WSARecvFrom(dst, &wsabuf, 1, NULL, &flags, NULL, NULL, &ov[i], NULL);
+            ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING,
+               "got %d, error %u\n", ret, WSAGetLastError());
+        }
+        ret = WaitForSingleObject(ov[i].hEvent, 0);
+        ok(ret == WAIT_TIMEOUT, "operation %u: got %d\n", i, ret);
+    }
+
+    ret = CancelIoEx((HANDLE)dst, &ov[1]);
+    ok(ret, "CancelIoEx failed, error %u\n", GetLastError());
+    ret = WaitForSingleObject(ov[1].hEvent, 1000);
+    ok(!ret, "wait failed, got %d\n", ret);
+    ok(ov[1].Internal == STATUS_CANCELLED, "got status %#lx\n", ov[1].Internal);
+    ret = WaitForSingleObject(ov[0].hEvent, 0);
+    ok(ret == WAIT_TIMEOUT, "got %d\n", ret);
+
+    for (i = 0; i < 2; i++)
+    {
+        char data[2] = {'a' + i, 0};
+        ret = sendto(src, data, 1, 0, (struct sockaddr *)&addr, sizeof(addr));
+        ok(ret == 1, "got %d, error %u\n", ret, WSAGetLastError());
+    }
+    for (i = 0; i < 3; i += 2)
+    {
+        ret = WaitForSingleObject(ov[i].hEvent, 1000);
+        ok(!ret, "wait %u failed, got %d\n", i, ret);
+        ret = WSAGetOverlappedResult(dst, &ov[i], &size, FALSE, &flags);
+        ok(ret, "WSAGetOverlappedResult failed, error %u\n", WSAGetLastError());
+        ok(size == 1, "operation %u: got size %u\n", i, size);
+        ok(bufs[i][0] == 'a' + i / 2, "operation %u: got data %#x\n", i, bufs[i][0]);
+    }
+    for (i = 0; i < 3; i++) CloseHandle(ov[i].hEvent);
+    SetEvent(params.done);
+    WaitForSingleObject(thread, 1000);
+    CloseHandle(thread);
+    CloseHandle(params.posted);
+    CloseHandle(params.done);
+
+    /* closing the socket cancels all pending receives */
+    for (i = 0; i < 2; i++)
+    {
+        memset(&ov[i], 0, sizeof(ov[i]));
+        ov[i].hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        wsabuf.buf = bufs[i];
+        wsabuf.len = sizeof(bufs[i]);
+        flags = 0;
+        ret = WSARecvFrom(dst, &wsabuf, 1, NULL, &flags, NULL, NULL, &ov[i], NULL);
+        ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING,
+           "got %d, error %u\n", ret, WSAGetLastError());
+    }
+
+    closesocket(dst);
+
+    for (i = 0; i < 2; i++)
+    {
+        ret = WaitForSingleObject(ov[i].hEvent, 1000);
+        ok(!ret, "wait %u failed, got %d\n", i, ret);
+        ok(ov[i].Internal != STATUS_PENDING, "operation %u: got status %#lx\n", i, ov[i].Internal);
+        CloseHandle(ov[i].hEvent);
+    }
+
+    /* Wine-specific batch receive ioctl */
+    dst = socket(AF_INET, SOCK_DGRAM, 0);
+    ok(dst != INVALID_SOCKET, "socket failed, error %u\n", WSAGetLastError());
+    addr.sin_port = 0;
+    ret = bind(dst, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(dst, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %u\n", WSAGetLastError());
+
+    for (i = 0; i < 5; i++)
+    {
+        entries[i].buf.buf = bufs[i];
+        entries[i].buf.len = sizeof(bufs[i]);
+        entries[i].len = 0xdeadbeef;
+        entries[i].from = NULL;
+        entries[i].fromlen = 0;
+    }
+    entries[0].from = (struct sockaddr *)&from[0];
+    entries[0].fromlen = sizeof(from[0]);
+
+    for (i = 0; i < 3; i++)
+    {
+        char data[2] = {'a' + i, 0};
+        ret = sendto(src, data, i + 1, 0, (struct sockaddr *)&addr, sizeof(addr));
+        ok(ret == i + 1, "got %d, error %u\n", ret, WSAGetLastError());
+    }
+    Sleep(100);
+
+    count = 0xdeadbeef;
+    ret = WSAIoctl(dst, SIO_WINE_RECV_BATCH, entries, sizeof(entries), NULL, 0, &count, NULL, NULL);
+    if (ret == SOCKET_ERROR && (WSAGetLastError() == WSAEOPNOTSUPP || WSAGetLastError() == WSAEINVAL))
+    {
+        win_skip("SIO_WINE_RECV_BATCH is not supported\n");
+        closesocket(src);
+        closesocket(dst);
+        return;
+    }
+    ok(!ret, "WSAIoctl failed, error %u\n", WSAGetLastError());
+    ok(count == 3, "got count %u\n", count);
+    for (i = 0; i < 3; i++)
+    {
+        ok(entries[i].len == i + 1, "entry %u: got size %u\n", i, entries[i].len);
+        ok(bufs[i][0] == 'a' + i, "entry %u: got data %#x\n", i, bufs[i][0]);
+    }
+    ok(entries[3].len == 0xdeadbeef, "got size %u\n", entries[3].len);
+    ok(from[0].sin_family == AF_INET, "got family %u\n", from[0].sin_family);
+
+    set_blocking(dst, FALSE);
+    ret = WSAIoctl(dst, SIO_WINE_RECV_BATCH, entries, sizeof(entries), NULL, 0, &count, NULL, NULL);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK,
+       "got %d, error %u\n", ret, WSAGetLastError());
+
+    ret = WSAIoctl(dst, SIO_WINE_RECV_BATCH, entries, sizeof(entries) - 1, NULL, 0, &count, NULL, NULL);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSAEFAULT,
+       "got %d, error %u\n", ret, WSAGetLastError());
+
+    closesocket(src);
+    closesocket(dst);
+}
+
 struct write_watch_thread_args
 {
     int func;
@@ -6971,6 +7436,378 @@ static DWORD CALLBACK write_watch_thread( void *arg )
     return 0;
 }
 
+static DWORD routine_error, routine_size;
+static unsigned int routine_calls;
+
+static void WINAPI overlapped_io_routine(DWORD error, DWORD size, WSAOVERLAPPED *ovl, DWORD flags)
+{
+    routine_error = error;
+    routine_size = size;
+    routine_calls++;
+}
+
+/* overlapped operations which have to wait; also run with WINEURING=1 in a
+ * child process, so that they go through the io_uring backend on Wine */
+static void test_overlapped_io(void)
+{
+    static const DWORD big_size = 8 << 20;
+    struct sockaddr_in addr, from;
+    SOCKET src, dst, udp_src, udp_dst;
+    char buffer[32], path[MAX_PATH], *big;
+    ULONG_PTR key;
+    WSAOVERLAPPED ov, *povl;
+    DWORD size, flags, total;
+    HANDLE port, file;
+    WSABUF wsabuf;
+    int ret, len;
+
+    if (tcp_socketpair(&src, &dst))
+    {
+        skip("failed to create sockets\n");
+        return;
+    }
+
+    memset(&ov, 0, sizeof(ov));
+    ov.hEvent = CreateEventA(NULL, TRUE, TRUE, NULL);
+
+    /* the event is reset while the receive is pending */
+    wsabuf.buf = buffer;
+    wsabuf.len = sizeof(buffer);
+    flags = 0;
+    ret = WSARecv(dst, &wsabuf, 1, NULL, &flags, &ov, NULL);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = WaitForSingleObject(ov.hEvent, 100);
+    ok(ret == WAIT_TIMEOUT, "got %d\n", ret);
+
+    ret = send(src, "hello", 5, 0);
+    ok(ret == 5, "send returned %d\n", ret);
+    ret = WaitForSingleObject(ov.hEvent, 1000);
+    ok(!ret, "wait failed, got %d\n", ret);
+    ret = WSAGetOverlappedResult(dst, &ov, &size, FALSE, &flags);
+    ok(ret, "WSAGetOverlappedResult failed, error %u\n", WSAGetLastError());
+    ok(size == 5, "got size %u\n", size);
+    ok(!memcmp(buffer, "hello", 5), "got data %.*s\n", (int)size, buffer);
+
+    /* cancelling a pending receive */
+    ResetEvent(ov.hEvent);
+    ret = WSARecv(dst, &wsabuf, 1, NULL, &flags, &ov, NULL);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = CancelIoEx((HANDLE)dst, &ov);
+    ok(ret, "CancelIoEx failed, error %u\n", GetLastError());
+    ret = WaitForSingleObject(ov.hEvent, 1000);
+    ok(!ret, "wait failed, got %d\n", ret);
+    ret = WSAGetOverlappedResult(dst, &ov, &size, FALSE, &flags);
+    ok(!ret && WSAGetLastError() == WSA_OPERATION_ABORTED, "got %d, error %u\n", ret, WSAGetLastError());
+
+    /* completion routine */
+    routine_calls = 0;
+    ret = WSARecv(dst, &wsabuf, 1, NULL, &flags, &ov, overlapped_io_routine);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = send(src, "world!", 6, 0);
+    ok(ret == 6, "send returned %d\n", ret);
+    ret = SleepEx(1000, TRUE);
+    ok(ret == WAIT_IO_COMPLETION, "got %d\n", ret);
+    ok(routine_calls == 1, "got %u calls\n", routine_calls);
+    ok(!routine_error, "got error %u\n", routine_error);
+    ok(routine_size == 6, "got size %u\n", routine_size);
+
+    /* completion port, and a send that has to wait for the peer */
+    port = CreateIoCompletionPort((HANDLE)src, NULL, 0x1234, 0);
+    ok(port != NULL, "CreateIoCompletionPort failed, error %u\n", GetLastError());
+
+    big = HeapAlloc(GetProcessHeap(), 0, big_size);
+    memset(big, 0x55, big_size);
+    wsabuf.buf = big;
+    wsabuf.len = big_size;
+    ret = WSASend(src, &wsabuf, 1, &size, 0, &ov, NULL);
+    ok(!ret || WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", ret, WSAGetLastError());
+
+    for (total = 0; total < big_size; total += ret)
+    {
+        ret = recv(dst, big, min(big_size - total, 65536), 0);
+        if (ret <= 0) break;
+    }
+    ok(total == big_size, "received %u bytes\n", total);
+
+    ret = GetQueuedCompletionStatus(port, &size, &key, &povl, 1000);
+    ok(ret, "GetQueuedCompletionStatus failed, error %u\n", GetLastError());
+    ok(size == big_size, "got size %u\n", size);
+    ok(key == 0x1234, "got key %#lx\n", key);
+    ok(povl == &ov, "got overlapped %p\n", povl);
+    HeapFree(GetProcessHeap(), 0, big);
+
+    closesocket(src);
+    closesocket(dst);
+    CloseHandle(port);
+
+    /* datagram source address */
+    udp_dst = socket(AF_INET, SOCK_DGRAM, 0);
+    udp_src = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ret = bind(udp_src, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %u\n", WSAGetLastError());
+    ret = bind(udp_dst, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(udp_dst, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %u\n", WSAGetLastError());
+
+    ResetEvent(ov.hEvent);
+    wsabuf.buf = buffer;
+    wsabuf.len = sizeof(buffer);
+    len = sizeof(from);
+    memset(&from, 0, sizeof(from));
+    ret = WSARecvFrom(udp_dst, &wsabuf, 1, NULL, &flags, (struct sockaddr *)&from, &len, &ov, NULL);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = sendto(udp_src, "datagram", 8, 0, (struct sockaddr *)&addr, sizeof(addr));
+    ok(ret == 8, "sendto returned %d\n", ret);
+    ret = WaitForSingleObject(ov.hEvent, 1000);
+    ok(!ret, "wait failed, got %d\n", ret);
+    ret = WSAGetOverlappedResult(udp_dst, &ov, &size, FALSE, &flags);
+    ok(ret, "WSAGetOverlappedResult failed, error %u\n", WSAGetLastError());
+    ok(size == 8, "got size %u\n", size);
+    len = sizeof(addr);
+    ret = getsockname(udp_src, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %u\n", WSAGetLastError());
+    ok(from.sin_family == AF_INET, "got family %u\n", from.sin_family);
+    ok(from.sin_port == addr.sin_port, "got port %u, expected %u\n", ntohs(from.sin_port), ntohs(addr.sin_port));
+
+    closesocket(udp_src);
+    closesocket(udp_dst);
+
+    /* overlapped file I/O at an offset */
+    GetTempPathA(MAX_PATH, path);
+    GetTempFileNameA(path, "wso", 0, path);
+    file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                       FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "CreateFile failed, error %u\n", GetLastError());
+
+    ov.Offset = 4;
+    ov.OffsetHigh = 0;
+    ret = WriteFile(file, "0123456789", 10, NULL, &ov);
+    ok(ret || GetLastError() == ERROR_IO_PENDING, "WriteFile failed, error %u\n", GetLastError());
+    ret = GetOverlappedResult(file, &ov, &size, TRUE);
+    ok(ret, "GetOverlappedResult failed, error %u\n", GetLastError());
+    ok(size == 10, "got size %u\n", size);
+
+    ov.Offset = 8;
+    memset(buffer, 0, sizeof(buffer));
+    ret = ReadFile(file, buffer, sizeof(buffer), NULL, &ov);
+    ok(ret || GetLastError() == ERROR_IO_PENDING, "ReadFile failed, error %u\n", GetLastError());
+    ret = GetOverlappedResult(file, &ov, &size, TRUE);
+    ok(ret, "GetOverlappedResult failed, error %u\n", GetLastError());
+    ok(size == 6, "got size %u\n", size);
+    ok(!memcmp(buffer, "456789", 6), "got data %.*s\n", (int)size, buffer);
+
+    ov.Offset = 100;
+    ret = ReadFile(file, buffer, sizeof(buffer), NULL, &ov);
+    if (!ret && GetLastError() == ERROR_IO_PENDING)
+        ret = GetOverlappedResult(file, &ov, &size, TRUE);
+    ok(!ret && GetLastError() == ERROR_HANDLE_EOF, "got %d, error %u\n", ret, GetLastError());
+
+    CloseHandle(file);
+    CloseHandle(ov.hEvent);
+}
+
+struct mixed_read
+{
+    SOCKET sock;
+    IO_STATUS_BLOCK io;
+    char buffer;
+};
+
+static DWORD WINAPI mixed_read_thread(void *arg)
+{
+    struct mixed_read *read = arg;
+    NTSTATUS status;
+
+    /* without an event, an apc or a completion value, only the handle is signaled */
+    status = pNtReadFile((HANDLE)read->sock, NULL, NULL, NULL, &read->io, &read->buffer, 1, NULL, NULL);
+    ok(status == STATUS_PENDING, "got %#x\n", status);
+    return 0;
+}
+
+/* requests reported in different ways complete in the order they were issued */
+static void test_overlapped_mixed(void)
+{
+    struct mixed_read read;
+    SOCKET src, dst;
+    WSAOVERLAPPED ov;
+    HANDLE thread;
+    DWORD size, flags, i;
+    char buffer;
+    WSABUF wsabuf;
+    int ret;
+
+    if (!pNtReadFile)
+    {
+        win_skip("NtReadFile is not available\n");
+        return;
+    }
+    if (tcp_socketpair(&src, &dst))
+    {
+        skip("failed to create sockets\n");
+        return;
+    }
+
+    memset(&ov, 0, sizeof(ov));
+    ov.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    wsabuf.buf = &buffer;
+    wsabuf.len = 1;
+    flags = 0;
+    ret = WSARecv(dst, &wsabuf, 1, NULL, &flags, &ov, NULL);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", ret, WSAGetLastError());
+
+    /* the second read may have to wait for the first one to be issued */
+    memset(&read, 0, sizeof(read));
+    read.sock = dst;
+    read.io.Status = STATUS_PENDING;
+    thread = CreateThread(NULL, 0, mixed_read_thread, &read, 0, NULL);
+    Sleep(100);
+
+    ret = send(src, "ab", 2, 0);
+    ok(ret == 2, "send returned %d\n", ret);
+    ret = WaitForSingleObject(ov.hEvent, 1000);
+    ok(!ret, "wait failed, got %d\n", ret);
+    ret = WSAGetOverlappedResult(dst, &ov, &size, FALSE, &flags);
+    ok(ret, "WSAGetOverlappedResult failed, error %u\n", WSAGetLastError());
+    ok(size == 1, "got size %u\n", size);
+    ok(buffer == 'a', "got %c\n", buffer);
+
+    ret = WaitForSingleObject(thread, 1000);
+    ok(!ret, "wait failed, got %d\n", ret);
+    CloseHandle(thread);
+    for (i = 0; i < 100 && read.io.Status == STATUS_PENDING; i++) Sleep(10);
+    ok(!read.io.Status, "got status %#x\n", read.io.Status);
+    ok(read.io.Information == 1, "got size %lu\n", read.io.Information);
+    ok(read.buffer == 'b', "got %c\n", read.buffer);
+
+    closesocket(src);
+    closesocket(dst);
+    CloseHandle(ov.hEvent);
+}
+
+/* requests can be cancelled through any handle to the socket */
+static void test_overlapped_cancel_duplicate(void)
+{
+    SOCKET src, dst;
+    WSAOVERLAPPED ov;
+    DWORD size, flags;
+    char buffer[32];
+    WSABUF wsabuf;
+    HANDLE dup;
+    int ret;
+
+    if (tcp_socketpair(&src, &dst))
+    {
+        skip("failed to create sockets\n");
+        return;
+    }
+
+    memset(&ov, 0, sizeof(ov));
+    ov.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    wsabuf.buf = buffer;
+    wsabuf.len = sizeof(buffer);
+    flags = 0;
+    ret = WSARecv(dst, &wsabuf, 1, NULL, &flags, &ov, NULL);
+    ok(ret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", ret, WSAGetLastError());
+
+    ret = DuplicateHandle(GetCurrentProcess(), (HANDLE)dst, GetCurrentProcess(), &dup, 0, FALSE,
+                          DUPLICATE_SAME_ACCESS);
+    ok(ret, "DuplicateHandle failed, error %u\n", GetLastError());
+    ret = CancelIoEx(dup, &ov);
+    ok(ret, "CancelIoEx failed, error %u\n", GetLastError());
+    ret = WaitForSingleObject(ov.hEvent, 1000);
+    ok(!ret, "wait failed, got %d\n", ret);
+    ret = WSAGetOverlappedResult(dst, &ov, &size, FALSE, &flags);
+    ok(!ret && WSAGetLastError() == WSA_OPERATION_ABORTED, "got %d, error %u\n", ret, WSAGetLastError());
+
+    /* nothing left to cancel */
+    ret = CancelIoEx(dup, &ov);
+    ok(!ret && GetLastError() == ERROR_NOT_FOUND, "got %d, error %u\n", ret, GetLastError());
+
+    CloseHandle(dup);
+    closesocket(src);
+    closesocket(dst);
+    CloseHandle(ov.hEvent);
+}
+
+/* Not a test: measures the echo throughput of overlapped TCP receives and
+ * sends through a completion port, to compare the server and io_uring paths
+ * on Wine. Only run in interactive mode. */
+static void test_echo_throughput(void)
+{
+    static const unsigned int count = 100000;
+    SOCKET src, dst;
+    WSAOVERLAPPED ov, *povl;
+    char buffer[64], reply[64];
+    DWORD size, flags, start, i;
+    ULONG_PTR key;
+    WSABUF wsabuf;
+    HANDLE port;
+    int ret;
+
+    if (!winetest_interactive) return;
+
+    if (tcp_socketpair(&src, &dst))
+    {
+        skip("failed to create sockets\n");
+        return;
+    }
+    port = CreateIoCompletionPort((HANDLE)dst, NULL, 0, 0);
+    memset(&ov, 0, sizeof(ov));
+    memset(buffer, 'x', sizeof(buffer));
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        wsabuf.buf = reply;
+        wsabuf.len = sizeof(reply);
+        flags = 0;
+        ret = WSARecv(dst, &wsabuf, 1, NULL, &flags, &ov, NULL);
+        if (ret && WSAGetLastError() != WSA_IO_PENDING) break;
+        send(src, buffer, sizeof(buffer), 0);
+        if (!GetQueuedCompletionStatus(port, &size, &key, &povl, 1000)) break;
+
+        wsabuf.len = size;
+        ret = WSASend(dst, &wsabuf, 1, NULL, 0, &ov, NULL);
+        if (ret && WSAGetLastError() != WSA_IO_PENDING) break;
+        if (!GetQueuedCompletionStatus(port, &size, &key, &povl, 1000)) break;
+        recv(src, buffer, size, 0);
+    }
+    ok(i == count, "echo failed after %u messages, error %u\n", i, GetLastError());
+    trace("%u echoed messages in %u ms\n", i, GetTickCount() - start);
+
+    closesocket(src);
+    closesocket(dst);
+    CloseHandle(port);
+}
+
+static void test_uring(void)
+{
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmdline[MAX_PATH + 16], **argv;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" sock uring", argv[0]);
+    memset(&startup, 0, sizeof(startup));
+    startup.cb = sizeof(startup);
+
+    SetEnvironmentVariableA("WINEURING", "1");
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info);
+    SetEnvironmentVariableA("WINEURING", NULL);
+    ok(ret, "CreateProcess failed, error %u\n", GetLastError());
+    if (!ret) return;
+
+    winetest_wait_child_process(info.hProcess);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+}
+
 static void test_write_watch(void)
 {
     SOCKET src, dest;
@@ -11516,8 +12353,20 @@ static void test_iocp(void)
 
 START_TEST( sock )
 {
+    char **argv;
     int i;
 
+    if (winetest_get_mainargs(&argv) >= 3 && !strcmp(argv[2], "uring"))
+    {
+        Init();
+        test_overlapped_io();
+        test_overlapped_mixed();
+        test_overlapped_cancel_duplicate();
+        test_echo_throughput();
+        Exit();
+        return;
+    }
+
 /* Leave these tests at the beginning. They depend on WSAStartup not having been
  * called, which is done by Init() below. */
     test_WithoutWSAStartup();
@@ -11555,6 +12404,9 @@ START_TEST( sock )
     test_errors();
     test_listen();
     test_select();
+    test_select_many();
+    test_select_many_close();
+    test_socket_state_handle_reuse();
     test_accept();
     test_getpeername();
     test_getsockname();
@@ -11569,6 +12421,12 @@ START_TEST( sock )
     test_WSASendMsg();
     test_WSASendTo();
     test_WSARecv();
+    test_WSARecvFrom_batch();
+    test_overlapped_io();
+    test_overlapped_mixed();
+    test_overlapped_cancel_duplicate();
+    test_echo_throughput();
+    test_uring();
     test_WSAPoll();
     test_write_watch();
     test_iocp();
@@ -741,6 +741,24 @@ typedef struct
 #define IMAGE_FLAGS_WineBuiltin               0x40
 #define IMAGE_FLAGS_WineFakeDll               0x80
 
+struct completion_packet
+{
+    apc_param_t    ckey;
+    apc_param_t    cvalue;
+    apc_param_t    information;
+    unsigned int   status;
+    unsigned int   __pad;
+};
+
+struct socket_shared_state
+{
+    unsigned int   serial;
+    unsigned int   state;
+    unsigned int   mask;
+    unsigned int   __pad;
+    unsigned __int64 inode;
+};
+
 struct rawinput_device
 {
     unsigned short usage_page;
@@ -1752,6 +1770,24 @@ struct get_socket_info_reply
 
 
 
+struct get_socket_shared_state_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    int          need_file;
+    char __pad_20[4];
+};
+struct get_socket_shared_state_reply
+{
+    struct reply_header __header;
+    unsigned int index;
+    unsigned int serial;
+    obj_handle_t file;
+    char __pad_20[4];
+};
+
+
+
 struct enable_socket_event_request
 {
     struct request_header __header;
@@ -2397,6 +2433,40 @@ struct is_same_mapping_reply
 };
 
 
+
+struct get_relocated_image_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+    client_ptr_t base;
+};
+struct get_relocated_image_reply
+{
+    struct reply_header __header;
+    mem_size_t   start;
+    mem_size_t   end;
+    obj_handle_t file;
+    char __pad_28[4];
+};
+
+
+
+struct set_relocated_image_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+    client_ptr_t base;
+    mem_size_t   start;
+    mem_size_t   end;
+    int          fd;
+    char __pad_44[4];
+};
+struct set_relocated_image_reply
+{
+    struct reply_header __header;
+};
+
+
 #define SNAP_PROCESS    0x00000001
 #define SNAP_THREAD     0x00000002
 
@@ -5440,6 +5510,19 @@ struct remove_completion_reply
 
 
 
+struct remove_completions_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct remove_completions_reply
+{
+    struct reply_header __header;
+    /* VARARG(packets,completion_packets); */
+};
+
+
+
 struct query_completion_request
 {
     struct request_header __header;
@@ -5824,12 +5907,12 @@ struct open_esync_reply
 };
 
 
-struct get_esync_fd_request
+struct get_esync_read_fd_request
 {
     struct request_header __header;
     obj_handle_t handle;
 };
-struct get_esync_fd_reply
+struct get_esync_read_fd_reply
 {
     struct reply_header __header;
     int          type;
@@ -5837,6 +5920,17 @@ struct get_esync_fd_reply
 };
 
 
+struct get_esync_write_fd_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct get_esync_write_fd_reply
+{
+    struct reply_header __header;
+};
+
+
 struct get_esync_apc_fd_request
 {
     struct request_header __header;
@@ -5867,6 +5961,43 @@ enum esync_type
     ESYNC_AUTO_SERVER,
     ESYNC_MANUAL_SERVER,
     ESYNC_QUEUE,
+    ESYNC_COMPLETION,
+};
+
+/* Shared packet queue of a completion port.
+ * Packets posted by clients are stored here; packets generated by the server
+ * are kept in the server's own list. Either kind adds one to the count of the
+ * port's eventfd. Entries use a bounded MPMC queue whose sequence numbers are
+ * stored relative to the entry index, so that a zero-filled queue is empty. */
+#define COMPLETION_QUEUE_ENTRIES 4096
+
+struct completion_queue_entry
+{
+    int          seq;
+    unsigned int status;
+    apc_param_t  ckey;
+    apc_param_t  cvalue;
+    apc_param_t  information;
+};
+
+struct completion_queue
+{
+    int          head;
+    int          __pad1[15];
+    int          tail;
+    int          __pad2[15];
+    struct completion_queue_entry entries[COMPLETION_QUEUE_ENTRIES];
+};
+
+
+struct get_esync_completion_fds_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct get_esync_completion_fds_reply
+{
+    struct reply_header __header;
 };
 
 
@@ -5931,6 +6062,7 @@ enum request
     REQ_set_socket_event,
     REQ_get_socket_event,
     REQ_get_socket_info,
+    REQ_get_socket_shared_state,
     REQ_enable_socket_event,
     REQ_set_socket_deferred,
     REQ_alloc_console,
@@ -5965,6 +6097,8 @@ enum request
     REQ_get_mapping_committed_range,
     REQ_add_mapping_committed_range,
     REQ_is_same_mapping,
+    REQ_get_relocated_image,
+    REQ_set_relocated_image,
     REQ_create_snapshot,
     REQ_next_process,
     REQ_next_thread,
@@ -6147,6 +6281,7 @@ enum request
     REQ_open_completion,
     REQ_add_completion,
     REQ_remove_completion,
+    REQ_remove_completions,
     REQ_query_completion,
     REQ_set_completion_info,
     REQ_add_fd_completion,
@@ -6172,9 +6307,11 @@ enum request
     REQ_resume_process,
     REQ_create_esync,
     REQ_open_esync,
-    REQ_get_esync_fd,
+    REQ_get_esync_read_fd,
+    REQ_get_esync_write_fd,
     REQ_get_esync_apc_fd,
     REQ_esync_msgwait,
+    REQ_get_esync_completion_fds,
     REQ_NB_REQUESTS
 };
 
@@ -6241,6 +6378,7 @@ union generic_request
     struct set_socket_event_request set_socket_event_request;
     struct get_socket_event_request get_socket_event_request;
     struct get_socket_info_request get_socket_info_request;
+    struct get_socket_shared_state_request get_socket_shared_state_request;
     struct enable_socket_event_request enable_socket_event_request;
     struct set_socket_deferred_request set_socket_deferred_request;
     struct alloc_console_request alloc_console_request;
@@ -6275,6 +6413,8 @@ union generic_request
     struct get_mapping_committed_range_request get_mapping_committed_range_request;
     struct add_mapping_committed_range_request add_mapping_committed_range_request;
     struct is_same_mapping_request is_same_mapping_request;
+    struct get_relocated_image_request get_relocated_image_request;
+    struct set_relocated_image_request set_relocated_image_request;
     struct create_snapshot_request create_snapshot_request;
     struct next_process_request next_process_request;
     struct next_thread_request next_thread_request;
@@ -6457,6 +6597,7 @@ union generic_request
     struct open_completion_request open_completion_request;
     struct add_completion_request add_completion_request;
     struct remove_completion_request remove_completion_request;
+    struct remove_completions_request remove_completions_request;
     struct query_completion_request query_completion_request;
     struct set_completion_info_request set_completion_info_request;
     struct add_fd_completion_request add_fd_completion_request;
@@ -6482,9 +6623,11 @@ union generic_request
     struct resume_process_request resume_process_request;
     struct create_esync_request create_esync_request;
     struct open_esync_request open_esync_request;
-    struct get_esync_fd_request get_esync_fd_request;
+    struct get_esync_read_fd_request get_esync_read_fd_request;
+    struct get_esync_write_fd_request get_esync_write_fd_request;
     struct get_esync_apc_fd_request get_esync_apc_fd_request;
     struct esync_msgwait_request esync_msgwait_request;
+    struct get_esync_completion_fds_request get_esync_completion_fds_request;
 };
 union generic_reply
 {
@@ -6549,6 +6692,7 @@ union generic_reply
     struct set_socket_event_reply set_socket_event_reply;
     struct get_socket_event_reply get_socket_event_reply;
     struct get_socket_info_reply get_socket_info_reply;
+    struct get_socket_shared_state_reply get_socket_shared_state_reply;
     struct enable_socket_event_reply enable_socket_event_reply;
     struct set_socket_deferred_reply set_socket_deferred_reply;
     struct alloc_console_reply alloc_console_reply;
@@ -6583,6 +6727,8 @@ union generic_reply
     struct get_mapping_committed_range_reply get_mapping_committed_range_reply;
     struct add_mapping_committed_range_reply add_mapping_committed_range_reply;
     struct is_same_mapping_reply is_same_mapping_reply;
+    struct get_relocated_image_reply get_relocated_image_reply;
+    struct set_relocated_image_reply set_relocated_image_reply;
     struct create_snapshot_reply create_snapshot_reply;
     struct next_process_reply next_process_reply;
     struct next_thread_reply next_thread_reply;
@@ -6765,6 +6911,7 @@ union generic_reply
     struct open_completion_reply open_completion_reply;
     struct add_completion_reply add_completion_reply;
     struct remove_completion_reply remove_completion_reply;
+    struct remove_completions_reply remove_completions_reply;
     struct query_completion_reply query_completion_reply;
     struct set_completion_info_reply set_completion_info_reply;
     struct add_fd_completion_reply add_fd_completion_reply;
@@ -6790,11 +6937,13 @@ union generic_reply
     struct resume_process_reply resume_process_reply;
     struct create_esync_reply create_esync_reply;
     struct open_esync_reply open_esync_reply;
-    struct get_esync_fd_reply get_esync_fd_reply;
+    struct get_esync_read_fd_reply get_esync_read_fd_reply;
+    struct get_esync_write_fd_reply get_esync_write_fd_reply;
     struct get_esync_apc_fd_reply get_esync_apc_fd_reply;
     struct esync_msgwait_reply esync_msgwait_reply;
+    struct get_esync_completion_fds_reply get_esync_completion_fds_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 584
+#define SERVER_PROTOCOL_VERSION 592
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
@@ -0,0 +1,52 @@
+/*
+ * Wine-specific Winsock extensions
+ *
+ * Copyright (C) the Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_WS2_32_H
+#define __WINE_WINE_WS2_32_H
+
+#include <winsock2.h>
+
+#ifdef USE_WS_PREFIX
+#define WS(x)    WS_##x
+#else
+#define WS(x)    x
+#endif
+
+/* Receive several datagrams with one call. The input buffer is an array of
+ * WINE_RECV_BATCH_ENTRY structures, and the returned size is the number of
+ * entries that were filled. The call waits for the first datagram on blocking
+ * sockets, but never for the following ones. */
+#ifndef USE_WS_PREFIX
+#define SIO_WINE_RECV_BATCH    _WSAIORW(IOC_VENDOR, 0x7700)
+#else
+#define WS_SIO_WINE_RECV_BATCH _WSAIORW(WS_IOC_VENDOR, 0x7700)
+#endif
+
+typedef struct _WINE_RECV_BATCH_ENTRY
+{
+    WSABUF              buf;      /* [in] buffer for one datagram */
+    DWORD               len;      /* [out] size of the received datagram */
+    struct WS(sockaddr) *from;    /* [out] source address, may be NULL */
+    INT                 fromlen;  /* [in/out] size of the from buffer */
+} WINE_RECV_BATCH_ENTRY;
+
+#undef WS
+
+#endif /* __WINE_WINE_WS2_32_H */
@@ -24,13 +24,19 @@
  *    + threads are awaken FIFO and not LIFO as native does
  *    + "max concurrent active threads" parameter not used
  *    + completion handle is waitable, while native isn't
+ *  - with esync, waiting on the handle only sees packets posted via the server
  */
 
 #include "config.h"
 #include "wine/port.h"
 
+#include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -42,6 +48,7 @@
 #include "file.h"
 #include "handle.h"
 #include "request.h"
+#include "esync.h"
 
 
 struct completion
@@ -49,9 +56,13 @@ struct completion
     struct object  obj;
     struct list    queue;
     unsigned int   depth;
+    int            shared_fd;   /* fd of the shared packet queue */
+    struct completion_queue *shared;  /* server mapping of the shared packet queue */
+    struct esync_fd *esync_fd;  /* packet count, shared with the clients */
 };
 
 static void completion_dump( struct object*, int );
+static unsigned int get_shared_depth( struct completion *completion );
 static struct object_type *completion_get_type( struct object *obj );
 static int completion_signaled( struct object *obj, struct wait_queue_entry *entry );
 static unsigned int completion_map_access( struct object *obj, unsigned int access );
@@ -99,6 +110,9 @@ static void completion_destroy( struct object *obj)
     {
         free( tmp );
     }
+    if (completion->shared) munmap( completion->shared, sizeof(*completion->shared) );
+    if (completion->shared_fd != -1) close( completion->shared_fd );
+    if (completion->esync_fd) esync_close_fd( completion->esync_fd );
 }
 
 static void completion_dump( struct object *obj, int verbose )
@@ -106,7 +120,7 @@ static void completion_dump( struct object *obj, int verbose )
     struct completion *completion = (struct completion *) obj;
 
     assert( obj->ops == &completion_ops );
-    fprintf( stderr, "Completion depth=%u\n", completion->depth );
+    fprintf( stderr, "Completion depth=%u shared=%u\n", completion->depth, get_shared_depth( completion ) );
 }
 
 static struct object_type *completion_get_type( struct object *obj )
@@ -120,7 +134,43 @@ static int completion_signaled( struct object *obj, struct wait_queue_entry *ent
 {
     struct completion *completion = (struct completion *)obj;
 
-    return !list_empty( &completion->queue );
+    return !list_empty( &completion->queue ) || get_shared_depth( completion );
+}
+
+/* number of packets in the shared queue; only a snapshot, clients update it concurrently */
+static unsigned int get_shared_depth( struct completion *completion )
+{
+    int depth;
+
+    if (!completion->shared) return 0;
+    depth = completion->shared->head - completion->shared->tail;
+    return depth > 0 ? depth : 0;
+}
+
+/* create the shared packet queue used by the client-side fast path */
+static void init_shared_queue( struct completion *completion )
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    void *ptr;
+
+    if (!do_esync()) return;
+
+    if ((completion->shared_fd = create_temp_file( sizeof(*completion->shared) )) == -1)
+    {
+        clear_error();
+        return;
+    }
+    ptr = mmap( NULL, sizeof(*completion->shared), PROT_READ | PROT_WRITE, MAP_SHARED,
+                completion->shared_fd, 0 );
+    if (ptr == MAP_FAILED)
+    {
+        close( completion->shared_fd );
+        completion->shared_fd = -1;
+        return;
+    }
+    completion->shared = ptr;
+    completion->esync_fd = esync_create_fd( 0, 1 );
+#endif
 }
 
 static unsigned int completion_map_access( struct object *obj, unsigned int access )
@@ -144,6 +194,10 @@ static struct completion *create_completion( struct object *root, const struct u
         {
             list_init( &completion->queue );
             completion->depth = 0;
+            completion->shared_fd = -1;
+            completion->shared = NULL;
+            completion->esync_fd = NULL;
+            init_shared_queue( completion );
         }
     }
 
@@ -171,6 +225,7 @@ void add_completion( struct completion *completion, apc_param_t ckey, apc_param_
     list_add_tail( &completion->queue, &msg->queue_entry );
     completion->depth++;
     wake_up( &completion->obj, 1 );
+    if (completion->esync_fd) esync_wake_fd( completion->esync_fd );
 }
 
 /* create a completion */
@@ -242,6 +297,38 @@ DECL_HANDLER(remove_completion)
     release_object( completion );
 }
 
+/* get several completions from completion port */
+DECL_HANDLER(remove_completions)
+{
+    struct completion* completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+    struct completion_packet *packets;
+    struct comp_msg *msg;
+    unsigned int i, count;
+
+    if (!completion) return;
+
+    count = min( completion->depth, get_reply_max_size() / sizeof(*packets) );
+    if (list_empty( &completion->queue ))
+        set_error( STATUS_PENDING );
+    else if ((packets = set_reply_data_size( count * sizeof(*packets) )))
+    {
+        for (i = 0; i < count; i++)
+        {
+            msg = LIST_ENTRY( list_head( &completion->queue ), struct comp_msg, queue_entry );
+            list_remove( &msg->queue_entry );
+            completion->depth--;
+            packets[i].ckey        = msg->ckey;
+            packets[i].cvalue      = msg->cvalue;
+            packets[i].information = msg->information;
+            packets[i].status      = msg->status;
+            packets[i].__pad       = 0;
+            free( msg );
+        }
+    }
+
+    release_object( completion );
+}
+
 /* get queue depth for completion port */
 DECL_HANDLER(query_completion)
 {
@@ -249,7 +336,25 @@ DECL_HANDLER(query_completion)
 
     if (!completion) return;
 
-    reply->depth = completion->depth;
+    reply->depth = completion->depth + get_shared_depth( completion );
+
+    release_object( completion );
+}
+
+/* get the shared packet queue of a completion port */
+DECL_HANDLER(get_esync_completion_fds)
+{
+    struct completion *completion = get_completion_obj( current->process, req->handle,
+                                                        IO_COMPLETION_MODIFY_STATE );
+
+    if (!completion) return;
+
+    if (completion->esync_fd)
+    {
+        send_client_fd( current->process, completion->shared_fd, req->handle );
+        esync_send_fd( completion->esync_fd, req->handle );
+    }
+    else set_error( STATUS_NOT_IMPLEMENTED );
 
     release_object( completion );
 }
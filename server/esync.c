@@ -434,6 +434,16 @@ void esync_clear( struct esync_fd *fd )
 #endif
 }
 
+/* Send the read side of an fd to the current client. */
+void esync_send_fd( struct esync_fd *fd, obj_handle_t handle )
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    send_client_fd( current->process, fd->fd, handle );
+#else
+    send_client_fd( current->process, fd->fds[0], handle );
+#endif
+}
+
 static inline void small_pause(void)
 {
 #ifdef __i386__
@@ -29,6 +29,7 @@ void esync_close_fd( struct esync_fd *fd );
 void esync_wake_fd( struct esync_fd *fd );
 void esync_wake_up( struct object *obj );
 void esync_clear( struct esync_fd *fd );
+void esync_send_fd( struct esync_fd *fd, obj_handle_t handle );
 
 struct esync;
 
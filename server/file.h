@@ -158,6 +158,8 @@ extern struct mapping *get_mapping_obj( struct process *process, obj_handle_t ha
 extern struct file *get_mapping_file( struct process *process, client_ptr_t base,
                                       unsigned int access, unsigned int sharing );
 extern void free_mapped_views( struct process *process );
+extern int create_temp_file( file_pos_t size );
+extern int create_shared_temp_file( file_pos_t size, int *readonly_fd );
 extern int get_page_size(void);
 
 /* device functions */
@@ -22,6 +22,7 @@
 #include "wine/port.h"
 
 #include <assert.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -121,6 +122,55 @@ static const struct object_ops shared_map_ops =
 
 static struct list shared_map_list = LIST_INIT( shared_map_list );
 
+/* pages of a PE image relocated at a given address, shared between processes */
+struct relocated_image
+{
+    struct object   obj;             /* object header */
+    struct fd      *fd;              /* file descriptor of the mapped PE file */
+    file_pos_t      file_size;       /* size of the PE file when the pages were stored */
+    time_t          file_mtime;      /* modification time of the PE file when the pages were stored */
+    client_ptr_t    base;            /* address the image was relocated to */
+    mem_size_t      size;            /* image size */
+    mem_size_t      start;           /* start of the relocated range */
+    mem_size_t      end;             /* end of the relocated range */
+    struct file    *file;            /* sealed file holding the relocated pages */
+    struct list     entry;           /* entry in global relocated images list */
+};
+
+static void relocated_image_dump( struct object *obj, int verbose );
+static void relocated_image_destroy( struct object *obj );
+
+static const struct object_ops relocated_image_ops =
+{
+    sizeof(struct relocated_image), /* size */
+    relocated_image_dump,      /* dump */
+    no_get_type,               /* get_type */
+    no_add_queue,              /* add_queue */
+    NULL,                      /* remove_queue */
+    NULL,                      /* signaled */
+    NULL,                      /* get_esync_fd */
+    NULL,                      /* satisfied */
+    no_signal,                 /* signal */
+    no_get_fd,                 /* get_fd */
+    no_map_access,             /* map_access */
+    default_get_sd,            /* get_sd */
+    default_set_sd,            /* set_sd */
+    no_lookup_name,            /* lookup_name */
+    no_link_name,              /* link_name */
+    NULL,                      /* unlink_name */
+    no_open_file,              /* open_file */
+    no_kernel_obj_list,        /* get_kernel_obj_list */
+    no_close_handle,           /* close_handle */
+    relocated_image_destroy    /* destroy */
+};
+
+static struct list relocated_image_list = LIST_INIT( relocated_image_list );
+
+#ifdef F_GET_SEALS
+/* seals required on the files holding relocated pages */
+#define RELOCATED_IMAGE_SEALS (F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE)
+#endif
+
 /* memory view mapped in client address space */
 struct memory_view
 {
@@ -128,6 +178,7 @@ struct memory_view
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct relocated_image *relocated; /* relocated pages shared with other processes */
     unsigned int    flags;           /* SEC_* flags */
     client_ptr_t    base;            /* view base address (in process addr space) */
     mem_size_t      size;            /* view size */
@@ -223,6 +274,23 @@ static void shared_map_destroy( struct object *obj )
     list_remove( &shared->entry );
 }
 
+static void relocated_image_dump( struct object *obj, int verbose )
+{
+    struct relocated_image *image = (struct relocated_image *)obj;
+    fprintf( stderr, "Relocated image fd=%p base=%08x%08x range=%x-%x file=%p\n", image->fd,
+             (unsigned int)(image->base >> 32), (unsigned int)image->base,
+             (unsigned int)image->start, (unsigned int)image->end, image->file );
+}
+
+static void relocated_image_destroy( struct object *obj )
+{
+    struct relocated_image *image = (struct relocated_image *)obj;
+
+    release_object( image->fd );
+    release_object( image->file );
+    list_remove( &image->entry );
+}
+
 /* extend a file beyond the current end of file */
 static int grow_file( int unix_fd, file_pos_t new_size )
 {
@@ -264,8 +332,8 @@ static int check_current_dir_for_exec(void)
     return (ret != MAP_FAILED);
 }
 
-/* create a temp file for anonymous mappings */
-static int create_temp_file( file_pos_t size )
+/* create a temp file for anonymous mappings, optionally with an additional read-only fd */
+static int open_temp_file( file_pos_t size, int *readonly_fd )
 {
     static int temp_dir_fd = -1;
     char tmpfn[] = "anonmap.XXXXXX";
@@ -294,6 +362,12 @@ static int create_temp_file( file_pos_t size )
             close( fd );
             fd = -1;
         }
+        else if (readonly_fd && (*readonly_fd = open( tmpfn, O_RDONLY )) == -1)
+        {
+            file_set_error();
+            close( fd );
+            fd = -1;
+        }
         unlink( tmpfn );
     }
     else file_set_error();
@@ -302,6 +376,18 @@ static int create_temp_file( file_pos_t size )
     return fd;
 }
 
+/* create a temp file for anonymous mappings */
+int create_temp_file( file_pos_t size )
+{
+    return open_temp_file( size, NULL );
+}
+
+/* create a temp file, along with a read-only fd on it to share with the clients */
+int create_shared_temp_file( file_pos_t size, int *readonly_fd )
+{
+    return open_temp_file( size, readonly_fd );
+}
+
 /* find a memory view from its base address */
 static struct memory_view *find_mapped_view( struct process *process, client_ptr_t base )
 {
@@ -319,6 +405,7 @@ static void free_memory_view( struct memory_view *view )
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    if (view->relocated) release_object( view->relocated );
     list_remove( &view->entry );
     free( view );
 }
@@ -745,6 +832,34 @@ static unsigned int get_image_params( struct mapping *mapping, file_pos_t file_s
     return STATUS_SUCCESS;
 }
 
+/* get the current state of the file mapped by an image view */
+static int get_view_file_stat( struct memory_view *view, struct stat *st )
+{
+    int unix_fd = get_unix_fd( view->fd );
+
+    if (unix_fd == -1) return -1;
+    if (fstat( unix_fd, st ) == -1)
+    {
+        file_set_error();
+        return -1;
+    }
+    return 0;
+}
+
+/* find the relocated pages of the image mapped by a view */
+static struct relocated_image *find_relocated_image( struct memory_view *view, const struct stat *st )
+{
+    struct relocated_image *image;
+
+    LIST_FOR_EACH_ENTRY( image, &relocated_image_list, struct relocated_image, entry )
+    {
+        if (image->base != view->base || image->size != view->size) continue;
+        if (image->file_size != st->st_size || image->file_mtime != st->st_mtime) continue;
+        if (is_same_file_fd( image->fd, view->fd )) return (struct relocated_image *)grab_object( image );
+    }
+    return NULL;
+}
+
 static struct ranges *create_ranges(void)
 {
     struct ranges *ranges = alloc_object( &ranges_ops );
@@ -1052,6 +1167,7 @@ DECL_HANDLER(map_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = mapping->committed ? (struct ranges *)grab_object( mapping->committed ) : NULL;
         view->shared    = mapping->shared ? (struct shared_map *)grab_object( mapping->shared ) : NULL;
+        view->relocated = NULL;
         list_add_tail( &current->process->views, &view->entry );
     }
 
@@ -1095,3 +1211,88 @@ DECL_HANDLER(is_same_mapping)
         !is_same_file_fd( view1->fd, view2->fd ))
         set_error( STATUS_NOT_SAME_DEVICE );
 }
+
+/* get the relocated pages of an image view stored by another process for the view address */
+DECL_HANDLER(get_relocated_image)
+{
+    struct memory_view *view = find_mapped_view( current->process, req->base );
+    struct stat st;
+
+    if (!view) return;
+    if (!view->fd || !(view->flags & SEC_IMAGE))
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        return;
+    }
+    if (!view->relocated)
+    {
+        if (get_view_file_stat( view, &st ) == -1) return;
+        if (!(view->relocated = find_relocated_image( view, &st )))
+        {
+            set_error( STATUS_NOT_FOUND );
+            return;
+        }
+    }
+    reply->start = view->relocated->start;
+    reply->end   = view->relocated->end;
+    reply->file  = alloc_handle( current->process, view->relocated->file, FILE_READ_DATA, 0 );
+}
+
+/* store the pages of an image view relocated by the client at the view address */
+DECL_HANDLER(set_relocated_image)
+{
+    struct memory_view *view;
+    struct relocated_image *image;
+    struct file *file;
+    struct stat st;
+    int unix_fd = thread_get_inflight_fd( current, req->fd );
+
+    if (unix_fd == -1)
+    {
+        set_error( STATUS_INVALID_HANDLE );
+        return;
+    }
+    if (!(view = find_mapped_view( current->process, req->base ))) goto failed;
+    if (!view->fd || !(view->flags & SEC_IMAGE) || view->relocated ||
+        req->start >= req->end || req->end > view->size || ((req->start | req->end) & page_mask))
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        goto failed;
+    }
+    if (get_view_file_stat( view, &st ) == -1) goto failed;
+    if ((view->relocated = find_relocated_image( view, &st ))) goto failed;  /* already stored */
+
+    /* the pages must not be modifiable by anybody once they are stored */
+#ifdef F_GET_SEALS
+    if ((fcntl( unix_fd, F_GET_SEALS ) & RELOCATED_IMAGE_SEALS) != RELOCATED_IMAGE_SEALS ||
+        lseek( unix_fd, 0, SEEK_END ) < req->end)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        goto failed;
+    }
+#else
+    set_error( STATUS_NOT_SUPPORTED );
+    goto failed;
+#endif
+
+    if (!(file = create_file_for_fd( unix_fd, FILE_GENERIC_READ, FILE_SHARE_READ ))) return;
+    if (!(image = alloc_object( &relocated_image_ops )))
+    {
+        release_object( file );
+        return;
+    }
+    image->fd         = (struct fd *)grab_object( view->fd );
+    image->file_size  = st.st_size;
+    image->file_mtime = st.st_mtime;
+    image->base       = view->base;
+    image->size       = view->size;
+    image->start      = req->start;
+    image->end        = req->end;
+    image->file       = file;
+    list_add_tail( &relocated_image_list, &image->entry );
+    view->relocated = image;
+    return;
+
+failed:
+    close( unix_fd );
+}
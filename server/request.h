@@ -171,6 +171,7 @@ DECL_HANDLER(accept_into_socket);
 DECL_HANDLER(set_socket_event);
 DECL_HANDLER(get_socket_event);
 DECL_HANDLER(get_socket_info);
+DECL_HANDLER(get_socket_shared_state);
 DECL_HANDLER(enable_socket_event);
 DECL_HANDLER(set_socket_deferred);
 DECL_HANDLER(alloc_console);
@@ -205,6 +206,8 @@ DECL_HANDLER(unmap_view);
 DECL_HANDLER(get_mapping_committed_range);
 DECL_HANDLER(add_mapping_committed_range);
 DECL_HANDLER(is_same_mapping);
+DECL_HANDLER(get_relocated_image);
+DECL_HANDLER(set_relocated_image);
 DECL_HANDLER(create_snapshot);
 DECL_HANDLER(next_process);
 DECL_HANDLER(next_thread);
@@ -387,6 +390,7 @@ DECL_HANDLER(create_completion);
 DECL_HANDLER(open_completion);
 DECL_HANDLER(add_completion);
 DECL_HANDLER(remove_completion);
+DECL_HANDLER(remove_completions);
 DECL_HANDLER(query_completion);
 DECL_HANDLER(set_completion_info);
 DECL_HANDLER(add_fd_completion);
@@ -412,9 +416,11 @@ DECL_HANDLER(suspend_process);
 DECL_HANDLER(resume_process);
 DECL_HANDLER(create_esync);
 DECL_HANDLER(open_esync);
-DECL_HANDLER(get_esync_fd);
+DECL_HANDLER(get_esync_read_fd);
+DECL_HANDLER(get_esync_write_fd);
 DECL_HANDLER(get_esync_apc_fd);
 DECL_HANDLER(esync_msgwait);
+DECL_HANDLER(get_esync_completion_fds);
 
 #ifdef WANT_REQUEST_HANDLERS
 
@@ -480,6 +486,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_socket_event,
     (req_handler)req_get_socket_event,
     (req_handler)req_get_socket_info,
+    (req_handler)req_get_socket_shared_state,
     (req_handler)req_enable_socket_event,
     (req_handler)req_set_socket_deferred,
     (req_handler)req_alloc_console,
@@ -514,6 +521,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_mapping_committed_range,
     (req_handler)req_add_mapping_committed_range,
     (req_handler)req_is_same_mapping,
+    (req_handler)req_get_relocated_image,
+    (req_handler)req_set_relocated_image,
     (req_handler)req_create_snapshot,
     (req_handler)req_next_process,
     (req_handler)req_next_thread,
@@ -696,6 +705,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_open_completion,
     (req_handler)req_add_completion,
     (req_handler)req_remove_completion,
+    (req_handler)req_remove_completions,
     (req_handler)req_query_completion,
     (req_handler)req_set_completion_info,
     (req_handler)req_add_fd_completion,
@@ -721,9 +731,11 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_resume_process,
     (req_handler)req_create_esync,
     (req_handler)req_open_esync,
-    (req_handler)req_get_esync_fd,
+    (req_handler)req_get_esync_read_fd,
+    (req_handler)req_get_esync_write_fd,
     (req_handler)req_get_esync_apc_fd,
     (req_handler)req_esync_msgwait,
+    (req_handler)req_get_esync_completion_fds,
 };
 
 C_ASSERT( sizeof(affinity_t) == 8 );
@@ -1121,6 +1133,13 @@ C_ASSERT( FIELD_OFFSET(struct get_socket_info_reply, family) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_socket_info_reply, type) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_socket_info_reply, protocol) == 16 );
 C_ASSERT( sizeof(struct get_socket_info_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_socket_shared_state_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_socket_shared_state_request, need_file) == 16 );
+C_ASSERT( sizeof(struct get_socket_shared_state_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_socket_shared_state_reply, index) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_socket_shared_state_reply, serial) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_socket_shared_state_reply, file) == 16 );
+C_ASSERT( sizeof(struct get_socket_shared_state_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, mask) == 16 );
 C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, sstate) == 20 );
@@ -1336,6 +1355,17 @@ C_ASSERT( sizeof(struct add_mapping_committed_range_request) == 40 );
 C_ASSERT( FIELD_OFFSET(struct is_same_mapping_request, base1) == 16 );
 C_ASSERT( FIELD_OFFSET(struct is_same_mapping_request, base2) == 24 );
 C_ASSERT( sizeof(struct is_same_mapping_request) == 32 );
+C_ASSERT( FIELD_OFFSET(struct get_relocated_image_request, base) == 16 );
+C_ASSERT( sizeof(struct get_relocated_image_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_relocated_image_reply, start) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_relocated_image_reply, end) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_relocated_image_reply, file) == 24 );
+C_ASSERT( sizeof(struct get_relocated_image_reply) == 32 );
+C_ASSERT( FIELD_OFFSET(struct set_relocated_image_request, base) == 16 );
+C_ASSERT( FIELD_OFFSET(struct set_relocated_image_request, start) == 24 );
+C_ASSERT( FIELD_OFFSET(struct set_relocated_image_request, end) == 32 );
+C_ASSERT( FIELD_OFFSET(struct set_relocated_image_request, fd) == 40 );
+C_ASSERT( sizeof(struct set_relocated_image_request) == 48 );
 C_ASSERT( FIELD_OFFSET(struct create_snapshot_request, attributes) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_snapshot_request, flags) == 16 );
 C_ASSERT( sizeof(struct create_snapshot_request) == 24 );
@@ -2361,6 +2391,9 @@ C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, cvalue) == 16 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, information) == 24 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, status) == 32 );
 C_ASSERT( sizeof(struct remove_completion_reply) == 40 );
+C_ASSERT( FIELD_OFFSET(struct remove_completions_request, handle) == 12 );
+C_ASSERT( sizeof(struct remove_completions_request) == 16 );
+C_ASSERT( sizeof(struct remove_completions_reply) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct query_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_reply, depth) == 8 );
@@ -2470,14 +2503,19 @@ C_ASSERT( FIELD_OFFSET(struct open_esync_reply, handle) == 8 );
 C_ASSERT( FIELD_OFFSET(struct open_esync_reply, type) == 12 );
 C_ASSERT( FIELD_OFFSET(struct open_esync_reply, shm_idx) == 16 );
 C_ASSERT( sizeof(struct open_esync_reply) == 24 );
-C_ASSERT( FIELD_OFFSET(struct get_esync_fd_request, handle) == 12 );
-C_ASSERT( sizeof(struct get_esync_fd_request) == 16 );
-C_ASSERT( FIELD_OFFSET(struct get_esync_fd_reply, type) == 8 );
-C_ASSERT( FIELD_OFFSET(struct get_esync_fd_reply, shm_idx) == 12 );
-C_ASSERT( sizeof(struct get_esync_fd_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_read_fd_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_esync_read_fd_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_read_fd_reply, type) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_read_fd_reply, shm_idx) == 12 );
+C_ASSERT( sizeof(struct get_esync_read_fd_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_write_fd_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_esync_write_fd_request) == 16 );
+C_ASSERT( sizeof(struct get_esync_write_fd_reply) == 8 );
 C_ASSERT( sizeof(struct get_esync_apc_fd_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct esync_msgwait_request, in_msgwait) == 12 );
 C_ASSERT( sizeof(struct esync_msgwait_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_completion_fds_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_esync_completion_fds_request) == 16 );
 
 #endif  /* WANT_REQUEST_HANDLERS */
 
@@ -22,6 +22,7 @@
  */
 
 #include "config.h"
+#include "wine/port.h"
 
 #include <assert.h>
 #include <fcntl.h>
@@ -33,8 +34,12 @@
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #endif
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 #ifdef HAVE_SYS_SOCKET_H
 # include <sys/socket.h>
 #endif
@@ -117,6 +122,7 @@ struct sock
     struct async_queue  ifchange_q;  /* queue for interface change notifications */
     struct object      *ifchange_obj; /* the interface change notification object */
     struct list         ifchange_entry; /* entry in ifchange notification list */
+    unsigned int        shared_index; /* index in the shared state file, 0 if none */
 };
 
 static void sock_dump( struct object *obj, int verbose );
@@ -252,6 +258,135 @@ void sock_init(void)
     }
 }
 
+/* Socket state shared with the clients.
+ *
+ * Clients look up the state and event mask of a socket in this file, so that
+ * they don't need a server call to know whether a socket is blocking or
+ * whether anybody selected for its events. Only the server writes to it, the
+ * clients get a read-only fd. Entries are only allocated when a client asks
+ * for one; index 0 is never used. */
+
+static struct file *shared_file;      /* read-only file given to the clients */
+static int shared_fd = -1;            /* writable fd for the server */
+static void **shared_pages;
+static unsigned int shared_pages_count;
+static unsigned int shared_size;      /* number of entries the file can hold */
+static unsigned int shared_count;     /* number of entries ever allocated */
+static unsigned int *shared_free;     /* stack of free entries */
+static unsigned int shared_free_count;
+static unsigned int shared_free_size;
+static unsigned int shared_serial;
+
+static volatile struct socket_shared_state *get_shared_state( unsigned int index )
+{
+    unsigned int per_page = get_page_size() / sizeof(struct socket_shared_state);
+    unsigned int page = index / per_page;
+
+    if (page >= shared_pages_count)
+    {
+        void **new_pages = realloc( shared_pages, (page + 1) * sizeof(*shared_pages) );
+        if (!new_pages) return NULL;
+        memset( new_pages + shared_pages_count, 0, (page + 1 - shared_pages_count) * sizeof(*shared_pages) );
+        shared_pages = new_pages;
+        shared_pages_count = page + 1;
+    }
+    if (!shared_pages[page])
+    {
+        void *ptr = mmap( NULL, get_page_size(), PROT_READ | PROT_WRITE, MAP_SHARED,
+                          shared_fd, (off_t)page * get_page_size() );
+        if (ptr == MAP_FAILED) return NULL;
+        shared_pages[page] = ptr;
+    }
+    return (struct socket_shared_state *)shared_pages[page] + index % per_page;
+}
+
+static unsigned int alloc_shared_state( struct sock *sock )
+{
+    volatile struct socket_shared_state *shared;
+    unsigned int index;
+    struct stat st;
+
+    if (fstat( get_unix_fd( sock->fd ), &st ) == -1)
+    {
+        file_set_error();
+        return 0;
+    }
+
+    if (!shared_file)
+    {
+        int fd, readonly_fd;
+
+        if ((fd = create_shared_temp_file( get_page_size(), &readonly_fd )) == -1) return 0;
+        if (!(shared_file = create_file_for_fd( readonly_fd, FILE_GENERIC_READ, 0 )))
+        {
+            close( fd );
+            return 0;
+        }
+        make_object_static( (struct object *)shared_file );
+        shared_fd = fd;
+        shared_size = get_page_size() / sizeof(*shared);
+        shared_count = 1;
+    }
+
+    if (shared_free_count) index = shared_free[--shared_free_count];
+    else
+    {
+        if (shared_count == shared_size)
+        {
+            if (ftruncate( shared_fd, (off_t)(shared_size * sizeof(*shared) + get_page_size()) ) == -1)
+            {
+                file_set_error();
+                return 0;
+            }
+            shared_size += get_page_size() / sizeof(*shared);
+        }
+        index = shared_count++;
+    }
+
+    if (!(shared = get_shared_state( index )))
+    {
+        set_error( STATUS_NO_MEMORY );
+        return 0;
+    }
+    if (!++shared_serial) ++shared_serial;
+    shared->serial = shared_serial;
+    shared->state  = sock->state;
+    shared->mask   = sock->mask;
+    shared->inode  = st.st_ino;
+    return index;
+}
+
+static void free_shared_state( struct sock *sock )
+{
+    volatile struct socket_shared_state *shared = get_shared_state( sock->shared_index );
+
+    if (shared)
+    {
+        shared->serial = 0;
+        shared->inode  = 0;
+    }
+    if (shared_free_count == shared_free_size)
+    {
+        unsigned int new_size = max( 64, shared_free_size * 2 );
+        unsigned int *new_free = realloc( shared_free, new_size * sizeof(*shared_free) );
+        if (!new_free) return;  /* leak the entry */
+        shared_free = new_free;
+        shared_free_size = new_size;
+    }
+    shared_free[shared_free_count++] = sock->shared_index;
+    sock->shared_index = 0;
+}
+
+/* update the shared copy of the socket state */
+static void sock_update_shared( struct sock *sock )
+{
+    volatile struct socket_shared_state *shared;
+
+    if (!sock->shared_index || !(shared = get_shared_state( sock->shared_index ))) return;
+    shared->state = sock->state;
+    shared->mask  = sock->mask;
+}
+
 static int sock_reselect( struct sock *sock )
 {
     int ev = sock_get_poll_events( sock->fd );
@@ -259,6 +394,8 @@ static int sock_reselect( struct sock *sock )
     if (debug_level)
         fprintf(stderr,"sock_reselect(%p): new mask %x\n", sock, ev);
 
+    sock_update_shared( sock );
+
     if (!sock->polling)  /* FIXME: should find a better way to do this */
     {
         /* previously unconnected socket, is this reselect supposed to connect it? */
@@ -618,6 +755,7 @@ static void sock_destroy( struct object *obj )
     if ( sock->deferred )
         release_object( sock->deferred );
 
+    if (sock->shared_index) free_shared_state( sock );
     async_wake_up( &sock->ifchange_q, STATUS_CANCELLED );
     sock_release_ifchange( sock );
     free_async_queue( &sock->read_q );
@@ -649,6 +787,7 @@ static void init_sock(struct sock *sock)
     sock->connect_time = 0;
     sock->deferred = NULL;
     sock->ifchange_obj = NULL;
+    sock->shared_index = 0;
     init_async_queue( &sock->read_q );
     init_async_queue( &sock->write_q );
     init_async_queue( &sock->ifchange_q );
@@ -1230,6 +1369,7 @@ DECL_HANDLER(set_socket_event)
                                                 FILE_WRITE_ATTRIBUTES, &sock_ops))) return;
     old_event = sock->event;
     sock->mask    = req->mask;
+    sock_update_shared( sock );
     sock->hmask   &= ~req->mask; /* re-enable held events */
     sock->event   = NULL;
     sock->window  = req->window;
@@ -1239,9 +1379,8 @@ DECL_HANDLER(set_socket_event)
 
     if (debug_level && sock->event) fprintf(stderr, "event ptr: %p\n", sock->event);
 
-    sock_reselect( sock );
-
     sock->state |= FD_WINE_NONBLOCKING;
+    sock_reselect( sock );
 
     /* if a network event is pending, signal the event object
        it is possible that FD_CONNECT or FD_ACCEPT network events has happened
@@ -1292,6 +1431,7 @@ DECL_HANDLER(enable_socket_event)
                                                FILE_WRITE_ATTRIBUTES, &sock_ops)))
         return;
 
+
     /* for event-based notification, windows erases stale events */
     sock->pmask &= ~req->mask;
 
@@ -1305,6 +1445,27 @@ DECL_HANDLER(enable_socket_event)
     release_object( &sock->obj );
 }
 
+/* get the index of the socket in the shared socket state file */
+DECL_HANDLER(get_socket_shared_state)
+{
+    volatile struct socket_shared_state *shared;
+    struct sock *sock;
+
+    if (!(sock = (struct sock *)get_handle_obj( current->process, req->handle,
+                                                FILE_READ_ATTRIBUTES, &sock_ops )))
+        return;
+
+    if (!sock->shared_index) sock->shared_index = alloc_shared_state( sock );
+    if (sock->shared_index && (shared = get_shared_state( sock->shared_index )))
+    {
+        reply->index  = sock->shared_index;
+        reply->serial = shared->serial;
+        if (req->need_file)
+            reply->file = alloc_handle_no_access_check( current->process, shared_file, FILE_GENERIC_READ, 0 );
+    }
+    release_object( &sock->obj );
+}
+
 DECL_HANDLER(set_socket_deferred)
 {
     struct sock *sock, *acceptsock;
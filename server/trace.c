@@ -1190,6 +1190,25 @@ static void dump_varargs_pe_image_info( const char *prefix, data_size_t size )
     remove_data( size );
 }
 
+static void dump_varargs_completion_packets( const char *prefix, data_size_t size )
+{
+    const struct completion_packet *packet;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*packet))
+    {
+        packet = cur_data;
+        dump_uint64( "{ckey=", &packet->ckey );
+        dump_uint64( ",cvalue=", &packet->cvalue );
+        dump_uint64( ",information=", &packet->information );
+        fprintf( stderr, ",status=%s}", get_status_name( packet->status ) );
+        size -= sizeof(*packet);
+        remove_data( sizeof(*packet) );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
 static void dump_varargs_rawinput_devices(const char *prefix, data_size_t size )
 {
     const struct rawinput_device *device;
@@ -1947,6 +1966,19 @@ static void dump_get_socket_info_reply( const struct get_socket_info_reply *req
     fprintf( stderr, ", protocol=%d", req->protocol );
 }
 
+static void dump_get_socket_shared_state_request( const struct get_socket_shared_state_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", need_file=%d", req->need_file );
+}
+
+static void dump_get_socket_shared_state_reply( const struct get_socket_shared_state_reply *req )
+{
+    fprintf( stderr, " index=%08x", req->index );
+    fprintf( stderr, ", serial=%08x", req->serial );
+    fprintf( stderr, ", file=%04x", req->file );
+}
+
 static void dump_enable_socket_event_request( const struct enable_socket_event_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -2339,6 +2371,26 @@ static void dump_is_same_mapping_request( const struct is_same_mapping_request *
     dump_uint64( ", base2=", &req->base2 );
 }
 
+static void dump_get_relocated_image_request( const struct get_relocated_image_request *req )
+{
+    dump_uint64( " base=", &req->base );
+}
+
+static void dump_get_relocated_image_reply( const struct get_relocated_image_reply *req )
+{
+    dump_uint64( " start=", &req->start );
+    dump_uint64( ", end=", &req->end );
+    fprintf( stderr, ", file=%04x", req->file );
+}
+
+static void dump_set_relocated_image_request( const struct set_relocated_image_request *req )
+{
+    dump_uint64( " base=", &req->base );
+    dump_uint64( ", start=", &req->start );
+    dump_uint64( ", end=", &req->end );
+    fprintf( stderr, ", fd=%d", req->fd );
+}
+
 static void dump_create_snapshot_request( const struct create_snapshot_request *req )
 {
     fprintf( stderr, " attributes=%08x", req->attributes );
@@ -4407,6 +4459,16 @@ static void dump_remove_completion_reply( const struct remove_completion_reply *
     fprintf( stderr, ", status=%08x", req->status );
 }
 
+static void dump_remove_completions_request( const struct remove_completions_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_remove_completions_reply( const struct remove_completions_reply *req )
+{
+    dump_varargs_completion_packets( " packets=", cur_size );
+}
+
 static void dump_query_completion_request( const struct query_completion_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -4626,17 +4688,22 @@ static void dump_open_esync_reply( const struct open_esync_reply *req )
     fprintf( stderr, ", shm_idx=%08x", req->shm_idx );
 }
 
-static void dump_get_esync_fd_request( const struct get_esync_fd_request *req )
+static void dump_get_esync_read_fd_request( const struct get_esync_read_fd_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
 }
 
-static void dump_get_esync_fd_reply( const struct get_esync_fd_reply *req )
+static void dump_get_esync_read_fd_reply( const struct get_esync_read_fd_reply *req )
 {
     fprintf( stderr, " type=%d", req->type );
     fprintf( stderr, ", shm_idx=%08x", req->shm_idx );
 }
 
+static void dump_get_esync_write_fd_request( const struct get_esync_write_fd_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_get_esync_apc_fd_request( const struct get_esync_apc_fd_request *req )
 {
 }
@@ -4646,6 +4713,11 @@ static void dump_esync_msgwait_request( const struct esync_msgwait_request *req
     fprintf( stderr, " in_msgwait=%d", req->in_msgwait );
 }
 
+static void dump_get_esync_completion_fds_request( const struct get_esync_completion_fds_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_new_process_request,
     (dump_func)dump_exec_process_request,
@@ -4706,6 +4778,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_socket_event_request,
     (dump_func)dump_get_socket_event_request,
     (dump_func)dump_get_socket_info_request,
+    (dump_func)dump_get_socket_shared_state_request,
     (dump_func)dump_enable_socket_event_request,
     (dump_func)dump_set_socket_deferred_request,
     (dump_func)dump_alloc_console_request,
@@ -4740,6 +4813,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_mapping_committed_range_request,
     (dump_func)dump_add_mapping_committed_range_request,
     (dump_func)dump_is_same_mapping_request,
+    (dump_func)dump_get_relocated_image_request,
+    (dump_func)dump_set_relocated_image_request,
     (dump_func)dump_create_snapshot_request,
     (dump_func)dump_next_process_request,
     (dump_func)dump_next_thread_request,
@@ -4922,6 +4997,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_open_completion_request,
     (dump_func)dump_add_completion_request,
     (dump_func)dump_remove_completion_request,
+    (dump_func)dump_remove_completions_request,
     (dump_func)dump_query_completion_request,
     (dump_func)dump_set_completion_info_request,
     (dump_func)dump_add_fd_completion_request,
@@ -4947,9 +5023,11 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_resume_process_request,
     (dump_func)dump_create_esync_request,
     (dump_func)dump_open_esync_request,
-    (dump_func)dump_get_esync_fd_request,
+    (dump_func)dump_get_esync_read_fd_request,
+    (dump_func)dump_get_esync_write_fd_request,
     (dump_func)dump_get_esync_apc_fd_request,
     (dump_func)dump_esync_msgwait_request,
+    (dump_func)dump_get_esync_completion_fds_request,
 };
 
 static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
@@ -5012,6 +5090,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_get_socket_event_reply,
     (dump_func)dump_get_socket_info_reply,
+    (dump_func)dump_get_socket_shared_state_reply,
     NULL,
     NULL,
     (dump_func)dump_alloc_console_reply,
@@ -5046,6 +5125,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_mapping_committed_range_reply,
     NULL,
     NULL,
+    (dump_func)dump_get_relocated_image_reply,
+    NULL,
     (dump_func)dump_create_snapshot_reply,
     (dump_func)dump_next_process_reply,
     (dump_func)dump_next_thread_reply,
@@ -5228,6 +5309,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_open_completion_reply,
     NULL,
     (dump_func)dump_remove_completion_reply,
+    (dump_func)dump_remove_completions_reply,
     (dump_func)dump_query_completion_reply,
     NULL,
     NULL,
@@ -5253,7 +5335,9 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_create_esync_reply,
     (dump_func)dump_open_esync_reply,
-    (dump_func)dump_get_esync_fd_reply,
+    (dump_func)dump_get_esync_read_fd_reply,
+    NULL,
+    NULL,
     NULL,
     NULL,
 };
@@ -5318,6 +5402,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_socket_event",
     "get_socket_event",
     "get_socket_info",
+    "get_socket_shared_state",
     "enable_socket_event",
     "set_socket_deferred",
     "alloc_console",
@@ -5352,6 +5437,8 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_mapping_committed_range",
     "add_mapping_committed_range",
     "is_same_mapping",
+    "get_relocated_image",
+    "set_relocated_image",
     "create_snapshot",
     "next_process",
     "next_thread",
@@ -5534,6 +5621,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "open_completion",
     "add_completion",
     "remove_completion",
+    "remove_completions",
     "query_completion",
     "set_completion_info",
     "add_fd_completion",
@@ -5559,9 +5647,11 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "resume_process",
     "create_esync",
     "open_esync",
-    "get_esync_fd",
+    "get_esync_read_fd",
+    "get_esync_write_fd",
     "get_esync_apc_fd",
     "esync_msgwait",
+    "get_esync_completion_fds",
 };
 
 static const struct